@@ -557,52 +557,85 @@ namespace std
         }
     };
 
-    /* Overloading the << operator */
+    /* Overloading the << operator. The hex isn't built for a failed stream,
+       which is what a log message below the log level is */
     inline ostream &operator<<(ostream &os, const Crypto::EllipticCurvePoint &ep)
     {
-        os << Common::podToHex(ep);
+        if (os)
+        {
+            os << Common::podToHex(ep);
+        }
+
         return os;
     }
 
     inline ostream &operator<<(ostream &os, const Crypto::EllipticCurveScalar &es)
     {
-        os << Common::podToHex(es);
+        if (os)
+        {
+            os << Common::podToHex(es);
+        }
+
         return os;
     }
 
     inline ostream &operator<<(ostream &os, const Crypto::Hash &hash)
     {
-        os << Common::podToHex(hash);
+        if (os)
+        {
+            os << Common::podToHex(hash);
+        }
+
         return os;
     }
 
     inline ostream &operator<<(ostream &os, const Crypto::PublicKey &publicKey)
     {
-        os << Common::podToHex(publicKey);
+        if (os)
+        {
+            os << Common::podToHex(publicKey);
+        }
+
         return os;
     }
 
     inline ostream &operator<<(ostream &os, const Crypto::SecretKey &secretKey)
     {
-        os << Common::podToHex(secretKey);
+        if (os)
+        {
+            os << Common::podToHex(secretKey);
+        }
+
         return os;
     }
 
     inline ostream &operator<<(ostream &os, const Crypto::KeyDerivation &keyDerivation)
     {
-        os << Common::podToHex(keyDerivation);
+        if (os)
+        {
+            os << Common::podToHex(keyDerivation);
+        }
+
         return os;
     }
 
     inline ostream &operator<<(ostream &os, const Crypto::KeyImage &keyImage)
     {
-        os << Common::podToHex(keyImage);
+        if (os)
+        {
+            os << Common::podToHex(keyImage);
+        }
+
         return os;
     }
 
     inline ostream &operator<<(ostream &os, const Crypto::Signature &signature)
     {
-        os << Common::podToHex(signature);
+        if (os)
+        {
+            os << Common::podToHex(signature);
+        }
+
         return os;
     }
 } // namespace std
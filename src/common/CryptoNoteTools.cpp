@@ -5,6 +5,9 @@
 
 #include "CryptoNoteTools.h"
 
+#include <algorithm>
+#include <iterator>
+
 using namespace CryptoNote;
 
 void CryptoNote::getBinaryArrayHash(const BinaryArray &binaryArray, Crypto::Hash &hash)
@@ -18,3 +21,23 @@ Crypto::Hash CryptoNote::getBinaryArrayHash(const BinaryArray &binaryArray)
     getBinaryArrayHash(binaryArray, hash);
     return hash;
 }
+
+uint64_t CryptoNote::getShortTransactionId(const Crypto::Hash &salt, const Crypto::Hash &transactionHash)
+{
+    uint8_t data[sizeof(salt) + sizeof(transactionHash)];
+
+    std::copy(std::begin(salt.data), std::end(salt.data), data);
+    std::copy(std::begin(transactionHash.data), std::end(transactionHash.data), data + sizeof(salt));
+
+    Crypto::Hash hash;
+    cn_fast_hash(data, sizeof(data), hash);
+
+    uint64_t shortId = 0;
+
+    for (size_t i = 0; i < COMPACT_BLOCK_SHORT_ID_SIZE; i++)
+    {
+        shortId |= static_cast<uint64_t>(hash.data[i]) << (8 * i);
+    }
+
+    return shortId;
+}
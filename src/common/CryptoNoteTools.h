@@ -22,6 +22,12 @@ namespace CryptoNote
 
     Crypto::Hash getBinaryArrayHash(const BinaryArray &binaryArray);
 
+    /* The transaction's hash, hashed with the salt and cut down to the first
+       COMPACT_BLOCK_SHORT_ID_SIZE bytes, for referring to it in a compact
+       block. The salt is the previous block hash, so the short ids of a block
+       can't be picked to collide before the block before it is found. */
+    uint64_t getShortTransactionId(const Crypto::Hash &salt, const Crypto::Hash &transactionHash);
+
     template<class T> bool getObjectBinarySize(const T &object, size_t &size)
     {
         BinaryArray ba;
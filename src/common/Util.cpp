@@ -20,7 +20,9 @@
 #include <windows.h>
 
 #else
+#include <fcntl.h>
 #include <sys/utsname.h>
+#include <unistd.h>
 #endif
 
 namespace Tools
@@ -339,4 +341,64 @@ namespace Tools
         std::error_code e;
         return fs::is_directory(path, e);
     }
+
+    bool syncFile(const std::string &path)
+    {
+#ifdef WIN32
+        HANDLE file = CreateFileA(
+            path.c_str(),
+            GENERIC_WRITE,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        const bool success = FlushFileBuffers(file);
+
+        CloseHandle(file);
+
+        return success;
+#else
+        /* Syncing flushes what was written through any descriptor for the
+           file, not just this one */
+        const int file = ::open(path.c_str(), O_RDONLY);
+
+        if (file == -1)
+        {
+            return false;
+        }
+
+        const bool success = ::fsync(file) == 0;
+
+        ::close(file);
+
+        return success;
+#endif
+    }
+
+    bool syncDirectory(const std::string &path)
+    {
+#ifdef WIN32
+        return true;
+#else
+        const int directory = ::open(path.empty() ? "." : path.c_str(), O_RDONLY | O_DIRECTORY);
+
+        if (directory == -1)
+        {
+            return false;
+        }
+
+        const bool success = ::fsync(directory) == 0;
+
+        ::close(directory);
+
+        return success;
+#endif
+    }
 } // namespace Tools
@@ -17,4 +17,11 @@ namespace Tools
     bool create_directories_if_necessary(const std::string &path);
 
     bool directoryExists(const std::string &path);
+
+    /* Waits for everything written to the file to reach the disk */
+    bool syncFile(const std::string &path);
+
+    /* Waits for files created, renamed or removed in the directory to reach
+       the disk. Does nothing on Windows, where it isn't needed. */
+    bool syncDirectory(const std::string &path);
 } // namespace Tools
@@ -221,6 +221,7 @@ namespace CryptoNote
 
         const char     CRYPTONOTE_BLOCKS_FILENAME[]                  = "blocks.bin";
         const char     CRYPTONOTE_BLOCKINDEXES_FILENAME[]            = "blockindexes.bin";
+        const char     CRYPTONOTE_BLOCKOFFSETS_FILENAME[]            = "blockoffsets.bin";
         const char     CRYPTONOTE_POOLDATA_FILENAME[]                = "poolstate.bin";
         const char     P2P_NET_DATA_FILENAME[]                       = "p2pstate.bin";
         const char     MINER_CONFIG_FILE_NAME[]                      = "miner_conf.json";
@@ -254,6 +255,9 @@ namespace CryptoNote
 
     const size_t   BLOCKS_IDS_SYNCHRONIZING_DEFAULT_COUNT        =  10000;  //by default, blocks ids count in synchronizing
     const uint64_t BLOCKS_SYNCHRONIZING_DEFAULT_COUNT            =  100;    //by default, blocks count in blocks downloading
+    const size_t   BLOCKS_SYNCHRONIZING_MAX_WINDOWS              =  20;     //windows of blocks downloaded or waiting to be added at once
+    const uint64_t BLOCKS_SYNCHRONIZING_STALL_TIMEOUT            =  30;     //seconds before a window is requested from another peer
+    const size_t   BLOCK_BLOB_CACHE_MAX_SIZE                     =  64 * 1024 * 1024; //bytes of serialized blocks kept for peers syncing from us
     const size_t   COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT         =  1000;
 
     const int      P2P_DEFAULT_PORT                              =  17890;
@@ -265,12 +269,18 @@ namespace CryptoNote
 
     // P2P Network Configuration Section - This defines our current P2P network version
     // and the minimum version for communication between nodes
-    const uint8_t  P2P_CURRENT_VERSION                           = 12;
+    const uint8_t  P2P_CURRENT_VERSION                           = 13;
     const uint8_t  P2P_MINIMUM_VERSION                           = 10;
 
     // This defines the minimum P2P version required for lite blocks propogation
     const uint8_t P2P_LITE_BLOCKS_PROPOGATION_VERSION            = 4;
 
+    // This defines the minimum P2P version required for compact blocks propogation
+    const uint8_t P2P_COMPACT_BLOCKS_PROPOGATION_VERSION         = 13;
+
+    // Bytes of each transaction's short id in a compact block
+    const size_t  COMPACT_BLOCK_SHORT_ID_SIZE                    = 6;
+
     // This defines the number of versions ahead we must see peers before we start displaying
     // warning messages that we need to upgrade our software.
     const uint8_t  P2P_UPGRADE_WINDOW                            = 2;
@@ -0,0 +1,86 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "hash.h"
+
+#include "argon2.h"
+
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace Crypto
+{
+    namespace
+    {
+        std::once_flag argon2ImplementationSelected;
+
+        /* Cache line sized, so the blocks Argon2 works on don't straddle
+           lines */
+        struct alignas(64) ScratchpadLine
+        {
+            uint8_t data[64];
+        };
+
+        /* The memory Argon2 fills, allocated the first time a thread hashes
+           and reused for every hash after, rather than allocating and
+           freeing half a megabyte per hash */
+        std::vector<ScratchpadLine> &chukwaScratchpad()
+        {
+            static const size_t size = argon2_memory_size(CHUKWA_MEMORY, CHUKWA_THREADS);
+
+            thread_local std::vector<ScratchpadLine> scratchpad((size + sizeof(ScratchpadLine) - 1)
+                                                                / sizeof(ScratchpadLine));
+
+            return scratchpad;
+        }
+    } // namespace
+
+    void chukwa_slow_hash(const void *data, size_t length, Hash &hash)
+    {
+        /* The first time we hash, have the Argon2 library benchmark the
+           implementations the CPU supports (SSE2 through AVX-512), and use
+           the fastest from then on. The benchmark isn't thread safe, and
+           the miner and the block validation pool hash on many threads at
+           once, so make sure it only runs once. */
+        std::call_once(argon2ImplementationSelected, [] { argon2_select_impl(NULL, NULL); });
+
+        uint8_t salt[CHUKWA_SALTLEN];
+        memcpy(salt, data, sizeof(salt));
+
+        auto &scratchpad = chukwaScratchpad();
+
+        argon2_context context;
+        context.out = hash.data;
+        context.outlen = CHUKWA_HASHLEN;
+        context.pwd = static_cast<uint8_t *>(const_cast<void *>(data));
+        context.pwdlen = static_cast<uint32_t>(length);
+        context.salt = salt;
+        context.saltlen = CHUKWA_SALTLEN;
+        context.secret = NULL;
+        context.secretlen = 0;
+        context.ad = NULL;
+        context.adlen = 0;
+        context.t_cost = CHUKWA_ITERS;
+        context.m_cost = CHUKWA_MEMORY;
+        context.lanes = CHUKWA_THREADS;
+        context.threads = CHUKWA_THREADS;
+        context.allocate_cbk = NULL;
+        context.free_cbk = NULL;
+        context.flags = ARGON2_DEFAULT_FLAGS;
+        context.version = ARGON2_VERSION_NUMBER;
+
+        const int result = argon2_ctx_mem(
+            &context,
+            Argon2_id,
+            scratchpad.data(),
+            argon2_memory_size(CHUKWA_MEMORY, CHUKWA_THREADS));
+
+        if (result != ARGON2_OK)
+        {
+            throw std::runtime_error(std::string("Chukwa hashing failed: ") + argon2_error_message(result));
+        }
+    }
+} // namespace Crypto
@@ -0,0 +1,866 @@
+// Copyright (c) 2018-2020, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "crypto-ops-51.h"
+
+#if defined(CRYPTO_OPS_51)
+
+#include <string.h>
+
+typedef unsigned __int128 uint128_t;
+
+static const uint64_t mask51 = 0x7ffffffffffffULL;
+
+/* Common functions */
+
+static uint64_t load_8(const unsigned char *in)
+{
+    uint64_t result = 0;
+    int i;
+
+    for (i = 7; i >= 0; i--)
+    {
+        result = (result << 8) | in[i];
+    }
+
+    return result;
+}
+
+static void store_8(unsigned char *out, uint64_t in)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        out[i] = (unsigned char)(in >> (8 * i));
+    }
+}
+
+/* Field arithmetic.
+
+   An element is f[0] + 2^51 f[1] + 2^102 f[2] + 2^153 f[3] + 2^204 f[4].
+   The limbs are left unreduced between operations: fe51_mul() and
+   fe51_sq() give limbs of at most 2^51 plus a little, fe51_add() up to
+   twice its inputs, and fe51_sub() adds 2p to keep the result positive, so
+   its limbs are at most 2^52 plus its first input. The point formulas below
+   are the ref10 ones, which never feed more than a couple of additions into
+   a multiplication, so nothing gets near overflowing. */
+
+static void fe51_0(fe51 h)
+{
+    h[0] = 0;
+    h[1] = 0;
+    h[2] = 0;
+    h[3] = 0;
+    h[4] = 0;
+}
+
+static void fe51_1(fe51 h)
+{
+    h[0] = 1;
+    h[1] = 0;
+    h[2] = 0;
+    h[3] = 0;
+    h[4] = 0;
+}
+
+static void fe51_copy(fe51 h, const fe51 f)
+{
+    memcpy(h, f, sizeof(fe51));
+}
+
+/* h = f + g */
+static void fe51_add(fe51 h, const fe51 f, const fe51 g)
+{
+    h[0] = f[0] + g[0];
+    h[1] = f[1] + g[1];
+    h[2] = f[2] + g[2];
+    h[3] = f[3] + g[3];
+    h[4] = f[4] + g[4];
+}
+
+/* h = f - g. g is carried first, so any limbs below 2^63 are fine. */
+static void fe51_sub(fe51 h, const fe51 f, const fe51 g)
+{
+    uint64_t h0 = g[0];
+    uint64_t h1 = g[1];
+    uint64_t h2 = g[2];
+    uint64_t h3 = g[3];
+    uint64_t h4 = g[4];
+
+    h1 += h0 >> 51;
+    h0 &= mask51;
+    h2 += h1 >> 51;
+    h1 &= mask51;
+    h3 += h2 >> 51;
+    h2 &= mask51;
+    h4 += h3 >> 51;
+    h3 &= mask51;
+    h0 += 19 * (h4 >> 51);
+    h4 &= mask51;
+
+    /* 2p = 2^256 - 38 */
+    h[0] = (f[0] + 0xfffffffffffdaULL) - h0;
+    h[1] = (f[1] + 0xffffffffffffeULL) - h1;
+    h[2] = (f[2] + 0xffffffffffffeULL) - h2;
+    h[3] = (f[3] + 0xffffffffffffeULL) - h3;
+    h[4] = (f[4] + 0xffffffffffffeULL) - h4;
+}
+
+/* h = -f */
+static void fe51_neg(fe51 h, const fe51 f)
+{
+    fe51 zero;
+    fe51_0(zero);
+    fe51_sub(h, zero, f);
+}
+
+/* Replace f with g if b == 1, leave it alone if b == 0, in constant time */
+static void fe51_cmov(fe51 f, const fe51 g, unsigned int b)
+{
+    const uint64_t mask = (uint64_t)0 - b;
+
+    f[0] ^= mask & (f[0] ^ g[0]);
+    f[1] ^= mask & (f[1] ^ g[1]);
+    f[2] ^= mask & (f[2] ^ g[2]);
+    f[3] ^= mask & (f[3] ^ g[3]);
+    f[4] ^= mask & (f[4] ^ g[4]);
+}
+
+/* Carries the five 128 bit column sums of a product into h */
+static void fe51_carry_wide(fe51 h, uint128_t r0, uint128_t r1, uint128_t r2, uint128_t r3, uint128_t r4)
+{
+    uint64_t h0, h1, h2, h3, h4, carry;
+
+    h0 = (uint64_t)r0 & mask51;
+    r1 += (uint64_t)(r0 >> 51);
+    h1 = (uint64_t)r1 & mask51;
+    r2 += (uint64_t)(r1 >> 51);
+    h2 = (uint64_t)r2 & mask51;
+    r3 += (uint64_t)(r2 >> 51);
+    h3 = (uint64_t)r3 & mask51;
+    r4 += (uint64_t)(r3 >> 51);
+    h4 = (uint64_t)r4 & mask51;
+    carry = (uint64_t)(r4 >> 51);
+
+    h0 += 19 * carry;
+    carry = h0 >> 51;
+    h0 &= mask51;
+    h1 += carry;
+    carry = h1 >> 51;
+    h1 &= mask51;
+    h2 += carry;
+
+    h[0] = h0;
+    h[1] = h1;
+    h[2] = h2;
+    h[3] = h3;
+    h[4] = h4;
+}
+
+/* h = f * g */
+static void fe51_mul(fe51 h, const fe51 f, const fe51 g)
+{
+    const uint64_t f0 = f[0];
+    const uint64_t f1 = f[1];
+    const uint64_t f2 = f[2];
+    const uint64_t f3 = f[3];
+    const uint64_t f4 = f[4];
+    const uint64_t g0 = g[0];
+    const uint64_t g1 = g[1];
+    const uint64_t g2 = g[2];
+    const uint64_t g3 = g[3];
+    const uint64_t g4 = g[4];
+
+    /* 2^255 = 19 mod p, so the columns past the top wrap around times 19 */
+    const uint64_t g1_19 = 19 * g1;
+    const uint64_t g2_19 = 19 * g2;
+    const uint64_t g3_19 = 19 * g3;
+    const uint64_t g4_19 = 19 * g4;
+
+    const uint128_t r0 = (uint128_t)f0 * g0 + (uint128_t)f1 * g4_19 + (uint128_t)f2 * g3_19 + (uint128_t)f3 * g2_19
+                         + (uint128_t)f4 * g1_19;
+    const uint128_t r1 = (uint128_t)f0 * g1 + (uint128_t)f1 * g0 + (uint128_t)f2 * g4_19 + (uint128_t)f3 * g3_19
+                         + (uint128_t)f4 * g2_19;
+    const uint128_t r2 = (uint128_t)f0 * g2 + (uint128_t)f1 * g1 + (uint128_t)f2 * g0 + (uint128_t)f3 * g4_19
+                         + (uint128_t)f4 * g3_19;
+    const uint128_t r3 = (uint128_t)f0 * g3 + (uint128_t)f1 * g2 + (uint128_t)f2 * g1 + (uint128_t)f3 * g0
+                         + (uint128_t)f4 * g4_19;
+    const uint128_t r4 = (uint128_t)f0 * g4 + (uint128_t)f1 * g3 + (uint128_t)f2 * g2 + (uint128_t)f3 * g1
+                         + (uint128_t)f4 * g0;
+
+    fe51_carry_wide(h, r0, r1, r2, r3, r4);
+}
+
+/* h = f * f */
+static void fe51_sq(fe51 h, const fe51 f)
+{
+    const uint64_t f0 = f[0];
+    const uint64_t f1 = f[1];
+    const uint64_t f2 = f[2];
+    const uint64_t f3 = f[3];
+    const uint64_t f4 = f[4];
+
+    const uint64_t f0_2 = 2 * f0;
+    const uint64_t f1_2 = 2 * f1;
+    const uint64_t f1_38 = 38 * f1;
+    const uint64_t f2_38 = 38 * f2;
+    const uint64_t f3_38 = 38 * f3;
+    const uint64_t f3_19 = 19 * f3;
+    const uint64_t f4_19 = 19 * f4;
+
+    const uint128_t r0 = (uint128_t)f0 * f0 + (uint128_t)f1_38 * f4 + (uint128_t)f2_38 * f3;
+    const uint128_t r1 = (uint128_t)f0_2 * f1 + (uint128_t)f2_38 * f4 + (uint128_t)f3_19 * f3;
+    const uint128_t r2 = (uint128_t)f0_2 * f2 + (uint128_t)f1 * f1 + (uint128_t)f3_38 * f4;
+    const uint128_t r3 = (uint128_t)f0_2 * f3 + (uint128_t)f1_2 * f2 + (uint128_t)f4_19 * f4;
+    const uint128_t r4 = (uint128_t)f0_2 * f4 + (uint128_t)f1_2 * f3 + (uint128_t)f2 * f2;
+
+    fe51_carry_wide(h, r0, r1, r2, r3, r4);
+}
+
+/* h = 2 * f * f */
+static void fe51_sq2(fe51 h, const fe51 f)
+{
+    fe51_sq(h, f);
+    fe51_add(h, h, h);
+}
+
+/* Ignores the top bit, like fe_frombytes() */
+static void fe51_frombytes(fe51 h, const unsigned char *s)
+{
+    h[0] = load_8(s) & mask51;
+    h[1] = (load_8(s + 6) >> 3) & mask51;
+    h[2] = (load_8(s + 12) >> 6) & mask51;
+    h[3] = (load_8(s + 19) >> 1) & mask51;
+    h[4] = (load_8(s + 24) >> 12) & mask51;
+}
+
+/* Fully reduces h, to the unique representative below p */
+static void fe51_reduce(fe51 h, const fe51 f)
+{
+    uint64_t h0 = f[0];
+    uint64_t h1 = f[1];
+    uint64_t h2 = f[2];
+    uint64_t h3 = f[3];
+    uint64_t h4 = f[4];
+    int i;
+
+    /* Twice, to get every limb below 2^51, so h < 2^255 */
+    for (i = 0; i < 2; i++)
+    {
+        h1 += h0 >> 51;
+        h0 &= mask51;
+        h2 += h1 >> 51;
+        h1 &= mask51;
+        h3 += h2 >> 51;
+        h2 &= mask51;
+        h4 += h3 >> 51;
+        h3 &= mask51;
+        h0 += 19 * (h4 >> 51);
+        h4 &= mask51;
+    }
+
+    /* Work out whether h >= p, by seeing if h + 19 carries past 2^255 */
+    uint64_t q = (h0 + 19) >> 51;
+    q = (h1 + q) >> 51;
+    q = (h2 + q) >> 51;
+    q = (h3 + q) >> 51;
+    q = (h4 + q) >> 51;
+
+    /* If so, h - p = h + 19 - 2^255 */
+    h0 += 19 * q;
+
+    h1 += h0 >> 51;
+    h0 &= mask51;
+    h2 += h1 >> 51;
+    h1 &= mask51;
+    h3 += h2 >> 51;
+    h2 &= mask51;
+    h4 += h3 >> 51;
+    h3 &= mask51;
+    h4 &= mask51;
+
+    h[0] = h0;
+    h[1] = h1;
+    h[2] = h2;
+    h[3] = h3;
+    h[4] = h4;
+}
+
+static void fe51_tobytes(unsigned char *s, const fe51 f)
+{
+    fe51 h;
+    fe51_reduce(h, f);
+
+    store_8(s, h[0] | (h[1] << 51));
+    store_8(s + 8, (h[1] >> 13) | (h[2] << 38));
+    store_8(s + 16, (h[2] >> 26) | (h[3] << 25));
+    store_8(s + 24, (h[3] >> 39) | (h[4] << 12));
+}
+
+static int fe51_isnegative(const fe51 f)
+{
+    fe51 h;
+    fe51_reduce(h, f);
+    return h[0] & 1;
+}
+
+static int fe51_isnonzero(const fe51 f)
+{
+    fe51 h;
+    fe51_reduce(h, f);
+    return (h[0] | h[1] | h[2] | h[3] | h[4]) != 0;
+}
+
+/* As fe_invert(), z^(p-2) */
+static void fe51_invert(fe51 out, const fe51 z)
+{
+    fe51 t0;
+    fe51 t1;
+    fe51 t2;
+    fe51 t3;
+    int i;
+
+    fe51_sq(t0, z);
+    fe51_sq(t1, t0);
+    fe51_sq(t1, t1);
+    fe51_mul(t1, z, t1);
+    fe51_mul(t0, t0, t1);
+    fe51_sq(t2, t0);
+    fe51_mul(t1, t1, t2);
+    fe51_sq(t2, t1);
+    for (i = 0; i < 4; ++i)
+    {
+        fe51_sq(t2, t2);
+    }
+    fe51_mul(t1, t2, t1);
+    fe51_sq(t2, t1);
+    for (i = 0; i < 9; ++i)
+    {
+        fe51_sq(t2, t2);
+    }
+    fe51_mul(t2, t2, t1);
+    fe51_sq(t3, t2);
+    for (i = 0; i < 19; ++i)
+    {
+        fe51_sq(t3, t3);
+    }
+    fe51_mul(t2, t3, t2);
+    fe51_sq(t2, t2);
+    for (i = 0; i < 9; ++i)
+    {
+        fe51_sq(t2, t2);
+    }
+    fe51_mul(t1, t2, t1);
+    fe51_sq(t2, t1);
+    for (i = 0; i < 49; ++i)
+    {
+        fe51_sq(t2, t2);
+    }
+    fe51_mul(t2, t2, t1);
+    fe51_sq(t3, t2);
+    for (i = 0; i < 99; ++i)
+    {
+        fe51_sq(t3, t3);
+    }
+    fe51_mul(t2, t3, t2);
+    fe51_sq(t2, t2);
+    for (i = 0; i < 49; ++i)
+    {
+        fe51_sq(t2, t2);
+    }
+    fe51_mul(t1, t2, t1);
+    fe51_sq(t1, t1);
+    for (i = 0; i < 4; ++i)
+    {
+        fe51_sq(t1, t1);
+    }
+    fe51_mul(out, t1, t0);
+}
+
+/* As fe_divpowm1(), r = uv^3(uv^7)^((p-5)/8) */
+static void fe51_divpowm1(fe51 r, const fe51 u, const fe51 v)
+{
+    fe51 v3, uv7, t0, t1, t2;
+    int i;
+
+    fe51_sq(v3, v);
+    fe51_mul(v3, v3, v); /* v3 = v^3 */
+    fe51_sq(uv7, v3);
+    fe51_mul(uv7, uv7, v);
+    fe51_mul(uv7, uv7, u); /* uv7 = uv^7 */
+
+    fe51_sq(t0, uv7);
+    fe51_sq(t1, t0);
+    fe51_sq(t1, t1);
+    fe51_mul(t1, uv7, t1);
+    fe51_mul(t0, t0, t1);
+    fe51_sq(t0, t0);
+    fe51_mul(t0, t1, t0);
+    fe51_sq(t1, t0);
+    for (i = 0; i < 4; ++i)
+    {
+        fe51_sq(t1, t1);
+    }
+    fe51_mul(t0, t1, t0);
+    fe51_sq(t1, t0);
+    for (i = 0; i < 9; ++i)
+    {
+        fe51_sq(t1, t1);
+    }
+    fe51_mul(t1, t1, t0);
+    fe51_sq(t2, t1);
+    for (i = 0; i < 19; ++i)
+    {
+        fe51_sq(t2, t2);
+    }
+    fe51_mul(t1, t2, t1);
+    for (i = 0; i < 10; ++i)
+    {
+        fe51_sq(t1, t1);
+    }
+    fe51_mul(t0, t1, t0);
+    fe51_sq(t1, t0);
+    for (i = 0; i < 49; ++i)
+    {
+        fe51_sq(t1, t1);
+    }
+    fe51_mul(t1, t1, t0);
+    fe51_sq(t2, t1);
+    for (i = 0; i < 99; ++i)
+    {
+        fe51_sq(t2, t2);
+    }
+    fe51_mul(t1, t2, t1);
+    for (i = 0; i < 50; ++i)
+    {
+        fe51_sq(t1, t1);
+    }
+    fe51_mul(t0, t1, t0);
+    fe51_sq(t0, t0);
+    fe51_sq(t0, t0);
+    fe51_mul(t0, t0, uv7);
+
+    /* t0 = (uv^7)^((p-5)/8) */
+    fe51_mul(t0, t0, v3);
+    fe51_mul(r, t0, u);
+}
+
+/* Group operations, as in crypto-ops.c */
+
+static void ge51_p2_0(ge51_p2 *h)
+{
+    fe51_0(h->X);
+    fe51_1(h->Y);
+    fe51_1(h->Z);
+}
+
+static void ge51_p3_0(ge51_p3 *h)
+{
+    fe51_0(h->X);
+    fe51_1(h->Y);
+    fe51_1(h->Z);
+    fe51_0(h->T);
+}
+
+static void ge51_precomp_0(ge51_precomp *h)
+{
+    fe51_1(h->yplusx);
+    fe51_1(h->yminusx);
+    fe51_0(h->xy2d);
+}
+
+static void ge51_cached_0(ge51_cached *r)
+{
+    fe51_1(r->YplusX);
+    fe51_1(r->YminusX);
+    fe51_1(r->Z);
+    fe51_0(r->T2d);
+}
+
+int ge51_frombytes_vartime(ge51_p3 *h, const unsigned char *s)
+{
+    fe51 u;
+    fe51 v;
+    fe51 vxx;
+    fe51 check;
+
+    fe51_frombytes(h->Y, s);
+
+    /* Validate the number to be canonical */
+    if (h->Y[4] == mask51 && h->Y[3] == mask51 && h->Y[2] == mask51 && h->Y[1] == mask51
+        && h->Y[0] >= mask51 - 18)
+    {
+        return -1;
+    }
+
+    fe51_1(h->Z);
+    fe51_sq(u, h->Y);
+    fe51_mul(v, u, fe51_d);
+    fe51_sub(u, u, h->Z); /* u = y^2-1 */
+    fe51_add(v, v, h->Z); /* v = dy^2+1 */
+
+    fe51_divpowm1(h->X, u, v); /* x = uv^3(uv^7)^((q-5)/8) */
+
+    fe51_sq(vxx, h->X);
+    fe51_mul(vxx, vxx, v);
+    fe51_sub(check, vxx, u); /* vx^2-u */
+    if (fe51_isnonzero(check))
+    {
+        fe51_add(check, vxx, u); /* vx^2+u */
+        if (fe51_isnonzero(check))
+        {
+            return -1;
+        }
+        fe51_mul(h->X, h->X, fe51_sqrtm1);
+    }
+
+    if (fe51_isnegative(h->X) != (s[31] >> 7))
+    {
+        /* If x = 0, the sign must be positive */
+        if (!fe51_isnonzero(h->X))
+        {
+            return -1;
+        }
+        fe51_neg(h->X, h->X);
+    }
+
+    fe51_mul(h->T, h->X, h->Y);
+    return 0;
+}
+
+void ge51_add(ge51_p1p1 *r, const ge51_p3 *p, const ge51_cached *q)
+{
+    fe51 t0;
+    fe51_add(r->X, p->Y, p->X);
+    fe51_sub(r->Y, p->Y, p->X);
+    fe51_mul(r->Z, r->X, q->YplusX);
+    fe51_mul(r->Y, r->Y, q->YminusX);
+    fe51_mul(r->T, q->T2d, p->T);
+    fe51_mul(r->X, p->Z, q->Z);
+    fe51_add(t0, r->X, r->X);
+    fe51_sub(r->X, r->Z, r->Y);
+    fe51_add(r->Y, r->Z, r->Y);
+    fe51_add(r->Z, t0, r->T);
+    fe51_sub(r->T, t0, r->T);
+}
+
+void ge51_sub(ge51_p1p1 *r, const ge51_p3 *p, const ge51_cached *q)
+{
+    fe51 t0;
+    fe51_add(r->X, p->Y, p->X);
+    fe51_sub(r->Y, p->Y, p->X);
+    fe51_mul(r->Z, r->X, q->YminusX);
+    fe51_mul(r->Y, r->Y, q->YplusX);
+    fe51_mul(r->T, q->T2d, p->T);
+    fe51_mul(r->X, p->Z, q->Z);
+    fe51_add(t0, r->X, r->X);
+    fe51_sub(r->X, r->Z, r->Y);
+    fe51_add(r->Y, r->Z, r->Y);
+    fe51_sub(r->Z, t0, r->T);
+    fe51_add(r->T, t0, r->T);
+}
+
+static void ge51_madd(ge51_p1p1 *r, const ge51_p3 *p, const ge51_precomp *q)
+{
+    fe51 t0;
+    fe51_add(r->X, p->Y, p->X);
+    fe51_sub(r->Y, p->Y, p->X);
+    fe51_mul(r->Z, r->X, q->yplusx);
+    fe51_mul(r->Y, r->Y, q->yminusx);
+    fe51_mul(r->T, q->xy2d, p->T);
+    fe51_add(t0, p->Z, p->Z);
+    fe51_sub(r->X, r->Z, r->Y);
+    fe51_add(r->Y, r->Z, r->Y);
+    fe51_add(r->Z, t0, r->T);
+    fe51_sub(r->T, t0, r->T);
+}
+
+void ge51_p1p1_to_p2(ge51_p2 *r, const ge51_p1p1 *p)
+{
+    fe51_mul(r->X, p->X, p->T);
+    fe51_mul(r->Y, p->Y, p->Z);
+    fe51_mul(r->Z, p->Z, p->T);
+}
+
+static void ge51_p1p1_to_p3(ge51_p3 *r, const ge51_p1p1 *p)
+{
+    fe51_mul(r->X, p->X, p->T);
+    fe51_mul(r->Y, p->Y, p->Z);
+    fe51_mul(r->Z, p->Z, p->T);
+    fe51_mul(r->T, p->X, p->Y);
+}
+
+static void ge51_p2_dbl(ge51_p1p1 *r, const ge51_p2 *p)
+{
+    fe51 t0;
+    fe51_sq(r->X, p->X);
+    fe51_sq(r->Z, p->Y);
+    fe51_sq2(r->T, p->Z);
+    fe51_add(r->Y, p->X, p->Y);
+    fe51_sq(t0, r->Y);
+    fe51_add(r->Y, r->Z, r->X);
+    fe51_sub(r->Z, r->Z, r->X);
+    fe51_sub(r->X, t0, r->Y);
+    fe51_sub(r->T, r->T, r->Z);
+}
+
+static void ge51_p3_to_p2(ge51_p2 *r, const ge51_p3 *p)
+{
+    fe51_copy(r->X, p->X);
+    fe51_copy(r->Y, p->Y);
+    fe51_copy(r->Z, p->Z);
+}
+
+static void ge51_p3_dbl(ge51_p1p1 *r, const ge51_p3 *p)
+{
+    ge51_p2 q;
+    ge51_p3_to_p2(&q, p);
+    ge51_p2_dbl(r, &q);
+}
+
+void ge51_p3_to_cached(ge51_cached *r, const ge51_p3 *p)
+{
+    fe51_add(r->YplusX, p->Y, p->X);
+    fe51_sub(r->YminusX, p->Y, p->X);
+    fe51_copy(r->Z, p->Z);
+    fe51_mul(r->T2d, p->T, fe51_d2);
+}
+
+void ge51_mul8(ge51_p1p1 *r, const ge51_p2 *t)
+{
+    ge51_p2 u;
+    ge51_p2_dbl(r, t);
+    ge51_p1p1_to_p2(&u, r);
+    ge51_p2_dbl(r, &u);
+    ge51_p1p1_to_p2(&u, r);
+    ge51_p2_dbl(r, &u);
+}
+
+void ge51_tobytes(unsigned char *s, const ge51_p2 *h)
+{
+    fe51 recip;
+    fe51 x;
+    fe51 y;
+
+    fe51_invert(recip, h->Z);
+    fe51_mul(x, h->X, recip);
+    fe51_mul(y, h->Y, recip);
+    fe51_tobytes(s, y);
+    s[31] ^= fe51_isnegative(x) << 7;
+}
+
+/* As ge_tobytes_batch(), sharing one inversion between all the points */
+void ge51_tobytes_batch(unsigned char *s, const ge51_p2 *h, fe51 *scratch, size_t count)
+{
+    fe51 inverse;
+    fe51 recip;
+    fe51 x;
+    fe51 y;
+    size_t i;
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    /* scratch[i] = Z0 * Z1 * ... * Zi */
+    fe51_copy(scratch[0], h[0].Z);
+
+    for (i = 1; i < count; i++)
+    {
+        fe51_mul(scratch[i], scratch[i - 1], h[i].Z);
+    }
+
+    fe51_invert(inverse, scratch[count - 1]);
+
+    for (i = count - 1; i > 0; i--)
+    {
+        /* inverse holds 1 / (Z0 * ... * Zi) here */
+        fe51_mul(recip, inverse, scratch[i - 1]);
+        fe51_mul(inverse, inverse, h[i].Z);
+
+        fe51_mul(x, h[i].X, recip);
+        fe51_mul(y, h[i].Y, recip);
+        fe51_tobytes(s + 32 * i, y);
+        s[32 * i + 31] ^= fe51_isnegative(x) << 7;
+    }
+
+    fe51_mul(x, h[0].X, inverse);
+    fe51_mul(y, h[0].Y, inverse);
+    fe51_tobytes(s, y);
+    s[31] ^= fe51_isnegative(x) << 7;
+}
+
+/* Scalar multiplication */
+
+static unsigned char equal(signed char b, signed char c)
+{
+    unsigned char ub = b;
+    unsigned char uc = c;
+    unsigned char x = ub ^ uc; /* 0: yes; 1..255: no */
+    uint32_t y = x; /* 0: yes; 1..255: no */
+    y -= 1; /* 4294967295: yes; 0..254: no */
+    y >>= 31; /* 1: yes; 0: no */
+    return y;
+}
+
+static unsigned char negative(signed char b)
+{
+    unsigned long long x = b; /* 18446744073709551361..18446744073709551615: yes; 0..255: no */
+    x >>= 63; /* 1: yes; 0: no */
+    return (unsigned char)x;
+}
+
+static void ge51_precomp_cmov(ge51_precomp *t, const ge51_precomp *u, unsigned char b)
+{
+    fe51_cmov(t->yplusx, u->yplusx, b);
+    fe51_cmov(t->yminusx, u->yminusx, b);
+    fe51_cmov(t->xy2d, u->xy2d, b);
+}
+
+static void ge51_cached_cmov(ge51_cached *t, const ge51_cached *u, unsigned char b)
+{
+    fe51_cmov(t->YplusX, u->YplusX, b);
+    fe51_cmov(t->YminusX, u->YminusX, b);
+    fe51_cmov(t->Z, u->Z, b);
+    fe51_cmov(t->T2d, u->T2d, b);
+}
+
+/* t = b * 256^pos * B, reading every entry of the row so the lookup takes
+   the same time whatever b is */
+static void select_base(ge51_precomp *t, int pos, signed char b)
+{
+    ge51_precomp minust;
+    unsigned char bnegative = negative(b);
+    unsigned char babs = b - (((-bnegative) & b) << 1);
+    int i;
+
+    ge51_precomp_0(t);
+    for (i = 0; i < 8; i++)
+    {
+        ge51_precomp_cmov(t, &ge51_base[pos][i], equal(babs, i + 1));
+    }
+    fe51_copy(minust.yplusx, t->yminusx);
+    fe51_copy(minust.yminusx, t->yplusx);
+    fe51_neg(minust.xy2d, t->xy2d);
+    ge51_precomp_cmov(t, &minust, bnegative);
+}
+
+/* h = a * B, assumes that a[31] <= 127 */
+void ge51_scalarmult_base(ge51_p3 *h, const unsigned char *a)
+{
+    signed char e[64];
+    signed char carry;
+    ge51_p1p1 r;
+    ge51_p2 s;
+    ge51_precomp t;
+    int i;
+
+    for (i = 0; i < 32; ++i)
+    {
+        e[2 * i + 0] = (a[i] >> 0) & 15;
+        e[2 * i + 1] = (a[i] >> 4) & 15;
+    }
+    /* each e[i] is between 0 and 15 */
+    /* e[63] is between 0 and 7 */
+
+    carry = 0;
+    for (i = 0; i < 63; ++i)
+    {
+        e[i] += carry;
+        carry = e[i] + 8;
+        carry >>= 4;
+        e[i] -= carry << 4;
+    }
+    e[63] += carry;
+    /* each e[i] is between -8 and 8 */
+
+    ge51_p3_0(h);
+    for (i = 1; i < 64; i += 2)
+    {
+        select_base(&t, i / 2, e[i]);
+        ge51_madd(&r, h, &t);
+        ge51_p1p1_to_p3(h, &r);
+    }
+
+    ge51_p3_dbl(&r, h);
+    ge51_p1p1_to_p2(&s, &r);
+    ge51_p2_dbl(&r, &s);
+    ge51_p1p1_to_p2(&s, &r);
+    ge51_p2_dbl(&r, &s);
+    ge51_p1p1_to_p2(&s, &r);
+    ge51_p2_dbl(&r, &s);
+    ge51_p1p1_to_p3(h, &r);
+
+    for (i = 0; i < 64; i += 2)
+    {
+        select_base(&t, i / 2, e[i]);
+        ge51_madd(&r, h, &t);
+        ge51_p1p1_to_p3(h, &r);
+    }
+}
+
+/* r = a * A, assumes that a[31] <= 127 */
+void ge51_scalarmult(ge51_p2 *r, const unsigned char *a, const ge51_p3 *A)
+{
+    signed char e[64];
+    int carry, carry2, i, j;
+    ge51_cached Ai[8]; /* 1 * A, 2 * A, ..., 8 * A */
+    ge51_p1p1 t;
+    ge51_p3 u;
+
+    carry = 0; /* 0..1 */
+    for (i = 0; i < 31; i++)
+    {
+        carry += a[i]; /* 0..256 */
+        carry2 = (carry + 8) >> 4; /* 0..16 */
+        e[2 * i] = carry - (carry2 << 4); /* -8..7 */
+        carry = (carry2 + 8) >> 4; /* 0..1 */
+        e[2 * i + 1] = carry2 - (carry << 4); /* -8..7 */
+    }
+    carry += a[31]; /* 0..128 */
+    carry2 = (carry + 8) >> 4; /* 0..8 */
+    e[62] = carry - (carry2 << 4); /* -8..7 */
+    e[63] = carry2; /* 0..8 */
+
+    ge51_p3_to_cached(&Ai[0], A);
+    for (i = 0; i < 7; i++)
+    {
+        ge51_add(&t, A, &Ai[i]);
+        ge51_p1p1_to_p3(&u, &t);
+        ge51_p3_to_cached(&Ai[i + 1], &u);
+    }
+
+    ge51_p2_0(r);
+    for (i = 63; i >= 0; i--)
+    {
+        signed char b = e[i];
+        unsigned char bnegative = negative(b);
+        unsigned char babs = b - (((-bnegative) & b) << 1);
+        ge51_cached cur, minuscur;
+        ge51_p2_dbl(&t, r);
+        ge51_p1p1_to_p2(r, &t);
+        ge51_p2_dbl(&t, r);
+        ge51_p1p1_to_p2(r, &t);
+        ge51_p2_dbl(&t, r);
+        ge51_p1p1_to_p2(r, &t);
+        ge51_p2_dbl(&t, r);
+        ge51_p1p1_to_p3(&u, &t);
+        ge51_cached_0(&cur);
+        for (j = 0; j < 8; j++)
+        {
+            ge51_cached_cmov(&cur, &Ai[j], equal(babs, j + 1));
+        }
+        fe51_copy(minuscur.YplusX, cur.YminusX);
+        fe51_copy(minuscur.YminusX, cur.YplusX);
+        fe51_copy(minuscur.Z, cur.Z);
+        fe51_neg(minuscur.T2d, cur.T2d);
+        ge51_cached_cmov(&cur, &minuscur, bnegative);
+        ge51_add(&t, &u, &cur);
+        ge51_p1p1_to_p2(r, &t);
+    }
+}
+
+#endif
@@ -0,0 +1,92 @@
+// Copyright (c) 2018-2020, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* The group operations wallet scanning spends its time in, on a field
+   element of five 51 bit limbs rather than ref10's ten 25/26 bit limbs.
+   Multiplying two of these takes 25 64x64->128 bit multiplications instead
+   of 100 32x32->64 bit ones, so this is only built where the compiler gives
+   us a 128 bit integer. Elsewhere, CRYPTO_OPS_51 isn't defined, and the
+   callers use the ref10 versions in crypto-ops.h.
+
+   The functions behave exactly like their ge_ counterparts. */
+
+#if defined(__SIZEOF_INT128__)
+
+#define CRYPTO_OPS_51 1
+
+typedef uint64_t fe51[5];
+
+typedef struct
+{
+    fe51 X;
+    fe51 Y;
+    fe51 Z;
+} ge51_p2;
+
+typedef struct
+{
+    fe51 X;
+    fe51 Y;
+    fe51 Z;
+    fe51 T;
+} ge51_p3;
+
+typedef struct
+{
+    fe51 X;
+    fe51 Y;
+    fe51 Z;
+    fe51 T;
+} ge51_p1p1;
+
+typedef struct
+{
+    fe51 yplusx;
+    fe51 yminusx;
+    fe51 xy2d;
+} ge51_precomp;
+
+typedef struct
+{
+    fe51 YplusX;
+    fe51 YminusX;
+    fe51 Z;
+    fe51 T2d;
+} ge51_cached;
+
+extern const fe51 fe51_d;
+
+extern const fe51 fe51_d2;
+
+extern const fe51 fe51_sqrtm1;
+
+/* base[i][j] = (j+1)*256^i*B */
+extern const ge51_precomp ge51_base[32][8];
+
+int ge51_frombytes_vartime(ge51_p3 *, const unsigned char *);
+
+void ge51_p1p1_to_p2(ge51_p2 *, const ge51_p1p1 *);
+
+void ge51_p3_to_cached(ge51_cached *, const ge51_p3 *);
+
+void ge51_add(ge51_p1p1 *, const ge51_p3 *, const ge51_cached *);
+
+void ge51_sub(ge51_p1p1 *, const ge51_p3 *, const ge51_cached *);
+
+void ge51_scalarmult(ge51_p2 *, const unsigned char *, const ge51_p3 *);
+
+void ge51_scalarmult_base(ge51_p3 *, const unsigned char *);
+
+void ge51_mul8(ge51_p1p1 *, const ge51_p2 *);
+
+void ge51_tobytes(unsigned char *, const ge51_p2 *);
+
+void ge51_tobytes_batch(unsigned char *, const ge51_p2 *, fe51 *, size_t);
+
+#endif
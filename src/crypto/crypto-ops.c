@@ -1811,6 +1811,53 @@ void ge_tobytes(unsigned char *s, const ge_p2 *h)
     s[31] ^= fe_isnegative(x) << 7;
 }
 
+/* New code */
+
+/* As ge_tobytes, for count points at once. The field inversion is by far
+   the most expensive part of encoding a point, so we use Montgomery's trick
+   to share a single inversion between all of them. scratch must have room
+   for count field elements. */
+void ge_tobytes_batch(unsigned char *s, const ge_p2 *h, fe *scratch, size_t count)
+{
+    fe inverse;
+    fe recip;
+    fe x;
+    fe y;
+    size_t i;
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    /* scratch[i] = Z0 * Z1 * ... * Zi */
+    fe_copy(scratch[0], h[0].Z);
+
+    for (i = 1; i < count; i++)
+    {
+        fe_mul(scratch[i], scratch[i - 1], h[i].Z);
+    }
+
+    fe_invert(inverse, scratch[count - 1]);
+
+    for (i = count - 1; i > 0; i--)
+    {
+        /* inverse holds 1 / (Z0 * ... * Zi) here */
+        fe_mul(recip, inverse, scratch[i - 1]);
+        fe_mul(inverse, inverse, h[i].Z);
+
+        fe_mul(x, h[i].X, recip);
+        fe_mul(y, h[i].Y, recip);
+        fe_tobytes(s + 32 * i, y);
+        s[32 * i + 31] ^= fe_isnegative(x) << 7;
+    }
+
+    fe_mul(x, h[0].X, inverse);
+    fe_mul(y, h[0].Y, inverse);
+    fe_tobytes(s, y);
+    s[31] ^= fe_isnegative(x) << 7;
+}
+
 /* From sc_reduce.c */
 
 /*
@@ -18,6 +18,16 @@
 
 namespace Crypto
 {
+    /* An output to underive as part of a batch, see underive_public_keys() */
+    struct UnderiveRequest
+    {
+        KeyDerivation derivation;
+
+        size_t outputIndex;
+
+        PublicKey derivedKey;
+    };
+
     class crypto_ops
     {
         crypto_ops();
@@ -126,6 +136,12 @@ namespace Crypto
         friend bool
             underive_public_key(const KeyDerivation &, size_t, const PublicKey &, const uint8_t *, size_t, PublicKey &);
 
+        static void
+            underive_public_keys(const std::vector<UnderiveRequest> &, std::vector<PublicKey> &, std::vector<bool> &);
+
+        friend void
+            underive_public_keys(const std::vector<UnderiveRequest> &, std::vector<PublicKey> &, std::vector<bool> &);
+
         static void generate_signature(const Hash &, const PublicKey &, const SecretKey &, Signature &);
 
         friend void generate_signature(const Hash &, const PublicKey &, const SecretKey &, Signature &);
@@ -186,8 +202,8 @@ namespace Crypto
         static bool checkRingSignature(
             const Hash &prefix_hash,
             const KeyImage &image,
-            const std::vector<PublicKey> pubs,
-            const std::vector<Signature> signatures);
+            const std::vector<PublicKey> &pubs,
+            const std::vector<Signature> &signatures);
 
         static void generateViewFromSpend(const Crypto::SecretKey &spend, Crypto::SecretKey &viewSecret);
 
@@ -363,6 +379,19 @@ namespace Crypto
         return crypto_ops::underive_public_key(derivation, output_index, derived_key, base);
     }
 
+    /* Batch version of underive_public_key(), for scanning many outputs at
+     * once. The encoding of the results shares a single field inversion, so
+     * this is considerably faster per output. valid[i] is false, and
+     * bases[i] unspecified, if requests[i].derivedKey is not a valid point.
+     */
+    inline void underive_public_keys(
+        const std::vector<UnderiveRequest> &requests,
+        std::vector<PublicKey> &bases,
+        std::vector<bool> &valid)
+    {
+        crypto_ops::underive_public_keys(requests, bases, valid);
+    }
+
     /* Generation and checking of a standard signature.
      */
     inline void generate_signature(const Hash &prefix_hash, const PublicKey &pub, const SecretKey &sec, Signature &sig)
@@ -7,8 +7,6 @@
 
 #pragma once
 
-#include "argon2.h"
-
 #include <CryptoTypes.h>
 #include <stddef.h>
 
@@ -59,8 +57,6 @@ namespace Crypto
 #include "hash-ops.h"
     }
 
-    static bool argon2_optimization_selected = false;
-
     /*
       Cryptonight hash functions
     */
@@ -363,26 +359,9 @@ namespace Crypto
         cn_slow_hash(data, length, reinterpret_cast<char *>(&hash), 1, 2, 0, pagesize, scratchpad, iterations);
     }
 
-    inline void chukwa_slow_hash(const void *data, size_t length, Hash &hash)
-    {
-        uint8_t salt[CHUKWA_SALTLEN];
-        memcpy(salt, data, sizeof(salt));
-
-        /* If this is the first time we've called this hash function then
-           we need to have the Argon2 library check to see if any of the
-           available CPU instruction sets are going to help us out */
-        if (!argon2_optimization_selected)
-        {
-            /* Call the library quick benchmark test to set which CPU
-               instruction sets will be used */
-            argon2_select_impl(NULL, NULL);
-
-            argon2_optimization_selected = true;
-        }
-
-        argon2id_hash_raw(
-            CHUKWA_ITERS, CHUKWA_MEMORY, CHUKWA_THREADS, data, length, salt, CHUKWA_SALTLEN, hash.data, CHUKWA_HASHLEN);
-    }
+    /* Argon2id with the Chukwa parameters. Each thread reuses the same
+       Argon2 memory for every hash it does, see chukwa.cpp. */
+    void chukwa_slow_hash(const void *data, size_t length, Hash &hash);
 
     inline void tree_hash(const Hash *hashes, size_t count, Hash &root_hash)
     {
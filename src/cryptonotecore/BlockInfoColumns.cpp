@@ -0,0 +1,235 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include <cassert>
+#include <cryptonotecore/BlockInfoColumns.h>
+#include <cstring>
+#include <limits>
+
+namespace CryptoNote
+{
+    namespace
+    {
+        const uint32_t COLUMNS_FORMAT_VERSION = 1;
+
+        template<typename T> void writePod(std::string &out, const T &value)
+        {
+            out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        template<typename T> bool readPod(const std::string &in, size_t &offset, T &value)
+        {
+            if (in.size() < offset + sizeof(value))
+            {
+                return false;
+            }
+
+            std::memcpy(&value, in.data() + offset, sizeof(value));
+            offset += sizeof(value);
+
+            return true;
+        }
+
+        void writeColumn(std::string &out, const std::vector<uint64_t> &column)
+        {
+            out.append(reinterpret_cast<const char *>(column.data()), column.size() * sizeof(uint64_t));
+        }
+
+        bool readColumn(const std::string &in, size_t &offset, const uint64_t count, std::vector<uint64_t> &column)
+        {
+            if ((in.size() - offset) / sizeof(uint64_t) < count)
+            {
+                return false;
+            }
+
+            column.resize(count);
+            std::memcpy(column.data(), in.data() + offset, count * sizeof(uint64_t));
+            offset += count * sizeof(uint64_t);
+
+            return true;
+        }
+    } // namespace
+
+    BlockInfoColumns::BlockInfoColumns(const uint32_t firstIndex): m_firstIndex(firstIndex) {}
+
+    uint32_t BlockInfoColumns::firstIndex() const
+    {
+        return m_firstIndex;
+    }
+
+    uint32_t BlockInfoColumns::endIndex() const
+    {
+        return m_firstIndex + static_cast<uint32_t>(m_timestamps.size());
+    }
+
+    bool BlockInfoColumns::empty() const
+    {
+        return m_timestamps.empty();
+    }
+
+    bool BlockInfoColumns::contains(const uint32_t blockIndex) const
+    {
+        return blockIndex >= m_firstIndex && blockIndex < endIndex();
+    }
+
+    void BlockInfoColumns::push(const CachedBlockInfo &info)
+    {
+        m_timestamps.push_back(info.timestamp);
+        m_cumulativeDifficulties.push_back(info.cumulativeDifficulty);
+        m_blockSizes.push_back(info.blockSize);
+        m_alreadyGeneratedCoins.push_back(info.alreadyGeneratedCoins);
+        m_alreadyGeneratedTransactions.push_back(info.alreadyGeneratedTransactions);
+    }
+
+    void BlockInfoColumns::truncate(const uint32_t blockIndex)
+    {
+        if (blockIndex <= m_firstIndex)
+        {
+            clear(blockIndex);
+            return;
+        }
+
+        if (blockIndex >= endIndex())
+        {
+            return;
+        }
+
+        const size_t count = blockIndex - m_firstIndex;
+
+        m_timestamps.resize(count);
+        m_cumulativeDifficulties.resize(count);
+        m_blockSizes.resize(count);
+        m_alreadyGeneratedCoins.resize(count);
+        m_alreadyGeneratedTransactions.resize(count);
+    }
+
+    void BlockInfoColumns::clear(const uint32_t firstIndex)
+    {
+        m_firstIndex = firstIndex;
+
+        m_timestamps.clear();
+        m_cumulativeDifficulties.clear();
+        m_blockSizes.clear();
+        m_alreadyGeneratedCoins.clear();
+        m_alreadyGeneratedTransactions.clear();
+    }
+
+    CachedBlockInfo BlockInfoColumns::infoAt(const uint32_t blockIndex) const
+    {
+        assert(contains(blockIndex));
+
+        const size_t i = blockIndex - m_firstIndex;
+
+        CachedBlockInfo info;
+
+        info.blockHash = Crypto::Hash();
+        info.timestamp = m_timestamps[i];
+        info.cumulativeDifficulty = m_cumulativeDifficulties[i];
+        info.blockSize = static_cast<uint32_t>(m_blockSizes[i]);
+        info.alreadyGeneratedCoins = m_alreadyGeneratedCoins[i];
+        info.alreadyGeneratedTransactions = m_alreadyGeneratedTransactions[i];
+
+        return info;
+    }
+
+    std::vector<uint64_t>
+        BlockInfoColumns::values(const Column column, const uint32_t startIndex, const uint32_t endIndex) const
+    {
+        assert(startIndex <= endIndex);
+        assert(startIndex == endIndex || (contains(startIndex) && contains(endIndex - 1)));
+
+        const auto &values = columnValues(column);
+
+        return std::vector<uint64_t>(
+            values.begin() + (startIndex - m_firstIndex), values.begin() + (endIndex - m_firstIndex));
+    }
+
+    uint64_t BlockInfoColumns::value(const CachedBlockInfo &info, const Column column)
+    {
+        switch (column)
+        {
+            case Column::Timestamp:
+                return info.timestamp;
+            case Column::CumulativeDifficulty:
+                return info.cumulativeDifficulty;
+            case Column::BlockSize:
+                return info.blockSize;
+            case Column::AlreadyGeneratedCoins:
+                return info.alreadyGeneratedCoins;
+            case Column::AlreadyGeneratedTransactions:
+                return info.alreadyGeneratedTransactions;
+        }
+
+        assert(false);
+        return 0;
+    }
+
+    const std::vector<uint64_t> &BlockInfoColumns::columnValues(const Column column) const
+    {
+        switch (column)
+        {
+            case Column::Timestamp:
+                return m_timestamps;
+            case Column::CumulativeDifficulty:
+                return m_cumulativeDifficulties;
+            case Column::BlockSize:
+                return m_blockSizes;
+            case Column::AlreadyGeneratedCoins:
+                return m_alreadyGeneratedCoins;
+            case Column::AlreadyGeneratedTransactions:
+                return m_alreadyGeneratedTransactions;
+        }
+
+        assert(false);
+        return m_timestamps;
+    }
+
+    std::string BlockInfoColumns::toBinary() const
+    {
+        std::string data;
+
+        data.reserve(sizeof(uint32_t) * 2 + sizeof(uint64_t) * (1 + m_timestamps.size() * 5));
+
+        writePod(data, COLUMNS_FORMAT_VERSION);
+        writePod(data, m_firstIndex);
+        writePod(data, static_cast<uint64_t>(m_timestamps.size()));
+
+        writeColumn(data, m_timestamps);
+        writeColumn(data, m_cumulativeDifficulties);
+        writeColumn(data, m_blockSizes);
+        writeColumn(data, m_alreadyGeneratedCoins);
+        writeColumn(data, m_alreadyGeneratedTransactions);
+
+        return data;
+    }
+
+    std::optional<BlockInfoColumns> BlockInfoColumns::fromBinary(const std::string &data)
+    {
+        size_t offset = 0;
+
+        uint32_t version;
+        uint32_t firstIndex;
+        uint64_t count;
+
+        if (!readPod(data, offset, version) || version != COLUMNS_FORMAT_VERSION
+            || !readPod(data, offset, firstIndex) || !readPod(data, offset, count)
+            || count > std::numeric_limits<uint32_t>::max() - firstIndex)
+        {
+            return std::nullopt;
+        }
+
+        BlockInfoColumns columns(firstIndex);
+
+        if (!readColumn(data, offset, count, columns.m_timestamps)
+            || !readColumn(data, offset, count, columns.m_cumulativeDifficulties)
+            || !readColumn(data, offset, count, columns.m_blockSizes)
+            || !readColumn(data, offset, count, columns.m_alreadyGeneratedCoins)
+            || !readColumn(data, offset, count, columns.m_alreadyGeneratedTransactions) || offset != data.size())
+        {
+            return std::nullopt;
+        }
+
+        return columns;
+    }
+} // namespace CryptoNote
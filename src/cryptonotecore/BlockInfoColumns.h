@@ -0,0 +1,82 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <cryptonotecore/BlockchainCache.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace CryptoNote
+{
+    /* The per block values the difficulty, block size and emission
+       calculations look back over, for a contiguous run of blocks. Each value
+       is stored in its own array, so the last N timestamps or cumulative
+       difficulties are a single copy out of memory, rather than N database
+       reads. At 40 bytes a block, the whole chain fits comfortably.
+
+       Block hashes are not held, and infoAt() returns a null one. */
+    class BlockInfoColumns
+    {
+      public:
+        enum class Column
+        {
+            Timestamp,
+            CumulativeDifficulty,
+            BlockSize,
+            AlreadyGeneratedCoins,
+            AlreadyGeneratedTransactions
+        };
+
+        explicit BlockInfoColumns(const uint32_t firstIndex = 0);
+
+        /* The index of the first block held */
+        uint32_t firstIndex() const;
+
+        /* One past the index of the last block held */
+        uint32_t endIndex() const;
+
+        bool empty() const;
+
+        bool contains(const uint32_t blockIndex) const;
+
+        /* Must be the block at endIndex() */
+        void push(const CachedBlockInfo &info);
+
+        /* Removes the block at blockIndex and every block after it */
+        void truncate(const uint32_t blockIndex);
+
+        /* Empties the columns, the next block pushed being at firstIndex */
+        void clear(const uint32_t firstIndex);
+
+        CachedBlockInfo infoAt(const uint32_t blockIndex) const;
+
+        /* The values of the blocks from startIndex up to but not including
+           endIndex, all of which must be held */
+        std::vector<uint64_t> values(const Column column, const uint32_t startIndex, const uint32_t endIndex) const;
+
+        static uint64_t value(const CachedBlockInfo &info, const Column column);
+
+        std::string toBinary() const;
+
+        /* Returns std::nullopt if the data is malformed */
+        static std::optional<BlockInfoColumns> fromBinary(const std::string &data);
+
+      private:
+        const std::vector<uint64_t> &columnValues(const Column column) const;
+
+        uint32_t m_firstIndex;
+
+        std::vector<uint64_t> m_timestamps;
+
+        std::vector<uint64_t> m_cumulativeDifficulties;
+
+        std::vector<uint64_t> m_blockSizes;
+
+        std::vector<uint64_t> m_alreadyGeneratedCoins;
+
+        std::vector<uint64_t> m_alreadyGeneratedTransactions;
+    };
+} // namespace CryptoNote
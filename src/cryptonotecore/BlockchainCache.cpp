@@ -13,6 +13,7 @@
 #include "common/StdOutputStream.h"
 #include "common/TransactionExtra.h"
 #include "cryptonotecore/BlockchainStorage.h"
+#include "cryptonotecore/BlockchainUtils.h"
 #include "cryptonotecore/CryptoNoteBasicImpl.h"
 #include "serialization/CryptoNoteSerialization.h"
 #include "serialization/SerializationOverloads.h"
@@ -527,6 +528,45 @@ namespace CryptoNote
         return parent != nullptr && parent->checkIfSpent(keyImage);
     }
 
+    std::unordered_set<Crypto::KeyImage> BlockchainCache::getSpentKeyImages(
+        const std::vector<Crypto::KeyImage> &keyImages,
+        uint32_t blockIndex) const
+    {
+        if (blockIndex < startIndex)
+        {
+            assert(parent != nullptr);
+            return parent->getSpentKeyImages(keyImages, blockIndex);
+        }
+
+        std::unordered_set<Crypto::KeyImage> spent;
+
+        std::vector<Crypto::KeyImage> notFound;
+
+        for (const auto &keyImage : keyImages)
+        {
+            auto it = spentKeyImages.get<KeyImageTag>().find(keyImage);
+
+            if (it == spentKeyImages.get<KeyImageTag>().end())
+            {
+                notFound.push_back(keyImage);
+            }
+            else if (it->blockIndex <= blockIndex)
+            {
+                spent.insert(keyImage);
+            }
+        }
+
+        /* Hand everything we don't know about to the parent in one go, so
+           the root segment can look them all up in a single read */
+        if (parent != nullptr && !notFound.empty())
+        {
+            const auto parentSpent = parent->getSpentKeyImages(notFound, blockIndex);
+            spent.insert(parentSpent.begin(), parentSpent.end());
+        }
+
+        return spent;
+    }
+
     uint32_t BlockchainCache::getBlockCount() const
     {
         return static_cast<uint32_t>(blockInfos.size());
@@ -806,6 +846,108 @@ namespace CryptoNote
         return blocks;
     }
 
+    std::vector<WalletTypes::WalletBlockInfo>
+        BlockchainCache::getWalletBlocks(const uint64_t startHeight, uint64_t endHeight) const
+    {
+        if (endHeight < startIndex)
+        {
+            return parent->getWalletBlocks(startHeight, endHeight);
+        }
+
+        std::vector<WalletTypes::WalletBlockInfo> blocks;
+
+        if (startHeight < startIndex)
+        {
+            blocks = parent->getWalletBlocks(startHeight, startIndex);
+        }
+
+        const uint64_t startOffset = std::max(startHeight, static_cast<uint64_t>(startIndex));
+
+        endHeight = std::min<uint64_t>(endHeight, startIndex + storage->getBlockCount());
+
+        for (uint64_t i = startOffset; i < endHeight; i++)
+        {
+            blocks.push_back(getWalletBlockInfo(storage->getBlockByIndex(i - startIndex)));
+        }
+
+        return blocks;
+    }
+
+    std::vector<WalletTypes::WalletBlockInfo>
+        BlockchainCache::getNonEmptyWalletBlocks(const uint64_t startHeight, const size_t blockCount) const
+    {
+        std::vector<WalletTypes::WalletBlockInfo> blocks;
+
+        if (startHeight < startIndex)
+        {
+            blocks = parent->getNonEmptyWalletBlocks(startHeight, blockCount);
+
+            if (blocks.size() == blockCount)
+            {
+                return blocks;
+            }
+        }
+
+        uint64_t i = std::max(startHeight, static_cast<uint64_t>(startIndex));
+
+        const uint64_t storageBlockCount = storage->getBlockCount();
+
+        while (blocks.size() < blockCount && i < startIndex + storageBlockCount)
+        {
+            auto block = storage->getBlockByIndex(i - startIndex);
+
+            i++;
+
+            if (block.transactions.empty())
+            {
+                continue;
+            }
+
+            blocks.push_back(getWalletBlockInfo(block));
+        }
+
+        return blocks;
+    }
+
+    WalletTypes::WalletBlockInfo BlockchainCache::getWalletBlockInfo(const RawBlock &rawBlock) const
+    {
+        /* Segments are short lived and small, so unlike the database cache,
+           we don't keep an index of these, and build them on demand */
+        BlockTemplate block;
+        fromBinaryArray(block, rawBlock.block);
+
+        std::vector<CachedTransaction> transactions;
+        Utils::restoreCachedTransactions(rawBlock.transactions, transactions);
+
+        CachedBlock cachedBlock(block);
+        CachedTransaction baseTransaction(block.baseTransaction);
+
+        std::vector<Crypto::Hash> transactionHashes {baseTransaction.getTransactionHash()};
+
+        for (const auto &transaction : transactions)
+        {
+            transactionHashes.push_back(transaction.getTransactionHash());
+        }
+
+        const auto indexes = getGlobalIndexes(transactionHashes);
+
+        std::vector<std::vector<uint32_t>> globalIndexes;
+
+        for (const auto &hash : transactionHashes)
+        {
+            const auto it = indexes.find(hash);
+
+            globalIndexes.emplace_back();
+
+            if (it != indexes.end())
+            {
+                globalIndexes.back().assign(it->second.begin(), it->second.end());
+            }
+        }
+
+        return Utils::getWalletBlockInfo(cachedBlock, baseTransaction, transactions, globalIndexes);
+    }
+
     std::unordered_map<Crypto::Hash, std::vector<uint64_t>>
         BlockchainCache::getGlobalIndexes(const std::vector<Crypto::Hash> transactionHashes) const
     {
@@ -991,6 +1133,11 @@ namespace CryptoNote
         serialize(s);
     }
 
+    /* Pushing a block is already cheap in memory, so there's nothing to defer */
+    void BlockchainCache::beginBulkImport() {}
+
+    void BlockchainCache::commitBulkImport() {}
+
     bool BlockchainCache::isTransactionSpendTimeUnlocked(uint64_t unlockTime) const
     {
         return isTransactionSpendTimeUnlocked(unlockTime, getTopBlockIndex());
@@ -123,6 +123,9 @@ namespace CryptoNote
 
         bool checkIfSpent(const Crypto::KeyImage &keyImage) const override;
 
+        std::unordered_set<Crypto::KeyImage>
+            getSpentKeyImages(const std::vector<Crypto::KeyImage> &keyImages, uint32_t blockIndex) const override;
+
         bool isTransactionSpendTimeUnlocked(uint64_t unlockTime) const override;
 
         bool isTransactionSpendTimeUnlocked(uint64_t unlockTime, uint32_t blockIndex) const override;
@@ -227,6 +230,10 @@ namespace CryptoNote
 
         virtual void load() override;
 
+        virtual void beginBulkImport() override;
+
+        virtual void commitBulkImport() override;
+
         virtual std::vector<BinaryArray> getRawTransactions(
             const std::vector<Crypto::Hash> &transactions,
             std::vector<Crypto::Hash> &missedTransactions) const override;
@@ -270,6 +277,12 @@ namespace CryptoNote
         virtual std::vector<RawBlock>
             getNonEmptyBlocks(const uint64_t startHeight, const size_t blockCount) const override;
 
+        virtual std::vector<WalletTypes::WalletBlockInfo>
+            getWalletBlocks(const uint64_t startHeight, const uint64_t endHeight) const override;
+
+        virtual std::vector<WalletTypes::WalletBlockInfo>
+            getNonEmptyWalletBlocks(const uint64_t startHeight, const size_t blockCount) const override;
+
       private:
         struct BlockIndexTag
         {
@@ -385,6 +398,8 @@ namespace CryptoNote
 
         void addSpentKeyImage(const Crypto::KeyImage &keyImage, uint32_t blockIndex);
 
+        WalletTypes::WalletBlockInfo getWalletBlockInfo(const RawBlock &rawBlock) const;
+
         void pushTransaction(const CachedTransaction &tx, uint32_t blockIndex, uint16_t transactionBlockIndex);
 
         void splitSpentKeyImages(BlockchainCache &newCache, uint32_t splitBlockIndex);
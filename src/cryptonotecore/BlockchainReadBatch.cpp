@@ -92,6 +92,16 @@ BlockchainReadBatch &BlockchainReadBatch::requestRawBlocks(uint64_t startHeight,
     return *this;
 }
 
+BlockchainReadBatch &BlockchainReadBatch::requestWalletBlockInfos(uint64_t startHeight, uint64_t endHeight)
+{
+    for (uint64_t i = startHeight; i < endHeight; i++)
+    {
+        state.walletBlockInfos.emplace(i, WalletBlockInfoRecord());
+    }
+
+    return *this;
+}
+
 BlockchainReadBatch &BlockchainReadBatch::requestLastBlockIndex()
 {
     state.lastBlockIndex.second = true;
@@ -170,6 +180,7 @@ std::vector<std::string> BlockchainReadBatch::getRawKeys() const
     DB::serializeKeys(rawKeys, DB::KEY_OUTPUT_AMOUNT_PREFIX, state.keyOutputGlobalIndexesCountForAmounts);
     DB::serializeKeys(rawKeys, DB::KEY_OUTPUT_AMOUNT_PREFIX, state.keyOutputGlobalIndexesForAmounts);
     DB::serializeKeys(rawKeys, DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, state.rawBlocks);
+    DB::serializeKeys(rawKeys, DB::BLOCK_INDEX_TO_WALLET_BLOCK_INFO_PREFIX, state.walletBlockInfos);
     DB::serializeKeys(rawKeys, DB::CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX, state.closestTimestampBlockIndex);
     DB::serializeKeys(rawKeys, DB::KEY_OUTPUT_AMOUNTS_COUNT_PREFIX, state.keyOutputAmounts);
     DB::serializeKeys(rawKeys, DB::PAYMENT_ID_TO_TX_HASH_PREFIX, state.transactionCountsByPaymentIds);
@@ -249,6 +260,11 @@ const std::unordered_map<uint32_t, RawBlock> &BlockchainReadResult::getRawBlocks
     return state.rawBlocks;
 }
 
+const std::unordered_map<uint32_t, WalletBlockInfoRecord> &BlockchainReadResult::getWalletBlockInfos() const
+{
+    return state.walletBlockInfos;
+}
+
 const std::pair<uint32_t, bool> &BlockchainReadResult::getLastBlockIndex() const
 {
     return state.lastBlockIndex;
@@ -306,6 +322,7 @@ void BlockchainReadBatch::submitRawResult(const std::vector<std::string> &values
     DB::deserializeValues(state.keyOutputGlobalIndexesCountForAmounts, iter, DB::KEY_OUTPUT_AMOUNT_PREFIX);
     DB::deserializeValues(state.keyOutputGlobalIndexesForAmounts, iter, DB::KEY_OUTPUT_AMOUNT_PREFIX);
     DB::deserializeValues(state.rawBlocks, iter, DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX);
+    DB::deserializeValues(state.walletBlockInfos, iter, DB::BLOCK_INDEX_TO_WALLET_BLOCK_INFO_PREFIX);
     DB::deserializeValues(state.closestTimestampBlockIndex, iter, DB::CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX);
     DB::deserializeValues(state.keyOutputAmounts, iter, DB::KEY_OUTPUT_AMOUNTS_COUNT_PREFIX);
     DB::deserializeValues(state.transactionCountsByPaymentIds, iter, DB::PAYMENT_ID_TO_TX_HASH_PREFIX);
@@ -332,6 +349,7 @@ BlockchainReadState::BlockchainReadState(BlockchainReadState &&state):
     keyOutputGlobalIndexesCountForAmounts(std::move(state.keyOutputGlobalIndexesCountForAmounts)),
     keyOutputGlobalIndexesForAmounts(std::move(state.keyOutputGlobalIndexesForAmounts)),
     rawBlocks(std::move(state.rawBlocks)),
+    walletBlockInfos(std::move(state.walletBlockInfos)),
     blockHashesByTimestamp(std::move(state.blockHashesByTimestamp)),
     keyOutputKeys(std::move(state.keyOutputKeys)),
     closestTimestampBlockIndex(std::move(state.closestTimestampBlockIndex)),
@@ -349,7 +367,8 @@ size_t BlockchainReadState::size() const
     return spentKeyImagesByBlock.size() + blockIndexesBySpentKeyImages.size() + cachedTransactions.size()
            + transactionHashesByBlocks.size() + cachedBlocks.size() + blockIndexesByBlockHashes.size()
            + keyOutputGlobalIndexesCountForAmounts.size() + keyOutputGlobalIndexesForAmounts.size() + rawBlocks.size()
-           + closestTimestampBlockIndex.size() + keyOutputAmounts.size() + transactionCountsByPaymentIds.size()
+           + walletBlockInfos.size() + closestTimestampBlockIndex.size() + keyOutputAmounts.size()
+           + transactionCountsByPaymentIds.size()
            + transactionHashesByPaymentIds.size() + blockHashesByTimestamp.size() + keyOutputKeys.size()
            + (lastBlockIndex.second ? 1 : 0) + (keyOutputAmountsCount.second ? 1 : 0)
            + (transactionsCount.second ? 1 : 0);
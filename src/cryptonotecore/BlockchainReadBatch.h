@@ -67,6 +67,8 @@ namespace CryptoNote
 
         std::unordered_map<uint32_t, RawBlock> rawBlocks;
 
+        std::unordered_map<uint32_t, WalletBlockInfoRecord> walletBlockInfos;
+
         std::unordered_map<uint64_t, uint32_t> closestTimestampBlockIndex;
 
         std::unordered_map<uint32_t, IBlockchainCache::Amount> keyOutputAmounts;
@@ -122,6 +124,8 @@ namespace CryptoNote
 
         const std::unordered_map<uint32_t, RawBlock> &getRawBlocks() const;
 
+        const std::unordered_map<uint32_t, WalletBlockInfoRecord> &getWalletBlockInfos() const;
+
         const std::pair<uint32_t, bool> &getLastBlockIndex() const;
 
         const std::unordered_map<uint64_t, uint32_t> &getClosestTimestampBlockIndex() const;
@@ -173,6 +177,8 @@ namespace CryptoNote
 
         BlockchainReadBatch &requestRawBlocks(uint64_t startHeight, uint64_t endHeight);
 
+        BlockchainReadBatch &requestWalletBlockInfos(uint64_t startHeight, uint64_t endHeight);
+
         BlockchainReadBatch &requestLastBlockIndex();
 
         BlockchainReadBatch &requestClosestTimestampBlockIndex(uint64_t timestamp);
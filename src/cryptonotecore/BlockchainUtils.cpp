@@ -5,6 +5,8 @@
 
 #include "BlockchainUtils.h"
 
+#include <utilities/ParseExtra.h>
+
 namespace CryptoNote
 {
     namespace Utils
@@ -29,5 +31,114 @@ namespace CryptoNote
             return true;
         }
 
+        namespace
+        {
+            std::vector<WalletTypes::KeyOutput>
+                getKeyOutputs(const Transaction &transaction, const std::vector<uint32_t> &globalIndexes)
+            {
+                std::vector<WalletTypes::KeyOutput> keyOutputs;
+
+                keyOutputs.reserve(transaction.outputs.size());
+
+                for (size_t i = 0; i < transaction.outputs.size(); i++)
+                {
+                    const auto &output = transaction.outputs[i];
+
+                    WalletTypes::KeyOutput keyOutput;
+
+                    keyOutput.amount = output.amount;
+                    keyOutput.key = boost::get<CryptoNote::KeyOutput>(output.target).key;
+
+                    if (i < globalIndexes.size())
+                    {
+                        keyOutput.globalOutputIndex = globalIndexes[i];
+                    }
+
+                    keyOutputs.push_back(keyOutput);
+                }
+
+                return keyOutputs;
+            }
+        } // namespace
+
+        WalletTypes::RawCoinbaseTransaction getRawCoinbaseTransaction(
+            const CachedTransaction &cachedTransaction,
+            const std::vector<uint32_t> &globalIndexes)
+        {
+            const auto &t = cachedTransaction.getTransaction();
+
+            WalletTypes::RawCoinbaseTransaction transaction;
+
+            transaction.hash = cachedTransaction.getTransactionHash();
+
+            transaction.transactionPublicKey = Utilities::getTransactionPublicKeyFromExtra(t.extra);
+
+            transaction.unlockTime = t.unlockTime;
+
+            transaction.keyOutputs = getKeyOutputs(t, globalIndexes);
+
+            return transaction;
+        }
+
+        WalletTypes::RawTransaction getRawTransaction(
+            const CachedTransaction &cachedTransaction,
+            const std::vector<uint32_t> &globalIndexes)
+        {
+            const auto &t = cachedTransaction.getTransaction();
+
+            WalletTypes::RawTransaction transaction;
+
+            transaction.hash = cachedTransaction.getTransactionHash();
+
+            Utilities::ParsedExtra parsedExtra = Utilities::parseExtra(t.extra);
+
+            /* Transaction public key, used for decrypting transactions along with
+               private view key */
+            transaction.transactionPublicKey = parsedExtra.transactionPublicKey;
+
+            /* Get the payment ID if it exists (Empty string if it doesn't) */
+            transaction.paymentID = parsedExtra.paymentID;
+
+            transaction.unlockTime = t.unlockTime;
+
+            transaction.keyOutputs = getKeyOutputs(t, globalIndexes);
+
+            /* Simplify the inputs */
+            for (const auto &input : t.inputs)
+            {
+                transaction.keyInputs.push_back(boost::get<CryptoNote::KeyInput>(input));
+            }
+
+            return transaction;
+        }
+
+        WalletTypes::WalletBlockInfo getWalletBlockInfo(
+            const CachedBlock &block,
+            const CachedTransaction &baseTransaction,
+            const std::vector<CachedTransaction> &transactions,
+            const std::vector<std::vector<uint32_t>> &globalIndexes)
+        {
+            const auto getGlobalIndexes = [&globalIndexes](const size_t i) {
+                return i < globalIndexes.size() ? globalIndexes[i] : std::vector<uint32_t>();
+            };
+
+            WalletTypes::WalletBlockInfo walletBlock;
+
+            walletBlock.blockHeight = block.getBlockIndex();
+            walletBlock.blockHash = block.getBlockHash();
+            walletBlock.blockTimestamp = block.getBlock().timestamp;
+
+            walletBlock.coinbaseTransaction = getRawCoinbaseTransaction(baseTransaction, getGlobalIndexes(0));
+
+            walletBlock.transactions.reserve(transactions.size());
+
+            for (size_t i = 0; i < transactions.size(); i++)
+            {
+                walletBlock.transactions.push_back(getRawTransaction(transactions[i], getGlobalIndexes(i + 1)));
+            }
+
+            return walletBlock;
+        }
+
     } // namespace Utils
 } // namespace CryptoNote
@@ -5,10 +5,12 @@
 
 #pragma once
 
+#include "CachedBlock.h"
 #include "CachedTransaction.h"
 #include "CryptoNote.h"
 #include "common/CryptoNoteTools.h"
 
+#include <WalletTypes.h>
 #include <vector>
 
 namespace CryptoNote
@@ -19,5 +21,26 @@ namespace CryptoNote
             const std::vector<BinaryArray> &binaryTransactions,
             std::vector<CachedTransaction> &transactions);
 
+        /* The parts of a coinbase transaction a wallet needs to sync. Global
+           indexes are filled in if given, one per output. */
+        WalletTypes::RawCoinbaseTransaction getRawCoinbaseTransaction(
+            const CachedTransaction &cachedTransaction,
+            const std::vector<uint32_t> &globalIndexes = {});
+
+        /* The parts of a transaction a wallet needs to sync. Global indexes
+           are filled in if given, one per output. */
+        WalletTypes::RawTransaction getRawTransaction(
+            const CachedTransaction &cachedTransaction,
+            const std::vector<uint32_t> &globalIndexes = {});
+
+        /* Everything a wallet needs to sync a block. globalIndexes holds the
+           global indexes of the outputs of the coinbase transaction, followed
+           by those of each transaction. */
+        WalletTypes::WalletBlockInfo getWalletBlockInfo(
+            const CachedBlock &block,
+            const CachedTransaction &baseTransaction,
+            const std::vector<CachedTransaction> &transactions,
+            const std::vector<std::vector<uint32_t>> &globalIndexes);
+
     } // namespace Utils
 } // namespace CryptoNote
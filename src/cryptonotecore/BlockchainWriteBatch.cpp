@@ -85,6 +85,13 @@ BlockchainWriteBatch &BlockchainWriteBatch::insertRawBlock(uint32_t blockIndex,
     return *this;
 }
 
+BlockchainWriteBatch &
+    BlockchainWriteBatch::insertWalletBlockInfo(uint32_t blockIndex, const WalletBlockInfoRecord &block)
+{
+    rawDataToInsert.emplace_back(DB::serialize(DB::BLOCK_INDEX_TO_WALLET_BLOCK_INFO_PREFIX, blockIndex, block));
+    return *this;
+}
+
 BlockchainWriteBatch &BlockchainWriteBatch::insertClosestTimestampBlockIndex(uint64_t timestamp, uint32_t blockIndex)
 {
     rawDataToInsert.emplace_back(DB::serialize(DB::CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX, timestamp, blockIndex));
@@ -189,6 +196,12 @@ BlockchainWriteBatch &BlockchainWriteBatch::removeRawBlock(uint32_t blockIndex)
     return *this;
 }
 
+BlockchainWriteBatch &BlockchainWriteBatch::removeWalletBlockInfo(uint32_t blockIndex)
+{
+    rawKeysToRemove.emplace_back(DB::serializeKey(DB::BLOCK_INDEX_TO_WALLET_BLOCK_INFO_PREFIX, blockIndex));
+    return *this;
+}
+
 BlockchainWriteBatch &BlockchainWriteBatch::removeClosestTimestampBlockIndex(uint64_t timestamp)
 {
     rawKeysToRemove.emplace_back(DB::serializeKey(DB::CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX, timestamp));
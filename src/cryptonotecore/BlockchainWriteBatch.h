@@ -42,6 +42,8 @@ namespace CryptoNote
 
         BlockchainWriteBatch &insertRawBlock(uint32_t blockIndex, const RawBlock &block);
 
+        BlockchainWriteBatch &insertWalletBlockInfo(uint32_t blockIndex, const WalletBlockInfoRecord &block);
+
         BlockchainWriteBatch &insertClosestTimestampBlockIndex(uint64_t timestamp, uint32_t blockIndex);
 
         BlockchainWriteBatch &insertKeyOutputAmounts(
@@ -71,6 +73,8 @@ namespace CryptoNote
 
         BlockchainWriteBatch &removeRawBlock(uint32_t blockIndex);
 
+        BlockchainWriteBatch &removeWalletBlockInfo(uint32_t blockIndex);
+
         BlockchainWriteBatch &removeClosestTimestampBlockIndex(uint64_t timestamp);
 
         BlockchainWriteBatch &removeTimestamp(uint64_t timestamp);
@@ -52,29 +52,10 @@ namespace CryptoNote
 
         UseGenesis addGenesisBlock = UseGenesis(true);
 
-        class TransactionSpentInputsChecker
-        {
-          public:
-            bool haveSpentInputs(const Transaction &transaction)
-            {
-                for (const auto &input : transaction.inputs)
-                {
-                    if (input.type() == typeid(KeyInput))
-                    {
-                        auto inserted = alreadySpentKeyImages.insert(boost::get<KeyInput>(input).keyImage);
-                        if (!inserted.second)
-                        {
-                            return true;
-                        }
-                    }
-                }
-
-                return false;
-            }
-
-          private:
-            std::unordered_set<Crypto::KeyImage> alreadySpentKeyImages;
-        };
+        /* The amount of blocks importBlocksFromStorage() reads and prepares at
+           once. Must stay well below the amount of recent block infos the
+           database cache keeps in memory, as a bulk import relies on them. */
+        const uint32_t IMPORT_BATCH_SIZE = 500;
 
         inline IBlockchainCache *findIndexInChain(IBlockchainCache *blockSegment, const Crypto::Hash &blockHash)
         {
@@ -227,6 +208,20 @@ namespace CryptoNote
 
         const std::chrono::seconds OUTDATED_TRANSACTION_POLLING_INTERVAL = std::chrono::seconds(60);
 
+        /* Logs as "index (hash)". Formatted when written, so it costs nothing
+           for messages below the log level. */
+        struct BlockDescription
+        {
+            uint32_t index;
+
+            Crypto::Hash hash;
+        };
+
+        std::ostream &operator<<(std::ostream &os, const BlockDescription &block)
+        {
+            return os << block.index << " (" << block.hash << ")";
+        }
+
     } // namespace
 
     Core::Core(
@@ -280,6 +275,37 @@ namespace CryptoNote
 
     bool Core::notifyObservers(BlockchainMessage &&msg) /* noexcept */
     {
+        {
+            std::scoped_lock lock(m_templateChangedMutex);
+
+            switch (msg.getType())
+            {
+                case BlockchainMessage::Type::NewBlock:
+                {
+                    m_chainVersion++;
+                    break;
+                }
+                case BlockchainMessage::Type::ChainSwitch:
+                {
+                    m_chainVersion++;
+                    m_chainSwitchCount++;
+                    break;
+                }
+                case BlockchainMessage::Type::AddTransaction:
+                case BlockchainMessage::Type::DeleteTransaction:
+                {
+                    m_poolVersion++;
+                    break;
+                }
+                case BlockchainMessage::Type::NewAlternativeBlock:
+                {
+                    break;
+                }
+            }
+        }
+
+        m_templateChanged.notify_all();
+
         try
         {
             for (auto &queue : queueList)
@@ -295,6 +321,45 @@ namespace CryptoNote
         }
     }
 
+    uint64_t Core::getPoolVersion() const
+    {
+        std::scoped_lock lock(m_templateChangedMutex);
+
+        return m_poolVersion;
+    }
+
+    uint64_t Core::getChainSwitchCount() const
+    {
+        std::scoped_lock lock(m_templateChangedMutex);
+
+        return m_chainSwitchCount;
+    }
+
+    void Core::waitForBlockTemplateChange(
+        const Crypto::Hash &topBlockHash,
+        const uint64_t poolVersion,
+        const std::chrono::steady_clock::time_point until) const
+    {
+        std::unique_lock lock(m_templateChangedMutex);
+
+        /* Taken before looking at the top block, so a block arriving in
+           between isn't missed */
+        const uint64_t chainVersion = m_chainVersion;
+
+        lock.unlock();
+
+        if (getTopBlockHash() != topBlockHash)
+        {
+            return;
+        }
+
+        lock.lock();
+
+        m_templateChanged.wait_until(lock, until, [this, chainVersion, poolVersion] {
+            return m_chainVersion != chainVersion || m_poolVersion != poolVersion;
+        });
+    }
+
     uint32_t Core::getTopBlockIndex() const
     {
         assert(!chainsStorage.empty());
@@ -800,42 +865,20 @@ namespace CryptoNote
                 return true;
             }
 
-            std::vector<RawBlock> rawBlocks;
-
+            /* Served from the wallet sync index, so the blocks don't need to
+               be parsed again for every request */
             if (skipCoinbaseTransactions)
             {
-                rawBlocks = mainChain->getNonEmptyBlocks(startIndex, actualBlockCount);
-            }
-            else
-            {
-                rawBlocks = mainChain->getBlocksByHeight(startIndex, endIndex);
-            }
-
-            for (const auto &rawBlock : rawBlocks)
-            {
-                BlockTemplate block;
-
-                fromBinaryArray(block, rawBlock.block);
+                walletBlocks = mainChain->getNonEmptyWalletBlocks(startIndex, actualBlockCount);
 
-                WalletTypes::WalletBlockInfo walletBlock;
-
-                CachedBlock cachedBlock(block);
-
-                walletBlock.blockHeight = cachedBlock.getBlockIndex();
-                walletBlock.blockHash = cachedBlock.getBlockHash();
-                walletBlock.blockTimestamp = block.timestamp;
-
-                if (!skipCoinbaseTransactions)
+                for (auto &walletBlock : walletBlocks)
                 {
-                    walletBlock.coinbaseTransaction = getRawCoinbaseTransaction(block.baseTransaction);
+                    walletBlock.coinbaseTransaction = std::nullopt;
                 }
-
-                for (const auto &transaction : rawBlock.transactions)
-                {
-                    walletBlock.transactions.push_back(getRawTransaction(transaction));
-                }
-
-                walletBlocks.push_back(walletBlock);
+            }
+            else
+            {
+                walletBlocks = mainChain->getWalletBlocks(startIndex, endIndex);
             }
 
             if (walletBlocks.empty())
@@ -969,73 +1012,6 @@ namespace CryptoNote
         }
     }
 
-    WalletTypes::RawCoinbaseTransaction Core::getRawCoinbaseTransaction(const CryptoNote::Transaction &t)
-    {
-        WalletTypes::RawCoinbaseTransaction transaction;
-
-        transaction.hash = getBinaryArrayHash(toBinaryArray(t));
-
-        transaction.transactionPublicKey = Utilities::getTransactionPublicKeyFromExtra(t.extra);
-
-        transaction.unlockTime = t.unlockTime;
-
-        /* Fill in the simplified key outputs */
-        for (const auto &output : t.outputs)
-        {
-            WalletTypes::KeyOutput keyOutput;
-
-            keyOutput.amount = output.amount;
-            keyOutput.key = boost::get<CryptoNote::KeyOutput>(output.target).key;
-
-            transaction.keyOutputs.push_back(keyOutput);
-        }
-
-        return transaction;
-    }
-
-    WalletTypes::RawTransaction Core::getRawTransaction(const std::vector<uint8_t> &rawTX)
-    {
-        Transaction t;
-
-        /* Convert the binary array to a transaction */
-        fromBinaryArray(t, rawTX);
-
-        WalletTypes::RawTransaction transaction;
-
-        /* Get the transaction hash from the binary array */
-        transaction.hash = getBinaryArrayHash(rawTX);
-
-        Utilities::ParsedExtra parsedExtra = Utilities::parseExtra(t.extra);
-
-        /* Transaction public key, used for decrypting transactions along with
-       private view key */
-        transaction.transactionPublicKey = parsedExtra.transactionPublicKey;
-
-        /* Get the payment ID if it exists (Empty string if it doesn't) */
-        transaction.paymentID = parsedExtra.paymentID;
-
-        transaction.unlockTime = t.unlockTime;
-
-        /* Simplify the outputs */
-        for (const auto &output : t.outputs)
-        {
-            WalletTypes::KeyOutput keyOutput;
-
-            keyOutput.amount = output.amount;
-            keyOutput.key = boost::get<CryptoNote::KeyOutput>(output.target).key;
-
-            transaction.keyOutputs.push_back(keyOutput);
-        }
-
-        /* Simplify the inputs */
-        for (const auto &input : t.inputs)
-        {
-            transaction.keyInputs.push_back(boost::get<CryptoNote::KeyInput>(input));
-        }
-
-        return transaction;
-    }
-
     std::optional<BinaryArray> Core::getTransaction(const Crypto::Hash &hash) const
     {
         throwIfNotInitialized();
@@ -1152,18 +1128,87 @@ namespace CryptoNote
     }
 
     std::error_code Core::addBlock(const CachedBlock &cachedBlock, RawBlock &&rawBlock)
+    {
+        throwIfNotInitialized();
+
+        /* The proof of work hash is computed lazily by addBlock, if needed */
+        auto preparedBlock = prepareBlock(cachedBlock, rawBlock, false);
+
+        return addBlock(cachedBlock, std::move(rawBlock), std::move(preparedBlock));
+    }
+
+    std::vector<PreparedBlock>
+        Core::prepareBlocks(const std::vector<CachedBlock> &cachedBlocks, const std::vector<RawBlock> &rawBlocks)
+    {
+        throwIfNotInitialized();
+
+        assert(cachedBlocks.size() == rawBlocks.size());
+
+        std::vector<PreparedBlock> preparedBlocks(cachedBlocks.size());
+
+        /* Every block is independent of the others at this stage, so spread
+           them over the thread pool a block at a time (the long hash makes
+           them expensive enough), and let addBlock() do the chain dependent
+           validation sequentially afterwards */
+        m_transactionValidationThreadPool.parallelFor(
+            cachedBlocks.size(),
+            [this, &cachedBlocks, &rawBlocks, &preparedBlocks](const size_t i) {
+                const auto &cachedBlock = cachedBlocks[i];
+
+                /* The long hash is only checked outside of the checkpoint zone */
+                const bool computeLongHash = !checkpoints.isInCheckpointZone(cachedBlock.getBlockIndex());
+
+                preparedBlocks[i] = prepareBlock(cachedBlock, rawBlocks[i], computeLongHash);
+            },
+            1);
+
+        return preparedBlocks;
+    }
+
+    PreparedBlock Core::prepareBlock(const CachedBlock &cachedBlock, const RawBlock &rawBlock, bool computeLongHash)
+    {
+        PreparedBlock preparedBlock;
+
+        preparedBlock.success =
+            extractTransactions(rawBlock.transactions, preparedBlock.transactions, preparedBlock.cumulativeSize);
+
+        if (preparedBlock.success)
+        {
+            /* Prime the cached hashes, they are used by both the duplicate
+               transaction checks and the signature checks */
+            for (const auto &transaction : preparedBlock.transactions)
+            {
+                transaction.getTransactionHash();
+                transaction.getTransactionPrefixHash();
+            }
+        }
+
+        if (computeLongHash)
+        {
+            try
+            {
+                cachedBlock.getBlockLongHash();
+            }
+            catch (const std::exception &)
+            {
+                /* Unknown block version - this is reported by validateBlock() */
+            }
+        }
+
+        return preparedBlock;
+    }
+
+    std::error_code Core::addBlock(const CachedBlock &cachedBlock, RawBlock &&rawBlock, PreparedBlock &&preparedBlock)
     {
         throwIfNotInitialized();
         uint32_t blockIndex = cachedBlock.getBlockIndex();
         Crypto::Hash blockHash = cachedBlock.getBlockHash();
-        std::ostringstream os;
-        os << blockIndex << " (" << blockHash << ")";
-        std::string blockStr = os.str();
+        const BlockDescription blockDescription {blockIndex, blockHash};
 
-        logger(Logging::DEBUGGING) << "Request to add block " << blockStr;
+        logger(Logging::DEBUGGING) << "Request to add block " << blockDescription;
         if (hasBlock(cachedBlock.getBlockHash()))
         {
-            logger(Logging::DEBUGGING) << "Block " << blockStr << " already exists";
+            logger(Logging::DEBUGGING) << "Block " << blockDescription << " already exists";
             return error::AddBlockErrorCode::ALREADY_EXISTS;
         }
 
@@ -1175,18 +1220,19 @@ namespace CryptoNote
         auto cache = findSegmentContainingBlock(previousBlockHash);
         if (cache == nullptr)
         {
-            logger(Logging::DEBUGGING) << "Block " << blockStr << " rejected as orphaned";
+            logger(Logging::DEBUGGING) << "Block " << blockDescription << " rejected as orphaned";
             return error::AddBlockErrorCode::REJECTED_AS_ORPHANED;
         }
 
-        std::vector<CachedTransaction> transactions;
-        uint64_t cumulativeSize = 0;
-        if (!extractTransactions(rawBlock.transactions, transactions, cumulativeSize))
+        if (!preparedBlock.success)
         {
-            logger(Logging::DEBUGGING) << "Couldn't deserialize raw block transactions in block " << blockStr;
+            logger(Logging::DEBUGGING) << "Couldn't deserialize raw block transactions in block " << blockDescription;
             return error::AddBlockErrorCode::DESERIALIZATION_FAILED;
         }
 
+        std::vector<CachedTransaction> transactions = std::move(preparedBlock.transactions);
+        const uint64_t cumulativeSize = preparedBlock.cumulativeSize;
+
         auto coinbaseTransactionSize = getObjectBinarySize(blockTemplate.baseTransaction);
         assert(coinbaseTransactionSize < std::numeric_limits<decltype(coinbaseTransactionSize)>::max());
         auto cumulativeBlockSize = coinbaseTransactionSize + cumulativeSize;
@@ -1198,7 +1244,7 @@ namespace CryptoNote
         auto maxBlockCumulativeSize = currency.maxBlockCumulativeSize(previousBlockIndex + 1);
         if (cumulativeBlockSize > maxBlockCumulativeSize)
         {
-            logger(Logging::DEBUGGING) << "Block " << blockStr << " has too big cumulative size";
+            logger(Logging::DEBUGGING) << "Block " << blockDescription << " has too big cumulative size";
             return error::BlockValidationError::CUMULATIVE_BLOCK_SIZE_TOO_BIG;
         }
 
@@ -1206,7 +1252,7 @@ namespace CryptoNote
         auto blockValidationResult = validateBlock(cachedBlock, cache, minerReward);
         if (blockValidationResult)
         {
-            logger(Logging::DEBUGGING) << "Failed to validate block " << blockStr << ": "
+            logger(Logging::DEBUGGING) << "Failed to validate block " << blockDescription << ": "
                                        << blockValidationResult.message();
             return blockValidationResult;
         }
@@ -1214,7 +1260,7 @@ namespace CryptoNote
         auto currentDifficulty = cache->getDifficultyForNextBlock(previousBlockIndex);
         if (currentDifficulty == 0)
         {
-            logger(Logging::DEBUGGING) << "Block " << blockStr << " has difficulty overhead";
+            logger(Logging::DEBUGGING) << "Block " << blockDescription << " has difficulty overhead";
             return error::BlockValidationError::DIFFICULTY_OVERHEAD;
         }
 
@@ -1264,32 +1310,44 @@ namespace CryptoNote
 
         uint64_t cumulativeFee = 0;
 
+        const auto rejectTransaction = [this](const CachedTransaction &transaction, const std::error_code &error) {
+            const auto hash = transaction.getTransactionHash();
+
+            logger(Logging::DEBUGGING) << "Failed to validate transaction " << hash << ": " << error.message();
+
+            if (transactionPool->checkIfTransactionPresent(hash))
+            {
+                logger(Logging::DEBUGGING) << "Invalid transaction " << hash << " is present in the pool, removing";
+                transactionPool->removeTransaction(hash);
+                notifyObservers(makeDelTransactionMessage({hash}, Messages::DeleteTransaction::Reason::NotActual));
+            }
+
+            return error;
+        };
+
+        /* The rings of every transaction in the block are verified together
+           once the cheaper checks have passed for all of them */
+        RingSignatureBatch ringSignatures(cache, m_transactionValidationThreadPool, previousBlockIndex, false);
+
         for (const auto &transaction : transactions)
         {
             uint64_t fee = 0;
             auto transactionValidationResult =
-                validateTransaction(transaction, validatorState, cache, m_transactionValidationThreadPool, fee, previousBlockIndex, false);
+                validateTransaction(transaction, validatorState, cache, ringSignatures, fee, previousBlockIndex);
 
             if (transactionValidationResult)
             {
-                const auto hash = transaction.getTransactionHash();
-
-                logger(Logging::DEBUGGING) << "Failed to validate transaction " << hash
-                                           << ": " << transactionValidationResult.message();
-
-                if (transactionPool->checkIfTransactionPresent(hash))
-                {
-                    logger(Logging::DEBUGGING) << "Invalid transaction " << hash << " is present in the pool, removing";
-                    transactionPool->removeTransaction(hash);
-                    notifyObservers(makeDelTransactionMessage({hash}, Messages::DeleteTransaction::Reason::NotActual));
-                }
-
-                return transactionValidationResult;
+                return rejectTransaction(transaction, transactionValidationResult);
             }
 
             cumulativeFee += fee;
         }
 
+        if (const auto failure = ringSignatures.verify())
+        {
+            return rejectTransaction(transactions[failure->transactionIndex], failure->errorCode);
+        }
+
         uint64_t reward = 0;
         int64_t emissionChange = 0;
         auto alreadyGeneratedCoins = cache->getAlreadyGeneratedCoins(previousBlockIndex);
@@ -1306,13 +1364,13 @@ namespace CryptoNote
                 reward,
                 emissionChange))
         {
-            logger(Logging::DEBUGGING) << "Block " << blockStr << " has too big cumulative size";
+            logger(Logging::DEBUGGING) << "Block " << blockDescription << " has too big cumulative size";
             return error::BlockValidationError::CUMULATIVE_BLOCK_SIZE_TOO_BIG;
         }
 
         if (minerReward != reward)
         {
-            logger(Logging::DEBUGGING) << "Block reward mismatch for block " << blockStr
+            logger(Logging::DEBUGGING) << "Block reward mismatch for block " << blockDescription
                                        << ". Expected reward: " << reward << ", got reward: " << minerReward;
             return error::BlockValidationError::BLOCK_REWARD_MISMATCH;
         }
@@ -1321,13 +1379,13 @@ namespace CryptoNote
         {
             if (!checkpoints.checkBlock(cachedBlock.getBlockIndex(), cachedBlock.getBlockHash()))
             {
-                logger(Logging::WARNING) << "Checkpoint block hash mismatch for block " << blockStr;
+                logger(Logging::WARNING) << "Checkpoint block hash mismatch for block " << blockDescription;
                 return error::BlockValidationError::CHECKPOINT_BLOCK_HASH_MISMATCH;
             }
         }
         else if (!currency.checkProofOfWork(cachedBlock, currentDifficulty))
         {
-            logger(Logging::DEBUGGING) << "Proof of work too weak for block " << blockStr;
+            logger(Logging::DEBUGGING) << "Proof of work too weak for block " << blockDescription;
             return error::BlockValidationError::PROOF_OF_WORK_TOO_WEAK;
         }
 
@@ -1362,10 +1420,10 @@ namespace CryptoNote
                     checkAndRemoveInvalidPoolTransactions(validatorState);
 
                     ret = error::AddBlockErrorCode::ADDED_TO_MAIN;
-                    logger(Logging::DEBUGGING) << "Block " << blockStr << " added to main chain.";
+                    logger(Logging::DEBUGGING) << "Block " << blockDescription << " added to main chain.";
                     if ((previousBlockIndex + 1) % 100 == 0)
                     {
-                        logger(Logging::INFO) << "Block " << blockStr << " added to main chain";
+                        logger(Logging::INFO) << "Block " << blockDescription << " added to main chain";
                     }
 
                     notifyObservers(
@@ -1381,7 +1439,7 @@ namespace CryptoNote
                         emissionChange,
                         currentDifficulty,
                         std::move(rawBlock));
-                    logger(Logging::DEBUGGING) << "Block " << blockStr << " added to alternative chain.";
+                    logger(Logging::DEBUGGING) << "Block " << blockDescription << " added to alternative chain.";
 
                     auto mainChainCache = chainsLeaves[0];
                     if (cache->getCurrentCumulativeDifficulty() > mainChainCache->getCurrentCumulativeDifficulty())
@@ -1406,7 +1464,7 @@ namespace CryptoNote
 
                         ret = error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE_AND_SWITCHED;
 
-                        logger(Logging::INFO) << "Resolved: " << blockStr
+                        logger(Logging::INFO) << "Resolved: " << blockDescription
                                               << ", Previous: " << chainsLeaves[endpointIndex]->getTopBlockIndex()
                                               << " (" << chainsLeaves[endpointIndex]->getTopBlockHash() << ")";
                     }
@@ -1423,7 +1481,7 @@ namespace CryptoNote
                 chainsStorage.emplace_back(std::move(newCache));
                 chainsLeaves.push_back(newlyForkedChainPtr);
 
-                logger(Logging::DEBUGGING) << "Resolving: " << blockStr;
+                logger(Logging::DEBUGGING) << "Resolving: " << blockDescription;
 
                 newlyForkedChainPtr->pushBlock(
                     cachedBlock,
@@ -1440,7 +1498,7 @@ namespace CryptoNote
         }
         else
         {
-            logger(Logging::DEBUGGING) << "Resolving: " << blockStr;
+            logger(Logging::DEBUGGING) << "Resolving: " << blockDescription;
 
             auto upperSegment = cache->split(previousBlockIndex + 1);
             //[cache] is lower segment now
@@ -1479,7 +1537,7 @@ namespace CryptoNote
             updateMainChainSet();
         }
 
-        logger(Logging::DEBUGGING) << "Block: " << blockStr << " successfully added";
+        logger(Logging::DEBUGGING) << "Block: " << blockDescription << " successfully added";
         notifyOnSuccess(ret, previousBlockIndex, cachedBlock, *cache);
 
         return ret;
@@ -1891,6 +1949,15 @@ namespace CryptoNote
         return transactionPool->getTransactionHashes();
     }
 
+    std::vector<std::optional<Crypto::Hash>> Core::getPoolTransactionHashesByShortId(
+        const Crypto::Hash &salt,
+        const std::vector<uint64_t> &shortIds) const
+    {
+        throwIfNotInitialized();
+
+        return transactionPool->getTransactionHashesByShortId(salt, shortIds);
+    }
+
     std::tuple<bool, CryptoNote::BinaryArray> Core::getPoolTransaction(const Crypto::Hash &transactionHash) const
     {
         if (transactionPool->checkIfTransactionPresent(transactionHash))
@@ -1912,7 +1979,8 @@ namespace CryptoNote
         throwIfNotInitialized();
 
         std::vector<Crypto::Hash> newTransactions;
-        getTransactionPoolDifference(knownHashes, newTransactions, deletedTransactions);
+        getTransactionPoolDifference(
+            transactionPool->getTransactionHashes(), knownHashes, newTransactions, deletedTransactions);
 
         addedTransactions.reserve(newTransactions.size());
         for (const auto &hash : newTransactions)
@@ -1926,21 +1994,40 @@ namespace CryptoNote
     bool Core::getPoolChangesLite(
         const Crypto::Hash &lastBlockHash,
         const std::vector<Crypto::Hash> &knownHashes,
+        const uint64_t knownSequence,
         std::vector<TransactionPrefixInfo> &addedTransactions,
-        std::vector<Crypto::Hash> &deletedTransactions) const
+        std::vector<Crypto::Hash> &deletedTransactions,
+        uint64_t &currentSequence) const
     {
         throwIfNotInitialized();
 
         std::vector<Crypto::Hash> newTransactions;
-        getTransactionPoolDifference(knownHashes, newTransactions, deletedTransactions);
+
+        if (!transactionPool->getTransactionChanges(knownSequence, newTransactions, deletedTransactions, currentSequence))
+        {
+            /* Too far behind, we've been given the whole pool instead */
+            const std::vector<Crypto::Hash> poolHashes = std::move(newTransactions);
+
+            newTransactions.clear();
+
+            getTransactionPoolDifference(poolHashes, knownHashes, newTransactions, deletedTransactions);
+        }
 
         addedTransactions.reserve(newTransactions.size());
         for (const auto &hash : newTransactions)
         {
+            /* May have been removed since we looked, in which case the client
+               will be told it was deleted next time, and ignore that */
+            const auto transaction = transactionPool->tryGetTransaction(hash);
+
+            if (!transaction)
+            {
+                continue;
+            }
+
             TransactionPrefixInfo transactionPrefixInfo;
             transactionPrefixInfo.txHash = hash;
-            transactionPrefixInfo.txPrefix =
-                static_cast<const TransactionPrefix &>(transactionPool->getTransaction(hash).getTransaction());
+            transactionPrefixInfo.txPrefix = static_cast<const TransactionPrefix &>(transaction->getTransaction());
             addedTransactions.emplace_back(std::move(transactionPrefixInfo));
         }
 
@@ -2272,7 +2359,7 @@ namespace CryptoNote
         const CachedTransaction &cachedTransaction,
         TransactionValidatorState &state,
         IBlockchainCache *cache,
-        Utilities::ThreadPool<bool> &threadPool,
+        Utilities::ThreadPool &threadPool,
         uint64_t &fee,
         uint32_t blockIndex,
         const bool isPoolTransaction)
@@ -2296,6 +2383,33 @@ namespace CryptoNote
         return result.errorCode;
     }
 
+    std::error_code Core::validateTransaction(
+        const CachedTransaction &cachedTransaction,
+        TransactionValidatorState &state,
+        IBlockchainCache *cache,
+        RingSignatureBatch &ringSignatures,
+        uint64_t &fee,
+        uint32_t blockIndex)
+    {
+        ValidateTransaction txValidator(
+            cachedTransaction,
+            state,
+            cache,
+            currency,
+            checkpoints,
+            m_transactionValidationThreadPool,
+            blockIndex,
+            blockMedianSize,
+            false /* Block transaction */
+        );
+
+        const auto result = txValidator.validate(ringSignatures);
+
+        fee = result.fee;
+
+        return result.errorCode;
+    }
+
     uint32_t Core::findBlockchainSupplement(const std::vector<Crypto::Hash> &remoteBlockIds) const
     {
         /* Requester doesn't know anything about the chain yet */
@@ -2541,64 +2655,145 @@ namespace CryptoNote
 
         auto previousBlockHash = getBlockHash(mainChainStorage->getBlockByIndex(commonIndex));
         auto blockCount = mainChainStorage->getBlockCount();
-        for (uint32_t i = commonIndex + 1; i < blockCount; ++i)
-        {
-            RawBlock rawBlock = mainChainStorage->getBlockByIndex(i);
-            auto blockTemplate = extractBlockTemplate(rawBlock);
-            CachedBlock cachedBlock(blockTemplate);
 
-            if (blockTemplate.previousBlockHash != previousBlockHash)
+        /* Blocks covered by the checkpoints are trusted, so they are written
+           a batch at a time, rather than with a database write per block */
+        bool bulkImport = false;
+
+        try
+        {
+            for (uint32_t batchStart = commonIndex + 1; batchStart < blockCount; batchStart += IMPORT_BATCH_SIZE)
             {
-                logger(Logging::ERROR)
-                    << "Local blockchain corruption detected. " << std::endl
-                    << "Block with index " << i << " and hash " << cachedBlock.getBlockHash()
-                    << " has previous block hash " << blockTemplate.previousBlockHash << ", but parent has hash "
-                    << previousBlockHash << "." << std::endl
-                    << "Please try to repair this issue by starting the node with the option: --rewind-to-height " << i
-                    << std::endl
-                    << "If the above does not repair the issue, please launch the node with the option: --resync"
-                    << std::endl;
-                throw std::system_error(make_error_code(error::CoreErrorCode::CORRUPTED_BLOCKCHAIN));
-            }
+                const uint32_t batchEnd = std::min(blockCount, batchStart + IMPORT_BATCH_SIZE);
 
-            previousBlockHash = cachedBlock.getBlockHash();
+                std::vector<RawBlock> rawBlocks;
+                rawBlocks.reserve(batchEnd - batchStart);
 
-            std::vector<CachedTransaction> transactions;
-            uint64_t cumulativeSize = 0;
-            if (!extractTransactions(rawBlock.transactions, transactions, cumulativeSize))
-            {
-                logger(Logging::ERROR) << "Couldn't deserialize raw block transactions in block "
-                                       << cachedBlock.getBlockHash();
-                throw std::system_error(make_error_code(error::AddBlockErrorCode::DESERIALIZATION_FAILED));
-            }
+                for (uint32_t i = batchStart; i < batchEnd; ++i)
+                {
+                    rawBlocks.push_back(mainChainStorage->getBlockByIndex(i));
+                }
 
-            cumulativeSize += getObjectBinarySize(blockTemplate.baseTransaction);
-            TransactionValidatorState spentOutputs = extractSpentOutputs(transactions);
-            auto currentDifficulty = chainsLeaves[0]->getDifficultyForNextBlock(i - 1);
+                std::vector<BlockTemplate> blockTemplates(rawBlocks.size());
+                std::vector<std::optional<CachedBlock>> cachedBlocks(rawBlocks.size());
+                std::vector<PreparedBlock> preparedBlocks(rawBlocks.size());
 
-            uint64_t cumulativeFee = std::accumulate(
-                transactions.begin(),
-                transactions.end(),
-                UINT64_C(0),
-                [](uint64_t fee, const CachedTransaction &transaction) {
-                    return fee + transaction.getTransactionFee();
+                /* Deserializing and hashing the blocks doesn't depend on the
+                   chain, so do that for the whole batch across all cores */
+                m_transactionValidationThreadPool.parallelFor(rawBlocks.size(), [&](const size_t j) {
+                    if (fromBinaryArray(blockTemplates[j], rawBlocks[j].block))
+                    {
+                        cachedBlocks[j].emplace(blockTemplates[j]);
+                        cachedBlocks[j]->getBlockHash();
+                        preparedBlocks[j] = prepareBlock(*cachedBlocks[j], rawBlocks[j], false);
+                    }
                 });
 
-            int64_t emissionChange =
-                getEmissionChange(currency, *chainsLeaves[0], i - 1, cachedBlock, cumulativeSize, cumulativeFee);
-            chainsLeaves[0]->pushBlock(
-                cachedBlock,
-                transactions,
-                spentOutputs,
-                cumulativeSize,
-                emissionChange,
-                currentDifficulty,
-                std::move(rawBlock));
+                if (checkpoints.isInCheckpointZone(batchStart))
+                {
+                    chainsLeaves[0]->beginBulkImport();
+                    bulkImport = true;
+                }
+
+                for (uint32_t i = batchStart; i < batchEnd; ++i)
+                {
+                    const size_t j = i - batchStart;
 
-            if (i % 1000 == 0)
+                    if (bulkImport && !checkpoints.isInCheckpointZone(i))
+                    {
+                        chainsLeaves[0]->commitBulkImport();
+                        bulkImport = false;
+                    }
+
+                    if (!cachedBlocks[j])
+                    {
+                        throw std::system_error(make_error_code(error::AddBlockErrorCode::DESERIALIZATION_FAILED));
+                    }
+
+                    const auto &cachedBlock = *cachedBlocks[j];
+                    const auto &blockTemplate = blockTemplates[j];
+
+                    if (blockTemplate.previousBlockHash != previousBlockHash)
+                    {
+                        logger(Logging::ERROR)
+                            << "Local blockchain corruption detected. " << std::endl
+                            << "Block with index " << i << " and hash " << cachedBlock.getBlockHash()
+                            << " has previous block hash " << blockTemplate.previousBlockHash
+                            << ", but parent has hash " << previousBlockHash << "." << std::endl
+                            << "Please try to repair this issue by starting the node with the option: "
+                            << "--rewind-to-height " << i << std::endl
+                            << "If the above does not repair the issue, please launch the node with the option: "
+                            << "--resync" << std::endl;
+                        throw std::system_error(make_error_code(error::CoreErrorCode::CORRUPTED_BLOCKCHAIN));
+                    }
+
+                    /* As the blocks are linked by hash, this vouches for every
+                       block below the checkpoint too */
+                    if (!checkpoints.checkBlock(i, cachedBlock.getBlockHash()))
+                    {
+                        logger(Logging::ERROR) << "Local blockchain doesn't match the checkpoint at index " << i
+                                               << ". Please launch the node with the option: --resync";
+                        throw std::system_error(make_error_code(error::CoreErrorCode::CORRUPTED_BLOCKCHAIN));
+                    }
+
+                    previousBlockHash = cachedBlock.getBlockHash();
+
+                    if (!preparedBlocks[j].success)
+                    {
+                        logger(Logging::ERROR) << "Couldn't deserialize raw block transactions in block "
+                                               << cachedBlock.getBlockHash();
+                        throw std::system_error(make_error_code(error::AddBlockErrorCode::DESERIALIZATION_FAILED));
+                    }
+
+                    const auto &transactions = preparedBlocks[j].transactions;
+
+                    uint64_t cumulativeSize =
+                        preparedBlocks[j].cumulativeSize + getObjectBinarySize(blockTemplate.baseTransaction);
+                    TransactionValidatorState spentOutputs = extractSpentOutputs(transactions);
+                    auto currentDifficulty = chainsLeaves[0]->getDifficultyForNextBlock(i - 1);
+
+                    uint64_t cumulativeFee = std::accumulate(
+                        transactions.begin(),
+                        transactions.end(),
+                        UINT64_C(0),
+                        [](uint64_t fee, const CachedTransaction &transaction) {
+                            return fee + transaction.getTransactionFee();
+                        });
+
+                    int64_t emissionChange = getEmissionChange(
+                        currency, *chainsLeaves[0], i - 1, cachedBlock, cumulativeSize, cumulativeFee);
+                    chainsLeaves[0]->pushBlock(
+                        cachedBlock,
+                        transactions,
+                        spentOutputs,
+                        cumulativeSize,
+                        emissionChange,
+                        currentDifficulty,
+                        std::move(rawBlocks[j]));
+
+                    if (i % 1000 == 0)
+                    {
+                        logger(Logging::INFO) << "Imported block with index " << i << " / " << (blockCount - 1);
+                    }
+                }
+
+                if (bulkImport)
+                {
+                    chainsLeaves[0]->commitBulkImport();
+                    bulkImport = false;
+                }
+            }
+        }
+        catch (...)
+        {
+            /* Keep what was imported before the failure, the blocks already
+               pushed are good */
+            if (bulkImport)
             {
-                logger(Logging::INFO) << "Imported block with index " << i << " / " << (blockCount - 1);
+                chainsLeaves[0]->commitBulkImport();
             }
+
+            throw;
         }
     }
 
@@ -2921,13 +3116,12 @@ namespace CryptoNote
     }
 
     void Core::getTransactionPoolDifference(
+        const std::vector<Crypto::Hash> &poolHashes,
         const std::vector<Crypto::Hash> &knownHashes,
         std::vector<Crypto::Hash> &newTransactions,
         std::vector<Crypto::Hash> &deletedTransactions) const
     {
-        auto t = transactionPool->getTransactionHashes();
-
-        std::unordered_set<Crypto::Hash> poolTransactions(t.begin(), t.end());
+        std::unordered_set<Crypto::Hash> poolTransactions(poolHashes.begin(), poolHashes.end());
         std::unordered_set<Crypto::Hash> knownTransactions(knownHashes.begin(), knownHashes.end());
 
         for (auto it = poolTransactions.begin(), end = poolTransactions.end(); it != end;)
@@ -2974,8 +3168,28 @@ namespace CryptoNote
 
     /* A transaction that is valid at the time it was added to the pool, is not
        neccessarily valid now, if the network rules changed. */
-    bool Core::validateBlockTemplateTransaction(const CachedTransaction &cachedTransaction, const uint64_t blockHeight)
+    bool Core::validateBlockTemplateTransaction(
+        const CachedTransaction &cachedTransaction,
+        const Crypto::Hash &previousBlockHash,
+        const uint64_t blockHeight)
     {
+        const size_t medianSize = blockMedianSize;
+
+        {
+            std::scoped_lock lock(m_templateValidityMutex);
+
+            if (previousBlockHash != m_templateValidityParent || medianSize != m_templateValidityMedianSize)
+            {
+                m_validTemplateTransactions.clear();
+                m_templateValidityParent = previousBlockHash;
+                m_templateValidityMedianSize = medianSize;
+            }
+            else if (m_validTemplateTransactions.count(cachedTransaction.getTransactionHash()) > 0)
+            {
+                return true;
+            }
+        }
+
         /* Not used in revalidateAfterHeightChange() */
         TransactionValidatorState state;
 
@@ -2987,12 +3201,22 @@ namespace CryptoNote
             checkpoints,
             m_transactionValidationThreadPool,
             blockHeight,
-            blockMedianSize,
+            medianSize,
             true /* Pool transaction */
         );
 
         const auto result = txValidator.revalidateAfterHeightChange();
 
+        if (result.valid)
+        {
+            std::scoped_lock lock(m_templateValidityMutex);
+
+            if (previousBlockHash == m_templateValidityParent && medianSize == m_templateValidityMedianSize)
+            {
+                m_validTemplateTransactions.insert(cachedTransaction.getTransactionHash());
+            }
+        }
+
         return result.valid;
     }
 
@@ -3011,74 +3235,33 @@ namespace CryptoNote
 
         maxTotalSize = std::min(maxTotalSize, maxCumulativeSize) - currency.minerTxBlobReservedSize();
 
-        TransactionSpentInputsChecker spentInputsChecker;
-
-        /* Go get our regular and fusion transactions from the transaction pool */
-        auto [regularTransactions, fusionTransactions] = transactionPool->getPoolTransactionsForBlockTemplate();
-
-        /* Define our lambda function for checking and adding transactions to a block template */
-        const auto addTransactionToBlockTemplate =
-            [this, &spentInputsChecker, maxTotalSize, height, &transactionsSize, &fee, &block](
-                const CachedTransaction &transaction) {
-                /* If the current set of transactions included in the blocktemplate plus the transaction
-                   we just passed in exceed the maximum size of a block, it won't fit so we'll move on */
-                if (transactionsSize + transaction.getTransactionBinaryArray().size() > maxTotalSize)
-                {
-                    return false;
-                }
-
+        /* Transactions we have already checked on top of this block aren't
+           checked again, so this stays cheap when called often */
+        const auto selected = transactionPool->selectTransactionsForBlockTemplate(
+            maxTotalSize, [this, &block, height](const CachedTransaction &transaction) {
                 /* Check to validate that the transaction is valid for a block at this height */
-                if (!validateBlockTemplateTransaction(transaction, height))
-                {
-                    transactionPool->removeTransaction(transaction.getTransactionHash());
-
-                    return false;
-                }
-
-                /* Make sure that we have not already spent funds in this same block via
-                   another transaction that we've already included in this block template */
-                if (!spentInputsChecker.haveSpentInputs(transaction.getTransaction()))
-                {
-                    transactionsSize += transaction.getTransactionBinaryArray().size();
-
-                    fee += transaction.getTransactionFee();
-
-                    block.transactionHashes.emplace_back(transaction.getTransactionHash());
+                return validateBlockTemplateTransaction(transaction, block.previousBlockHash, height);
+            });
 
-                    return true;
-                }
-                else
-                {
-                    return false;
-                }
-            };
+        const bool logTransactions = logger.isEnabled(Logging::TRACE);
 
-        /* First we're going to loop through transactions that have a fee:
-           ie. the transactions that are paying to use the network */
-        for (const auto &transaction : regularTransactions)
+        for (const auto &hash : selected.invalidTransactions)
         {
-            if (addTransactionToBlockTemplate(transaction))
+            if (logTransactions)
             {
-                logger(Logging::TRACE) << "Transaction " << transaction.getTransactionHash()
-                                       << " included in block template";
+                logger(Logging::TRACE) << "Transaction " << hash << " no longer valid, removing from pool";
             }
-            else
-            {
-                logger(Logging::TRACE) << "Transaction " << transaction.getTransactionHash()
-                                       << " not included in block template";
-            }
-        }
 
-        /* Then we'll loop through the fusion transactions as they don't
-           pay anything to use the network */
-        for (const auto &transaction : fusionTransactions)
-        {
-            if (addTransactionToBlockTemplate(transaction))
-            {
-                logger(Logging::TRACE) << "Fusion transaction " << transaction.getTransactionHash()
-                                       << " included in block template";
-            }
+            transactionPool->removeTransaction(hash);
         }
+
+        block.transactionHashes.insert(
+            block.transactionHashes.end(), selected.transactionHashes.begin(), selected.transactionHashes.end());
+
+        transactionsSize = selected.transactionsSize;
+        fee = selected.fee;
+
+        logger(Logging::TRACE) << block.transactionHashes.size() << " transactions included in block template";
     }
 
     void Core::deleteAlternativeChains()
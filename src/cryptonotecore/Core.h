@@ -20,13 +20,18 @@
 #include "ITransactionPoolCleaner.h"
 #include "IUpgradeManager.h"
 #include "MessageQueue.h"
+#include "RingSignatureBatch.h"
 #include "TransactionValidatiorState.h"
 
 #include <WalletTypes.h>
+#include <chrono>
+#include <condition_variable>
+#include <config/Constants.h>
 #include <ctime>
 #include <logging/LoggerMessage.h>
 #include <system/ContextGroup.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <utilities/ThreadPool.h>
 #include <vector>
 
@@ -145,6 +150,13 @@ namespace CryptoNote
 
         virtual std::error_code addBlock(RawBlock &&rawBlock) override;
 
+        virtual std::error_code
+            addBlock(const CachedBlock &cachedBlock, RawBlock &&rawBlock, PreparedBlock &&preparedBlock) override;
+
+        virtual std::vector<PreparedBlock> prepareBlocks(
+            const std::vector<CachedBlock> &cachedBlocks,
+            const std::vector<RawBlock> &rawBlocks) override;
+
         virtual std::error_code submitBlock(const BinaryArray &rawBlockTemplate) override;
 
         virtual bool getTransactionGlobalIndexes(
@@ -168,17 +180,26 @@ namespace CryptoNote
 
         virtual std::tuple<bool, BinaryArray> getPoolTransaction(const Crypto::Hash &transactionHash) const override;
 
+        virtual std::vector<std::optional<Crypto::Hash>> getPoolTransactionHashesByShortId(
+            const Crypto::Hash &salt,
+            const std::vector<uint64_t> &shortIds) const override;
+
         virtual bool getPoolChanges(
             const Crypto::Hash &lastBlockHash,
             const std::vector<Crypto::Hash> &knownHashes,
             std::vector<BinaryArray> &addedTransactions,
             std::vector<Crypto::Hash> &deletedTransactions) const override;
 
+        /* If knownSequence, a sequence number returned from a previous call,
+           is still recent enough, only the changes since then are looked up,
+           otherwise the pool is diffed against knownHashes */
         virtual bool getPoolChangesLite(
             const Crypto::Hash &lastBlockHash,
             const std::vector<Crypto::Hash> &knownHashes,
+            const uint64_t knownSequence,
             std::vector<TransactionPrefixInfo> &addedTransactions,
-            std::vector<Crypto::Hash> &deletedTransactions) const override;
+            std::vector<Crypto::Hash> &deletedTransactions,
+            uint64_t &currentSequence) const override;
 
         virtual std::tuple<bool, std::string> getBlockTemplate(
             BlockTemplate &b,
@@ -188,6 +209,15 @@ namespace CryptoNote
             uint64_t &difficulty,
             uint32_t &height) override;
 
+        virtual uint64_t getPoolVersion() const override;
+
+        virtual uint64_t getChainSwitchCount() const override;
+
+        virtual void waitForBlockTemplateChange(
+            const Crypto::Hash &topBlockHash,
+            const uint64_t poolVersion,
+            const std::chrono::steady_clock::time_point until) const override;
+
         virtual CoreStatistics getCoreStatistics() const override;
 
         virtual std::time_t getStartTime() const;
@@ -220,10 +250,6 @@ namespace CryptoNote
 
         virtual uint64_t get_current_blockchain_height() const;
 
-        static WalletTypes::RawCoinbaseTransaction getRawCoinbaseTransaction(const CryptoNote::Transaction &t);
-
-        static WalletTypes::RawTransaction getRawTransaction(const std::vector<uint8_t> &rawTX);
-
         CryptoNote::RawBlock getRawBlock(uint32_t blockIndex) const;
 
         CryptoNote::RawBlock getRawBlock(const Crypto::Hash &blockHash) const;
@@ -257,7 +283,7 @@ namespace CryptoNote
 
         std::unique_ptr<IMainChainStorage> mainChainStorage;
 
-        Utilities::ThreadPool<bool> m_transactionValidationThreadPool;
+        Utilities::ThreadPool m_transactionValidationThreadPool;
 
         bool initialized;
 
@@ -272,15 +298,25 @@ namespace CryptoNote
             std::vector<CachedTransaction> &transactions,
             uint64_t &cumulativeSize);
 
+        PreparedBlock prepareBlock(const CachedBlock &cachedBlock, const RawBlock &rawBlock, bool computeLongHash);
+
         std::error_code validateTransaction(
             const CachedTransaction &transaction,
             TransactionValidatorState &state,
             IBlockchainCache *cache,
-            Utilities::ThreadPool<bool> &threadPool,
+            Utilities::ThreadPool &threadPool,
             uint64_t &fee,
             uint32_t blockIndex,
             const bool isPoolTransaction);
 
+        std::error_code validateTransaction(
+            const CachedTransaction &transaction,
+            TransactionValidatorState &state,
+            IBlockchainCache *cache,
+            RingSignatureBatch &ringSignatures,
+            uint64_t &fee,
+            uint32_t blockIndex);
+
         uint32_t findBlockchainSupplement(const std::vector<Crypto::Hash> &remoteBlockIds) const;
 
         std::vector<Crypto::Hash> getBlockHashes(uint32_t startBlockIndex, uint32_t maxCount) const;
@@ -350,6 +386,7 @@ namespace CryptoNote
             std::vector<BlockDetails> &entries) const;
 
         void getTransactionPoolDifference(
+            const std::vector<Crypto::Hash> &poolHashes,
             const std::vector<Crypto::Hash> &knownHashes,
             std::vector<Crypto::Hash> &newTransactions,
             std::vector<Crypto::Hash> &deletedTransactions) const;
@@ -358,7 +395,10 @@ namespace CryptoNote
 
         size_t calculateCumulativeBlocksizeLimit(uint32_t height) const;
 
-        bool validateBlockTemplateTransaction(const CachedTransaction &cachedTransaction, const uint64_t blockHeight);
+        bool validateBlockTemplateTransaction(
+            const CachedTransaction &cachedTransaction,
+            const Crypto::Hash &previousBlockHash,
+            const uint64_t blockHeight);
 
         void fillBlockTemplate(
             BlockTemplate &block,
@@ -413,6 +453,31 @@ namespace CryptoNote
         void switchMainChainStorage(uint32_t splitBlockIndex, IBlockchainCache &newChain);
 
         std::mutex m_submitBlockMutex;
+
+        /* Pool transactions known to be valid for a block template on top of
+           the given block, with the given median size. Keyed on the parent
+           rather than the height, so a reorg to a different block at the same
+           height, which may have spent their inputs, checks them again. */
+        std::mutex m_templateValidityMutex;
+
+        Crypto::Hash m_templateValidityParent = Constants::NULL_HASH;
+
+        size_t m_templateValidityMedianSize = 0;
+
+        std::unordered_set<Crypto::Hash> m_validTemplateTransactions;
+
+        /* Lets RPC threads wait for the inputs to the block template to
+           change, fed from the same messages as the message queues */
+        mutable std::mutex m_templateChangedMutex;
+
+        mutable std::condition_variable m_templateChanged;
+
+        /* Bumped on every new main chain block or chain switch */
+        uint64_t m_chainVersion = 0;
+
+        uint64_t m_poolVersion = 0;
+
+        uint64_t m_chainSwitchCount = 0;
     };
 
 } // namespace CryptoNote
@@ -5,6 +5,9 @@
 
 #include "DBUtils.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace
 {
     const std::string RAW_BLOCK_NAME = "raw_block";
@@ -36,5 +39,43 @@ namespace CryptoNote
             serializer(value.block, RAW_BLOCK_NAME);
             serializer(value.transactions, RAW_TXS_NAME);
         }
+
+        std::string getKeyPrefix(const std::string &rawKey)
+        {
+            /* The prefix is the name of the only field in the key, so it sits
+               at the same offset in every key, after the same header */
+            static const std::string sampleKey = serializeKey("?", uint8_t(0));
+            static const size_t prefixOffset = sampleKey.find('?');
+
+            if (rawKey.size() <= prefixOffset || rawKey.compare(0, prefixOffset, sampleKey, 0, prefixOffset) != 0)
+            {
+                return std::string();
+            }
+
+            return rawKey.substr(prefixOffset, 1);
+        }
+
+        size_t getKeyOutputPrefixLength(const std::string &keyPrefix)
+        {
+            const auto first = serializeKey(keyPrefix, std::make_pair(uint64_t(0), uint32_t(0)));
+            const auto last = serializeKey(keyPrefix, std::make_pair(uint64_t(0), std::numeric_limits<uint32_t>::max()));
+
+            return std::mismatch(first.begin(), first.end(), last.begin()).first - first.begin();
+        }
+
+        std::string getKeyOutputCountKeyPrefix()
+        {
+            /* The amount is the last field, so it is the end of the key */
+            const auto key = serializeKey(KEY_OUTPUT_AMOUNT_PREFIX, uint64_t(0));
+
+            return key.substr(0, key.size() - sizeof(uint64_t));
+        }
+
+        bool isKeyOutputCountKey(const std::string &rawKey)
+        {
+            static const std::string prefix = getKeyOutputCountKeyPrefix();
+
+            return rawKey.size() == prefix.size() + sizeof(uint64_t) && rawKey.compare(0, prefix.size(), prefix) == 0;
+        }
     } // namespace DB
 } // namespace CryptoNote
@@ -38,6 +38,8 @@ namespace CryptoNote
 
         const std::string TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX = "a";
 
+        const std::string BLOCK_INDEX_TO_WALLET_BLOCK_INFO_PREFIX = "c";
+
         const std::string KEY_OUTPUT_AMOUNT_PREFIX = "b";
 
         const std::string CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX = "e";
@@ -139,5 +141,21 @@ namespace CryptoNote
                 ++serializedValuesIter;
             }
         }
+
+        /* Returns the prefix a key made by serializeKey() was built with, or
+           an empty string for keys which weren't, such as the scheme version */
+        std::string getKeyPrefix(const std::string &rawKey);
+
+        /* Returns how many leading bytes of a key output key are shared by
+           every global index of the same amount, for use as a prefix */
+        size_t getKeyOutputPrefixLength(const std::string &keyPrefix);
+
+        /* The bytes every amount to output count key under
+           KEY_OUTPUT_AMOUNT_PREFIX starts with, before the amount */
+        std::string getKeyOutputCountKeyPrefix();
+
+        /* Whether a KEY_OUTPUT_AMOUNT_PREFIX key is the output count of an
+           amount, rather than one of the amount's global indexes */
+        bool isKeyOutputCountKey(const std::string &rawKey);
     } // namespace DB
 } // namespace CryptoNote
@@ -15,6 +15,7 @@
 #include <cryptonotecore/CryptoNoteBasicImpl.h>
 #include <cryptonotecore/DatabaseBlockchainCache.h>
 #include <cstdlib>
+#include <cstring>
 #include <ctime>
 
 namespace CryptoNote
@@ -467,17 +468,6 @@ namespace CryptoNote
             }
         }
 
-        void cutTail(std::deque<CachedBlockInfo> &cache, size_t count)
-        {
-            if (count >= cache.size())
-            {
-                cache.clear();
-                return;
-            }
-
-            cache.erase(std::next(cache.begin(), cache.size() - count), cache.end());
-        }
-
         const std::string DB_VERSION_KEY = "db_scheme_version";
 
         class DatabaseVersionReadBatch : public IReadBatch
@@ -534,7 +524,115 @@ namespace CryptoNote
             uint32_t schemeVersion;
         };
 
-        const uint32_t CURRENT_DB_SCHEME_VERSION = 2;
+        const std::string KEY_IMAGE_FILTER_KEY = "key_image_filter";
+
+        const std::string BLOCK_INFO_COLUMNS_KEY = "block_info_columns";
+
+        /* A snapshot of in memory state derived from the chain, such as the
+           key image filter, and the block it is up to date with. The block
+           hash is stored so a snapshot taken before a reorg can be detected,
+           and thrown away. */
+        struct ChainSnapshot
+        {
+            uint32_t blockIndex;
+
+            Crypto::Hash blockHash;
+
+            std::string data;
+        };
+
+        class ChainSnapshotReadBatch : public IReadBatch
+        {
+          public:
+            explicit ChainSnapshotReadBatch(const std::string &key): key(key) {}
+
+            virtual ~ChainSnapshotReadBatch() {}
+
+            virtual std::vector<std::string> getRawKeys() const override
+            {
+                return {key};
+            }
+
+            virtual void
+                submitRawResult(const std::vector<std::string> &values, const std::vector<bool> &resultStates) override
+            {
+                assert(values.size() == 1);
+                assert(resultStates.size() == values.size());
+
+                const size_t headerSize = sizeof(uint32_t) + sizeof(Crypto::Hash);
+
+                if (!resultStates[0] || values[0].size() < headerSize)
+                {
+                    return;
+                }
+
+                ChainSnapshot result;
+
+                std::memcpy(&result.blockIndex, values[0].data(), sizeof(uint32_t));
+                std::memcpy(&result.blockHash, values[0].data() + sizeof(uint32_t), sizeof(Crypto::Hash));
+
+                result.data = values[0].substr(headerSize);
+
+                snapshot = std::move(result);
+            }
+
+            std::optional<ChainSnapshot> &getSnapshot()
+            {
+                return snapshot;
+            }
+
+          private:
+            std::string key;
+
+            std::optional<ChainSnapshot> snapshot;
+        };
+
+        class ChainSnapshotWriteBatch : public IWriteBatch
+        {
+          public:
+            ChainSnapshotWriteBatch(const std::string &key, const ChainSnapshot &snapshot): key(key)
+            {
+                value.reserve(sizeof(uint32_t) + sizeof(Crypto::Hash) + snapshot.data.size());
+                value.append(reinterpret_cast<const char *>(&snapshot.blockIndex), sizeof(uint32_t));
+                value.append(reinterpret_cast<const char *>(&snapshot.blockHash), sizeof(Crypto::Hash));
+                value.append(snapshot.data);
+            }
+
+            virtual ~ChainSnapshotWriteBatch() {}
+
+            virtual std::vector<std::pair<std::string, std::string>> extractRawDataToInsert() override
+            {
+                return {make_pair(key, std::move(value))};
+            }
+
+            virtual std::vector<std::string> extractRawKeysToRemove() override
+            {
+                return {};
+            }
+
+          private:
+            std::string key;
+
+            std::string value;
+        };
+
+        /* How many blocks to read spent key images for at once when filling
+           the key image filter */
+        const uint32_t KEY_IMAGE_FILTER_FILL_BATCH_SIZE = 1000;
+
+        /* How many blocks to read the cached block info of at once when
+           filling the block info columns */
+        const uint32_t BLOCK_INFO_COLUMNS_FILL_BATCH_SIZE = 1000;
+
+        /* How many blocks to build the wallet sync index for at once when
+           upgrading an older database */
+        const uint32_t WALLET_BLOCK_INFO_BUILD_BATCH_SIZE = 1000;
+
+        const uint32_t CURRENT_DB_SCHEME_VERSION = 3;
+
+        /* The last version without the wallet sync index, which load() can
+           build in place rather than resyncing */
+        const uint32_t WALLET_BLOCK_INFO_UPGRADABLE_DB_SCHEME_VERSION = 2;
 
     } // namespace
 
@@ -583,6 +681,10 @@ namespace CryptoNote
             logger(Logging::DEBUGGING) << "top block index is null, add genesis block";
             addGenesisBlock(CachedBlock(currency.genesisBlock()));
         }
+        else
+        {
+            blockInfos.clear(getTopBlockIndex() + 1);
+        }
     }
 
     bool DatabaseBlockchainCache::checkDBSchemeVersion(IDataBase &database, std::shared_ptr<Logging::ILogger> _logger)
@@ -602,6 +704,12 @@ namespace CryptoNote
             // DB scheme version not found. Looks like it was just created.
             return true;
         }
+        else if (*version == WALLET_BLOCK_INFO_UPGRADABLE_DB_SCHEME_VERSION)
+        {
+            logger(Logging::INFO) << "DB scheme version " << *version << " will be upgraded to version "
+                                  << CURRENT_DB_SCHEME_VERSION << " on load.";
+            return true;
+        }
         else if (*version < CURRENT_DB_SCHEME_VERSION)
         {
             logger(Logging::WARNING) << "DB scheme version is less than expected. Expected version "
@@ -668,6 +776,7 @@ namespace CryptoNote
     std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitBlockIndex)
     {
         assert(splitBlockIndex <= getTopBlockIndex());
+        assert(!bulkImport);
         logger(Logging::DEBUGGING) << "split at index " << splitBlockIndex
                                    << " started, top block index: " << getTopBlockIndex();
 
@@ -696,7 +805,9 @@ namespace CryptoNote
             auto &validatorState = std::get<2>(*it);
             uint64_t timestamp = std::get<3>(*it);
 
-            writeBatch.removeCachedBlock(blockHash, blockIndex).removeRawBlock(blockIndex);
+            writeBatch.removeCachedBlock(blockHash, blockIndex)
+                .removeRawBlock(blockIndex)
+                .removeWalletBlockInfo(blockIndex);
             requestDeleteSpentOutputs(writeBatch, blockIndex, validatorState);
             requestRemoveTimestamp(writeBatch, timestamp, blockHash);
         }
@@ -733,7 +844,7 @@ namespace CryptoNote
             throw std::runtime_error(err.message());
         }
 
-        cutTail(unitsCache, currentTop + 1 - splitBlockIndex);
+        blockInfos.truncate(splitBlockIndex);
 
         children.push_back(cache.get());
         logger(Logging::TRACE) << "Delete successfull";
@@ -939,7 +1050,7 @@ namespace CryptoNote
         }
     }
 
-    void DatabaseBlockchainCache::pushTransaction(
+    std::vector<uint32_t> DatabaseBlockchainCache::pushTransaction(
         const CachedTransaction &cachedTransaction,
         uint32_t blockIndex,
         uint16_t transactionBlockIndex,
@@ -1014,13 +1125,22 @@ namespace CryptoNote
         Crypto::Hash paymentId;
         if (getPaymentIdFromTxExtra(cachedTransaction.getTransaction().extra, paymentId))
         {
-            insertPaymentId(batch, cachedTransaction.getTransactionHash(), paymentId);
+            if (bulkImport)
+            {
+                bulkImport->paymentIds.emplace_back(cachedTransaction.getTransactionHash(), paymentId);
+            }
+            else
+            {
+                insertPaymentId(batch, cachedTransaction.getTransactionHash(), paymentId);
+            }
         }
 
         batch.insertCachedTransaction(transactionCacheInfo, getCachedTransactionsCount() + 1);
         transactionsCount = *transactionsCount + 1;
         logger(Logging::DEBUGGING) << "push transaction with hash " << cachedTransaction.getTransactionHash()
                                    << " finished";
+
+        return transactionCacheInfo.globalIndexes;
     }
 
     uint32_t DatabaseBlockchainCache::updateKeyOutputCount(Amount amount, int32_t diff) const
@@ -1108,11 +1228,14 @@ namespace CryptoNote
         uint64_t blockDifficulty,
         RawBlock &&rawBlock)
     {
-        BlockchainWriteBatch batch;
+        BlockchainWriteBatch blockBatch;
+
+        /* When bulk importing, the block is written with the rest on commit */
+        BlockchainWriteBatch &batch = bulkImport ? bulkImport->batch : blockBatch;
+
         logger(Logging::DEBUGGING) << "push block with hash " << cachedBlock.getBlockHash() << ", and "
                                    << cachedTransactions.size() + 1 << " transactions"; //+1 for base transaction
 
-        // TODO: cache top block difficulty, size, timestamp, coins; use it here
         auto lastBlockInfo = getCachedBlockInfo(getTopBlockIndex());
         auto cumulativeDifficulty = lastBlockInfo.cumulativeDifficulty + blockDifficulty;
         auto alreadyGeneratedCoins = lastBlockInfo.alreadyGeneratedCoins + generatedCoins;
@@ -1128,6 +1251,17 @@ namespace CryptoNote
 
         batch.insertSpentKeyImages(getTopBlockIndex() + 1, validatorState.spentKeyImages);
 
+        /* Added before the key images are written, so the filter never says
+           a key image in the database is unspent. If the write fails, the
+           extra entries only cost a database lookup. */
+        if (keyImageFilter)
+        {
+            for (const auto &keyImage : validatorState.spentKeyImages)
+            {
+                keyImageFilter->insert(keyImage);
+            }
+        }
+
         auto txHashes = cachedBlock.getBlock().transactionHashes;
         auto baseTransaction = cachedBlock.getBlock().baseTransaction;
         auto cachedBaseTransaction = CachedTransaction {std::move(baseTransaction)};
@@ -1138,47 +1272,63 @@ namespace CryptoNote
         batch.insertCachedBlock(blockInfo, getTopBlockIndex() + 1, txHashes);
         batch.insertRawBlock(getTopBlockIndex() + 1, std::move(rawBlock));
 
+        std::vector<std::vector<uint32_t>> globalIndexes;
+        globalIndexes.reserve(cachedTransactions.size() + 1);
+
         auto transactionIndex = 0;
-        pushTransaction(cachedBaseTransaction, getTopBlockIndex() + 1, transactionIndex++, batch);
+        globalIndexes.push_back(
+            pushTransaction(cachedBaseTransaction, getTopBlockIndex() + 1, transactionIndex++, batch));
 
         for (const auto &transaction : cachedTransactions)
         {
-            pushTransaction(transaction, getTopBlockIndex() + 1, transactionIndex++, batch);
+            globalIndexes.push_back(pushTransaction(transaction, getTopBlockIndex() + 1, transactionIndex++, batch));
         }
 
-        auto closestBlockIndexDb =
-            requestClosestBlockIndexByTimestamp(roundToMidnight(cachedBlock.getBlock().timestamp), database);
-        if (!closestBlockIndexDb.second)
-        {
-            logger(Logging::ERROR) << "push block " << cachedBlock.getBlockHash()
-                                   << " request closest block index by timestamp failed";
-            throw std::runtime_error("Couldn't get closest to timestamp block index");
-        }
+        /* Everything a wallet needs from this block is at hand now, so store
+           it ready to serve, rather than reparsing the block per sync request */
+        batch.insertWalletBlockInfo(
+            getTopBlockIndex() + 1,
+            {Utils::getWalletBlockInfo(cachedBlock, cachedBaseTransaction, cachedTransactions, globalIndexes)});
 
-        if (!closestBlockIndexDb.first)
+        if (bulkImport)
         {
-            batch.insertClosestTimestampBlockIndex(
-                roundToMidnight(cachedBlock.getBlock().timestamp), getTopBlockIndex() + 1);
+            bulkImport->timestamps.emplace_back(
+                getTopBlockIndex() + 1, cachedBlock.getBlock().timestamp, cachedBlock.getBlockHash());
         }
+        else
+        {
+            auto closestBlockIndexDb =
+                requestClosestBlockIndexByTimestamp(roundToMidnight(cachedBlock.getBlock().timestamp), database);
+            if (!closestBlockIndexDb.second)
+            {
+                logger(Logging::ERROR) << "push block " << cachedBlock.getBlockHash()
+                                       << " request closest block index by timestamp failed";
+                throw std::runtime_error("Couldn't get closest to timestamp block index");
+            }
 
-        insertBlockTimestamp(batch, cachedBlock.getBlock().timestamp, cachedBlock.getBlockHash());
+            if (!closestBlockIndexDb.first)
+            {
+                batch.insertClosestTimestampBlockIndex(
+                    roundToMidnight(cachedBlock.getBlock().timestamp), getTopBlockIndex() + 1);
+            }
 
-        auto res = database.write(batch);
-        if (res)
-        {
-            logger(Logging::ERROR) << "push block " << cachedBlock.getBlockHash() << " write failed: " << res.message();
-            throw std::runtime_error(res.message());
+            insertBlockTimestamp(batch, cachedBlock.getBlock().timestamp, cachedBlock.getBlockHash());
+
+            auto res = database.write(batch);
+            if (res)
+            {
+                logger(Logging::ERROR) << "push block " << cachedBlock.getBlockHash()
+                                       << " write failed: " << res.message();
+                throw std::runtime_error(res.message());
+            }
         }
 
         topBlockIndex = *topBlockIndex + 1;
         topBlockHash = cachedBlock.getBlockHash();
+
         logger(Logging::DEBUGGING) << "push block " << cachedBlock.getBlockHash() << " completed";
 
-        unitsCache.push_back(blockInfo);
-        if (unitsCache.size() > unitsCacheSize)
-        {
-            unitsCache.pop_front();
-        }
+        blockInfos.push(blockInfo);
     }
 
     PushedBlockInfo DatabaseBlockchainCache::getPushedBlockInfo(uint32_t blockIndex) const
@@ -1186,8 +1336,18 @@ namespace CryptoNote
         return getExtendedPushedBlockInfo(blockIndex).pushedBlockInfo;
     }
 
+    bool DatabaseBlockchainCache::mayBeSpent(const Crypto::KeyImage &keyImage) const
+    {
+        return !keyImageFilter || keyImageFilter->contains(keyImage);
+    }
+
     bool DatabaseBlockchainCache::checkIfSpent(const Crypto::KeyImage &keyImage, uint32_t blockIndex) const
     {
+        if (!mayBeSpent(keyImage))
+        {
+            return false;
+        }
+
         auto batch = BlockchainReadBatch().requestBlockIndexBySpentKeyImage(keyImage);
         auto res = database.readThreadSafe(batch);
 
@@ -1208,6 +1368,56 @@ namespace CryptoNote
         return checkIfSpent(keyImage, getTopBlockIndex());
     }
 
+    std::unordered_set<Crypto::KeyImage> DatabaseBlockchainCache::getSpentKeyImages(
+        const std::vector<Crypto::KeyImage> &keyImages,
+        uint32_t blockIndex) const
+    {
+        std::unordered_set<Crypto::KeyImage> spent;
+
+        if (keyImages.empty())
+        {
+            return spent;
+        }
+
+        BlockchainReadBatch batch;
+
+        bool haveCandidates = false;
+
+        for (const auto &keyImage : keyImages)
+        {
+            if (mayBeSpent(keyImage))
+            {
+                batch.requestBlockIndexBySpentKeyImage(keyImage);
+                haveCandidates = true;
+            }
+        }
+
+        if (!haveCandidates)
+        {
+            return spent;
+        }
+
+        auto res = database.readThreadSafe(batch);
+
+        if (res)
+        {
+            logger(Logging::ERROR) << "getSpentKeyImages failed, request to database failed: " << res.message();
+            return spent;
+        }
+
+        auto readResult = batch.extractResult();
+
+        for (const auto &[keyImage, spentIndex] : readResult.getBlockIndexesBySpentKeyImages())
+        {
+            if (spentIndex <= blockIndex)
+            {
+                spent.insert(keyImage);
+            }
+        }
+
+        return spent;
+    }
+
     bool DatabaseBlockchainCache::isTransactionSpendTimeUnlocked(uint64_t unlockTime) const
     {
         return isTransactionSpendTimeUnlocked(unlockTime, getTopBlockIndex());
@@ -1415,7 +1625,7 @@ namespace CryptoNote
     std::vector<uint64_t>
         DatabaseBlockchainCache::getLastTimestamps(size_t count, uint32_t blockIndex, UseGenesis useGenesis) const
     {
-        return getLastUnits(count, blockIndex, useGenesis, [](const CachedBlockInfo &inf) { return inf.timestamp; });
+        return getLastColumnValues(count, blockIndex, useGenesis, BlockInfoColumns::Column::Timestamp);
     }
 
     std::vector<uint64_t> DatabaseBlockchainCache::getLastBlocksSizes(size_t count) const
@@ -1426,7 +1636,7 @@ namespace CryptoNote
     std::vector<uint64_t>
         DatabaseBlockchainCache::getLastBlocksSizes(size_t count, uint32_t blockIndex, UseGenesis useGenesis) const
     {
-        return getLastUnits(count, blockIndex, useGenesis, [](const CachedBlockInfo &cb) { return cb.blockSize; });
+        return getLastColumnValues(count, blockIndex, useGenesis, BlockInfoColumns::Column::BlockSize);
     }
 
     std::vector<uint64_t> DatabaseBlockchainCache::getLastCumulativeDifficulties(
@@ -1434,8 +1644,7 @@ namespace CryptoNote
         uint32_t blockIndex,
         UseGenesis useGenesis) const
     {
-        return getLastUnits(
-            count, blockIndex, useGenesis, [](const CachedBlockInfo &info) { return info.cumulativeDifficulty; });
+        return getLastColumnValues(count, blockIndex, useGenesis, BlockInfoColumns::Column::CumulativeDifficulty);
     }
 
     std::vector<uint64_t> DatabaseBlockchainCache::getLastCumulativeDifficulties(size_t count) const
@@ -1477,6 +1686,13 @@ namespace CryptoNote
 
     CachedBlockInfo DatabaseBlockchainCache::getCachedBlockInfo(uint32_t index) const
     {
+        /* When bulk importing, the most recent blocks may not have been
+           written yet, but are always in memory */
+        if (blockInfos.contains(index))
+        {
+            return blockInfos.infoAt(index);
+        }
+
         auto batch = BlockchainReadBatch().requestCachedBlock(index);
         auto result = readDatabase(batch);
         return result.getCachedBlocks().at(index);
@@ -1497,46 +1713,6 @@ namespace CryptoNote
         return getCachedBlockInfo(blockIndex).alreadyGeneratedTransactions;
     }
 
-    std::vector<CachedBlockInfo>
-        DatabaseBlockchainCache::getLastCachedUnits(uint32_t blockIndex, size_t count, UseGenesis useGenesis) const
-    {
-        assert(blockIndex <= getTopBlockIndex());
-
-        std::vector<CachedBlockInfo> cachedResult;
-        const uint32_t cacheStartIndex = (getTopBlockIndex() + 1) - static_cast<uint32_t>(unitsCache.size());
-
-        count = std::min(unitsCache.size(), count);
-
-        if (cacheStartIndex > blockIndex || count == 0)
-        {
-            return cachedResult;
-        }
-
-        count = std::min(blockIndex - cacheStartIndex + 1, static_cast<uint32_t>(count));
-        uint32_t offset = static_cast<uint32_t>(blockIndex + 1 - count) - cacheStartIndex;
-
-        assert(offset < unitsCache.size());
-
-        if (!useGenesis && cacheStartIndex == 0 && offset == 0)
-        {
-            ++offset;
-            --count;
-        }
-
-        if (offset >= unitsCache.size() || count == 0)
-        {
-            return cachedResult;
-        }
-
-        cachedResult.reserve(count);
-        for (size_t i = 0; i < count; ++i)
-        {
-            cachedResult.push_back(unitsCache[offset + i]);
-        }
-
-        return cachedResult;
-    }
-
     std::vector<CachedBlockInfo>
         DatabaseBlockchainCache::getLastDbUnits(uint32_t blockIndex, size_t count, UseGenesis useGenesis) const
     {
@@ -1586,49 +1762,68 @@ namespace CryptoNote
         std::function<uint64_t(const CachedBlockInfo &)> pred) const
     {
         assert(count <= std::numeric_limits<uint32_t>::max());
+        assert(blockIndex <= getTopBlockIndex());
 
-        auto cachedUnits = getLastCachedUnits(blockIndex, count, useGenesis);
+        const uint32_t endIndex = blockIndex + 1;
+        uint32_t startIndex = endIndex - std::min(endIndex, static_cast<uint32_t>(count));
 
-        uint32_t availableUnits = blockIndex;
-        if (useGenesis)
+        if (startIndex == 0 && !useGenesis)
         {
-            availableUnits += 1;
+            startIndex = 1;
         }
 
-        assert(availableUnits >= cachedUnits.size());
+        std::vector<uint64_t> result;
+
+        if (startIndex >= endIndex)
+        {
+            return result;
+        }
+
+        result.reserve(endIndex - startIndex);
+
+        /* Only before load() can the window reach below the blocks in memory */
+        const uint32_t memoryStartIndex = std::min(std::max(startIndex, blockInfos.firstIndex()), endIndex);
 
-        if (availableUnits - cachedUnits.size() == 0)
+        if (memoryStartIndex > startIndex)
         {
-            std::vector<uint64_t> result;
-            result.reserve(cachedUnits.size());
-            for (const auto &unit : cachedUnits)
+            for (const auto &unit : getLastDbUnits(memoryStartIndex - 1, memoryStartIndex - startIndex, useGenesis))
             {
                 result.push_back(pred(unit));
             }
+        }
 
-            return result;
+        for (uint32_t i = memoryStartIndex; i < endIndex; i++)
+        {
+            result.push_back(pred(blockInfos.infoAt(i)));
         }
 
-        assert(blockIndex + 1 >= cachedUnits.size());
-        uint32_t dbIndex = blockIndex - static_cast<uint32_t>(cachedUnits.size());
+        return result;
+    }
+
+    std::vector<uint64_t> DatabaseBlockchainCache::getLastColumnValues(
+        size_t count,
+        uint32_t blockIndex,
+        UseGenesis useGenesis,
+        BlockInfoColumns::Column column) const
+    {
+        assert(blockIndex <= getTopBlockIndex());
 
-        assert(count >= cachedUnits.size());
-        size_t leftCount = count - cachedUnits.size();
+        const uint32_t endIndex = blockIndex + 1;
+        uint32_t startIndex = endIndex - static_cast<uint32_t>(std::min<size_t>(endIndex, count));
 
-        auto dbUnits = getLastDbUnits(dbIndex, leftCount, useGenesis);
-        std::vector<uint64_t> result;
-        result.reserve(dbUnits.size() + cachedUnits.size());
-        for (const auto &unit : dbUnits)
+        if (startIndex == 0 && !useGenesis)
         {
-            result.push_back(pred(unit));
+            startIndex = 1;
         }
 
-        for (const auto &unit : cachedUnits)
+        if (startIndex < endIndex && blockInfos.contains(startIndex) && blockInfos.contains(blockIndex))
         {
-            result.push_back(pred(unit));
+            return blockInfos.values(column, startIndex, endIndex);
         }
 
-        return result;
+        return getLastUnits(count, blockIndex, useGenesis, [column](const CachedBlockInfo &info) {
+            return BlockInfoColumns::value(info, column);
+        });
     }
 
     Crypto::Hash DatabaseBlockchainCache::getBlockHash(uint32_t blockIndex) const
@@ -1796,9 +1991,362 @@ namespace CryptoNote
         return children.size();
     }
 
-    void DatabaseBlockchainCache::save() {}
+    void DatabaseBlockchainCache::save()
+    {
+        saveBlockInfos();
+        saveKeyImageFilter();
+    }
+
+    void DatabaseBlockchainCache::beginBulkImport()
+    {
+        if (!bulkImport)
+        {
+            bulkImport = std::make_unique<BulkImport>();
+        }
+    }
+
+    void DatabaseBlockchainCache::commitBulkImport()
+    {
+        if (!bulkImport)
+        {
+            return;
+        }
+
+        const auto import = std::move(bulkImport);
+
+        /* Read the existing index entries for every payment ID and timestamp
+           at once, rather than once per transaction and block */
+        BlockchainReadBatch readBatch;
+
+        for (const auto &[transactionHash, paymentId] : import->paymentIds)
+        {
+            readBatch.requestTransactionCountByPaymentId(paymentId);
+        }
+
+        for (const auto &[blockIndex, timestamp, blockHash] : import->timestamps)
+        {
+            readBatch.requestBlockHashesByTimestamp(timestamp);
+            readBatch.requestClosestTimestampBlockIndex(roundToMidnight(timestamp));
+        }
+
+        auto readResult = readDatabase(readBatch);
+
+        auto paymentIdCounts = readResult.getTransactionCountByPaymentIds();
+
+        for (const auto &[transactionHash, paymentId] : import->paymentIds)
+        {
+            import->batch.insertPaymentId(transactionHash, paymentId, ++paymentIdCounts[paymentId]);
+        }
+
+        auto blockHashesByTimestamp = readResult.getBlockHashesByTimestamp();
+        auto closestBlockIndexes = readResult.getClosestTimestampBlockIndex();
+
+        std::set<uint64_t> updatedTimestamps;
+
+        for (const auto &[blockIndex, timestamp, blockHash] : import->timestamps)
+        {
+            blockHashesByTimestamp[timestamp].push_back(blockHash);
+            updatedTimestamps.insert(timestamp);
+
+            /* The first block of the day is the closest to midnight */
+            if (closestBlockIndexes.emplace(roundToMidnight(timestamp), blockIndex).second)
+            {
+                import->batch.insertClosestTimestampBlockIndex(roundToMidnight(timestamp), blockIndex);
+            }
+        }
+
+        for (const auto timestamp : updatedTimestamps)
+        {
+            import->batch.insertTimestamp(timestamp, blockHashesByTimestamp[timestamp]);
+        }
+
+        logger(Logging::DEBUGGING) << "Writing " << import->timestamps.size() << " bulk imported blocks";
+
+        auto res = database.write(import->batch);
+        if (res)
+        {
+            logger(Logging::ERROR) << "bulk import write failed: " << res.message();
+            throw std::runtime_error(res.message());
+        }
+    }
+
+    void DatabaseBlockchainCache::load()
+    {
+        DatabaseVersionReadBatch readBatch;
+
+        auto ec = database.read(readBatch);
+        if (ec)
+        {
+            throw std::system_error(ec);
+        }
+
+        const auto version = readBatch.getDbSchemeVersion();
+
+        if (version && *version < CURRENT_DB_SCHEME_VERSION)
+        {
+            buildWalletBlockInfos();
+
+            DatabaseVersionWriteBatch writeBatch(CURRENT_DB_SCHEME_VERSION);
+
+            auto writeError = database.write(writeBatch);
+            if (writeError)
+            {
+                throw std::system_error(writeError);
+            }
+        }
+
+        loadBlockInfos();
+        loadKeyImageFilter();
+    }
+
+    void DatabaseBlockchainCache::buildWalletBlockInfos()
+    {
+        const uint32_t topIndex = getTopBlockIndex();
+
+        logger(Logging::INFO) << "Building wallet sync index, this may take a while...";
+
+        for (uint64_t batchStart = 0; batchStart <= topIndex; batchStart += WALLET_BLOCK_INFO_BUILD_BATCH_SIZE)
+        {
+            const uint64_t batchEnd =
+                std::min<uint64_t>(batchStart + WALLET_BLOCK_INFO_BUILD_BATCH_SIZE, uint64_t(topIndex) + 1);
+
+            auto blockBatch = BlockchainReadBatch().requestRawBlocks(batchStart, batchEnd);
+            const auto rawBlocks = readDatabase(blockBatch).getRawBlocks();
+
+            struct ParsedBlock
+            {
+                BlockTemplate block;
+                std::vector<CachedTransaction> transactions;
+            };
+
+            std::vector<ParsedBlock> parsedBlocks(batchEnd - batchStart);
+            std::vector<Crypto::Hash> transactionHashes;
+
+            for (uint64_t height = batchStart; height < batchEnd; height++)
+            {
+                auto &parsed = parsedBlocks[height - batchStart];
+                const auto &rawBlock = rawBlocks.at(static_cast<uint32_t>(height));
+
+                fromBinaryArray(parsed.block, rawBlock.block);
+                Utils::restoreCachedTransactions(rawBlock.transactions, parsed.transactions);
+
+                transactionHashes.push_back(getBinaryArrayHash(toBinaryArray(parsed.block.baseTransaction)));
+
+                for (const auto &transaction : parsed.transactions)
+                {
+                    transactionHashes.push_back(transaction.getTransactionHash());
+                }
+            }
+
+            auto transactionBatch = BlockchainReadBatch().requestCachedTransactions(transactionHashes);
+            const auto cachedTransactions = readDatabase(transactionBatch).getCachedTransactions();
+
+            BlockchainWriteBatch writeBatch;
+
+            for (uint64_t height = batchStart; height < batchEnd; height++)
+            {
+                const auto &parsed = parsedBlocks[height - batchStart];
+
+                const CachedBlock cachedBlock(parsed.block);
+                const CachedTransaction baseTransaction(parsed.block.baseTransaction);
+
+                std::vector<std::vector<uint32_t>> globalIndexes;
+
+                globalIndexes.push_back(cachedTransactions.at(baseTransaction.getTransactionHash()).globalIndexes);
+
+                for (const auto &transaction : parsed.transactions)
+                {
+                    globalIndexes.push_back(cachedTransactions.at(transaction.getTransactionHash()).globalIndexes);
+                }
+
+                writeBatch.insertWalletBlockInfo(
+                    static_cast<uint32_t>(height),
+                    {Utils::getWalletBlockInfo(cachedBlock, baseTransaction, parsed.transactions, globalIndexes)});
+            }
+
+            auto writeError = database.write(writeBatch);
+            if (writeError)
+            {
+                logger(Logging::ERROR) << "Failed to write wallet sync index: " << writeError.message();
+                throw std::system_error(writeError);
+            }
+
+            logger(Logging::INFO) << "Built wallet sync index up to block " << batchEnd - 1 << " of " << topIndex;
+        }
+    }
+
+    void DatabaseBlockchainCache::loadBlockInfos()
+    {
+        ChainSnapshotReadBatch readBatch(BLOCK_INFO_COLUMNS_KEY);
+
+        auto ec = database.read(readBatch);
+        if (ec)
+        {
+            throw std::system_error(ec);
+        }
+
+        const auto &snapshot = readBatch.getSnapshot();
+        const uint32_t topIndex = getTopBlockIndex();
+
+        std::optional<BlockInfoColumns> columns;
+
+        if (snapshot && snapshot->blockIndex <= topIndex && getBlockHash(snapshot->blockIndex) == snapshot->blockHash)
+        {
+            columns = BlockInfoColumns::fromBinary(snapshot->data);
+
+            if (columns && (columns->firstIndex() != 0 || columns->endIndex() != snapshot->blockIndex + 1))
+            {
+                columns = std::nullopt;
+            }
+        }
+
+        if (columns)
+        {
+            logger(Logging::DEBUGGING) << "Loaded block info columns at block index " << snapshot->blockIndex
+                                       << ", catching up to block index " << topIndex;
+        }
+        else
+        {
+            logger(Logging::INFO) << "Building block info columns, this may take a while...";
+
+            columns.emplace(0);
+        }
+
+        for (uint32_t batchStart = columns->endIndex(); batchStart <= topIndex;
+             batchStart += BLOCK_INFO_COLUMNS_FILL_BATCH_SIZE)
+        {
+            const uint32_t batchEnd = std::min(batchStart + BLOCK_INFO_COLUMNS_FILL_BATCH_SIZE - 1, topIndex);
+
+            for (const auto &info : getLastDbUnits(batchEnd, batchEnd - batchStart + 1, UseGenesis {true}))
+            {
+                columns->push(info);
+            }
+        }
+
+        assert(columns->endIndex() == topIndex + 1);
 
-    void DatabaseBlockchainCache::load() {}
+        blockInfos = std::move(*columns);
+
+        if (!snapshot || snapshot->blockIndex != topIndex)
+        {
+            saveBlockInfos();
+        }
+    }
+
+    void DatabaseBlockchainCache::saveBlockInfos()
+    {
+        /* Until load() has filled in the rest of the chain, there is nothing
+           worth saving */
+        if (blockInfos.firstIndex() != 0)
+        {
+            return;
+        }
+
+        ChainSnapshot snapshot;
+
+        snapshot.blockIndex = getTopBlockIndex();
+        snapshot.blockHash = getTopBlockHash();
+        snapshot.data = blockInfos.toBinary();
+
+        ChainSnapshotWriteBatch writeBatch(BLOCK_INFO_COLUMNS_KEY, snapshot);
+
+        auto ec = database.write(writeBatch);
+        if (ec)
+        {
+            logger(Logging::ERROR) << "Failed to save block info columns: " << ec.message();
+        }
+    }
+
+    void DatabaseBlockchainCache::loadKeyImageFilter()
+    {
+        ChainSnapshotReadBatch readBatch(KEY_IMAGE_FILTER_KEY);
+
+        auto ec = database.read(readBatch);
+        if (ec)
+        {
+            throw std::system_error(ec);
+        }
+
+        const auto &snapshot = readBatch.getSnapshot();
+        const uint32_t topIndex = getTopBlockIndex();
+
+        if (snapshot && snapshot->blockIndex <= topIndex && getBlockHash(snapshot->blockIndex) == snapshot->blockHash)
+        {
+            auto filter = KeyImageFilter::fromBinary(snapshot->data);
+
+            if (filter)
+            {
+                logger(Logging::DEBUGGING) << "Loaded key image filter at block index " << snapshot->blockIndex
+                                           << ", catching up to block index " << topIndex;
+
+                keyImageFilter = std::move(*filter);
+                fillKeyImageFilter(snapshot->blockIndex + 1);
+                return;
+            }
+        }
+
+        /* Key images spent in blocks the snapshot doesn't cover would be
+           missing from it, and reported as unspent, so anything but a snapshot
+           of an ancestor of our top block has to be rebuilt from scratch */
+        logger(Logging::INFO) << "Building key image filter, this may take a while...";
+
+        keyImageFilter.emplace();
+        fillKeyImageFilter(0);
+
+        logger(Logging::INFO) << "Key image filter built, " << keyImageFilter->size() << " key images";
+
+        saveKeyImageFilter();
+    }
+
+    void DatabaseBlockchainCache::saveKeyImageFilter()
+    {
+        if (!keyImageFilter)
+        {
+            return;
+        }
+
+        ChainSnapshot snapshot;
+
+        snapshot.blockIndex = getTopBlockIndex();
+        snapshot.blockHash = getTopBlockHash();
+        snapshot.data = keyImageFilter->toBinary();
+
+        ChainSnapshotWriteBatch writeBatch(KEY_IMAGE_FILTER_KEY, snapshot);
+
+        auto ec = database.write(writeBatch);
+        if (ec)
+        {
+            logger(Logging::ERROR) << "Failed to save key image filter: " << ec.message();
+        }
+    }
+
+    void DatabaseBlockchainCache::fillKeyImageFilter(uint32_t startIndex)
+    {
+        const uint32_t topIndex = getTopBlockIndex();
+
+        for (uint64_t batchStart = startIndex; batchStart <= topIndex; batchStart += KEY_IMAGE_FILTER_FILL_BATCH_SIZE)
+        {
+            const uint32_t batchEnd = static_cast<uint32_t>(
+                std::min<uint64_t>(batchStart + KEY_IMAGE_FILTER_FILL_BATCH_SIZE - 1, topIndex));
+
+            BlockchainReadBatch readBatch;
+
+            for (uint32_t blockIndex = static_cast<uint32_t>(batchStart); blockIndex <= batchEnd; blockIndex++)
+            {
+                readBatch.requestSpentKeyImagesByBlock(blockIndex);
+            }
+
+            auto result = readDatabase(readBatch);
+
+            for (const auto &[blockIndex, spentKeyImages] : result.getSpentKeyImagesByBlock())
+            {
+                for (const auto &keyImage : spentKeyImages)
+                {
+                    keyImageFilter->insert(keyImage);
+                }
+            }
+        }
+    }
 
     std::vector<BinaryArray> DatabaseBlockchainCache::getRawTransactions(
         const std::vector<Crypto::Hash> &transactions,
@@ -2098,6 +2646,72 @@ namespace CryptoNote
         return orderedBlocks;
     }
 
+    std::vector<WalletTypes::WalletBlockInfo>
+        DatabaseBlockchainCache::getNonEmptyWalletBlocks(const uint64_t startHeight, const size_t blockCount) const
+    {
+        std::vector<WalletTypes::WalletBlockInfo> orderedBlocks;
+
+        const uint32_t storageBlockCount = getBlockCount();
+
+        uint64_t height = startHeight;
+
+        while (orderedBlocks.size() < blockCount && height < storageBlockCount)
+        {
+            uint64_t startHeight = height;
+
+            /* Same balancing act as getNonEmptyBlocks() */
+            uint64_t endHeight = std::min<uint64_t>(startHeight + (blockCount * 2), storageBlockCount);
+
+            auto blockBatch = BlockchainReadBatch().requestWalletBlockInfos(startHeight, endHeight);
+            auto walletBlocks = readDatabase(blockBatch).getWalletBlockInfos();
+
+            while (orderedBlocks.size() < blockCount && height < endHeight)
+            {
+                const auto it = walletBlocks.find(height);
+
+                /* Every stored block should have one, so the index is incomplete.
+                   Skipping the block would hide its transactions from wallets,
+                   and not moving on would never return. */
+                if (it == walletBlocks.end())
+                {
+                    throw std::runtime_error(
+                        "Wallet sync data missing for block " + std::to_string(height)
+                        + ", the wallet sync index is incomplete");
+                }
+
+                auto &block = it->second.block;
+
+                height++;
+
+                if (block.transactions.empty())
+                {
+                    continue;
+                }
+
+                orderedBlocks.push_back(std::move(block));
+            }
+        }
+
+        return orderedBlocks;
+    }
+
+    std::vector<WalletTypes::WalletBlockInfo>
+        DatabaseBlockchainCache::getWalletBlocks(const uint64_t startHeight, const uint64_t endHeight) const
+    {
+        auto blockBatch = BlockchainReadBatch().requestWalletBlockInfos(startHeight, endHeight);
+
+        auto walletBlocks = readDatabase(blockBatch).getWalletBlockInfos();
+
+        std::vector<WalletTypes::WalletBlockInfo> orderedBlocks;
+
+        for (uint64_t height = startHeight; height < startHeight + walletBlocks.size(); height++)
+        {
+            orderedBlocks.push_back(std::move(walletBlocks.at(height).block));
+        }
+
+        return orderedBlocks;
+    }
+
     std::vector<RawBlock>
         DatabaseBlockchainCache::getBlocksByHeight(const uint64_t startHeight, uint64_t endHeight) const
     {
@@ -2232,9 +2846,11 @@ namespace CryptoNote
         auto baseTransaction = genesisBlock.getBlock().baseTransaction;
         auto cachedBaseTransaction = CachedTransaction {std::move(baseTransaction)};
 
-        pushTransaction(cachedBaseTransaction, 0, 0, batch);
+        const auto globalIndexes = pushTransaction(cachedBaseTransaction, 0, 0, batch);
 
         batch.insertCachedBlock(blockInfo, 0, {cachedBaseTransaction.getTransactionHash()});
+        batch.insertWalletBlockInfo(
+            0, {Utils::getWalletBlockInfo(genesisBlock, cachedBaseTransaction, {}, {globalIndexes})});
         batch.insertRawBlock(0, {toBinaryArray(genesisBlock.getBlock()), {}});
         batch.insertClosestTimestampBlockIndex(roundToMidnight(genesisBlock.getBlock().timestamp), 0);
 
@@ -2247,7 +2863,8 @@ namespace CryptoNote
 
         topBlockHash = genesisBlock.getBlockHash();
 
-        unitsCache.push_back(blockInfo);
+        blockInfos.clear(0);
+        blockInfos.push(blockInfo);
     }
 
 } // namespace CryptoNote
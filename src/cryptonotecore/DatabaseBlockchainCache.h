@@ -23,10 +23,13 @@
 #include "cryptonotecore/UpgradeManager.h"
 
 #include <IDataBase.h>
+#include <cryptonotecore/BlockInfoColumns.h>
 #include <cryptonotecore/BlockchainReadBatch.h>
 #include <cryptonotecore/BlockchainWriteBatch.h>
 #include <cryptonotecore/DatabaseCacheData.h>
 #include <cryptonotecore/IBlockchainCacheFactory.h>
+#include <cryptonotecore/KeyImageFilter.h>
+#include <optional>
 
 namespace CryptoNote
 {
@@ -77,6 +80,9 @@ namespace CryptoNote
 
         bool checkIfSpent(const Crypto::KeyImage &keyImage) const override;
 
+        std::unordered_set<Crypto::KeyImage>
+            getSpentKeyImages(const std::vector<Crypto::KeyImage> &keyImages, uint32_t blockIndex) const override;
+
         bool isTransactionSpendTimeUnlocked(uint64_t unlockTime) const override;
 
         bool isTransactionSpendTimeUnlocked(uint64_t unlockTime, uint32_t blockIndex) const override;
@@ -193,6 +199,10 @@ namespace CryptoNote
 
         virtual void load() override;
 
+        virtual void beginBulkImport() override;
+
+        virtual void commitBulkImport() override;
+
         virtual std::vector<BinaryArray> getRawTransactions(
             const std::vector<Crypto::Hash> &transactions,
             std::vector<Crypto::Hash> &missedTransactions) const override;
@@ -233,6 +243,12 @@ namespace CryptoNote
         virtual std::vector<RawBlock>
             getNonEmptyBlocks(const uint64_t startHeight, const size_t blockCount) const override;
 
+        virtual std::vector<WalletTypes::WalletBlockInfo>
+            getWalletBlocks(const uint64_t startHeight, const uint64_t endHeight) const override;
+
+        virtual std::vector<WalletTypes::WalletBlockInfo>
+            getNonEmptyWalletBlocks(const uint64_t startHeight, const size_t blockCount) const override;
+
       private:
         const Currency &currency;
 
@@ -254,9 +270,29 @@ namespace CryptoNote
 
         Logging::LoggerRef logger;
 
-        std::deque<CachedBlockInfo> unitsCache;
+        /* The timestamp, size, cumulative difficulty and emission of every
+           block from blockInfos.firstIndex() to the top block. Only the
+           blocks pushed since construction until load() has been called,
+           after which it covers the whole chain. */
+        BlockInfoColumns blockInfos;
+
+        /* Spent key images, so lookups of unspent ones (nearly all of them)
+           can skip the database. Empty until load() has been called. */
+        std::optional<KeyImageFilter> keyImageFilter;
+
+        /* What pushBlock() has held back since beginBulkImport() */
+        struct BulkImport
+        {
+            BlockchainWriteBatch batch;
+
+            /* The hash and payment ID of each transaction with a payment ID */
+            std::vector<std::pair<Crypto::Hash, Crypto::Hash>> paymentIds;
+
+            /* The index, timestamp and hash of each block */
+            std::vector<std::tuple<uint32_t, uint64_t, Crypto::Hash>> timestamps;
+        };
 
-        const size_t unitsCacheSize = 1000;
+        std::unique_ptr<BulkImport> bulkImport;
 
         struct ExtendedPushedBlockInfo;
 
@@ -270,7 +306,26 @@ namespace CryptoNote
 
         void addSpentKeyImage(const Crypto::KeyImage &keyImage, uint32_t blockIndex);
 
-        void pushTransaction(
+        bool mayBeSpent(const Crypto::KeyImage &keyImage) const;
+
+        /* Fills blockInfos for the whole chain, from the snapshot saved by
+           saveBlockInfos() if it is still on our chain */
+        void loadBlockInfos();
+
+        void saveBlockInfos();
+
+        void loadKeyImageFilter();
+
+        void saveKeyImageFilter();
+
+        /* Adds the key images spent in blocks startIndex .. top to the filter */
+        void fillKeyImageFilter(uint32_t startIndex);
+
+        /* Builds the wallet sync index for databases created before it existed */
+        void buildWalletBlockInfos();
+
+        /* Returns the global indexes of the transaction outputs */
+        std::vector<uint32_t> pushTransaction(
             const CachedTransaction &cachedTransaction,
             uint32_t blockIndex,
             uint16_t transactionBlockIndex,
@@ -334,8 +389,13 @@ namespace CryptoNote
 
         uint64_t getCachedTransactionsCount() const;
 
-        std::vector<CachedBlockInfo> getLastCachedUnits(uint32_t blockIndex, size_t count, UseGenesis useGenesis) const;
-
         std::vector<CachedBlockInfo> getLastDbUnits(uint32_t blockIndex, size_t count, UseGenesis useGenesis) const;
+
+        /* The value in the given column of up to count blocks, ending with blockIndex */
+        std::vector<uint64_t> getLastColumnValues(
+            size_t count,
+            uint32_t blockIndex,
+            UseGenesis useGenesis,
+            BlockInfoColumns::Column column) const;
     };
 } // namespace CryptoNote
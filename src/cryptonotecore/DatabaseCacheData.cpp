@@ -10,6 +10,42 @@
 
 namespace CryptoNote
 {
+    namespace
+    {
+        /* The parts shared by coinbase and regular transactions */
+        void serializeTransaction(WalletTypes::RawCoinbaseTransaction &transaction, ISerializer &s)
+        {
+            uint64_t outputCount = transaction.keyOutputs.size();
+
+            s.beginArray(outputCount, "key_outputs");
+
+            if (s.type() == ISerializer::INPUT)
+            {
+                transaction.keyOutputs.resize(outputCount);
+            }
+
+            for (auto &output : transaction.keyOutputs)
+            {
+                /* Always known when building the index */
+                uint64_t globalIndex = output.globalOutputIndex.value_or(0);
+
+                s.beginObject("");
+                s(output.key, "key");
+                s(output.amount, "amount");
+                s(globalIndex, "global_index");
+                s.endObject();
+
+                output.globalOutputIndex = globalIndex;
+            }
+
+            s.endArray();
+
+            s(transaction.hash, "hash");
+            s(transaction.transactionPublicKey, "transaction_public_key");
+            s(transaction.unlockTime, "unlock_time");
+        }
+    } // namespace
+
     void ExtendedTransactionInfo::serialize(CryptoNote::ISerializer &s)
     {
         s(static_cast<CachedTransactionInfo &>(*this), "cached_transaction");
@@ -24,4 +60,50 @@ namespace CryptoNote
         s(outputIndex, "output_index");
     }
 
+    void WalletBlockInfoRecord::serialize(ISerializer &s)
+    {
+        /* The index always holds the coinbase transaction, but the binary
+           wallet sync stream leaves it out if the wallet doesn't want it */
+        bool hasCoinbaseTransaction = block.coinbaseTransaction.has_value();
+        s(hasCoinbaseTransaction, "has_coinbase_transaction");
+
+        if (s.type() == ISerializer::INPUT)
+        {
+            block.coinbaseTransaction = hasCoinbaseTransaction
+                                            ? std::optional(WalletTypes::RawCoinbaseTransaction())
+                                            : std::nullopt;
+        }
+
+        if (hasCoinbaseTransaction)
+        {
+            s.beginObject("coinbase_transaction");
+            serializeTransaction(*block.coinbaseTransaction, s);
+            s.endObject();
+        }
+
+        uint64_t transactionCount = block.transactions.size();
+
+        s.beginArray(transactionCount, "transactions");
+
+        if (s.type() == ISerializer::INPUT)
+        {
+            block.transactions.resize(transactionCount);
+        }
+
+        for (auto &transaction : block.transactions)
+        {
+            s.beginObject("");
+            serializeTransaction(transaction, s);
+            s(transaction.paymentID, "payment_id");
+            s(transaction.keyInputs, "key_inputs");
+            s.endObject();
+        }
+
+        s.endArray();
+
+        s(block.blockHeight, "block_height");
+        s(block.blockHash, "block_hash");
+        s(block.blockTimestamp, "block_timestamp");
+    }
+
 } // namespace CryptoNote
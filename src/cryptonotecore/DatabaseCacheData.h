@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <WalletTypes.h>
 #include <cryptonotecore/BlockchainCache.h>
 #include <map>
 
@@ -32,4 +33,15 @@ namespace CryptoNote
         void serialize(ISerializer &s);
     };
 
+    /* The wallet sync data stored for each block, also used as the block
+       frame of the binary wallet sync stream. The RPC server has its own
+       serializers for these types, which leave out the global indexes, so
+       this wraps them to store everything */
+    struct WalletBlockInfoRecord
+    {
+        WalletTypes::WalletBlockInfo block;
+
+        void serialize(ISerializer &s);
+    };
+
 } // namespace CryptoNote
@@ -11,7 +11,9 @@
 #include "cryptonotecore/TransactionValidatiorState.h"
 
 #include <CryptoNote.h>
+#include <WalletTypes.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace CryptoNote
@@ -99,6 +101,10 @@ namespace CryptoNote
 
         virtual bool checkIfSpent(const Crypto::KeyImage &keyImage) const = 0;
 
+        /* Returns the subset of the given key images which were spent at or before blockIndex */
+        virtual std::unordered_set<Crypto::KeyImage>
+            getSpentKeyImages(const std::vector<Crypto::KeyImage> &keyImages, uint32_t blockIndex) const = 0;
+
         virtual bool isTransactionSpendTimeUnlocked(uint64_t unlockTime) const = 0;
 
         virtual bool isTransactionSpendTimeUnlocked(uint64_t unlockTime, uint32_t blockIndex) const = 0;
@@ -222,6 +228,14 @@ namespace CryptoNote
 
         virtual void load() = 0;
 
+        /* Blocks pushed from here until commitBulkImport() may be written
+           together, with the payment ID and timestamp indexes built once for
+           all of them. Only for trusted blocks, while nothing else is reading
+           the cache, as the blocks may not be visible until committed. */
+        virtual void beginBulkImport() = 0;
+
+        virtual void commitBulkImport() = 0;
+
         virtual std::vector<uint64_t> getLastUnits(
             size_t count,
             uint32_t blockIndex,
@@ -241,6 +255,16 @@ namespace CryptoNote
         virtual std::vector<RawBlock> getBlocksByHeight(const uint64_t startHeight, uint64_t endHeight) const = 0;
 
         virtual std::vector<RawBlock> getNonEmptyBlocks(const uint64_t startHeight, const size_t blockCount) const = 0;
+
+        /* Like getBlocksByHeight(), but returns what a wallet needs to sync
+           each block, including the global indexes of the outputs */
+        virtual std::vector<WalletTypes::WalletBlockInfo>
+            getWalletBlocks(const uint64_t startHeight, const uint64_t endHeight) const = 0;
+
+        /* Like getNonEmptyBlocks(), but returns what a wallet needs to sync
+           each block */
+        virtual std::vector<WalletTypes::WalletBlockInfo>
+            getNonEmptyWalletBlocks(const uint64_t startHeight, const size_t blockCount) const = 0;
     };
 
 } // namespace CryptoNote
@@ -17,6 +17,7 @@
 #include "MessageQueue.h"
 
 #include <CryptoNote.h>
+#include <chrono>
 #include <optional>
 #include <unordered_map>
 #include <unordered_set>
@@ -30,6 +31,19 @@ namespace CryptoNote
         BLOCKHAIN_UPDATED
     };
 
+    /* The chain independent part of adding a block - the deserialized and
+       hashed transactions - which can be computed ahead of time, in parallel,
+       by ICore::prepareBlocks() */
+    struct PreparedBlock
+    {
+        std::vector<CachedTransaction> transactions;
+
+        uint64_t cumulativeSize = 0;
+
+        /* False if the transactions failed to deserialize */
+        bool success = false;
+    };
+
     class ICore
     {
       public:
@@ -139,6 +153,19 @@ namespace CryptoNote
 
         virtual std::error_code addBlock(RawBlock &&rawBlock) = 0;
 
+        virtual std::error_code
+            addBlock(const CachedBlock &cachedBlock, RawBlock &&rawBlock, PreparedBlock &&preparedBlock) = 0;
+
+        /*!
+         * \brief prepareBlocks Performs the work of addBlock() which does not depend on the chain state
+         *        (transaction deserialization and hashing, the proof of work hash) for a batch of blocks in parallel
+         * \param cachedBlocks The blocks to prepare, their long hashes are cached as a side effect
+         * \param rawBlocks The raw blocks, matching cachedBlocks by index
+         * \return One PreparedBlock per block, to be handed to addBlock() in order
+         */
+        virtual std::vector<PreparedBlock>
+            prepareBlocks(const std::vector<CachedBlock> &cachedBlocks, const std::vector<RawBlock> &rawBlocks) = 0;
+
         virtual std::error_code submitBlock(const BinaryArray &rawBlockTemplate) = 0;
 
         virtual bool getTransactionGlobalIndexes(
@@ -163,17 +190,27 @@ namespace CryptoNote
         virtual std::tuple<bool, CryptoNote::BinaryArray>
             getPoolTransaction(const Crypto::Hash &transactionHash) const = 0;
 
+        /* See ITransactionPool::getTransactionHashesByShortId */
+        virtual std::vector<std::optional<Crypto::Hash>> getPoolTransactionHashesByShortId(
+            const Crypto::Hash &salt,
+            const std::vector<uint64_t> &shortIds) const = 0;
+
         virtual bool getPoolChanges(
             const Crypto::Hash &lastBlockHash,
             const std::vector<Crypto::Hash> &knownHashes,
             std::vector<BinaryArray> &addedTransactions,
             std::vector<Crypto::Hash> &deletedTransactions) const = 0;
 
+        /* If knownSequence, a sequence number returned from a previous call,
+           is still recent enough, only the changes since then are looked up,
+           otherwise the pool is diffed against knownHashes */
         virtual bool getPoolChangesLite(
             const Crypto::Hash &lastBlockHash,
             const std::vector<Crypto::Hash> &knownHashes,
+            const uint64_t knownSequence,
             std::vector<TransactionPrefixInfo> &addedTransactions,
-            std::vector<Crypto::Hash> &deletedTransactions) const = 0;
+            std::vector<Crypto::Hash> &deletedTransactions,
+            uint64_t &currentSequence) const = 0;
 
         virtual std::tuple<bool, std::string> getBlockTemplate(
             BlockTemplate &b,
@@ -183,6 +220,20 @@ namespace CryptoNote
             uint64_t &difficulty,
             uint32_t &height) = 0;
 
+        /* Bumped whenever a transaction is added to or removed from the pool */
+        virtual uint64_t getPoolVersion() const = 0;
+
+        /* Bumped whenever the main chain switches to an alternative chain */
+        virtual uint64_t getChainSwitchCount() const = 0;
+
+        /* Blocks until the top block is no longer topBlockHash, the pool
+           version is no longer poolVersion, or until the given time. Must not
+           be called from the dispatcher thread, which does the notifying. */
+        virtual void waitForBlockTemplateChange(
+            const Crypto::Hash &topBlockHash,
+            const uint64_t poolVersion,
+            const std::chrono::steady_clock::time_point until) const = 0;
+
         virtual CoreStatistics getCoreStatistics() const = 0;
 
         virtual void save() = 0;
@@ -18,7 +18,7 @@ namespace CryptoNote
 
         virtual void popBlock() = 0;
 
-        virtual void rewindTo(uint32_t index) const = 0;
+        virtual void rewindTo(uint32_t index) = 0;
 
         virtual RawBlock getBlockByIndex(uint32_t index) const = 0;
 
@@ -7,10 +7,26 @@
 
 #include "CachedTransaction.h"
 
+#include <functional>
+#include <optional>
+
 namespace CryptoNote
 {
     struct TransactionValidatorState;
 
+    struct BlockTemplateTransactions
+    {
+        std::vector<Crypto::Hash> transactionHashes;
+
+        size_t transactionsSize = 0;
+
+        uint64_t fee = 0;
+
+        /* Transactions which are no longer valid, and should be removed from
+           the pool */
+        std::vector<Crypto::Hash> invalidTransactions;
+    };
+
     class ITransactionPool
     {
       public:
@@ -30,19 +46,43 @@ namespace CryptoNote
 
         virtual std::vector<Crypto::Hash> getTransactionHashes() const = 0;
 
+        /* Every transaction added to or removed from the pool bumps its
+           sequence number, which is returned in currentSequence. Fills in the
+           net changes made after sinceSequence. If those are no longer all
+           remembered, returns false, and fills in addedTransactions with every
+           transaction in the pool instead. */
+        virtual bool getTransactionChanges(
+            const uint64_t sinceSequence,
+            std::vector<Crypto::Hash> &addedTransactions,
+            std::vector<Crypto::Hash> &deletedTransactions,
+            uint64_t &currentSequence) const = 0;
+
         virtual bool checkIfTransactionPresent(const Crypto::Hash &hash) const = 0;
 
         virtual const TransactionValidatorState &getPoolTransactionValidationState() const = 0;
 
         virtual std::vector<CachedTransaction> getPoolTransactions() const = 0;
 
-        virtual std::tuple<std::vector<CachedTransaction>, std::vector<CachedTransaction>>
-            getPoolTransactionsForBlockTemplate() const = 0;
+        /* Picks the transactions for a block template, best fee per byte
+           first, so fusion transactions come last, until maxTotalSize is
+           reached. isValid is called, without the pool locked, for each one
+           which would fit. Only the chosen hashes are returned. */
+        virtual BlockTemplateTransactions selectTransactionsForBlockTemplate(
+            const size_t maxTotalSize,
+            const std::function<bool(const CachedTransaction &)> &isValid) const = 0;
 
         virtual uint64_t getTransactionReceiveTime(const Crypto::Hash &hash) const = 0;
 
         virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash &paymentId) const = 0;
 
+        /* The hashes of the pool transactions with the given short ids, see
+           getShortTransactionId. Each is std::nullopt if no transaction has
+           that short id, or more than one does. The index is kept for one
+           salt at a time, and rebuilt when another is asked for. */
+        virtual std::vector<std::optional<Crypto::Hash>> getTransactionHashesByShortId(
+            const Crypto::Hash &salt,
+            const std::vector<uint64_t> &shortIds) const = 0;
+
         virtual void flush() = 0;
     };
 
@@ -0,0 +1,264 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include <algorithm>
+#include <cryptonotecore/KeyImageFilter.h>
+#include <cstring>
+#include <mutex>
+
+namespace CryptoNote
+{
+    namespace
+    {
+        /* 12 bits and 8 probes per key image gives a false positive rate of
+           roughly 0.3% per layer */
+        const uint64_t BITS_PER_KEY_IMAGE = 12;
+
+        const uint64_t PROBES_PER_KEY_IMAGE = 8;
+
+        const uint32_t FILTER_FORMAT_VERSION = 1;
+
+        /* Key images are curve points, and as such are already uniformly
+           distributed - two words of the key image are good enough hashes
+           to derive the probes from with double hashing */
+        void getHashes(const Crypto::KeyImage &keyImage, uint64_t &first, uint64_t &second)
+        {
+            std::memcpy(&first, keyImage.data, sizeof(first));
+            std::memcpy(&second, keyImage.data + sizeof(first), sizeof(second));
+
+            /* Must be odd, so the probes don't cycle early */
+            second |= 1;
+        }
+
+        template<typename T> void writePod(std::string &out, const T &value)
+        {
+            out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+
+        template<typename T> bool readPod(const std::string &in, size_t &offset, T &value)
+        {
+            if (in.size() < offset + sizeof(value))
+            {
+                return false;
+            }
+
+            std::memcpy(&value, in.data() + offset, sizeof(value));
+            offset += sizeof(value);
+
+            return true;
+        }
+    } // namespace
+
+    KeyImageFilter::KeyImageFilter(const uint64_t initialCapacity):
+        m_initialCapacity(std::max<uint64_t>(initialCapacity, 1))
+    {
+        m_layers.push_back(makeLayer(m_initialCapacity));
+    }
+
+    KeyImageFilter::KeyImageFilter(KeyImageFilter &&other)
+    {
+        std::unique_lock lock(other.m_mutex);
+
+        m_initialCapacity = other.m_initialCapacity;
+        m_layers = std::move(other.m_layers);
+    }
+
+    KeyImageFilter &KeyImageFilter::operator=(KeyImageFilter &&other)
+    {
+        if (this != &other)
+        {
+            std::scoped_lock lock(m_mutex, other.m_mutex);
+
+            m_initialCapacity = other.m_initialCapacity;
+            m_layers = std::move(other.m_layers);
+        }
+
+        return *this;
+    }
+
+    KeyImageFilter::Layer KeyImageFilter::makeLayer(const uint64_t capacity)
+    {
+        Layer layer;
+
+        layer.capacity = capacity;
+        layer.count = 0;
+        layer.bits.resize((capacity * BITS_PER_KEY_IMAGE + 63) / 64);
+
+        return layer;
+    }
+
+    void KeyImageFilter::Layer::insert(const Crypto::KeyImage &keyImage)
+    {
+        uint64_t first;
+        uint64_t second;
+
+        getHashes(keyImage, first, second);
+
+        const uint64_t bitCount = bits.size() * 64;
+
+        for (uint64_t i = 0; i < PROBES_PER_KEY_IMAGE; i++)
+        {
+            const uint64_t bit = (first + i * second) % bitCount;
+            bits[bit / 64] |= uint64_t(1) << (bit % 64);
+        }
+
+        count++;
+    }
+
+    bool KeyImageFilter::Layer::contains(const Crypto::KeyImage &keyImage) const
+    {
+        uint64_t first;
+        uint64_t second;
+
+        getHashes(keyImage, first, second);
+
+        const uint64_t bitCount = bits.size() * 64;
+
+        for (uint64_t i = 0; i < PROBES_PER_KEY_IMAGE; i++)
+        {
+            const uint64_t bit = (first + i * second) % bitCount;
+
+            if ((bits[bit / 64] & (uint64_t(1) << (bit % 64))) == 0)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void KeyImageFilter::insert(const Crypto::KeyImage &keyImage)
+    {
+        std::unique_lock lock(m_mutex);
+
+        /* Filling a layer past its capacity would push up the false positive
+           rate, so start a bigger one instead */
+        if (m_layers.back().count >= m_layers.back().capacity)
+        {
+            m_layers.push_back(makeLayer(m_layers.back().capacity * 2));
+        }
+
+        m_layers.back().insert(keyImage);
+    }
+
+    bool KeyImageFilter::contains(const Crypto::KeyImage &keyImage) const
+    {
+        std::shared_lock lock(m_mutex);
+
+        /* Newest layer first, recently spent key images are the most likely
+           to be looked up again */
+        for (auto it = m_layers.rbegin(); it != m_layers.rend(); ++it)
+        {
+            if (it->contains(keyImage))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    uint64_t KeyImageFilter::size() const
+    {
+        std::shared_lock lock(m_mutex);
+
+        uint64_t count = 0;
+
+        for (const auto &layer : m_layers)
+        {
+            count += layer.count;
+        }
+
+        return count;
+    }
+
+    void KeyImageFilter::clear()
+    {
+        std::unique_lock lock(m_mutex);
+
+        m_layers.clear();
+        m_layers.push_back(makeLayer(m_initialCapacity));
+    }
+
+    std::string KeyImageFilter::toBinary() const
+    {
+        std::shared_lock lock(m_mutex);
+
+        std::string data;
+
+        writePod(data, FILTER_FORMAT_VERSION);
+        writePod(data, m_initialCapacity);
+        writePod(data, static_cast<uint64_t>(m_layers.size()));
+
+        for (const auto &layer : m_layers)
+        {
+            writePod(data, layer.capacity);
+            writePod(data, layer.count);
+            writePod(data, static_cast<uint64_t>(layer.bits.size()));
+
+            data.append(reinterpret_cast<const char *>(layer.bits.data()), layer.bits.size() * sizeof(uint64_t));
+        }
+
+        return data;
+    }
+
+    std::optional<KeyImageFilter> KeyImageFilter::fromBinary(const std::string &data)
+    {
+        size_t offset = 0;
+
+        uint32_t version;
+        uint64_t initialCapacity;
+        uint64_t layerCount;
+
+        if (!readPod(data, offset, version) || version != FILTER_FORMAT_VERSION
+            || !readPod(data, offset, initialCapacity) || initialCapacity == 0
+            || !readPod(data, offset, layerCount) || layerCount == 0)
+        {
+            return std::nullopt;
+        }
+
+        KeyImageFilter filter(initialCapacity);
+
+        filter.m_layers.clear();
+
+        for (uint64_t i = 0; i < layerCount; i++)
+        {
+            uint64_t capacity;
+            uint64_t count;
+            uint64_t wordCount;
+
+            if (!readPod(data, offset, capacity) || !readPod(data, offset, count)
+                || !readPod(data, offset, wordCount))
+            {
+                return std::nullopt;
+            }
+
+            /* Must match what makeLayer() would have produced, or the probes
+               would land on different bits */
+            if (capacity == 0 || capacity > data.size() || wordCount != (capacity * BITS_PER_KEY_IMAGE + 63) / 64
+                || wordCount > (data.size() - offset) / sizeof(uint64_t))
+            {
+                return std::nullopt;
+            }
+
+            Layer layer;
+
+            layer.capacity = capacity;
+            layer.count = count;
+            layer.bits.resize(wordCount);
+
+            std::memcpy(layer.bits.data(), data.data() + offset, wordCount * sizeof(uint64_t));
+            offset += wordCount * sizeof(uint64_t);
+
+            filter.m_layers.push_back(std::move(layer));
+        }
+
+        if (offset != data.size())
+        {
+            return std::nullopt;
+        }
+
+        return filter;
+    }
+} // namespace CryptoNote
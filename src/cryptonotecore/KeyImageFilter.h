@@ -0,0 +1,77 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <CryptoTypes.h>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace CryptoNote
+{
+    /* An approximate set of spent key images, kept in memory in front of the
+       database. contains() never returns false for a key image which was
+       inserted, but may return true for one which was not, in which case the
+       caller has to confirm with the database.
+
+       The filter is made of bloom filter layers. When the newest layer is
+       full, a new one of twice the size is added, so the filter can grow
+       with the chain without rehashing everything inserted so far.
+
+       Key images can't be removed. When blocks are popped, their key images
+       remain in the filter, which only costs the occasional false positive. */
+    class KeyImageFilter
+    {
+      public:
+        /* The amount of key images the first layer is sized for */
+        explicit KeyImageFilter(const uint64_t initialCapacity = 1 << 20);
+
+        void insert(const Crypto::KeyImage &keyImage);
+
+        /* False if the key image is definitely not in the set */
+        bool contains(const Crypto::KeyImage &keyImage) const;
+
+        /* The amount of key images inserted */
+        uint64_t size() const;
+
+        void clear();
+
+        std::string toBinary() const;
+
+        /* Returns std::nullopt if the data is malformed */
+        static std::optional<KeyImageFilter> fromBinary(const std::string &data);
+
+        /* The mutex can't be moved, only the contents */
+        KeyImageFilter(KeyImageFilter &&other);
+
+        KeyImageFilter &operator=(KeyImageFilter &&other);
+
+      private:
+        struct Layer
+        {
+            /* The amount of key images this layer is sized for */
+            uint64_t capacity;
+
+            /* The amount of key images inserted into this layer */
+            uint64_t count;
+
+            std::vector<uint64_t> bits;
+
+            void insert(const Crypto::KeyImage &keyImage);
+
+            bool contains(const Crypto::KeyImage &keyImage) const;
+        };
+
+        static Layer makeLayer(const uint64_t capacity);
+
+        uint64_t m_initialCapacity;
+
+        std::vector<Layer> m_layers;
+
+        /* Inserts happen on block push, lookups from validation threads */
+        mutable std::shared_mutex m_mutex;
+    };
+} // namespace CryptoNote
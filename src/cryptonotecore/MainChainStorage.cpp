@@ -7,55 +7,376 @@
 
 #include "common/CryptoNoteTools.h"
 #include "common/FileSystemShim.h"
+#include "common/MemoryInputStream.h"
+#include "serialization/BinaryInputStreamSerializer.h"
+#include "serialization/CryptoNoteSerialization.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <sstream>
 
 namespace CryptoNote
 {
-    const size_t STORAGE_CACHE_SIZE = 100;
+    namespace
+    {
+        const uint64_t OFFSETS_FORMAT_VERSION = 1;
+
+        /* Segments are created at this size up front and filled in as blocks
+           arrive. The files are sparse where the filesystem allows it, so the
+           unused tail of the last segment costs nothing. */
+        const uint64_t SEGMENT_SIZE = 128 * 1024 * 1024;
+
+        /* The amount of blocks the offsets file has room for to begin with.
+           It doubles whenever it fills up. */
+        const uint64_t INITIAL_OFFSETS_CAPACITY = 1024 * 1024;
+
+        /* Flushing on every block would make syncing from scratch crawl,
+           losing the last few blocks on a crash just means downloading them
+           again */
+        const uint32_t SYNC_INTERVAL = 100;
+    } // namespace
 
-    MainChainStorage::MainChainStorage(const std::string &blocksFilename, const std::string &indexesFilename)
+    MainChainStorage::MainChainStorage(
+        const std::string &blocksFilename,
+        const std::string &offsetsFilename,
+        const std::string &legacyIndexesFilename,
+        const uint32_t syncInterval):
+        m_blocksFilename(blocksFilename),
+        m_offsetsFilename(offsetsFilename),
+        m_syncInterval(syncInterval)
     {
-        if (!storage.open(blocksFilename, indexesFilename, STORAGE_CACHE_SIZE))
+        if (!fs::exists(offsetsFilename))
+        {
+            createOffsets(legacyIndexesFilename);
+        }
+
+        m_offsets.open(offsetsFilename);
+
+        const uint64_t capacity = m_offsets.size() < sizeof(OffsetsHeader)
+                                      ? 0
+                                      : (m_offsets.size() - sizeof(OffsetsHeader)) / sizeof(BlockLocation);
+
+        if (capacity == 0 || header().version != OFFSETS_FORMAT_VERSION || header().count > capacity)
         {
-            throw std::runtime_error("Failed to load main chain storage: " + blocksFilename);
+            throw std::runtime_error("Failed to load main chain storage, invalid block offsets file: " + offsetsFilename);
+        }
+
+        /* Anything pushed after the last sync isn't counted, so a torn tail
+           is dropped here and downloaded again. A segment file which has
+           gone missing or been truncated since is dropped the same way. */
+        m_count = header().count;
+
+        while (m_count > 0)
+        {
+            const BlockLocation &last = locations()[m_count - 1];
+
+            std::error_code ec;
+
+            const uint64_t segmentSize = fs::file_size(segmentFilename(last.segment), ec);
+
+            if (!ec && last.offset + last.size <= segmentSize)
+            {
+                break;
+            }
+
+            m_count--;
+        }
+
+        if (m_count < header().count)
+        {
+            header().count = m_count;
+            m_countLowered = true;
+        }
+
+        if (m_count > 0)
+        {
+            const uint32_t lastSegment = locations()[m_count - 1].segment;
+
+            for (uint32_t segment = 0; segment <= lastSegment; segment++)
+            {
+                auto file = std::make_unique<System::MemoryMappedFile>();
+
+                file->open(segmentFilename(segment));
+
+                m_segments.push_back(std::move(file));
+            }
+
+            m_dirtySegments.resize(m_segments.size(), false);
         }
     }
 
     MainChainStorage::~MainChainStorage()
     {
-        storage.close();
+        try
+        {
+            sync();
+        }
+        catch (const std::exception &)
+        {
+            /* Nothing more we can do, the unsynced blocks are trimmed on the
+               next open */
+        }
+    }
+
+    void MainChainStorage::createOffsets(const std::string &legacyIndexesFilename) const
+    {
+        std::vector<BlockLocation> locations;
+
+        /* The old index is the block count, followed by the size of each
+           block, which are stored back to back in the blocks file */
+        std::ifstream legacyIndexes(legacyIndexesFilename, std::ios::binary);
+
+        if (legacyIndexes)
+        {
+            std::error_code ec;
+
+            const uint64_t blocksFileSize = fs::file_size(m_blocksFilename, ec);
+
+            uint64_t count = 0;
+
+            legacyIndexes.read(reinterpret_cast<char *>(&count), sizeof(count));
+
+            uint64_t offset = 0;
+
+            for (uint64_t i = 0; legacyIndexes && !ec && i < count; i++)
+            {
+                uint32_t size;
+
+                legacyIndexes.read(reinterpret_cast<char *>(&size), sizeof(size));
+
+                if (!legacyIndexes || offset + size > blocksFileSize)
+                {
+                    break;
+                }
+
+                locations.push_back({0, size, offset});
+
+                offset += size;
+            }
+        }
+
+        const uint64_t capacity = std::max<uint64_t>(INITIAL_OFFSETS_CAPACITY, locations.size() * 2);
+
+        /* Written to a temporary file first, so if we're interrupted, the
+           conversion just starts over */
+        const std::string temporaryFilename = m_offsetsFilename + ".tmp";
+
+        {
+            System::MemoryMappedFile offsets;
+
+            offsets.create(temporaryFilename, sizeof(OffsetsHeader) + capacity * sizeof(BlockLocation), true);
+
+            OffsetsHeader header {OFFSETS_FORMAT_VERSION, locations.size()};
+
+            std::memcpy(offsets.data(), &header, sizeof(header));
+
+            if (!locations.empty())
+            {
+                std::memcpy(
+                    offsets.data() + sizeof(header), locations.data(), locations.size() * sizeof(BlockLocation));
+            }
+        }
+
+        fs::rename(temporaryFilename, m_offsetsFilename);
+
+        std::error_code ignore;
+        fs::remove(legacyIndexesFilename, ignore);
+    }
+
+    std::string MainChainStorage::segmentFilename(const uint32_t segment) const
+    {
+        /* The first segment is the original blocks file */
+        if (segment == 0)
+        {
+            return m_blocksFilename;
+        }
+
+        return m_blocksFilename + "." + std::to_string(segment);
+    }
+
+    void MainChainStorage::createSegment(const uint32_t segment, const uint64_t minimumSize)
+    {
+        auto file = std::make_unique<System::MemoryMappedFile>();
+
+        file->create(segmentFilename(segment), std::max(SEGMENT_SIZE, minimumSize), true);
+
+        if (segment < m_segments.size())
+        {
+            m_segments[segment] = std::move(file);
+        }
+        else
+        {
+            m_segments.push_back(std::move(file));
+            m_dirtySegments.push_back(false);
+        }
+    }
+
+    void MainChainStorage::reserveOffsets(const uint64_t count)
+    {
+        const uint64_t capacity = (m_offsets.size() - sizeof(OffsetsHeader)) / sizeof(BlockLocation);
+
+        if (count <= capacity)
+        {
+            return;
+        }
+
+        const uint64_t newCapacity = std::max(count, capacity * 2);
+
+        m_offsets.close();
+
+        fs::resize_file(m_offsetsFilename, sizeof(OffsetsHeader) + newCapacity * sizeof(BlockLocation));
+
+        m_offsets.open(m_offsetsFilename);
+    }
+
+    void MainChainStorage::sync()
+    {
+        for (size_t segment = 0; segment < m_segments.size(); segment++)
+        {
+            if (m_dirtySegments[segment])
+            {
+                m_segments[segment]->flush(m_segments[segment]->data(), m_segments[segment]->size());
+                m_dirtySegments[segment] = false;
+            }
+        }
+
+        /* The index entries have to be on disk before the count covering
+           them is */
+        m_offsets.flush(m_offsets.data(), sizeof(OffsetsHeader) + m_count * sizeof(BlockLocation));
+
+        header().count = m_count;
+
+        m_offsets.flush(m_offsets.data(), sizeof(OffsetsHeader));
+
+        m_unsyncedChanges = 0;
+
+        m_countLowered = false;
     }
 
     void MainChainStorage::pushBlock(const RawBlock &rawBlock)
     {
-        storage.push_back(rawBlock);
+        const BinaryArray record = toBinaryArray(rawBlock);
+
+        /* We're about to overwrite popped blocks, so the header can't still
+           be counting them on disk */
+        if (m_countLowered)
+        {
+            m_offsets.flush(m_offsets.data(), sizeof(OffsetsHeader));
+            m_countLowered = false;
+        }
+
+        BlockLocation location {0, static_cast<uint32_t>(record.size()), 0};
+
+        const uint64_t count = m_count;
+
+        if (count > 0)
+        {
+            const BlockLocation &last = locations()[count - 1];
+
+            location.segment = last.segment;
+            location.offset = last.offset + last.size;
+
+            /* Doesn't fit in the current segment, start the next one */
+            if (location.offset + record.size() > m_segments[location.segment]->size())
+            {
+                location.segment++;
+                location.offset = 0;
+            }
+        }
+
+        /* Any existing file for a segment we're starting only holds blocks
+           which have since been popped */
+        if (location.offset == 0)
+        {
+            createSegment(location.segment, record.size());
+        }
+
+        auto &segment = *m_segments[location.segment];
+
+        std::memcpy(segment.data() + location.offset, record.data(), record.size());
+
+        m_dirtySegments[location.segment] = true;
+
+        /* The block goes in before the index entry pointing to it */
+        reserveOffsets(count + 1);
+
+        locations()[count] = location;
+        m_count = count + 1;
+
+        if (m_syncInterval == 0)
+        {
+            header().count = m_count;
+        }
+        else if (++m_unsyncedChanges >= m_syncInterval)
+        {
+            sync();
+        }
     }
 
     void MainChainStorage::popBlock()
     {
-        storage.pop_back();
+        if (m_count == 0)
+        {
+            throw std::out_of_range("Can't pop a block from an empty main chain storage");
+        }
+
+        m_count--;
+
+        if (m_count < header().count)
+        {
+            header().count = m_count;
+            m_countLowered = true;
+        }
+
+        if (m_syncInterval != 0 && ++m_unsyncedChanges >= m_syncInterval)
+        {
+            sync();
+        }
     }
 
-    void MainChainStorage::rewindTo(const uint32_t index) const
+    void MainChainStorage::rewindTo(const uint32_t index)
     {
         while (getBlockCount() >= index)
         {
-            storage.pop_back();
+            popBlock();
         }
+
+        sync();
     }
 
-    RawBlock MainChainStorage::getBlockByIndex(uint32_t index) const
+    Common::ArrayView<uint8_t> MainChainStorage::getSerializedBlockByIndex(uint32_t index) const
     {
-        if (index >= storage.size())
+        if (index >= getBlockCount())
         {
             throw std::out_of_range(
                 "Block index " + std::to_string(index)
-                + " is out of range. Blocks count: " + std::to_string(storage.size()));
+                + " is out of range. Blocks count: " + std::to_string(getBlockCount()));
         }
 
+        const BlockLocation &location = locations()[index];
+
+        return Common::ArrayView<uint8_t>(m_segments[location.segment]->data() + location.offset, location.size);
+    }
+
+    RawBlock MainChainStorage::getBlockByIndex(uint32_t index) const
+    {
+        const auto record = getSerializedBlockByIndex(index);
+
         try
         {
-            return storage[index];
+            Common::MemoryInputStream stream(record.getData(), record.getSize());
+            BinaryInputStreamSerializer serializer(stream);
+
+            RawBlock rawBlock;
+            serialize(rawBlock, serializer);
+
+            if (!stream.endOfStream())
+            {
+                throw std::runtime_error("Trailing data after block");
+            }
+
+            return rawBlock;
         }
         catch (std::exception &)
         {
@@ -77,22 +398,35 @@ namespace CryptoNote
 
     uint32_t MainChainStorage::getBlockCount() const
     {
-        return static_cast<uint32_t>(storage.size());
+        return static_cast<uint32_t>(m_count);
     }
 
     void MainChainStorage::clear()
     {
-        storage.clear();
+        m_count = 0;
+
+        sync();
+    }
+
+    MainChainStorage::OffsetsHeader &MainChainStorage::header() const
+    {
+        return *reinterpret_cast<OffsetsHeader *>(m_offsets.data());
     }
 
-    std::unique_ptr<IMainChainStorage>
-        createSwappedMainChainStorage(const std::string &dataDir, const Currency &currency)
+    MainChainStorage::BlockLocation *MainChainStorage::locations() const
+    {
+        return reinterpret_cast<BlockLocation *>(m_offsets.data() + sizeof(OffsetsHeader));
+    }
+
+    std::unique_ptr<IMainChainStorage> createMainChainStorage(const std::string &dataDir, const Currency &currency)
     {
         fs::path blocksFilename = fs::path(dataDir) / currency.blocksFileName();
+        fs::path offsetsFilename = fs::path(dataDir) / parameters::CRYPTONOTE_BLOCKOFFSETS_FILENAME;
         fs::path indexesFilename = fs::path(dataDir) / currency.blockIndexesFileName();
 
-        std::unique_ptr<IMainChainStorage> storage(
-            new MainChainStorage(blocksFilename.string(), indexesFilename.string()));
+        std::unique_ptr<IMainChainStorage> storage(new MainChainStorage(
+            blocksFilename.string(), offsetsFilename.string(), indexesFilename.string(), SYNC_INTERVAL));
+
         if (storage->getBlockCount() == 0)
         {
             RawBlock genesis;
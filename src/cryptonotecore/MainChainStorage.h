@@ -7,22 +7,44 @@
 
 #include "Currency.h"
 #include "IMainChainStorage.h"
-#include "SwappedVector.h"
+#include "common/ArrayView.h"
+
+#include <memory>
+#include <system/MemoryMappedFile.h>
+#include <vector>
 
 namespace CryptoNote
 {
+    /* Keeps the main chain in append only, memory mapped segment files, along
+       with a fixed width index of where each block lives, so any block can be
+       found without reading the ones before it, and read without copying.
+
+       The first segment is the blocks file itself, which has the same record
+       format as the old SwappedVector storage, so an existing blocks file is
+       used as is. Only its index needs converting, which is done on open. */
     class MainChainStorage : public IMainChainStorage
     {
       public:
-        MainChainStorage(const std::string &blocksFilame, const std::string &indexesFilename);
+        /* The segments and index are flushed to disk every syncInterval
+           pushes or pops, and on close. Zero leaves it to the OS, and a crash
+           may then leave blocks counted which never reached the disk. */
+        MainChainStorage(
+            const std::string &blocksFilename,
+            const std::string &offsetsFilename,
+            const std::string &legacyIndexesFilename,
+            const uint32_t syncInterval);
 
         virtual ~MainChainStorage();
 
+        MainChainStorage(const MainChainStorage &) = delete;
+
+        MainChainStorage &operator=(const MainChainStorage &) = delete;
+
         virtual void pushBlock(const RawBlock &rawBlock) override;
 
         virtual void popBlock() override;
 
-        void rewindTo(const uint32_t index) const override;
+        virtual void rewindTo(const uint32_t index) override;
 
         virtual RawBlock getBlockByIndex(uint32_t index) const override;
 
@@ -31,10 +53,78 @@ namespace CryptoNote
         virtual void clear() override;
 
       private:
-        mutable SwappedVector<RawBlock> storage;
+        /* The offsets file is this header, followed by a BlockLocation for
+           each block, with room to spare so it doesn't need growing on every
+           push.
+
+           The count is only advanced by sync(), once the blocks it covers
+           have been flushed, so on open everything it counts is known to be
+           on disk. The segments are preallocated, so their size can't tell
+           us that. */
+        struct OffsetsHeader
+        {
+            uint64_t version;
+
+            uint64_t count;
+        };
+
+        struct BlockLocation
+        {
+            uint32_t segment;
+
+            uint32_t size;
+
+            uint64_t offset;
+        };
+
+        static_assert(sizeof(OffsetsHeader) == 16 && sizeof(BlockLocation) == 16, "Offsets file layout changed");
+
+        /* Writes a fresh offsets file, from the old block indexes file if
+           there is one */
+        void createOffsets(const std::string &legacyIndexesFilename) const;
+
+        std::string segmentFilename(const uint32_t segment) const;
+
+        /* Creates (or recreates, discarding popped blocks) a segment with room
+           for at least minimumSize bytes */
+        void createSegment(const uint32_t segment, const uint64_t minimumSize);
+
+        void reserveOffsets(const uint64_t count);
+
+        void sync();
+
+        /* The stored block, a binary serialized RawBlock. Pointing into the
+           segment mapping, it is only valid until the next push or pop. */
+        Common::ArrayView<uint8_t> getSerializedBlockByIndex(uint32_t index) const;
+
+        OffsetsHeader &header() const;
+
+        BlockLocation *locations() const;
+
+        std::string m_blocksFilename;
+
+        std::string m_offsetsFilename;
+
+        uint32_t m_syncInterval;
+
+        /* The blocks we have, including any not yet committed to the header */
+        uint64_t m_count = 0;
+
+        /* Pushes and pops since the last sync */
+        uint32_t m_unsyncedChanges = 0;
+
+        /* A pop has lowered the count in the header, which has to reach the
+           disk before anything is written over the popped blocks */
+        bool m_countLowered = false;
+
+        /* The segments written to since the last sync */
+        std::vector<bool> m_dirtySegments;
+
+        mutable System::MemoryMappedFile m_offsets;
+
+        std::vector<std::unique_ptr<System::MemoryMappedFile>> m_segments;
     };
 
-    std::unique_ptr<IMainChainStorage>
-        createSwappedMainChainStorage(const std::string &dataDir, const Currency &currency);
+    std::unique_ptr<IMainChainStorage> createMainChainStorage(const std::string &dataDir, const Currency &currency);
 
 } // namespace CryptoNote
@@ -0,0 +1,184 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <limits>
+#include <config/CryptoNoteConfig.h>
+#include <cryptonotecore/RingSignatureBatch.h>
+#include <cryptonotecore/TransactionValidationErrors.h>
+
+RingSignatureBatch::RingSignatureBatch(
+    const CryptoNote::IBlockchainCache *cache,
+    Utilities::ThreadPool &threadPool,
+    const uint64_t blockHeight,
+    const bool isPoolTransaction) :
+    m_blockchainCache(cache),
+    m_threadPool(threadPool),
+    m_blockHeight(blockHeight),
+    m_isPoolTransaction(isPoolTransaction)
+{
+}
+
+size_t RingSignatureBatch::addTransaction(const CryptoNote::CachedTransaction &cachedTransaction)
+{
+    const size_t transactionIndex = m_transactionCount++;
+
+    const auto &inputs = cachedTransaction.getTransaction().inputs;
+
+    for (size_t inputIndex = 0; inputIndex < inputs.size(); inputIndex++)
+    {
+        if (inputs[inputIndex].type() == typeid(CryptoNote::KeyInput))
+        {
+            m_rings.push_back({transactionIndex, inputIndex, &cachedTransaction});
+        }
+    }
+
+    return transactionIndex;
+}
+
+size_t RingSignatureBatch::size() const
+{
+    return m_rings.size();
+}
+
+std::optional<RingSignatureBatchFailure> RingSignatureBatch::verify()
+{
+    if (m_rings.empty())
+    {
+        return std::nullopt;
+    }
+
+    /* Look up every key image in one go, instead of one database read per input */
+    std::vector<Crypto::KeyImage> keyImages;
+    keyImages.reserve(m_rings.size());
+
+    for (const auto &ring : m_rings)
+    {
+        const auto &input = ring.transaction->getTransaction().inputs[ring.inputIndex];
+        keyImages.push_back(boost::get<CryptoNote::KeyInput>(input).keyImage);
+    }
+
+    /* Block indexes are 32 bit throughout the cache */
+    assert(m_blockHeight <= std::numeric_limits<uint32_t>::max());
+
+    const auto spentKeyImages =
+        m_blockchainCache->getSpentKeyImages(keyImages, static_cast<uint32_t>(m_blockHeight));
+
+    if (!spentKeyImages.empty())
+    {
+        for (size_t i = 0; i < m_rings.size(); i++)
+        {
+            if (spentKeyImages.find(keyImages[i]) != spentKeyImages.end())
+            {
+                return RingSignatureBatchFailure {
+                    m_rings[i].transactionIndex,
+                    CryptoNote::error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT,
+                    "Transaction contains key image that has already been spent"
+                };
+            }
+        }
+    }
+
+    /* Each ring writes its own slot, so no locking is required */
+    std::vector<std::optional<RingSignatureBatchFailure>> results(m_rings.size());
+
+    /* The lowest failing ring found so far. Rings after it are skipped, but
+       rings before it are still verified, so the failure reported is always
+       the first one, however the work was scheduled. Rings are added in
+       transaction order, so that is also the earliest transaction. */
+    std::atomic<size_t> firstFailure = m_rings.size();
+
+    /* Split the rings into one coarse chunk per thread */
+    m_threadPool.parallelFor(m_rings.size(), [&results, &firstFailure, this](const size_t i) {
+        if (i > firstFailure.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        results[i] = verifyRing(m_rings[i]);
+
+        if (results[i])
+        {
+            size_t current = firstFailure.load(std::memory_order_relaxed);
+
+            while (i < current && !firstFailure.compare_exchange_weak(current, i, std::memory_order_relaxed))
+            {
+            }
+        }
+    });
+
+    if (firstFailure == m_rings.size())
+    {
+        return std::nullopt;
+    }
+
+    return results[firstFailure];
+}
+
+std::optional<RingSignatureBatchFailure> RingSignatureBatch::verifyRing(const Ring &ring) const
+{
+    const auto &transaction = ring.transaction->getTransaction();
+
+    const CryptoNote::KeyInput &in = boost::get<CryptoNote::KeyInput>(transaction.inputs[ring.inputIndex]);
+
+    std::vector<Crypto::PublicKey> outputKeys;
+    std::vector<uint32_t> globalIndexes(in.outputIndexes.size());
+
+    globalIndexes[0] = in.outputIndexes[0];
+
+    /* Convert output indexes from relative to absolute */
+    for (size_t i = 1; i < in.outputIndexes.size(); ++i)
+    {
+        globalIndexes[i] = globalIndexes[i - 1] + in.outputIndexes[i];
+    }
+
+    const auto result = m_blockchainCache->extractKeyOutputKeys(
+        in.amount, m_blockHeight, {globalIndexes.data(), globalIndexes.size()}, outputKeys);
+
+    if (result == CryptoNote::ExtractOutputKeysResult::INVALID_GLOBAL_INDEX)
+    {
+        return RingSignatureBatchFailure {
+            ring.transactionIndex,
+            CryptoNote::error::TransactionValidationError::INPUT_INVALID_GLOBAL_INDEX,
+            "Transaction contains invalid global indexes"
+        };
+    }
+
+    if (result == CryptoNote::ExtractOutputKeysResult::OUTPUT_LOCKED)
+    {
+        return RingSignatureBatchFailure {
+            ring.transactionIndex,
+            CryptoNote::error::TransactionValidationError::INPUT_SPEND_LOCKED_OUT,
+            "Transaction includes an input which is still locked"
+        };
+    }
+
+    const auto &signatures = transaction.signatures[ring.inputIndex];
+
+    if (m_isPoolTransaction || m_blockHeight >= CryptoNote::parameters::TRANSACTION_SIGNATURE_COUNT_VALIDATION_HEIGHT)
+    {
+        if (outputKeys.size() != signatures.size())
+        {
+            return RingSignatureBatchFailure {
+                ring.transactionIndex,
+                CryptoNote::error::TransactionValidationError::INPUT_INVALID_SIGNATURES_COUNT,
+                "Transaction has an invalid number of signatures"
+            };
+        }
+    }
+
+    if (!Crypto::crypto_ops::checkRingSignature(
+            ring.transaction->getTransactionPrefixHash(), in.keyImage, outputKeys, signatures))
+    {
+        return RingSignatureBatchFailure {
+            ring.transactionIndex,
+            CryptoNote::error::TransactionValidationError::INPUT_INVALID_SIGNATURES,
+            "Transaction contains invalid signatures"
+        };
+    }
+
+    return std::nullopt;
+}
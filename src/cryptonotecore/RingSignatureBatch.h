@@ -0,0 +1,90 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <system_error>
+
+#include <CryptoNote.h>
+#include <cryptonotecore/CachedTransaction.h>
+#include <cryptonotecore/IBlockchainCache.h>
+#include <optional>
+#include <utilities/ThreadPool.h>
+
+struct RingSignatureBatchFailure
+{
+    /* The index of the failing transaction, in the order they were added */
+    size_t transactionIndex;
+
+    /* A programmatic error code of the failure */
+    std::error_code errorCode;
+
+    /* An error message describing the error code */
+    std::string errorMessage;
+};
+
+/* Verifies the expensive parts of transaction input validation - key images
+ * not being spent, and the ring signatures - for many transactions at once,
+ * such as every transaction in a block. All key images are looked up in a
+ * single read, and the rings are then verified across the thread pool in
+ * a handful of coarse chunks, rather than a job per input. */
+class RingSignatureBatch
+{
+    public:
+        /////////////////
+        /* CONSTRUCTOR */
+        /////////////////
+        RingSignatureBatch(
+            const CryptoNote::IBlockchainCache *cache,
+            Utilities::ThreadPool &threadPool,
+            const uint64_t blockHeight,
+            const bool isPoolTransaction);
+
+        /////////////////////////////
+        /* PUBLIC MEMBER FUNCTIONS */
+        /////////////////////////////
+
+        /* Queues every key input of the transaction for verification. The
+         * transaction must outlive the batch. Returns the index of the
+         * transaction in the batch. */
+        size_t addTransaction(const CryptoNote::CachedTransaction &cachedTransaction);
+
+        /* Verifies all queued rings. Returns the first failing transaction,
+         * if any. */
+        std::optional<RingSignatureBatchFailure> verify();
+
+        size_t size() const;
+
+    private:
+        struct Ring
+        {
+            /* The transaction this ring belongs to */
+            size_t transactionIndex;
+
+            /* The input index in the transaction */
+            size_t inputIndex;
+
+            const CryptoNote::CachedTransaction *transaction;
+        };
+
+        //////////////////////////////
+        /* PRIVATE MEMBER FUNCTIONS */
+        //////////////////////////////
+        std::optional<RingSignatureBatchFailure> verifyRing(const Ring &ring) const;
+
+        /////////////////////////
+        /* PRIVATE MEMBER VARS */
+        /////////////////////////
+        const CryptoNote::IBlockchainCache *m_blockchainCache;
+
+        Utilities::ThreadPool &m_threadPool;
+
+        const uint64_t m_blockHeight;
+
+        const bool m_isPoolTransaction;
+
+        std::vector<Ring> m_rings;
+
+        size_t m_transactionCount = 0;
+};
@@ -5,19 +5,43 @@
 
 #include "RocksDBWrapper.h"
 
+#include "DBUtils.h"
 #include "DataBaseErrors.h"
 #include "rocksdb/cache.h"
 #include "rocksdb/db.h"
+#include "rocksdb/filter_policy.h"
+#include "rocksdb/slice_transform.h"
 #include "rocksdb/table.h"
 #include "rocksdb/utilities/backupable_db.h"
 
+#include <algorithm>
+
 using namespace CryptoNote;
 using namespace Logging;
 
 namespace
 {
     const std::string DB_NAME = "DB";
-}
+
+    const std::string COLUMN_FAMILY_NAME_PREFIX = "prefix_";
+
+    /* Stored in the default column family once every record has been moved
+       to the column family for its prefix */
+    const std::string COLUMN_FAMILY_LAYOUT_KEY = "column_family_layout";
+
+    const std::string COLUMN_FAMILY_LAYOUT_VERSION = "1";
+
+    /* The output count of each amount is stored under the same key prefix
+       as the amount's global indexes, but the keys are shaped differently,
+       so they get a column family of their own rather than sharing the
+       global indexes' prefix extractor */
+    const std::string KEY_OUTPUT_COUNT_COLUMN_FAMILY = "key_output_counts";
+
+    /* Flush the migration write batch once it holds this many bytes */
+    const size_t MIGRATION_BATCH_SIZE = 64 * 1024 * 1024;
+
+    const int BLOOM_FILTER_BITS_PER_KEY = 10;
+} // namespace
 
 RocksDBWrapper::RocksDBWrapper(std::shared_ptr<Logging::ILogger> logger):
     logger(logger, "RocksDBWrapper"),
@@ -25,7 +49,14 @@ RocksDBWrapper::RocksDBWrapper(std::shared_ptr<Logging::ILogger> logger):
 {
 }
 
-RocksDBWrapper::~RocksDBWrapper() {}
+RocksDBWrapper::~RocksDBWrapper()
+{
+    /* Column family handles must go before the DB they belong to */
+    if (db)
+    {
+        closeColumnFamilies();
+    }
+}
 
 void RocksDBWrapper::init(const DataBaseConfig &config)
 {
@@ -38,10 +69,40 @@ void RocksDBWrapper::init(const DataBaseConfig &config)
 
     logger(INFO) << "Opening DB in " << dataDir;
 
+    blockCache = rocksdb::NewLRUCache(config.readCacheSize);
+
     rocksdb::DB *dbPtr;
 
     rocksdb::Options dbOptions = getDBOptions(config);
-    rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, &dbPtr);
+
+    /* DBs created before the split into column families only have the
+       default one, the rest get created on open */
+    dbOptions.create_missing_column_families = true;
+
+    std::vector<rocksdb::ColumnFamilyDescriptor> descriptors = getColumnFamilyDescriptors(config);
+
+    /* RocksDB refuses to open a DB without every one of its column families,
+       so open any we don't know about too, with the default options */
+    std::vector<std::string> existingColumnFamilies;
+
+    if (rocksdb::DB::ListColumnFamilies(dbOptions, dataDir, &existingColumnFamilies).ok())
+    {
+        for (const auto &name : existingColumnFamilies)
+        {
+            const auto it = std::find_if(descriptors.begin(), descriptors.end(), [&name](const auto &descriptor) {
+                return descriptor.name == name;
+            });
+
+            if (it == descriptors.end())
+            {
+                descriptors.emplace_back(name, rocksdb::ColumnFamilyOptions(dbOptions));
+            }
+        }
+    }
+
+    std::vector<rocksdb::ColumnFamilyHandle *> handles;
+
+    rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, descriptors, &handles, &dbPtr);
     if (status.ok())
     {
         logger(INFO) << "DB opened in " << dataDir;
@@ -50,7 +111,7 @@ void RocksDBWrapper::init(const DataBaseConfig &config)
     {
         logger(INFO) << "DB not found in " << dataDir << ". Creating new DB...";
         dbOptions.create_if_missing = true;
-        rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, &dbPtr);
+        rocksdb::Status status = rocksdb::DB::Open(dbOptions, dataDir, descriptors, &handles, &dbPtr);
         if (!status.ok())
         {
             logger(ERROR) << "DB Error. DB can't be created in " << dataDir << ". Error: " << status.ToString();
@@ -69,6 +130,32 @@ void RocksDBWrapper::init(const DataBaseConfig &config)
     }
 
     db.reset(dbPtr);
+
+    columnFamilyHandles = handles;
+
+    for (size_t i = 0; i < descriptors.size(); i++)
+    {
+        if (descriptors[i].name == rocksdb::kDefaultColumnFamilyName)
+        {
+            defaultColumnFamily = handles[i];
+            continue;
+        }
+
+        if (descriptors[i].name == KEY_OUTPUT_COUNT_COLUMN_FAMILY)
+        {
+            keyOutputCountColumnFamily = handles[i];
+            continue;
+        }
+
+        /* Our column families are named after the key prefix they hold */
+        if (descriptors[i].name.rfind(COLUMN_FAMILY_NAME_PREFIX, 0) == 0)
+        {
+            columnFamiliesByPrefix[descriptors[i].name.substr(COLUMN_FAMILY_NAME_PREFIX.size())] = handles[i];
+        }
+    }
+
+    migrateToColumnFamilies();
+
     state.store(INITIALIZED);
 }
 
@@ -80,8 +167,9 @@ void RocksDBWrapper::shutdown()
     }
 
     logger(INFO) << "Closing DB.";
-    db->Flush(rocksdb::FlushOptions());
+    db->Flush(rocksdb::FlushOptions(), columnFamilyHandles);
     db->SyncWAL();
+    closeColumnFamilies();
     db.reset();
     state.store(NOT_INITIALIZED);
 }
@@ -130,13 +218,13 @@ std::error_code RocksDBWrapper::write(IWriteBatch &batch, bool sync)
     std::vector<std::pair<std::string, std::string>> rawData(batch.extractRawDataToInsert());
     for (const std::pair<std::string, std::string> &kvPair : rawData)
     {
-        rocksdbBatch.Put(rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
+        rocksdbBatch.Put(getColumnFamily(kvPair.first), rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
     }
 
     std::vector<std::string> rawKeys(batch.extractRawKeysToRemove());
     for (const std::string &key : rawKeys)
     {
-        rocksdbBatch.Delete(rocksdb::Slice(key));
+        rocksdbBatch.Delete(getColumnFamily(key), rocksdb::Slice(key));
     }
 
     rocksdb::Status status = db->Write(writeOptions, &rocksdbBatch);
@@ -163,15 +251,18 @@ std::error_code RocksDBWrapper::read(IReadBatch &batch)
 
     std::vector<std::string> rawKeys(batch.getRawKeys());
     std::vector<rocksdb::Slice> keySlices;
+    std::vector<rocksdb::ColumnFamilyHandle *> columnFamilies;
     keySlices.reserve(rawKeys.size());
+    columnFamilies.reserve(rawKeys.size());
     for (const std::string &key : rawKeys)
     {
         keySlices.emplace_back(rocksdb::Slice(key));
+        columnFamilies.push_back(getColumnFamily(key));
     }
 
     std::vector<std::string> values;
     values.reserve(rawKeys.size());
-    std::vector<rocksdb::Status> statuses = db->MultiGet(readOptions, keySlices, &values);
+    std::vector<rocksdb::Status> statuses = db->MultiGet(readOptions, columnFamilies, keySlices, &values);
 
     std::error_code error;
     std::vector<bool> resultStates;
@@ -207,7 +298,7 @@ std::error_code RocksDBWrapper::readThreadSafe(IReadBatch &batch)
 
     for (const std::string &key : rawKeys)
     {
-        const rocksdb::Status status = db->Get(readOptions, rocksdb::Slice(key), &values[i]);
+        const rocksdb::Status status = db->Get(readOptions, getColumnFamily(key), rocksdb::Slice(key), &values[i]);
 
         if (status.ok())
         {
@@ -236,7 +327,18 @@ rocksdb::Options RocksDBWrapper::getDBOptions(const DataBaseConfig &config)
     dbOptions.IncreaseParallelism(config.backgroundThreadsCount);
     dbOptions.info_log_level = rocksdb::InfoLogLevel::WARN_LEVEL;
     dbOptions.max_open_files = config.maxOpenFiles;
+    // every column family has its own memtables, cap them as a whole at what a
+    // single column family could use before the split
+    dbOptions.db_write_buffer_size = static_cast<size_t>(config.writeBufferSize) * 6;
+
+    return rocksdb::Options(dbOptions, getColumnFamilyOptions(config, ColumnFamilyProfile::SEQUENTIAL, ""));
+}
 
+rocksdb::ColumnFamilyOptions RocksDBWrapper::getColumnFamilyOptions(
+    const DataBaseConfig &config,
+    const ColumnFamilyProfile profile,
+    const std::string &keyPrefix)
+{
     rocksdb::ColumnFamilyOptions fOptions;
     fOptions.write_buffer_size = static_cast<size_t>(config.writeBufferSize);
     // merge two memtables when flushing to L0
@@ -269,19 +371,213 @@ rocksdb::Options RocksDBWrapper::getDBOptions(const DataBaseConfig &config)
 
     for (int i = 0; i < fOptions.num_levels; ++i)
     {
-        // don't compress l0 & l1
-        fOptions.compression_per_level[i] = (i < 2 ? rocksdb::kNoCompression : compressionLevel);
+        // don't compress l0 & l1, except for raw blocks, which are big and
+        // rarely read, so are worth compressing everywhere
+        const bool compress = i >= 2 || profile == ColumnFamilyProfile::RAW_BLOCK;
+        fOptions.compression_per_level[i] = compress ? compressionLevel : rocksdb::kNoCompression;
     }
 
     // bottom most use kZSTD
     fOptions.bottommost_compression = compressionLevel;
 
     rocksdb::BlockBasedTableOptions tableOptions;
-    tableOptions.block_cache = rocksdb::NewLRUCache(config.readCacheSize);
+    tableOptions.block_cache = blockCache;
+
+    switch (profile)
+    {
+        case ColumnFamilyProfile::SEQUENTIAL:
+        {
+            break;
+        }
+        case ColumnFamilyProfile::POINT_LOOKUP:
+        {
+            // most lookups are for keys which don't exist (unspent key images,
+            // unknown transactions), which a bloom filter answers without
+            // reading a data block
+            tableOptions.filter_policy.reset(rocksdb::NewBloomFilterPolicy(BLOOM_FILTER_BITS_PER_KEY, false));
+            tableOptions.whole_key_filtering = true;
+            tableOptions.cache_index_and_filter_blocks = true;
+            tableOptions.pin_l0_filter_and_index_blocks_in_cache = true;
+            tableOptions.data_block_index_type = rocksdb::BlockBasedTableOptions::kDataBlockBinaryAndHash;
+            fOptions.memtable_prefix_bloom_size_ratio = 0.02;
+            fOptions.memtable_whole_key_filtering = true;
+            break;
+        }
+        case ColumnFamilyProfile::KEY_OUTPUT:
+        {
+            // keys of the same amount share a prefix, so put that in the bloom
+            // filter as well as the whole key
+            fOptions.prefix_extractor.reset(
+                rocksdb::NewFixedPrefixTransform(DB::getKeyOutputPrefixLength(keyPrefix)));
+            tableOptions.filter_policy.reset(rocksdb::NewBloomFilterPolicy(BLOOM_FILTER_BITS_PER_KEY, false));
+            tableOptions.whole_key_filtering = true;
+            tableOptions.cache_index_and_filter_blocks = true;
+            tableOptions.pin_l0_filter_and_index_blocks_in_cache = true;
+            fOptions.memtable_prefix_bloom_size_ratio = 0.02;
+            break;
+        }
+        case ColumnFamilyProfile::RAW_BLOCK:
+        {
+            // large blocks compress better, and raw blocks are read whole
+            tableOptions.block_size = 64 * 1024;
+            break;
+        }
+    }
+
     std::shared_ptr<rocksdb::TableFactory> tfp(NewBlockBasedTableFactory(tableOptions));
     fOptions.table_factory = tfp;
 
-    return rocksdb::Options(dbOptions, fOptions);
+    return fOptions;
+}
+
+std::vector<rocksdb::ColumnFamilyDescriptor> RocksDBWrapper::getColumnFamilyDescriptors(const DataBaseConfig &config)
+{
+    std::vector<rocksdb::ColumnFamilyDescriptor> descriptors;
+
+    /* Holds the scheme version and other records without a prefix */
+    descriptors.emplace_back(
+        rocksdb::kDefaultColumnFamilyName, getColumnFamilyOptions(config, ColumnFamilyProfile::SEQUENTIAL, ""));
+
+    const std::vector<std::pair<std::string, ColumnFamilyProfile>> columnFamilies = {
+        {DB::BLOCK_INDEX_TO_KEY_IMAGE_PREFIX, ColumnFamilyProfile::SEQUENTIAL},
+        {DB::BLOCK_INDEX_TO_TX_HASHES_PREFIX, ColumnFamilyProfile::SEQUENTIAL},
+        {DB::BLOCK_INDEX_TO_TRANSACTION_INFO_PREFIX, ColumnFamilyProfile::SEQUENTIAL},
+        {DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, ColumnFamilyProfile::RAW_BLOCK},
+        {DB::BLOCK_HASH_TO_BLOCK_INDEX_PREFIX, ColumnFamilyProfile::POINT_LOOKUP},
+        {DB::BLOCK_INDEX_TO_BLOCK_INFO_PREFIX, ColumnFamilyProfile::SEQUENTIAL},
+        {DB::KEY_IMAGE_TO_BLOCK_INDEX_PREFIX, ColumnFamilyProfile::POINT_LOOKUP},
+        {DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, ColumnFamilyProfile::SEQUENTIAL},
+        {DB::TRANSACTION_HASH_TO_TRANSACTION_INFO_PREFIX, ColumnFamilyProfile::POINT_LOOKUP},
+        {DB::KEY_OUTPUT_AMOUNT_PREFIX, ColumnFamilyProfile::KEY_OUTPUT},
+        {DB::CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX, ColumnFamilyProfile::SEQUENTIAL},
+        {DB::PAYMENT_ID_TO_TX_HASH_PREFIX, ColumnFamilyProfile::POINT_LOOKUP},
+        {DB::TIMESTAMP_TO_BLOCKHASHES_PREFIX, ColumnFamilyProfile::SEQUENTIAL},
+        {DB::KEY_OUTPUT_AMOUNTS_COUNT_PREFIX, ColumnFamilyProfile::SEQUENTIAL},
+        {DB::KEY_OUTPUT_KEY_PREFIX, ColumnFamilyProfile::KEY_OUTPUT},
+        {DB::BLOCK_INDEX_TO_WALLET_BLOCK_INFO_PREFIX, ColumnFamilyProfile::SEQUENTIAL},
+    };
+
+    for (const auto &[prefix, profile] : columnFamilies)
+    {
+        descriptors.emplace_back(
+            COLUMN_FAMILY_NAME_PREFIX + prefix, getColumnFamilyOptions(config, profile, prefix));
+    }
+
+    descriptors.emplace_back(
+        KEY_OUTPUT_COUNT_COLUMN_FAMILY, getColumnFamilyOptions(config, ColumnFamilyProfile::POINT_LOOKUP, ""));
+
+    return descriptors;
+}
+
+void RocksDBWrapper::migrateToColumnFamilies()
+{
+    std::string layoutVersion;
+
+    if (db->Get(rocksdb::ReadOptions(), defaultColumnFamily, COLUMN_FAMILY_LAYOUT_KEY, &layoutVersion).ok())
+    {
+        return;
+    }
+
+    logger(INFO) << "Moving DB records into column families, this may take a while...";
+
+    /* Every write moves a record atomically, so if we're interrupted the
+       records left in the default column family get moved next time */
+    std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(rocksdb::ReadOptions(), defaultColumnFamily));
+
+    rocksdb::WriteBatch batch;
+
+    uint64_t movedRecords = 0;
+
+    for (it->SeekToFirst(); it->Valid(); it->Next())
+    {
+        rocksdb::ColumnFamilyHandle *columnFamily = getColumnFamily(it->key().ToString());
+
+        if (columnFamily == defaultColumnFamily)
+        {
+            continue;
+        }
+
+        batch.Put(columnFamily, it->key(), it->value());
+        batch.Delete(defaultColumnFamily, it->key());
+
+        movedRecords++;
+
+        if (batch.GetDataSize() >= MIGRATION_BATCH_SIZE)
+        {
+            rocksdb::Status status = db->Write(rocksdb::WriteOptions(), &batch);
+
+            if (!status.ok())
+            {
+                logger(ERROR) << "Failed to move DB records into column families: " << status.ToString();
+                throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+            }
+
+            batch.Clear();
+
+            logger(INFO) << "Moved " << movedRecords << " records";
+        }
+    }
+
+    if (!it->status().ok())
+    {
+        logger(ERROR) << "Failed to read DB records to move: " << it->status().ToString();
+        throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+    }
+
+    it.reset();
+
+    batch.Put(defaultColumnFamily, COLUMN_FAMILY_LAYOUT_KEY, COLUMN_FAMILY_LAYOUT_VERSION);
+
+    rocksdb::WriteOptions writeOptions;
+    writeOptions.sync = true;
+
+    rocksdb::Status status = db->Write(writeOptions, &batch);
+
+    if (!status.ok())
+    {
+        logger(ERROR) << "Failed to move DB records into column families: " << status.ToString();
+        throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR));
+    }
+
+    if (movedRecords != 0)
+    {
+        logger(INFO) << "Moved " << movedRecords << " records, compacting...";
+
+        /* Drop the tombstones the move left behind */
+        db->CompactRange(rocksdb::CompactRangeOptions(), defaultColumnFamily, nullptr, nullptr);
+    }
+}
+
+rocksdb::ColumnFamilyHandle *RocksDBWrapper::getColumnFamily(const std::string &rawKey) const
+{
+    const auto prefix = DB::getKeyPrefix(rawKey);
+
+    if (prefix == DB::KEY_OUTPUT_AMOUNT_PREFIX && DB::isKeyOutputCountKey(rawKey))
+    {
+        return keyOutputCountColumnFamily;
+    }
+
+    const auto it = columnFamiliesByPrefix.find(prefix);
+
+    if (it == columnFamiliesByPrefix.end())
+    {
+        return defaultColumnFamily;
+    }
+
+    return it->second;
+}
+
+void RocksDBWrapper::closeColumnFamilies()
+{
+    for (auto handle : columnFamilyHandles)
+    {
+        db->DestroyColumnFamilyHandle(handle);
+    }
+
+    columnFamilyHandles.clear();
+    columnFamiliesByPrefix.clear();
+    defaultColumnFamily = nullptr;
+    keyOutputCountColumnFamily = nullptr;
 }
 
 std::string RocksDBWrapper::getDataDir(const DataBaseConfig &config)
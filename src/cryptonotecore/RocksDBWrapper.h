@@ -12,6 +12,8 @@
 #include <logging/LoggerRef.h>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace CryptoNote
 {
@@ -43,10 +45,41 @@ namespace CryptoNote
         std::error_code readThreadSafe(IReadBatch &batch) override;
 
       private:
+        /* How a column family is tuned, based on how its records are read */
+        enum class ColumnFamilyProfile
+        {
+            /* Records read mostly in order of block index */
+            SEQUENTIAL,
+
+            /* Records looked up by hash - bloom filters pay off */
+            POINT_LOOKUP,
+
+            /* Records keyed by amount and global index */
+            KEY_OUTPUT,
+
+            /* Large, rarely read records */
+            RAW_BLOCK
+        };
+
         std::error_code write(IWriteBatch &batch, bool sync);
 
         rocksdb::Options getDBOptions(const DataBaseConfig &config);
 
+        rocksdb::ColumnFamilyOptions getColumnFamilyOptions(
+            const DataBaseConfig &config,
+            const ColumnFamilyProfile profile,
+            const std::string &keyPrefix);
+
+        std::vector<rocksdb::ColumnFamilyDescriptor> getColumnFamilyDescriptors(const DataBaseConfig &config);
+
+        /* Moves records out of the default column family, where every record
+           lived before the DB was split into column families */
+        void migrateToColumnFamilies();
+
+        rocksdb::ColumnFamilyHandle *getColumnFamily(const std::string &rawKey) const;
+
+        void closeColumnFamilies();
+
         std::string getDataDir(const DataBaseConfig &config);
 
         enum State
@@ -59,6 +92,19 @@ namespace CryptoNote
 
         std::unique_ptr<rocksdb::DB> db;
 
+        /* Shared by every column family */
+        std::shared_ptr<rocksdb::Cache> blockCache;
+
+        std::vector<rocksdb::ColumnFamilyHandle *> columnFamilyHandles;
+
+        rocksdb::ColumnFamilyHandle *defaultColumnFamily = nullptr;
+
+        /* Key prefix to the column family holding records with that prefix */
+        std::unordered_map<std::string, rocksdb::ColumnFamilyHandle *> columnFamiliesByPrefix;
+
+        /* The output count of each amount, split out of the amount's column family */
+        rocksdb::ColumnFamilyHandle *keyOutputCountColumnFamily = nullptr;
+
         std::atomic<State> state;
     };
 } // namespace CryptoNote
@@ -6,17 +6,27 @@
 #include "TransactionPool.h"
 
 #include "CryptoNoteBasicImpl.h"
+#include "common/CryptoNoteTools.h"
 #include "common/TransactionExtra.h"
 #include "common/int-util.h"
 
+#include <chrono>
+
 namespace CryptoNote
 {
+    namespace
+    {
+        /* Enough to cover a client polling every few seconds through a busy
+           pool. Clients further behind than this get a full diff instead. */
+        const size_t MAX_REMEMBERED_POOL_CHANGES = 16384;
+    } // namespace
+
     /* Is the left hand side preferred over the right hand side? */
     bool TransactionPool::TransactionPriorityComparator::
         operator()(const PendingTransactionInfo &lhs, const PendingTransactionInfo &rhs) const
     {
-        const CachedTransaction &left = lhs.cachedTransaction;
-        const CachedTransaction &right = rhs.cachedTransaction;
+        const CachedTransaction &left = *lhs.cachedTransaction;
+        const CachedTransaction &right = *rhs.cachedTransaction;
 
         /* We want to work out if fee per byte(lhs) is greater than fee per byte(rhs).
          * Fee per byte is calculated by (lhs.fee / lhs.size) > (rhs.fee / rhs.size).
@@ -110,7 +120,7 @@ namespace CryptoNote
 
     const Crypto::Hash &TransactionPool::PendingTransactionInfo::getTransactionHash() const
     {
-        return cachedTransaction.getTransactionHash();
+        return cachedTransaction->getTransactionHash();
     }
 
     size_t TransactionPool::PaymentIdHasher::operator()(const boost::optional<Crypto::Hash> &paymentId) const
@@ -127,16 +137,43 @@ namespace CryptoNote
         transactionHashIndex(transactions.get<TransactionHashTag>()),
         transactionCostIndex(transactions.get<TransactionCostTag>()),
         paymentIdIndex(transactions.get<PaymentIdTag>()),
+        /* Start from the time, rather than zero, so a sequence number a
+           client got before we restarted isn't mistaken for a current one */
+        m_sequence(std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count()),
         logger(logger, "TransactionPool")
     {
     }
 
+    void TransactionPool::recordChange(const Crypto::Hash &hash, const bool added)
+    {
+        m_sequence++;
+
+        m_changes.push_back({m_sequence, hash, added});
+
+        if (m_changes.size() > MAX_REMEMBERED_POOL_CHANGES)
+        {
+            m_changes.pop_front();
+        }
+    }
+
     bool TransactionPool::pushTransaction(CachedTransaction &&transaction, TransactionValidatorState &&transactionState)
     {
-        auto pendingTx = PendingTransactionInfo {static_cast<uint64_t>(time(nullptr)), std::move(transaction)};
+        auto cachedTransaction = std::make_shared<const CachedTransaction>(std::move(transaction));
+
+        /* Fill in the cached values now. The transaction is read without the
+           pool locked once it's in, and they're filled in on first use. */
+        cachedTransaction->getTransactionHash();
+        cachedTransaction->getTransactionPrefixHash();
+        cachedTransaction->getTransactionBinaryArray();
+        cachedTransaction->getTransactionFee();
+        cachedTransaction->getTransactionAmount();
+
+        auto pendingTx = PendingTransactionInfo {static_cast<uint64_t>(time(nullptr)), std::move(cachedTransaction)};
 
         Crypto::Hash paymentId;
-        if (getPaymentIdFromTxExtra(pendingTx.cachedTransaction.getTransaction().extra, paymentId))
+        if (getPaymentIdFromTxExtra(pendingTx.cachedTransaction->getTransaction().extra, paymentId))
         {
             pendingTx.paymentId = paymentId;
         }
@@ -159,7 +196,21 @@ namespace CryptoNote
 
         logger(Logging::DEBUGGING) << "pushed transaction " << pendingTx.getTransactionHash() << " to pool";
 
-        return transactionHashIndex.insert(std::move(pendingTx)).second;
+        const Crypto::Hash hash = pendingTx.getTransactionHash();
+
+        if (!transactionHashIndex.insert(std::move(pendingTx)).second)
+        {
+            return false;
+        }
+
+        recordChange(hash, true);
+
+        if (m_shortIdSalt)
+        {
+            m_shortIds.emplace(getShortTransactionId(*m_shortIdSalt, hash), hash);
+        }
+
+        return true;
     }
 
     const std::optional<CachedTransaction> TransactionPool::tryGetTransaction(const Crypto::Hash &hash) const
@@ -170,7 +221,7 @@ namespace CryptoNote
 
         if (it != transactionHashIndex.end())
         {
-            return it->cachedTransaction;
+            return *it->cachedTransaction;
         }
 
         return std::nullopt;
@@ -183,7 +234,7 @@ namespace CryptoNote
         auto it = transactionHashIndex.find(hash);
         assert(it != transactionHashIndex.end());
 
-        return it->cachedTransaction;
+        return *it->cachedTransaction;
     }
 
     bool TransactionPool::removeTransaction(const Crypto::Hash &hash)
@@ -197,9 +248,25 @@ namespace CryptoNote
             return false;
         }
 
-        excludeFromState(poolState, it->cachedTransaction);
+        excludeFromState(poolState, *it->cachedTransaction);
         transactionHashIndex.erase(it);
 
+        recordChange(hash, false);
+
+        if (m_shortIdSalt)
+        {
+            auto [begin, end] = m_shortIds.equal_range(getShortTransactionId(*m_shortIdSalt, hash));
+
+            for (auto shortId = begin; shortId != end; ++shortId)
+            {
+                if (shortId->second == hash)
+                {
+                    m_shortIds.erase(shortId);
+                    break;
+                }
+            }
+        }
+
         logger(Logging::DEBUGGING) << "transaction " << hash << " removed from pool";
         return true;
     }
@@ -212,7 +279,7 @@ namespace CryptoNote
 
         for (const auto &transaction : transactionCostIndex)
         {
-            size_t transactionFee = transaction.cachedTransaction.getTransactionFee();
+            size_t transactionFee = transaction.cachedTransaction->getTransactionFee();
 
             if (transactionFee == 0)
             {
@@ -264,36 +331,82 @@ namespace CryptoNote
 
         for (const auto &transactionItem : transactionCostIndex)
         {
-            result.emplace_back(transactionItem.cachedTransaction);
+            result.emplace_back(*transactionItem.cachedTransaction);
         }
 
         return result;
     }
 
-    std::tuple<std::vector<CachedTransaction>, std::vector<CachedTransaction>>
-        TransactionPool::getPoolTransactionsForBlockTemplate() const
+    BlockTemplateTransactions TransactionPool::selectTransactionsForBlockTemplate(
+        const size_t maxTotalSize,
+        const std::function<bool(const CachedTransaction &)> &isValid) const
     {
-        std::vector<CachedTransaction> regularTransactions;
+        struct Candidate
+        {
+            Crypto::Hash hash;
 
-        std::vector<CachedTransaction> fusionTransactions;
+            size_t size;
 
-        std::scoped_lock lock(m_transactionsMutex);
+            uint64_t fee;
+
+            std::shared_ptr<const CachedTransaction> transaction;
+        };
+
+        /* Validating can take a while, so we only note down the transactions
+           which could fit, in fee order, and check them without holding up
+           the pool. The transactions themselves aren't copied. */
+        std::vector<Candidate> candidates;
 
-        for (const auto &transaction : transactionCostIndex)
         {
-            uint64_t transactionFee = transaction.cachedTransaction.getTransactionFee();
+            std::scoped_lock lock(m_transactionsMutex);
 
-            if (transactionFee != 0)
+            candidates.reserve(transactionCostIndex.size());
+
+            for (const auto &transaction : transactionCostIndex)
             {
-                regularTransactions.emplace_back(transaction.cachedTransaction);
+                const CachedTransaction &cachedTransaction = *transaction.cachedTransaction;
+
+                const size_t size = cachedTransaction.getTransactionBinaryArray().size();
+
+                if (size <= maxTotalSize)
+                {
+                    candidates.push_back({cachedTransaction.getTransactionHash(),
+                                          size,
+                                          cachedTransaction.getTransactionFee(),
+                                          transaction.cachedTransaction});
+                }
             }
-            else
+        }
+
+        BlockTemplateTransactions result;
+
+        /* Transactions sharing a key image can't both get into the pool, so
+           there is no need to check the ones we pick against each other */
+        for (const auto &candidate : candidates)
+        {
+            /* Won't fit, but a smaller one further on might */
+            if (result.transactionsSize + candidate.size > maxTotalSize)
             {
-                fusionTransactions.emplace_back(transaction.cachedTransaction);
+                continue;
+            }
+
+            if (!isValid(*candidate.transaction))
+            {
+                result.invalidTransactions.push_back(candidate.hash);
+                continue;
+            }
+
+            result.transactionHashes.push_back(candidate.hash);
+            result.transactionsSize += candidate.size;
+            result.fee += candidate.fee;
+
+            if (result.transactionsSize == maxTotalSize)
+            {
+                break;
             }
         }
 
-        return {regularTransactions, fusionTransactions};
+        return result;
     }
 
     uint64_t TransactionPool::getTransactionReceiveTime(const Crypto::Hash &hash) const
@@ -323,6 +436,108 @@ namespace CryptoNote
         return transactionHashes;
     }
 
+    std::vector<std::optional<Crypto::Hash>> TransactionPool::getTransactionHashesByShortId(
+        const Crypto::Hash &salt,
+        const std::vector<uint64_t> &shortIds) const
+    {
+        std::scoped_lock lock(m_transactionsMutex);
+
+        /* Blocks are almost always built on the same parent as the last one
+           we were sent, so this is once per block at most */
+        if (m_shortIdSalt != salt)
+        {
+            m_shortIds.clear();
+            m_shortIds.reserve(transactionHashIndex.size());
+
+            for (const auto &transaction : transactionHashIndex)
+            {
+                const auto &hash = transaction.getTransactionHash();
+                m_shortIds.emplace(getShortTransactionId(salt, hash), hash);
+            }
+
+            m_shortIdSalt = salt;
+        }
+
+        std::vector<std::optional<Crypto::Hash>> transactionHashes;
+        transactionHashes.reserve(shortIds.size());
+
+        for (const auto shortId : shortIds)
+        {
+            auto [begin, end] = m_shortIds.equal_range(shortId);
+
+            if (begin != end && std::next(begin) == end)
+            {
+                transactionHashes.push_back(begin->second);
+            }
+            else
+            {
+                transactionHashes.push_back(std::nullopt);
+            }
+        }
+
+        return transactionHashes;
+    }
+
+    bool TransactionPool::getTransactionChanges(
+        const uint64_t sinceSequence,
+        std::vector<Crypto::Hash> &addedTransactions,
+        std::vector<Crypto::Hash> &deletedTransactions,
+        uint64_t &currentSequence) const
+    {
+        std::scoped_lock lock(m_transactionsMutex);
+
+        currentSequence = m_sequence;
+
+        const bool remembered = sinceSequence <= m_sequence
+                                && (sinceSequence == m_sequence
+                                    || (!m_changes.empty() && m_changes.front().sequence <= sinceSequence + 1));
+
+        if (!remembered)
+        {
+            for (const auto &transaction : transactionHashIndex)
+            {
+                addedTransactions.push_back(transaction.getTransactionHash());
+            }
+
+            return false;
+        }
+
+        /* Whether each transaction was in the pool before the first change
+           we're looking at, and whether it is now. A transaction which was
+           added and then removed again (or vice versa) is no change at all. */
+        std::unordered_map<Crypto::Hash, std::pair<bool, bool>> changes;
+
+        const size_t firstChange = m_changes.empty() ? 0 : sinceSequence + 1 - m_changes.front().sequence;
+
+        for (size_t i = firstChange; i < m_changes.size(); i++)
+        {
+            const auto &change = m_changes[i];
+
+            const auto [it, inserted] = changes.try_emplace(change.hash, !change.added, change.added);
+
+            if (!inserted)
+            {
+                it->second.second = change.added;
+            }
+        }
+
+        for (const auto &[hash, states] : changes)
+        {
+            const auto [wasInPool, isInPool] = states;
+
+            if (!wasInPool && isInPool)
+            {
+                addedTransactions.push_back(hash);
+            }
+            else if (wasInPool && !isInPool)
+            {
+                deletedTransactions.push_back(hash);
+            }
+        }
+
+        return true;
+    }
+
     void TransactionPool::flush()
     {
         const auto txns = getTransactionHashes();
@@ -17,6 +17,8 @@
 #include <boost/multi_index_container.hpp>
 #include <logging/LoggerMessage.h>
 #include <logging/LoggerRef.h>
+#include <deque>
+#include <memory>
 #include <unordered_map>
 
 namespace CryptoNote
@@ -41,19 +43,30 @@ namespace CryptoNote
 
         virtual std::vector<Crypto::Hash> getTransactionHashes() const override;
 
+        virtual bool getTransactionChanges(
+            const uint64_t sinceSequence,
+            std::vector<Crypto::Hash> &addedTransactions,
+            std::vector<Crypto::Hash> &deletedTransactions,
+            uint64_t &currentSequence) const override;
+
         virtual bool checkIfTransactionPresent(const Crypto::Hash &hash) const override;
 
         virtual const TransactionValidatorState &getPoolTransactionValidationState() const override;
 
         virtual std::vector<CachedTransaction> getPoolTransactions() const override;
 
-        virtual std::tuple<std::vector<CachedTransaction>, std::vector<CachedTransaction>>
-            getPoolTransactionsForBlockTemplate() const override;
+        virtual BlockTemplateTransactions selectTransactionsForBlockTemplate(
+            const size_t maxTotalSize,
+            const std::function<bool(const CachedTransaction &)> &isValid) const override;
 
         virtual uint64_t getTransactionReceiveTime(const Crypto::Hash &hash) const override;
 
         virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash &paymentId) const override;
 
+        virtual std::vector<std::optional<Crypto::Hash>> getTransactionHashesByShortId(
+            const Crypto::Hash &salt,
+            const std::vector<uint64_t> &shortIds) const override;
+
         virtual void flush() override;
 
       private:
@@ -63,7 +76,9 @@ namespace CryptoNote
         {
             uint64_t receiveTime;
 
-            CachedTransaction cachedTransaction;
+            /* Shared, so block template selection can hold on to it after
+               letting go of the pool lock, without copying it */
+            std::shared_ptr<const CachedTransaction> cachedTransaction;
 
             boost::optional<Crypto::Hash> paymentId;
 
@@ -124,6 +139,30 @@ namespace CryptoNote
 
         TransactionsContainer::index<PaymentIdTag>::type &paymentIdIndex;
 
+        struct PoolChange
+        {
+            uint64_t sequence;
+
+            Crypto::Hash hash;
+
+            bool added;
+        };
+
+        void recordChange(const Crypto::Hash &hash, const bool added);
+
+        /* The sequence number of the latest change */
+        uint64_t m_sequence;
+
+        /* The most recent changes, oldest first, with consecutive sequence
+           numbers */
+        std::deque<PoolChange> m_changes;
+
+        /* The salt m_shortIds was built with, once they have been asked for */
+        mutable std::optional<Crypto::Hash> m_shortIdSalt;
+
+        /* Short id to transaction hash, for every transaction in the pool */
+        mutable std::unordered_multimap<uint64_t, Crypto::Hash> m_shortIds;
+
         mutable std::mutex m_transactionsMutex;
 
         Logging::LoggerRef logger;
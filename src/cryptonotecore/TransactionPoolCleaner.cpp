@@ -67,6 +67,16 @@ namespace CryptoNote
         return transactionPool->getTransactionHashes();
     }
 
+    bool TransactionPoolCleanWrapper::getTransactionChanges(
+        const uint64_t sinceSequence,
+        std::vector<Crypto::Hash> &addedTransactions,
+        std::vector<Crypto::Hash> &deletedTransactions,
+        uint64_t &currentSequence) const
+    {
+        return transactionPool->getTransactionChanges(
+            sinceSequence, addedTransactions, deletedTransactions, currentSequence);
+    }
+
     bool TransactionPoolCleanWrapper::checkIfTransactionPresent(const Crypto::Hash &hash) const
     {
         return transactionPool->checkIfTransactionPresent(hash);
@@ -82,10 +92,11 @@ namespace CryptoNote
         return transactionPool->getPoolTransactions();
     }
 
-    std::tuple<std::vector<CachedTransaction>, std::vector<CachedTransaction>>
-        TransactionPoolCleanWrapper::getPoolTransactionsForBlockTemplate() const
+    BlockTemplateTransactions TransactionPoolCleanWrapper::selectTransactionsForBlockTemplate(
+        const size_t maxTotalSize,
+        const std::function<bool(const CachedTransaction &)> &isValid) const
     {
-        return transactionPool->getPoolTransactionsForBlockTemplate();
+        return transactionPool->selectTransactionsForBlockTemplate(maxTotalSize, isValid);
     }
 
     uint64_t TransactionPoolCleanWrapper::getTransactionReceiveTime(const Crypto::Hash &hash) const
@@ -99,6 +110,13 @@ namespace CryptoNote
         return transactionPool->getTransactionHashesByPaymentId(paymentId);
     }
 
+    std::vector<std::optional<Crypto::Hash>> TransactionPoolCleanWrapper::getTransactionHashesByShortId(
+        const Crypto::Hash &salt,
+        const std::vector<uint64_t> &shortIds) const
+    {
+        return transactionPool->getTransactionHashesByShortId(salt, shortIds);
+    }
+
     void TransactionPoolCleanWrapper::flush()
     {
         return transactionPool->flush();
@@ -51,19 +51,30 @@ namespace CryptoNote
 
         virtual std::vector<Crypto::Hash> getTransactionHashes() const override;
 
+        virtual bool getTransactionChanges(
+            const uint64_t sinceSequence,
+            std::vector<Crypto::Hash> &addedTransactions,
+            std::vector<Crypto::Hash> &deletedTransactions,
+            uint64_t &currentSequence) const override;
+
         virtual bool checkIfTransactionPresent(const Crypto::Hash &hash) const override;
 
         virtual const TransactionValidatorState &getPoolTransactionValidationState() const override;
 
         virtual std::vector<CachedTransaction> getPoolTransactions() const override;
 
-        virtual std::tuple<std::vector<CachedTransaction>, std::vector<CachedTransaction>>
-            getPoolTransactionsForBlockTemplate() const override;
+        virtual BlockTemplateTransactions selectTransactionsForBlockTemplate(
+            const size_t maxTotalSize,
+            const std::function<bool(const CachedTransaction &)> &isValid) const override;
 
         virtual uint64_t getTransactionReceiveTime(const Crypto::Hash &hash) const override;
 
         virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash &paymentId) const override;
 
+        virtual std::vector<std::optional<Crypto::Hash>> getTransactionHashesByShortId(
+            const Crypto::Hash &salt,
+            const std::vector<uint64_t> &shortIds) const override;
+
         virtual void flush() override;
 
         virtual std::vector<Crypto::Hash> clean(const uint32_t height) override;
@@ -17,7 +17,7 @@ ValidateTransaction::ValidateTransaction(
     CryptoNote::IBlockchainCache *cache,
     const CryptoNote::Currency &currency,
     const CryptoNote::Checkpoints &checkpoints,
-    Utilities::ThreadPool<bool> &threadPool,
+    Utilities::ThreadPool &threadPool,
     const uint64_t blockHeight,
     const uint64_t blockSizeMedian,
     const bool isPoolTransaction) :
@@ -36,55 +36,40 @@ ValidateTransaction::ValidateTransaction(
 
 TransactionValidationResult ValidateTransaction::validate()
 {
-    /* Validate transaction isn't too big */
-    if (!validateTransactionSize())
-    {
-        return m_validationResult;
-    }
-
-    /* Validate the transaction inputs are non empty, key images are valid, etc. */
-    if (!validateTransactionInputs())
-    {
-        return m_validationResult;
-    }
-
-    /* Validate transaction outputs are non zero, don't overflow, etc */
-    if (!validateTransactionOutputs())
+    if (!validateTransactionInexpensive())
     {
         return m_validationResult;
     }
 
-    /* Verify inputs > outputs, fee is > min fee unless fusion, etc */
-    if (!validateTransactionFee())
+    /* Verify key images are not spent, ring signatures are valid, etc. We
+     * do this separately from the transaction input verification, because
+     * these checks are much slower to perform, so we want to fail fast on the
+     * cheaper checks first. */
+    if (!validateTransactionInputsExpensive())
     {
         return m_validationResult;
     }
 
-    /* Validate the transaction extra is a reasonable size. */
-    if (!validateTransactionExtra())
-    {
-        return m_validationResult;
-    }
+    m_validationResult.valid = true;
+    setTransactionValidationResult(
+        CryptoNote::error::TransactionValidationError::VALIDATION_SUCCESS
+    );
 
-    /* Validate transaction input / output ratio is not excessive */
-    if (!validateInputOutputRatio())
-    {
-        return m_validationResult;
-    }
+    return m_validationResult;
+}
 
-    /* Validate transaction mixin is in the valid range */
-    if (!validateTransactionMixin())
+TransactionValidationResult ValidateTransaction::validate(RingSignatureBatch &batch)
+{
+    if (!validateTransactionInexpensive())
     {
         return m_validationResult;
     }
 
-    /* Verify key images are not spent, ring signatures are valid, etc. We
-     * do this separately from the transaction input verification, because
-     * these checks are much slower to perform, so we want to fail fast on the
-     * cheaper checks first. */
-    if (!validateTransactionInputsExpensive())
+    /* Transactions in a checkpoints range don't need the expensive checks,
+     * see validateTransactionInputsExpensive() */
+    if (!m_checkpoints.isInCheckpointZone(m_blockHeight + 1))
     {
-        return m_validationResult;
+        batch.addTransaction(m_cachedTransaction);
     }
 
     m_validationResult.valid = true;
@@ -125,6 +110,54 @@ TransactionValidationResult ValidateTransaction::revalidateAfterHeightChange()
 }
 
 
+/* Every check apart from the expensive input checks */
+bool ValidateTransaction::validateTransactionInexpensive()
+{
+    /* Validate transaction isn't too big */
+    if (!validateTransactionSize())
+    {
+        return false;
+    }
+
+    /* Validate the transaction inputs are non empty, key images are valid, etc. */
+    if (!validateTransactionInputs())
+    {
+        return false;
+    }
+
+    /* Validate transaction outputs are non zero, don't overflow, etc */
+    if (!validateTransactionOutputs())
+    {
+        return false;
+    }
+
+    /* Verify inputs > outputs, fee is > min fee unless fusion, etc */
+    if (!validateTransactionFee())
+    {
+        return false;
+    }
+
+    /* Validate the transaction extra is a reasonable size. */
+    if (!validateTransactionExtra())
+    {
+        return false;
+    }
+
+    /* Validate transaction input / output ratio is not excessive */
+    if (!validateInputOutputRatio())
+    {
+        return false;
+    }
+
+    /* Validate transaction mixin is in the valid range */
+    if (!validateTransactionMixin())
+    {
+        return false;
+    }
+
+    return true;
+}
+
 bool ValidateTransaction::validateTransactionSize()
 {
     const auto maxTransactionSize = m_blockSizeMedian * 2 - m_currency.minerTxBlobReservedSize();
@@ -489,108 +522,18 @@ bool ValidateTransaction::validateTransactionInputsExpensive()
         return true;
     }
 
-    uint64_t inputIndex = 0;
+    RingSignatureBatch batch(m_blockchainCache, m_threadPool, m_blockHeight, m_isPoolTransaction);
 
-    std::vector<std::future<bool>> validationResult;
-    std::atomic<bool> cancelValidation = false;
-    const Crypto::Hash prefixHash = m_cachedTransaction.getTransactionPrefixHash();
+    batch.addTransaction(m_cachedTransaction);
 
-    for (const auto &input : m_transaction.inputs)
+    if (const auto failure = batch.verify())
     {
-        /* Validate each input on a separate thread in our thread pool */
-        validationResult.push_back(m_threadPool.addJob([inputIndex, &input, &prefixHash, &cancelValidation, this] {
-            const CryptoNote::KeyInput &in = boost::get<CryptoNote::KeyInput>(input);
-            if (cancelValidation)
-            {
-                return false; // fail the validation immediately if cancel requested
-            }
-            if (m_blockchainCache->checkIfSpent(in.keyImage, m_blockHeight))
-            {
-                setTransactionValidationResult(
-                    CryptoNote::error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT,
-                    "Transaction contains key image that has already been spent"
-                );
-
-                return false;
-            }
+        setTransactionValidationResult(failure->errorCode, failure->errorMessage);
 
-            std::vector<Crypto::PublicKey> outputKeys;
-            std::vector<uint32_t> globalIndexes(in.outputIndexes.size());
-
-            globalIndexes[0] = in.outputIndexes[0];
-
-            /* Convert output indexes from relative to absolute */
-            for (size_t i = 1; i < in.outputIndexes.size(); ++i)
-            {
-                globalIndexes[i] = globalIndexes[i - 1] + in.outputIndexes[i];
-            }
-
-            const auto result = m_blockchainCache->extractKeyOutputKeys(
-                in.amount, m_blockHeight, {globalIndexes.data(), globalIndexes.size()}, outputKeys);
-
-            if (result == CryptoNote::ExtractOutputKeysResult::INVALID_GLOBAL_INDEX)
-            {
-                setTransactionValidationResult(
-                    CryptoNote::error::TransactionValidationError::INPUT_INVALID_GLOBAL_INDEX,
-                    "Transaction contains invalid global indexes"
-                );
-
-                return false;
-            }
-
-            if (result == CryptoNote::ExtractOutputKeysResult::OUTPUT_LOCKED)
-            {
-                setTransactionValidationResult(
-                    CryptoNote::error::TransactionValidationError::INPUT_SPEND_LOCKED_OUT,
-                    "Transaction includes an input which is still locked"
-                );
-
-                return false;
-            }
-
-            if (m_isPoolTransaction
-                || m_blockHeight >= CryptoNote::parameters::TRANSACTION_SIGNATURE_COUNT_VALIDATION_HEIGHT)
-            {
-                if (outputKeys.size() != m_transaction.signatures[inputIndex].size())
-                {
-                    setTransactionValidationResult(
-                        CryptoNote::error::TransactionValidationError::INPUT_INVALID_SIGNATURES_COUNT,
-                        "Transaction has an invalid number of signatures"
-                    );
-
-                    return false;
-                }
-            }
-
-            if (!Crypto::crypto_ops::checkRingSignature(
-                    prefixHash, in.keyImage, outputKeys, m_transaction.signatures[inputIndex]))
-            {
-                setTransactionValidationResult(
-                    CryptoNote::error::TransactionValidationError::INPUT_INVALID_SIGNATURES,
-                    "Transaction contains invalid signatures"
-                );
-
-                return false;
-            }
-
-            return true;
-        }));
-
-        inputIndex++;
-    }
-
-    bool valid = true;
-
-    for (auto &result : validationResult)
-    {
-        if (!result.get())
-        {
-            valid = false;
-            cancelValidation = true;
-        }
+        return false;
     }
 
-    return valid;
+    return true;
 }
 
 
@@ -14,6 +14,7 @@
 #include <cryptonotecore/Checkpoints.h>
 #include <cryptonotecore/Currency.h>
 #include <cryptonotecore/IBlockchainCache.h>
+#include <cryptonotecore/RingSignatureBatch.h>
 #include <utilities/ThreadPool.h>
 
 struct TransactionValidationResult
@@ -46,7 +47,7 @@ class ValidateTransaction
             CryptoNote::IBlockchainCache *cache,
             const CryptoNote::Currency &currency,
             const CryptoNote::Checkpoints &checkpoints,
-            Utilities::ThreadPool<bool> &threadPool,
+            Utilities::ThreadPool &threadPool,
             const uint64_t blockHeight,
             const uint64_t blockSizeMedian,
             const bool isPoolTransaction);
@@ -56,12 +57,20 @@ class ValidateTransaction
         /////////////////////////////
         TransactionValidationResult validate();
 
+        /* Performs every check except the expensive input checks, which are
+         * queued onto the batch instead, so the rings of many transactions
+         * can be verified together. The transaction is only valid once
+         * batch.verify() has succeeded. */
+        TransactionValidationResult validate(RingSignatureBatch &batch);
+
         TransactionValidationResult revalidateAfterHeightChange();
 
     private:
         //////////////////////////////
         /* PRIVATE MEMBER FUNCTIONS */
         //////////////////////////////
+        bool validateTransactionInexpensive();
+
         bool validateTransactionSize();
 
         bool validateTransactionInputs();
@@ -106,7 +115,7 @@ class ValidateTransaction
         uint64_t m_sumOfOutputs = 0;
         uint64_t m_sumOfInputs = 0;
 
-        Utilities::ThreadPool<bool> &m_threadPool;
+        Utilities::ThreadPool &m_threadPool;
 
         std::mutex m_mutex;
 };
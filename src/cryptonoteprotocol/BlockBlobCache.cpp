@@ -0,0 +1,66 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "BlockBlobCache.h"
+
+namespace CryptoNote
+{
+    BlockBlobCache::BlockBlobCache(const size_t maxSize): m_maxSize(maxSize) {}
+
+    std::shared_ptr<const BinaryArray> BlockBlobCache::get(const Crypto::Hash &hash)
+    {
+        const auto it = m_index.find(hash);
+
+        if (it == m_index.end())
+        {
+            return nullptr;
+        }
+
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+
+        return it->second->blob;
+    }
+
+    std::shared_ptr<const BinaryArray> BlockBlobCache::insert(const Crypto::Hash &hash, BinaryArray &&blob)
+    {
+        auto shared = std::make_shared<const BinaryArray>(std::move(blob));
+
+        /* Larger than the whole cache, nothing worth dropping for it */
+        if (shared->size() > m_maxSize)
+        {
+            return shared;
+        }
+
+        const auto existing = m_index.find(hash);
+
+        if (existing != m_index.end())
+        {
+            m_size -= existing->second->blob->size();
+            m_entries.erase(existing->second);
+            m_index.erase(existing);
+        }
+
+        m_entries.push_front(Entry {hash, shared});
+        m_index.emplace(hash, m_entries.begin());
+        m_size += shared->size();
+
+        while (m_size > m_maxSize)
+        {
+            const auto &oldest = m_entries.back();
+
+            m_size -= oldest.blob->size();
+            m_index.erase(oldest.hash);
+            m_entries.pop_back();
+        }
+
+        return shared;
+    }
+
+    void BlockBlobCache::clear()
+    {
+        m_entries.clear();
+        m_index.clear();
+        m_size = 0;
+    }
+} // namespace CryptoNote
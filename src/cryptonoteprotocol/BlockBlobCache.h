@@ -0,0 +1,49 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <CryptoNote.h>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace CryptoNote
+{
+    /* Blocks as they are sent to peers syncing from us, already serialized
+       into the block_complete_entry of a NOTIFY_RESPONSE_GET_OBJECTS, so they
+       can be copied straight into the response.
+
+       Holds up to maxSize bytes, dropping the least recently sent blocks
+       first. Only used from the dispatcher thread. */
+    class BlockBlobCache
+    {
+      public:
+        explicit BlockBlobCache(const size_t maxSize);
+
+        /* The serialized block, if it is cached */
+        std::shared_ptr<const BinaryArray> get(const Crypto::Hash &hash);
+
+        std::shared_ptr<const BinaryArray> insert(const Crypto::Hash &hash, BinaryArray &&blob);
+
+        void clear();
+
+      private:
+        struct Entry
+        {
+            Crypto::Hash hash;
+
+            std::shared_ptr<const BinaryArray> blob;
+        };
+
+        /* Most recently used first */
+        std::list<Entry> m_entries;
+
+        std::unordered_map<Crypto::Hash, std::list<Entry>::iterator> m_index;
+
+        size_t m_size = 0;
+
+        const size_t m_maxSize;
+    };
+} // namespace CryptoNote
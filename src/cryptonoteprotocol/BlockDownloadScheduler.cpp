@@ -0,0 +1,390 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "BlockDownloadScheduler.h"
+
+#include <algorithm>
+#include <config/CryptoNoteConfig.h>
+
+namespace CryptoNote
+{
+    void BlockDownloadScheduler::addPeerChain(
+        const PeerId &peerId,
+        const std::string &address,
+        const uint32_t startIndex,
+        const std::vector<Crypto::Hash> &hashes)
+    {
+        std::scoped_lock lock(m_mutex);
+
+        auto &peer = m_peers[peerId];
+
+        peer.address = address;
+        peer.chainStartIndex = startIndex;
+        peer.chain = hashes;
+
+        if (hashes.empty())
+        {
+            return;
+        }
+
+        size_t offset;
+
+        /* Continues the blocks already queued */
+        if (m_endIndex > startIndex && m_endIndex <= startIndex + hashes.size() && !m_windows.empty()
+            && hashes[m_endIndex - startIndex - 1] == m_windows.rbegin()->second.hashes.back())
+        {
+            offset = m_endIndex - startIndex;
+        }
+        else if (m_windows.empty())
+        {
+            offset = 0;
+            m_endIndex = startIndex;
+        }
+        /* A different chain to the one being downloaded. The peer can still
+           help with the windows it agrees with, if any. */
+        else
+        {
+            return;
+        }
+
+        while (offset < hashes.size())
+        {
+            const size_t count = std::min<size_t>(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT, hashes.size() - offset);
+
+            WindowState window;
+
+            window.hashes.assign(hashes.begin() + offset, hashes.begin() + offset + count);
+
+            m_windows.emplace(m_endIndex, std::move(window));
+
+            m_endIndex += static_cast<uint32_t>(count);
+            offset += count;
+        }
+    }
+
+    std::optional<BlockDownloadScheduler::Window>
+        BlockDownloadScheduler::assignWindow(const PeerId &peerId, const Clock::time_point now)
+    {
+        std::scoped_lock lock(m_mutex);
+
+        const auto peerIt = m_peers.find(peerId);
+
+        if (peerIt == m_peers.end() || peerIt->second.window)
+        {
+            return std::nullopt;
+        }
+
+        auto &peer = peerIt->second;
+
+        size_t windowsChecked = 0;
+
+        /* Only the first windows, so the blocks waiting to be added are
+           bounded, however far ahead the fastest peer gets */
+        for (auto it = m_windows.begin(); it != m_windows.end() && windowsChecked < BLOCKS_SYNCHRONIZING_MAX_WINDOWS;
+             ++it, ++windowsChecked)
+        {
+            auto &[startIndex, window] = *it;
+
+            if (window.peerId || window.downloaded || !canServe(peer, startIndex, window))
+            {
+                continue;
+            }
+
+            window.peerId = peerId;
+            window.requestedAt = now;
+
+            peer.window = startIndex;
+            peer.requestedAt = now;
+            peer.windowsRequested++;
+
+            return Window {startIndex, window.hashes};
+        }
+
+        return std::nullopt;
+    }
+
+    bool BlockDownloadScheduler::addBlocks(
+        const PeerId &peerId,
+        std::vector<RawBlock> &&rawBlocks,
+        std::vector<BlockTemplate> &&blockTemplates,
+        const std::vector<Crypto::Hash> &blockHashes,
+        const uint64_t bytes,
+        const Clock::time_point now)
+    {
+        std::scoped_lock lock(m_mutex);
+
+        const auto peerIt = m_peers.find(peerId);
+
+        if (peerIt == m_peers.end() || !peerIt->second.window)
+        {
+            return true;
+        }
+
+        auto &peer = peerIt->second;
+
+        const uint32_t startIndex = *peer.window;
+
+        peer.window = std::nullopt;
+        peer.stalled = false;
+        peer.blocksReceived += rawBlocks.size();
+        peer.bytesReceived += bytes;
+        peer.windowsReceived++;
+        peer.downloadTime += now - peer.requestedAt;
+
+        const auto windowIt = m_windows.find(startIndex);
+
+        /* Already sent by another peer, or dropped with the rest */
+        if (windowIt == m_windows.end() || windowIt->second.downloaded)
+        {
+            return true;
+        }
+
+        auto &window = windowIt->second;
+
+        if (window.peerId == peerId)
+        {
+            window.peerId = std::nullopt;
+        }
+
+        if (rawBlocks.size() != window.hashes.size() || blockTemplates.size() != window.hashes.size()
+            || blockHashes.size() != window.hashes.size())
+        {
+            return false;
+        }
+
+        std::unordered_map<Crypto::Hash, size_t> positions;
+
+        for (size_t i = 0; i < window.hashes.size(); i++)
+        {
+            positions.emplace(window.hashes[i], i);
+        }
+
+        DownloadedWindow downloaded {peerId, {}, {}};
+
+        downloaded.rawBlocks.resize(rawBlocks.size());
+        downloaded.blockTemplates.resize(blockTemplates.size());
+
+        std::vector<bool> filled(blockHashes.size(), false);
+
+        /* Peers send the blocks in the order asked for, but nothing says
+           they have to */
+        for (size_t i = 0; i < blockHashes.size(); i++)
+        {
+            const auto position = positions.find(blockHashes[i]);
+
+            if (position == positions.end() || filled[position->second])
+            {
+                return false;
+            }
+
+            filled[position->second] = true;
+
+            downloaded.rawBlocks[position->second] = std::move(rawBlocks[i]);
+            downloaded.blockTemplates[position->second] = std::move(blockTemplates[i]);
+        }
+
+        window.downloaded = std::move(downloaded);
+
+        return true;
+    }
+
+    std::optional<BlockDownloadScheduler::DownloadedWindow> BlockDownloadScheduler::takeNextWindow()
+    {
+        std::scoped_lock lock(m_mutex);
+
+        if (m_windows.empty() || !m_windows.begin()->second.downloaded)
+        {
+            return std::nullopt;
+        }
+
+        auto downloaded = std::move(m_windows.begin()->second.downloaded);
+
+        m_windows.erase(m_windows.begin());
+
+        return downloaded;
+    }
+
+    bool BlockDownloadScheduler::releaseStalledWindows(const Clock::time_point now)
+    {
+        std::scoped_lock lock(m_mutex);
+
+        bool released = false;
+
+        for (auto &[startIndex, window] : m_windows)
+        {
+            if (!window.peerId || now - window.requestedAt < std::chrono::seconds(BLOCKS_SYNCHRONIZING_STALL_TIMEOUT))
+            {
+                continue;
+            }
+
+            const auto peerIt = m_peers.find(*window.peerId);
+
+            if (peerIt != m_peers.end())
+            {
+                peerIt->second.stalled = true;
+                peerIt->second.windowsStalled++;
+            }
+
+            window.peerId = std::nullopt;
+            released = true;
+        }
+
+        dropUnservableWindows();
+
+        return released;
+    }
+
+    void BlockDownloadScheduler::removePeer(const PeerId &peerId)
+    {
+        std::scoped_lock lock(m_mutex);
+
+        m_peers.erase(peerId);
+
+        for (auto &[startIndex, window] : m_windows)
+        {
+            if (window.peerId == peerId)
+            {
+                window.peerId = std::nullopt;
+            }
+        }
+
+        dropUnservableWindows();
+    }
+
+    void BlockDownloadScheduler::clear()
+    {
+        std::scoped_lock lock(m_mutex);
+
+        /* Peers keep the window they were asked for, so they aren't asked for
+           another until they answer, and the answer can be told apart */
+        m_windows.clear();
+        m_endIndex = 0;
+    }
+
+    bool BlockDownloadScheduler::empty() const
+    {
+        std::scoped_lock lock(m_mutex);
+
+        return m_windows.empty();
+    }
+
+    bool BlockDownloadScheduler::hasWork(const PeerId &peerId) const
+    {
+        std::scoped_lock lock(m_mutex);
+
+        const auto peerIt = m_peers.find(peerId);
+
+        if (peerIt == m_peers.end())
+        {
+            return false;
+        }
+
+        return peerIt->second.window || hasWindowFor(peerIt->second);
+    }
+
+    std::optional<Crypto::Hash> BlockDownloadScheduler::lastPeerHash(const PeerId &peerId) const
+    {
+        std::scoped_lock lock(m_mutex);
+
+        const auto peerIt = m_peers.find(peerId);
+
+        if (peerIt == m_peers.end() || peerIt->second.chain.empty())
+        {
+            return std::nullopt;
+        }
+
+        return peerIt->second.chain.back();
+    }
+
+    std::vector<PeerDownloadStatistics> BlockDownloadScheduler::getPeerStatistics() const
+    {
+        std::scoped_lock lock(m_mutex);
+
+        std::vector<PeerDownloadStatistics> statistics;
+
+        for (const auto &[peerId, peer] : m_peers)
+        {
+            const uint64_t milliseconds =
+                std::chrono::duration_cast<std::chrono::milliseconds>(peer.downloadTime).count();
+
+            PeerDownloadStatistics peerStatistics;
+
+            peerStatistics.address = peer.address;
+            peerStatistics.blocksReceived = peer.blocksReceived;
+            peerStatistics.bytesReceived = peer.bytesReceived;
+            peerStatistics.bytesPerSecond = milliseconds == 0 ? 0 : peer.bytesReceived * 1000 / milliseconds;
+            peerStatistics.averageResponseTime = peer.windowsReceived == 0 ? 0 : milliseconds / peer.windowsReceived;
+            peerStatistics.windowsRequested = peer.windowsRequested;
+            peerStatistics.windowsStalled = peer.windowsStalled;
+            peerStatistics.downloading = peer.window.has_value();
+            peerStatistics.stalled = peer.stalled;
+
+            statistics.push_back(peerStatistics);
+        }
+
+        return statistics;
+    }
+
+    bool BlockDownloadScheduler::canServe(const PeerState &peer, const uint32_t startIndex, const WindowState &window)
+        const
+    {
+        const uint64_t endIndex = startIndex + window.hashes.size();
+
+        /* The hash of each block commits to the one before it, so agreeing on
+           the last block of the window is agreeing on all of them */
+        return startIndex >= peer.chainStartIndex && endIndex <= peer.chainStartIndex + peer.chain.size()
+               && peer.chain[endIndex - peer.chainStartIndex - 1] == window.hashes.back();
+    }
+
+    bool BlockDownloadScheduler::hasWindowFor(const PeerState &peer) const
+    {
+        size_t windowsChecked = 0;
+
+        /* The same windows assignWindow() would look at */
+        for (auto it = m_windows.begin(); it != m_windows.end() && windowsChecked < BLOCKS_SYNCHRONIZING_MAX_WINDOWS;
+             ++it, ++windowsChecked)
+        {
+            const auto &[startIndex, window] = *it;
+
+            if (!window.peerId && !window.downloaded && canServe(peer, startIndex, window))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void BlockDownloadScheduler::dropUnservableWindows()
+    {
+        const auto next = std::find_if(
+            m_windows.begin(), m_windows.end(), [](const auto &window) { return !window.second.downloaded; });
+
+        if (next == m_windows.end())
+        {
+            return;
+        }
+
+        for (const auto &[peerId, peer] : m_peers)
+        {
+            if (canServe(peer, next->first, next->second))
+            {
+                return;
+            }
+        }
+
+        /* The peer which told us about it is on another fork, lied, or has
+           gone. Nothing above it can be added without it, and while they're
+           queued the other peers' chains aren't, so we'd never get going
+           again. The windows which arrived below it are still added. */
+        m_endIndex = next->first;
+
+        m_windows.erase(next, m_windows.end());
+
+        if (m_windows.empty())
+        {
+            m_endIndex = 0;
+        }
+    }
+} // namespace CryptoNote
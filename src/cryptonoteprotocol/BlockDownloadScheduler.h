@@ -0,0 +1,178 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include "cryptonoteprotocol/ICryptoNoteProtocolQuery.h"
+
+#include <CryptoNote.h>
+#include <boost/functional/hash.hpp>
+#include <boost/uuid/uuid.hpp>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace CryptoNote
+{
+    /* Decides which blocks to request from which synchronizing peer.
+
+       The hashes of the blocks we are missing, as told to us by the peers'
+       chain entries, are split into windows of BLOCKS_SYNCHRONIZING_DEFAULT_COUNT
+       blocks. Every peer whose chain entry agrees with a window can be asked
+       for it, so several windows are downloaded at once. Downloaded windows
+       are held until every window below them has arrived too, and then handed
+       out in height order, so blocks are always added to the chain in order.
+
+       No more than BLOCKS_SYNCHRONIZING_MAX_WINDOWS windows above the chain
+       are downloaded or held at once. A window a peer hasn't answered within
+       BLOCKS_SYNCHRONIZING_STALL_TIMEOUT seconds is handed to another peer,
+       and the stalled peer gets no more until it answers. Once none of our
+       peers can serve the next window we need, it and everything above it
+       are dropped, so the chains of the peers we do have can be queued.
+
+       The protocol handler only calls this from the dispatcher thread, but
+       the statistics are read from the RPC server thread, so everything is
+       behind a mutex. */
+    class BlockDownloadScheduler
+    {
+      public:
+        using PeerId = boost::uuids::uuid;
+
+        using Clock = std::chrono::steady_clock;
+
+        struct Window
+        {
+            uint32_t startIndex;
+
+            std::vector<Crypto::Hash> hashes;
+        };
+
+        struct DownloadedWindow
+        {
+            /* The peer the blocks came from */
+            PeerId peerId;
+
+            std::vector<RawBlock> rawBlocks;
+
+            std::vector<BlockTemplate> blockTemplates;
+        };
+
+        /* Records the missing block hashes a peer told us about, from
+           startIndex onwards. If they continue the ones we are already
+           downloading, or we aren't downloading any, the new ones are queued
+           for download. */
+        void addPeerChain(
+            const PeerId &peerId,
+            const std::string &address,
+            const uint32_t startIndex,
+            const std::vector<Crypto::Hash> &hashes);
+
+        /* The next window to request from the peer, if it isn't already
+           downloading one and there is one it can serve */
+        std::optional<Window> assignWindow(const PeerId &peerId, const Clock::time_point now);
+
+        /* Stores the blocks the peer sent for its window, with their hashes.
+           Blocks for a window which was handed to someone else and has already
+           arrived are thrown away. Returns false if the blocks aren't those of
+           the window. */
+        bool addBlocks(
+            const PeerId &peerId,
+            std::vector<RawBlock> &&rawBlocks,
+            std::vector<BlockTemplate> &&blockTemplates,
+            const std::vector<Crypto::Hash> &blockHashes,
+            const uint64_t bytes,
+            const Clock::time_point now);
+
+        /* The lowest window, if it has arrived */
+        std::optional<DownloadedWindow> takeNextWindow();
+
+        /* Hands the windows of peers which haven't answered in time to other
+           peers, and drops the windows no peer can serve any more. Returns
+           true if any windows were handed on. */
+        bool releaseStalledWindows(const Clock::time_point now);
+
+        void removePeer(const PeerId &peerId);
+
+        /* Drops every window, after one of them couldn't be added to the chain */
+        void clear();
+
+        /* Nothing to download, downloading, or waiting to be added */
+        bool empty() const;
+
+        /* True if the peer is downloading a window, or there is one it could */
+        bool hasWork(const PeerId &peerId) const;
+
+        /* The last hash the peer told us about */
+        std::optional<Crypto::Hash> lastPeerHash(const PeerId &peerId) const;
+
+        std::vector<PeerDownloadStatistics> getPeerStatistics() const;
+
+      private:
+        struct WindowState
+        {
+            std::vector<Crypto::Hash> hashes;
+
+            /* The peer downloading it, if any */
+            std::optional<PeerId> peerId;
+
+            Clock::time_point requestedAt;
+
+            std::optional<DownloadedWindow> downloaded;
+        };
+
+        struct PeerState
+        {
+            std::string address;
+
+            /* The missing block hashes the peer told us about */
+            uint32_t chainStartIndex = 0;
+
+            std::vector<Crypto::Hash> chain;
+
+            /* The window the peer was asked for and hasn't answered yet. Kept
+               when the window is handed to someone else, so a late answer can
+               still be used. */
+            std::optional<uint32_t> window;
+
+            Clock::time_point requestedAt;
+
+            bool stalled = false;
+
+            uint64_t blocksReceived = 0;
+
+            uint64_t bytesReceived = 0;
+
+            uint64_t windowsRequested = 0;
+
+            uint64_t windowsReceived = 0;
+
+            uint64_t windowsStalled = 0;
+
+            /* Total time between asking for a window and receiving it */
+            Clock::duration downloadTime = Clock::duration::zero();
+        };
+
+        bool canServe(const PeerState &peer, const uint32_t startIndex, const WindowState &window) const;
+
+        bool hasWindowFor(const PeerState &peer) const;
+
+        /* Drops the lowest window which hasn't arrived, and all those above
+           it, if none of our peers can serve it. m_mutex must be held. */
+        void dropUnservableWindows();
+
+        /* Windows keyed by the index of their first block. The first is always
+           the next one to add to the chain. */
+        std::map<uint32_t, WindowState> m_windows;
+
+        /* One past the index of the last block queued */
+        uint32_t m_endIndex = 0;
+
+        std::unordered_map<PeerId, PeerState, boost::hash<PeerId>> m_peers;
+
+        mutable std::mutex m_mutex;
+    };
+} // namespace CryptoNote
@@ -207,4 +207,77 @@ namespace CryptoNote
         const static int ID = BC_COMMANDS_POOL_BASE + 10;
         typedef NOTIFY_MISSING_TXS_request request;
     };
+
+    /* A new block, with its transactions referred to by their short ids,
+       salted with the block's previous block hash. The block template is sent
+       without its transaction hashes, which the receiver puts back from its
+       pool. It asks the sender for the transactions it doesn't have, and for
+       the lite block if the block it rebuilds has the wrong hash. */
+    struct NOTIFY_NEW_COMPACT_BLOCK_request
+    {
+        BinaryArray blockTemplate;
+
+        Crypto::Hash blockHash;
+
+        /* COMPACT_BLOCK_SHORT_ID_SIZE little endian bytes per transaction */
+        BinaryArray shortIds;
+
+        uint32_t current_blockchain_height;
+
+        uint32_t hop;
+    };
+
+    struct NOTIFY_NEW_COMPACT_BLOCK
+    {
+        const static int ID = BC_COMMANDS_POOL_BASE + 11;
+        typedef NOTIFY_NEW_COMPACT_BLOCK_request request;
+    };
+
+    struct NOTIFY_REQUEST_LITE_BLOCK_request
+    {
+        Crypto::Hash blockHash;
+
+        uint32_t current_blockchain_height;
+
+        /* Of the compact block, sent back in the lite block */
+        uint32_t hop;
+    };
+
+    struct NOTIFY_REQUEST_LITE_BLOCK
+    {
+        const static int ID = BC_COMMANDS_POOL_BASE + 12;
+        typedef NOTIFY_REQUEST_LITE_BLOCK_request request;
+    };
+
+    struct NOTIFY_REQUEST_COMPACT_BLOCK_TXS_request
+    {
+        Crypto::Hash blockHash;
+
+        uint32_t current_blockchain_height;
+
+        /* Of the transactions in the block, in ascending order */
+        std::vector<uint32_t> indexes;
+    };
+
+    struct NOTIFY_REQUEST_COMPACT_BLOCK_TXS
+    {
+        const static int ID = BC_COMMANDS_POOL_BASE + 13;
+        typedef NOTIFY_REQUEST_COMPACT_BLOCK_TXS_request request;
+    };
+
+    struct NOTIFY_COMPACT_BLOCK_TXS_request
+    {
+        Crypto::Hash blockHash;
+
+        uint32_t current_blockchain_height;
+
+        /* In the order they were asked for */
+        std::vector<BinaryArray> txs;
+    };
+
+    struct NOTIFY_COMPACT_BLOCK_TXS
+    {
+        const static int ID = BC_COMMANDS_POOL_BASE + 14;
+        typedef NOTIFY_COMPACT_BLOCK_TXS_request request;
+    };
 } // namespace CryptoNote
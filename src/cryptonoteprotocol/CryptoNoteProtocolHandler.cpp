@@ -13,6 +13,7 @@
 #include "cryptonotecore/Currency.h"
 #include "p2p/LevinProtocol.h"
 
+#include <algorithm>
 #include <boost/scope_exit.hpp>
 #include <boost/uuid/uuid_io.hpp>
 #include <config/Ascii.h>
@@ -21,6 +22,7 @@
 #include <future>
 #include <serialization/SerializationTools.h>
 #include <system/Dispatcher.h>
+#include <unordered_set>
 #include <utilities/FormatTools.h>
 
 using namespace Logging;
@@ -48,30 +50,50 @@ namespace CryptoNote
             p2p.externalRelayNotifyToAll(t_parametr::ID, LevinProtocol::encode(arg), excludeConnection);
         }
 
-        std::vector<RawBlockLegacy> convertRawBlocksToRawBlocksLegacy(const std::vector<RawBlock> &rawBlocks)
+        std::vector<RawBlock> convertRawBlocksLegacyToRawBlocks(const std::vector<RawBlockLegacy> &legacy)
         {
-            std::vector<RawBlockLegacy> legacy;
-            legacy.reserve(rawBlocks.size());
+            std::vector<RawBlock> rawBlocks;
+            rawBlocks.reserve(legacy.size());
 
-            for (const auto &rawBlock : rawBlocks)
+            for (const auto &legacyBlock : legacy)
             {
-                legacy.emplace_back(rawBlock.block, rawBlock.transactions);
+                rawBlocks.emplace_back(RawBlock {legacyBlock.blockTemplate, legacyBlock.transactions});
             }
 
-            return legacy;
+            return rawBlocks;
         }
 
-        std::vector<RawBlock> convertRawBlocksLegacyToRawBlocks(const std::vector<RawBlockLegacy> &legacy)
+        /* The lite block with its transaction hashes swapped for short ids, or
+           nothing if the template doesn't parse */
+        std::optional<NOTIFY_NEW_COMPACT_BLOCK::request> makeCompactBlock(const NOTIFY_NEW_LITE_BLOCK::request &lite)
         {
-            std::vector<RawBlock> rawBlocks;
-            rawBlocks.reserve(legacy.size());
+            BlockTemplate blockTemplate;
 
-            for (const auto &legacyBlock : legacy)
+            if (!fromBinaryArray(blockTemplate, lite.blockTemplate))
             {
-                rawBlocks.emplace_back(RawBlock {legacyBlock.blockTemplate, legacyBlock.transactions});
+                return std::nullopt;
             }
 
-            return rawBlocks;
+            NOTIFY_NEW_COMPACT_BLOCK::request compact;
+            compact.current_blockchain_height = lite.current_blockchain_height;
+            compact.hop = lite.hop;
+            compact.blockHash = CachedBlock(blockTemplate).getBlockHash();
+            compact.shortIds.reserve(blockTemplate.transactionHashes.size() * COMPACT_BLOCK_SHORT_ID_SIZE);
+
+            for (const auto &transactionHash : blockTemplate.transactionHashes)
+            {
+                const uint64_t shortId = getShortTransactionId(blockTemplate.previousBlockHash, transactionHash);
+
+                for (size_t i = 0; i < COMPACT_BLOCK_SHORT_ID_SIZE; i++)
+                {
+                    compact.shortIds.push_back(static_cast<uint8_t>(shortId >> (8 * i)));
+                }
+            }
+
+            blockTemplate.transactionHashes.clear();
+            compact.blockTemplate = toBinaryArray(blockTemplate);
+
+            return compact;
         }
 
     } // namespace
@@ -176,6 +198,120 @@ namespace CryptoNote
         serializeAsBinary(request.missing_txs, "missing_txs", s);
     }
 
+    static inline void serialize(NOTIFY_NEW_COMPACT_BLOCK_request &request, ISerializer &s)
+    {
+        std::string blockTemplate;
+        std::string shortIds;
+
+        s(request.current_blockchain_height, "current_blockchain_height");
+        s(request.hop, "hop");
+        s(request.blockHash, "blockHash");
+
+        if (s.type() == ISerializer::INPUT)
+        {
+            s(blockTemplate, "blockTemplate");
+            s(shortIds, "shortIds");
+            request.blockTemplate.assign(blockTemplate.begin(), blockTemplate.end());
+            request.shortIds.assign(shortIds.begin(), shortIds.end());
+        }
+        else
+        {
+            blockTemplate.assign(request.blockTemplate.begin(), request.blockTemplate.end());
+            shortIds.assign(request.shortIds.begin(), request.shortIds.end());
+            s(blockTemplate, "blockTemplate");
+            s(shortIds, "shortIds");
+        }
+    }
+
+    static inline void serialize(NOTIFY_REQUEST_LITE_BLOCK_request &request, ISerializer &s)
+    {
+        s(request.current_blockchain_height, "current_blockchain_height");
+        s(request.hop, "hop");
+        s(request.blockHash, "blockHash");
+    }
+
+    static inline void serialize(NOTIFY_REQUEST_COMPACT_BLOCK_TXS_request &request, ISerializer &s)
+    {
+        s(request.current_blockchain_height, "current_blockchain_height");
+        s(request.blockHash, "blockHash");
+        serializeAsBinary(request.indexes, "indexes", s);
+    }
+
+    static inline void serialize(NOTIFY_COMPACT_BLOCK_TXS_request &request, ISerializer &s)
+    {
+        std::vector<std::string> transactions;
+
+        s(request.current_blockchain_height, "current_blockchain_height");
+        s(request.blockHash, "blockHash");
+
+        if (s.type() == ISerializer::INPUT)
+        {
+            s(transactions, "txs");
+            request.txs.reserve(transactions.size());
+            std::transform(
+                transactions.begin(), transactions.end(), std::back_inserter(request.txs), [](const std::string &s) {
+                    return BinaryArray(s.begin(), s.end());
+                });
+        }
+        else
+        {
+            transactions.reserve(request.txs.size());
+            std::transform(
+                request.txs.begin(), request.txs.end(), std::back_inserter(transactions), [](const BinaryArray &s) {
+                    return std::string(s.begin(), s.end());
+                });
+            s(transactions, "txs");
+        }
+    }
+
+    /* A block as it is written into the blocks of a NOTIFY_RESPONSE_GET_OBJECTS */
+    static BinaryArray serializeBlockBlob(RawBlock &&rawBlock)
+    {
+        RawBlockLegacy legacy;
+        legacy.blockTemplate = std::move(rawBlock.block);
+        legacy.transactions = std::move(rawBlock.transactions);
+
+        KVBinaryOutputStreamSerializer serializer;
+        serialize(legacy, serializer);
+
+        BinaryArray blob;
+        Common::VectorOutputStream stream(blob);
+        serializer.dumpObject(stream);
+
+        return blob;
+    }
+
+    /* The same as LevinProtocol::encode(response), with the blocks copied in
+       already serialized instead of taken from response.blocks */
+    static BinaryArray encodeGetObjectsResponse(
+        NOTIFY_RESPONSE_GET_OBJECTS_request &response,
+        const std::vector<std::shared_ptr<const BinaryArray>> &blockBlobs)
+    {
+        KVBinaryOutputStreamSerializer serializer;
+
+        serializer(response.txs, "txs");
+
+        uint64_t count = blockBlobs.size();
+
+        serializer.beginArray(count, "blocks");
+
+        for (const auto &blob : blockBlobs)
+        {
+            serializer.serializedObject(*blob, "");
+        }
+
+        serializer.endArray();
+
+        serializeAsBinary(response.missed_ids, "missed_ids", serializer);
+        serializer(response.current_blockchain_height, "current_blockchain_height");
+
+        BinaryArray result;
+        Common::VectorOutputStream stream(result);
+        serializer.dump(stream);
+
+        return result;
+    }
+
     CryptoNoteProtocolHandler::CryptoNoteProtocolHandler(
         const Currency &currency,
         System::Dispatcher &dispatcher,
@@ -191,6 +327,7 @@ namespace CryptoNote
         m_observedHeight(0),
         m_blockchainHeight(0),
         m_peersCount(0),
+        m_blockBlobs(BLOCK_BLOB_CACHE_MAX_SIZE),
         logger(log, "protocol")
     {
         if (!m_p2p)
@@ -237,6 +374,10 @@ namespace CryptoNote
             m_observerManager.notify(&ICryptoNoteProtocolObserver::lastKnownBlockHeightUpdated, m_observedHeight);
         }
 
+        /* Its windows go to the other peers on the next idle tick. Those
+           none of them can serve are dropped now */
+        m_downloads.removePeer(context.m_connection_id);
+
         if (context.m_state != CryptoNoteConnectionContext::state_befor_handshake)
         {
             m_peersCount--;
@@ -255,12 +396,12 @@ namespace CryptoNote
 
         if (context.m_state == CryptoNoteConnectionContext::state_synchronizing)
         {
-            assert(context.m_needed_objects.empty());
             assert(context.m_requested_objects.empty());
 
             NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
             r.block_ids = m_core.buildSparseChain();
             logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
+            context.m_chain_requested = true;
             post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
         }
 
@@ -444,6 +585,10 @@ namespace CryptoNote
             HANDLE_NOTIFY(NOTIFY_REQUEST_TX_POOL, handleRequestTxPool)
             HANDLE_NOTIFY(NOTIFY_NEW_LITE_BLOCK, handle_notify_new_lite_block)
             HANDLE_NOTIFY(NOTIFY_MISSING_TXS, handle_notify_missing_txs)
+            HANDLE_NOTIFY(NOTIFY_NEW_COMPACT_BLOCK, handle_notify_new_compact_block)
+            HANDLE_NOTIFY(NOTIFY_REQUEST_LITE_BLOCK, handle_request_lite_block)
+            HANDLE_NOTIFY(NOTIFY_REQUEST_COMPACT_BLOCK_TXS, handle_request_compact_block_txs)
+            HANDLE_NOTIFY(NOTIFY_COMPACT_BLOCK_TXS, handle_compact_block_txs)
 
             default:
                 handled = false;
@@ -500,6 +645,7 @@ namespace CryptoNote
             NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
             r.block_ids = m_core.buildSparseChain();
             logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
+            context.m_chain_requested = true;
             post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
         }
         else
@@ -572,24 +718,74 @@ namespace CryptoNote
         //}
 
         rsp.current_blockchain_height = m_core.getTopBlockIndex() + 1;
-        std::vector<RawBlock> rawBlocks;
-        m_core.getBlocks(arg.blocks, rawBlocks, rsp.missed_ids);
+        const auto blockBlobs = getBlockBlobs(arg.blocks, rsp.missed_ids);
         if (!arg.txs.empty())
         {
             logger(Logging::WARNING, Logging::BRIGHT_YELLOW)
                 << context << "NOTIFY_RESPONSE_GET_OBJECTS: request.txs.empty() != true";
         }
 
-        rsp.blocks = convertRawBlocksToRawBlocksLegacy(rawBlocks);
-
-        logger(Logging::TRACE) << context << "-->>NOTIFY_RESPONSE_GET_OBJECTS: blocks.size()=" << rsp.blocks.size()
+        logger(Logging::TRACE) << context << "-->>NOTIFY_RESPONSE_GET_OBJECTS: blocks.size()=" << blockBlobs.size()
                                << ", txs.size()=" << rsp.txs.size()
                                << ", rsp.m_current_blockchain_height=" << rsp.current_blockchain_height
                                << ", missed_ids.size()=" << rsp.missed_ids.size();
-        post_notify<NOTIFY_RESPONSE_GET_OBJECTS>(*m_p2p, rsp, context);
+        m_p2p->invoke_notify_to_peer(
+            NOTIFY_RESPONSE_GET_OBJECTS::ID, encodeGetObjectsResponse(rsp, blockBlobs), context);
         return 1;
     }
 
+    std::vector<std::shared_ptr<const BinaryArray>> CryptoNoteProtocolHandler::getBlockBlobs(
+        const std::vector<Crypto::Hash> &blockHashes,
+        std::vector<Crypto::Hash> &missedHashes)
+    {
+        const uint64_t chainSwitchCount = m_core.getChainSwitchCount();
+
+        if (chainSwitchCount != m_blockBlobsChainSwitchCount)
+        {
+            m_blockBlobs.clear();
+            m_blockBlobsChainSwitchCount = chainSwitchCount;
+        }
+
+        std::vector<std::shared_ptr<const BinaryArray>> blobs(blockHashes.size());
+        std::vector<Crypto::Hash> uncachedHashes;
+
+        for (size_t i = 0; i < blockHashes.size(); i++)
+        {
+            blobs[i] = m_blockBlobs.get(blockHashes[i]);
+
+            if (!blobs[i])
+            {
+                uncachedHashes.push_back(blockHashes[i]);
+            }
+        }
+
+        if (!uncachedHashes.empty())
+        {
+            std::vector<RawBlock> rawBlocks;
+            m_core.getBlocks(uncachedHashes, rawBlocks, missedHashes);
+
+            const std::unordered_set<Crypto::Hash> missed(missedHashes.begin(), missedHashes.end());
+
+            /* The blocks found come back in the order asked for */
+            auto rawBlock = rawBlocks.begin();
+
+            for (size_t i = 0; i < blockHashes.size(); i++)
+            {
+                if (blobs[i] || missed.count(blockHashes[i]) != 0)
+                {
+                    continue;
+                }
+
+                blobs[i] = m_blockBlobs.insert(blockHashes[i], serializeBlockBlob(std::move(*rawBlock)));
+                ++rawBlock;
+            }
+        }
+
+        blobs.erase(std::remove(blobs.begin(), blobs.end(), nullptr), blobs.end());
+
+        return blobs;
+    }
+
     int CryptoNoteProtocolHandler::handle_response_get_objects(
         int command,
         NOTIFY_RESPONSE_GET_OBJECTS::request &arg,
@@ -610,11 +806,12 @@ namespace CryptoNote
         updateObservedHeight(arg.current_blockchain_height, context);
         context.m_remote_blockchain_height = arg.current_blockchain_height;
         std::vector<BlockTemplate> blockTemplates;
-        std::vector<CachedBlock> cachedBlocks;
+        std::vector<Crypto::Hash> blockHashes;
         blockTemplates.resize(arg.blocks.size());
-        cachedBlocks.reserve(arg.blocks.size());
+        blockHashes.reserve(arg.blocks.size());
 
         std::vector<RawBlock> rawBlocks = convertRawBlocksLegacyToRawBlocks(arg.blocks);
+        uint64_t bytes = 0;
 
         for (size_t index = 0; index < rawBlocks.size(); ++index)
         {
@@ -626,41 +823,37 @@ namespace CryptoNote
                 return 1;
             }
 
-            cachedBlocks.emplace_back(blockTemplates[index]);
-            if (index == 1)
-            {
-                if (m_core.hasBlock(cachedBlocks.back().getBlockHash()))
-                { // TODO
-                    context.m_state = CryptoNoteConnectionContext::state_idle;
-                    context.m_needed_objects.clear();
-                    context.m_requested_objects.clear();
-                    logger(Logging::DEBUGGING) << context << "Connection set to idle state.";
-                    return 1;
-                }
-            }
+            const CachedBlock cachedBlock(blockTemplates[index]);
+            blockHashes.push_back(cachedBlock.getBlockHash());
 
-            auto req_it = context.m_requested_objects.find(cachedBlocks.back().getBlockHash());
+            auto req_it = context.m_requested_objects.find(blockHashes.back());
             if (req_it == context.m_requested_objects.end())
             {
                 logger(Logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id="
-                                       << Common::podToHex(cachedBlocks.back().getBlockHash())
+                                       << Common::podToHex(blockHashes.back())
                                        << " wasn't requested, dropping connection";
                 context.m_state = CryptoNoteConnectionContext::state_shutdown;
                 return 1;
             }
 
-            if (cachedBlocks.back().getBlock().transactionHashes.size() != rawBlocks[index].transactions.size())
+            if (blockTemplates[index].transactionHashes.size() != rawBlocks[index].transactions.size())
             {
                 logger(Logging::ERROR) << context << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: block with id="
-                                       << Common::podToHex(cachedBlocks.back().getBlockHash())
-                                       << ", transactionHashes.size()="
-                                       << cachedBlocks.back().getBlock().transactionHashes.size()
+                                       << Common::podToHex(blockHashes.back()) << ", transactionHashes.size()="
+                                       << blockTemplates[index].transactionHashes.size()
                                        << " mismatch with block_complete_entry.m_txs.size()="
                                        << rawBlocks[index].transactions.size() << ", dropping connection";
                 context.m_state = CryptoNoteConnectionContext::state_shutdown;
                 return 1;
             }
 
+            bytes += rawBlocks[index].block.size();
+
+            for (const auto &transaction : rawBlocks[index].transactions)
+            {
+                bytes += transaction.size();
+            }
+
             context.m_requested_objects.erase(req_it);
         }
 
@@ -673,29 +866,147 @@ namespace CryptoNote
             return 1;
         }
 
+        if (!m_downloads.addBlocks(
+                context.m_connection_id,
+                std::move(rawBlocks),
+                std::move(blockTemplates),
+                blockHashes,
+                bytes,
+                BlockDownloadScheduler::Clock::now()))
+        {
+            logger(Logging::ERROR) << context
+                                   << "sent wrong NOTIFY_RESPONSE_GET_OBJECTS: blocks don't match the requested "
+                                      "window, dropping connection";
+            context.m_state = CryptoNoteConnectionContext::state_shutdown;
+            return 1;
+        }
+
+        processDownloadedBlocks();
+        requestBlocks();
+
+        return 1;
+    }
+
+    void CryptoNoteProtocolHandler::processDownloadedBlocks()
+    {
+        if (m_processingDownloads)
         {
-            int result = processObjects(context, std::move(rawBlocks), cachedBlocks);
-            if (result != 0)
+            return;
+        }
+
+        m_processingDownloads = true;
+
+        BOOST_SCOPE_EXIT_ALL(this)
+        {
+            m_processingDownloads = false;
+        };
+
+        while (!m_stop)
+        {
+            auto window = m_downloads.takeNextWindow();
+
+            if (!window)
             {
-                return result;
+                break;
             }
+
+            std::vector<CachedBlock> cachedBlocks;
+            cachedBlocks.reserve(window->blockTemplates.size());
+
+            for (const auto &blockTemplate : window->blockTemplates)
+            {
+                cachedBlocks.emplace_back(blockTemplate);
+            }
+
+            if (!processObjects(window->peerId, std::move(window->rawBlocks), cachedBlocks))
+            {
+                /* Everything above the block builds on it */
+                m_downloads.clear();
+                break;
+            }
+
+            logger(DEBUGGING, BRIGHT_GREEN) << "Local blockchain updated, new index = " << m_core.getTopBlockIndex();
+
+            /* A window's worth of room has been made */
+            requestBlocks();
         }
+    }
 
-        logger(DEBUGGING, BRIGHT_GREEN) << "Local blockchain updated, new index = " << m_core.getTopBlockIndex();
-        if (!m_stop && context.m_state == CryptoNoteConnectionContext::state_synchronizing)
+    void CryptoNoteProtocolHandler::requestBlocks()
+    {
+        if (m_stop)
         {
-            request_missing_objects(context, true);
+            return;
         }
 
-        return 1;
+        const auto now = BlockDownloadScheduler::Clock::now();
+
+        m_p2p->for_each_connection([&](CryptoNoteConnectionContext &context, uint64_t peerId) {
+            if (context.m_state != CryptoNoteConnectionContext::state_synchronizing)
+            {
+                return;
+            }
+
+            if (const auto window = m_downloads.assignWindow(context.m_connection_id, now))
+            {
+                NOTIFY_REQUEST_GET_OBJECTS::request req;
+                req.blocks = window->hashes;
+
+                context.m_requested_objects.clear();
+                context.m_requested_objects.insert(window->hashes.begin(), window->hashes.end());
+
+                logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: start index="
+                                       << window->startIndex << ", blocks.size()=" << req.blocks.size();
+                post_notify<NOTIFY_REQUEST_GET_OBJECTS>(*m_p2p, req, context);
+            }
+            else if (!context.m_chain_requested && !m_downloads.hasWork(context.m_connection_id))
+            {
+                request_missing_objects(context);
+            }
+        });
     }
 
-    int CryptoNoteProtocolHandler::processObjects(
-        CryptoNoteConnectionContext &context,
+    void CryptoNoteProtocolHandler::onIdle()
+    {
+        if (m_downloads.releaseStalledWindows(BlockDownloadScheduler::Clock::now()))
+        {
+            logger(Logging::DEBUGGING) << "Requesting stalled block downloads from other peers";
+        }
+
+        requestBlocks();
+    }
+
+    std::vector<PeerDownloadStatistics> CryptoNoteProtocolHandler::getPeerDownloadStatistics() const
+    {
+        return m_downloads.getPeerStatistics();
+    }
+
+    void CryptoNoteProtocolHandler::shutdownConnection(
+        const boost::uuids::uuid &connectionId,
+        Logging::Level level,
+        const std::string &reason)
+    {
+        m_p2p->for_each_connection([&](CryptoNoteConnectionContext &context, uint64_t peerId) {
+            if (context.m_connection_id == connectionId)
+            {
+                logger(level) << context << reason;
+                context.m_state = CryptoNoteConnectionContext::state_shutdown;
+            }
+        });
+    }
+
+    bool CryptoNoteProtocolHandler::processObjects(
+        const boost::uuids::uuid &connectionId,
         std::vector<RawBlock> &&rawBlocks,
         const std::vector<CachedBlock> &cachedBlocks)
     {
         assert(rawBlocks.size() == cachedBlocks.size());
+
+        /* Deserialize, hash and compute the proof of work for the whole batch
+           up front across all cores, so only the chain dependent part of
+           adding each block is done one at a time below */
+        auto preparedBlocks = m_core.prepareBlocks(cachedBlocks, rawBlocks);
+
         for (size_t index = 0; index < rawBlocks.size(); ++index)
         {
             if (m_stop)
@@ -703,38 +1014,37 @@ namespace CryptoNote
                 break;
             }
 
-            auto addResult = m_core.addBlock(cachedBlocks[index], std::move(rawBlocks[index]));
+            auto addResult = m_core.addBlock(
+                cachedBlocks[index], std::move(rawBlocks[index]), std::move(preparedBlocks[index]));
             if (addResult == error::AddBlockErrorCondition::BLOCK_VALIDATION_FAILED
                 || addResult == error::AddBlockErrorCondition::TRANSACTION_VALIDATION_FAILED
                 || addResult == error::AddBlockErrorCondition::DESERIALIZATION_FAILED)
             {
-                logger(Logging::DEBUGGING)
-                    << context << "Block verification failed, dropping connection: " << addResult.message();
-                context.m_state = CryptoNoteConnectionContext::state_shutdown;
-                return 1;
+                shutdownConnection(
+                    connectionId,
+                    Logging::DEBUGGING,
+                    "Block verification failed, dropping connection: " + addResult.message());
+                return false;
             }
             else if (addResult == error::AddBlockErrorCondition::BLOCK_REJECTED)
             {
-                logger(Logging::INFO) << context
-                                      << "Block received at sync phase was marked as orphaned, dropping connection: "
-                                      << addResult.message();
-                context.m_state = CryptoNoteConnectionContext::state_shutdown;
-                return 1;
+                shutdownConnection(
+                    connectionId,
+                    Logging::INFO,
+                    "Block received at sync phase was marked as orphaned, dropping connection: "
+                        + addResult.message());
+                return false;
             }
             else if (addResult == error::AddBlockErrorCode::ALREADY_EXISTS)
             {
-                logger(Logging::DEBUGGING)
-                    << context << "Block already exists, switching to idle state: " << addResult.message();
-                context.m_state = CryptoNoteConnectionContext::state_idle;
-                context.m_needed_objects.clear();
-                context.m_requested_objects.clear();
-                return 1;
+                /* Relayed to us while it was being downloaded */
+                logger(Logging::DEBUGGING) << "Downloaded block already exists: " << addResult.message();
             }
 
             m_dispatcher.yield();
         }
 
-        return 0;
+        return true;
     }
 
     int CryptoNoteProtocolHandler::doPushLiteBlock(
@@ -821,17 +1131,13 @@ namespace CryptoNote
                 if (result == error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE_AND_SWITCHED)
                 {
                     ++arg.hop;
-                    // TODO: Add here announce protocol usage
-                    relay_post_notify<NOTIFY_NEW_LITE_BLOCK>(*m_p2p, arg, &context.m_connection_id);
-                    // relay_block(arg, context);
+                    relayLiteBlock(arg, &context.m_connection_id);
                     requestMissingPoolTransactions(context);
                 }
                 else if (result == error::AddBlockErrorCode::ADDED_TO_MAIN)
                 {
                     ++arg.hop;
-                    // TODO: Add here announce protocol usage
-                    relay_post_notify<NOTIFY_NEW_LITE_BLOCK>(*m_p2p, arg, &context.m_connection_id);
-                    // relay_block(arg, context);
+                    relayLiteBlock(arg, &context.m_connection_id);
                 }
                 else if (result == error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE)
                 {
@@ -849,6 +1155,7 @@ namespace CryptoNote
                 r.block_ids = m_core.buildSparseChain();
                 logger(Logging::TRACE) << context
                                        << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
+                context.m_chain_requested = true;
                 post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
             }
             else
@@ -923,49 +1230,31 @@ namespace CryptoNote
         return 1;
     }
 
-    bool CryptoNoteProtocolHandler::request_missing_objects(
-        CryptoNoteConnectionContext &context,
-        bool check_having_blocks)
+    bool CryptoNoteProtocolHandler::request_missing_objects(CryptoNoteConnectionContext &context)
     {
-        if (context.m_needed_objects.size())
-        {
-            // we know objects that we need, request this objects
-            NOTIFY_REQUEST_GET_OBJECTS::request req;
-            size_t count = 0;
-            auto it = context.m_needed_objects.begin();
-
-            while (it != context.m_needed_objects.end() && count < BLOCKS_SYNCHRONIZING_DEFAULT_COUNT)
-            {
-                if (!(check_having_blocks && m_core.hasBlock(*it)))
-                {
-                    req.blocks.push_back(*it);
-                    ++count;
-                    context.m_requested_objects.insert(*it);
-                }
-                it = context.m_needed_objects.erase(it);
-            }
-            logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_GET_OBJECTS: blocks.size()=" << req.blocks.size()
-                                   << ", txs.size()=" << req.txs.size();
-            post_notify<NOTIFY_REQUEST_GET_OBJECTS>(*m_p2p, req, context);
-        }
-        else if (context.m_last_response_height < context.m_remote_blockchain_height - 1)
-        { // we have to fetch more objects ids, request blockchain entry
+        const auto lastPeerHash = m_downloads.lastPeerHash(context.m_connection_id);
 
+        /* We have to fetch more objects ids, request blockchain entry. Also when
+           the peer's chain differs from the one we downloaded, once that is done. */
+        if (context.m_last_response_height < context.m_remote_blockchain_height - 1
+            || (lastPeerHash && !m_core.hasBlock(*lastPeerHash) && m_downloads.empty()))
+        {
             NOTIFY_REQUEST_CHAIN::request r = boost::value_initialized<NOTIFY_REQUEST_CHAIN::request>();
             r.block_ids = m_core.buildSparseChain();
             logger(Logging::TRACE) << context << "-->>NOTIFY_REQUEST_CHAIN: m_block_ids.size()=" << r.block_ids.size();
+            context.m_chain_requested = true;
             post_notify<NOTIFY_REQUEST_CHAIN>(*m_p2p, r, context);
         }
-        else
+        /* Blocks from this peer's chain may still be on their way from others */
+        else if (m_downloads.empty())
         {
             if (!(context.m_last_response_height == context.m_remote_blockchain_height - 1
-                  && !context.m_needed_objects.size() && !context.m_requested_objects.size()))
+                  && !context.m_requested_objects.size()))
             {
                 logger(Logging::ERROR, Logging::BRIGHT_RED)
                     << "request_missing_blocks final condition failed!"
                     << "\r\nm_last_response_height=" << context.m_last_response_height
                     << "\r\nm_remote_blockchain_height=" << context.m_remote_blockchain_height
-                    << "\r\nm_needed_objects.size()=" << context.m_needed_objects.size()
                     << "\r\nm_requested_objects.size()=" << context.m_requested_objects.size() << "\r\non connection ["
                     << context << "]";
                 return false;
@@ -1026,6 +1315,7 @@ namespace CryptoNote
             return 1;
         }
 
+        context.m_chain_requested = false;
         context.m_remote_blockchain_height = arg.total_height;
         context.m_last_response_height = arg.start_height + static_cast<uint32_t>(arg.m_block_ids.size()) - 1;
 
@@ -1037,24 +1327,21 @@ namespace CryptoNote
             context.m_state = CryptoNoteConnectionContext::state_shutdown;
         }
 
-        bool allBlocksKnown = true;
-        for (auto &bl_id : arg.m_block_ids)
+        /* Everything from the first block we don't have */
+        size_t firstNeeded = 0;
+
+        while (firstNeeded < arg.m_block_ids.size() && m_core.hasBlock(arg.m_block_ids[firstNeeded]))
         {
-            if (allBlocksKnown)
-            {
-                if (!m_core.hasBlock(bl_id))
-                {
-                    context.m_needed_objects.push_back(bl_id);
-                    allBlocksKnown = false;
-                }
-            }
-            else
-            {
-                context.m_needed_objects.push_back(bl_id);
-            }
+            ++firstNeeded;
         }
 
-        request_missing_objects(context, false);
+        m_downloads.addPeerChain(
+            context.m_connection_id,
+            Common::ipAddressToString(context.m_remote_ip) + ":" + std::to_string(context.m_remote_port),
+            arg.start_height + static_cast<uint32_t>(firstNeeded),
+            std::vector<Crypto::Hash>(arg.m_block_ids.begin() + firstNeeded, arg.m_block_ids.end()));
+
+        requestBlocks();
         return 1;
     }
 
@@ -1135,6 +1422,293 @@ namespace CryptoNote
         return 1;
     }
 
+    int CryptoNoteProtocolHandler::handle_notify_new_compact_block(
+        int command,
+        NOTIFY_NEW_COMPACT_BLOCK::request &arg,
+        CryptoNoteConnectionContext &context)
+    {
+        logger(Logging::TRACE) << context << "NOTIFY_NEW_COMPACT_BLOCK (hop " << arg.hop << ")";
+        updateObservedHeight(arg.current_blockchain_height, context);
+        context.m_remote_blockchain_height = arg.current_blockchain_height;
+        if (context.m_state != CryptoNoteConnectionContext::state_normal)
+        {
+            return 1;
+        }
+
+        BlockTemplate blockTemplate;
+
+        if (!fromBinaryArray(blockTemplate, arg.blockTemplate) || !blockTemplate.transactionHashes.empty()
+            || arg.shortIds.size() % COMPACT_BLOCK_SHORT_ID_SIZE != 0)
+        {
+            logger(Logging::WARNING) << context << "Invalid compact block, dropping connection";
+            context.m_state = CryptoNoteConnectionContext::state_shutdown;
+            return 1;
+        }
+
+        if (m_core.hasBlock(arg.blockHash))
+        {
+            return 1;
+        }
+
+        std::vector<uint64_t> shortIds;
+        shortIds.reserve(arg.shortIds.size() / COMPACT_BLOCK_SHORT_ID_SIZE);
+
+        for (auto it = arg.shortIds.begin(); it != arg.shortIds.end(); it += COMPACT_BLOCK_SHORT_ID_SIZE)
+        {
+            uint64_t shortId = 0;
+
+            for (size_t i = 0; i < COMPACT_BLOCK_SHORT_ID_SIZE; i++)
+            {
+                shortId |= static_cast<uint64_t>(*(it + i)) << (8 * i);
+            }
+
+            shortIds.push_back(shortId);
+        }
+
+        auto transactionHashes = m_core.getPoolTransactionHashesByShortId(blockTemplate.previousBlockHash, shortIds);
+
+        NOTIFY_REQUEST_COMPACT_BLOCK_TXS::request req;
+
+        /* Transactions we don't have, or short ids matching more than one of
+           ours, are asked for by their place in the block */
+        for (uint32_t i = 0; i < transactionHashes.size(); i++)
+        {
+            if (transactionHashes[i])
+            {
+                blockTemplate.transactionHashes.push_back(*transactionHashes[i]);
+            }
+            else
+            {
+                req.indexes.push_back(i);
+            }
+        }
+
+        if (!req.indexes.empty())
+        {
+            logger(Logging::DEBUGGING) << context << "Requesting " << req.indexes.size() << " of "
+                                       << shortIds.size() << " transactions in compact block " << arg.blockHash;
+
+            req.blockHash = arg.blockHash;
+            req.current_blockchain_height = m_core.getTopBlockIndex() + 1;
+
+            context.m_pending_compact_block = PendingCompactBlock {std::move(arg), std::move(transactionHashes)};
+
+            if (!post_notify<NOTIFY_REQUEST_COMPACT_BLOCK_TXS>(*m_p2p, req, context))
+            {
+                context.m_pending_compact_block = std::nullopt;
+                context.m_state = CryptoNoteConnectionContext::state_shutdown;
+            }
+
+            return 1;
+        }
+
+        return doPushCompactBlock(arg, std::move(blockTemplate), context, {});
+    }
+
+    int CryptoNoteProtocolHandler::doPushCompactBlock(
+        const NOTIFY_NEW_COMPACT_BLOCK::request &arg,
+        BlockTemplate blockTemplate,
+        CryptoNoteConnectionContext &context,
+        std::vector<BinaryArray> missingTxs)
+    {
+        /* A short id matching a different transaction to the one in the
+           block, so fall back to the lite block */
+        if (CachedBlock(blockTemplate).getBlockHash() != arg.blockHash)
+        {
+            logger(Logging::DEBUGGING) << context << "Couldn't rebuild compact block " << arg.blockHash
+                                       << ", requesting lite block";
+
+            NOTIFY_REQUEST_LITE_BLOCK::request req;
+            req.blockHash = arg.blockHash;
+            req.current_blockchain_height = m_core.getTopBlockIndex() + 1;
+            req.hop = arg.hop;
+
+            if (!post_notify<NOTIFY_REQUEST_LITE_BLOCK>(*m_p2p, req, context))
+            {
+                context.m_state = CryptoNoteConnectionContext::state_shutdown;
+            }
+
+            return 1;
+        }
+
+        NOTIFY_NEW_LITE_BLOCK::request lite;
+        lite.blockTemplate = toBinaryArray(blockTemplate);
+        lite.current_blockchain_height = arg.current_blockchain_height;
+        lite.hop = arg.hop;
+
+        return doPushLiteBlock(std::move(lite), context, std::move(missingTxs));
+    }
+
+    int CryptoNoteProtocolHandler::handle_request_lite_block(
+        int command,
+        NOTIFY_REQUEST_LITE_BLOCK::request &arg,
+        CryptoNoteConnectionContext &context)
+    {
+        logger(Logging::TRACE) << context << "NOTIFY_REQUEST_LITE_BLOCK";
+        updateObservedHeight(arg.current_blockchain_height, context);
+        context.m_remote_blockchain_height = arg.current_blockchain_height;
+
+        std::vector<RawBlock> blocks;
+        std::vector<Crypto::Hash> missedHashes;
+        m_core.getBlocks({arg.blockHash}, blocks, missedHashes);
+
+        /* Probably orphaned since we sent it */
+        if (blocks.empty())
+        {
+            logger(Logging::DEBUGGING) << context << "Requested lite block " << arg.blockHash << " not found";
+            return 1;
+        }
+
+        NOTIFY_NEW_LITE_BLOCK::request lite;
+        lite.blockTemplate = std::move(blocks.front().block);
+        lite.current_blockchain_height = m_core.getTopBlockIndex() + 1;
+        lite.hop = arg.hop;
+
+        post_notify<NOTIFY_NEW_LITE_BLOCK>(*m_p2p, lite, context);
+
+        return 1;
+    }
+
+    int CryptoNoteProtocolHandler::handle_request_compact_block_txs(
+        int command,
+        NOTIFY_REQUEST_COMPACT_BLOCK_TXS::request &arg,
+        CryptoNoteConnectionContext &context)
+    {
+        logger(Logging::TRACE) << context << "NOTIFY_REQUEST_COMPACT_BLOCK_TXS";
+        updateObservedHeight(arg.current_blockchain_height, context);
+        context.m_remote_blockchain_height = arg.current_blockchain_height;
+
+        std::vector<RawBlock> blocks;
+        std::vector<Crypto::Hash> missedHashes;
+        m_core.getBlocks({arg.blockHash}, blocks, missedHashes);
+
+        /* Probably orphaned since we sent it */
+        if (blocks.empty())
+        {
+            logger(Logging::DEBUGGING) << context << "Requested compact block " << arg.blockHash << " not found";
+            return 1;
+        }
+
+        auto &transactions = blocks.front().transactions;
+
+        NOTIFY_COMPACT_BLOCK_TXS::request res;
+        res.blockHash = arg.blockHash;
+        res.current_blockchain_height = m_core.getTopBlockIndex() + 1;
+        res.txs.reserve(arg.indexes.size());
+
+        for (const auto index : arg.indexes)
+        {
+            if (index >= transactions.size())
+            {
+                logger(Logging::WARNING) << context << "Invalid compact block transaction request, dropping connection";
+                context.m_state = CryptoNoteConnectionContext::state_shutdown;
+                return 1;
+            }
+
+            res.txs.push_back(std::move(transactions[index]));
+        }
+
+        post_notify<NOTIFY_COMPACT_BLOCK_TXS>(*m_p2p, res, context);
+
+        return 1;
+    }
+
+    int CryptoNoteProtocolHandler::handle_compact_block_txs(
+        int command,
+        NOTIFY_COMPACT_BLOCK_TXS::request &arg,
+        CryptoNoteConnectionContext &context)
+    {
+        logger(Logging::TRACE) << context << "NOTIFY_COMPACT_BLOCK_TXS";
+        updateObservedHeight(arg.current_blockchain_height, context);
+        context.m_remote_blockchain_height = arg.current_blockchain_height;
+
+        /* Superseded by a newer compact block, or one we never asked for */
+        if (!context.m_pending_compact_block || context.m_pending_compact_block->request.blockHash != arg.blockHash)
+        {
+            return 1;
+        }
+
+        const auto pending = std::move(*context.m_pending_compact_block);
+        context.m_pending_compact_block = std::nullopt;
+
+        if (context.m_state != CryptoNoteConnectionContext::state_normal)
+        {
+            return 1;
+        }
+
+        const size_t requested =
+            std::count(pending.transactionHashes.begin(), pending.transactionHashes.end(), std::nullopt);
+
+        if (arg.txs.size() != requested)
+        {
+            logger(Logging::DEBUGGING) << context
+                                       << "Peer didn't provide the transactions requested for a compact block, "
+                                          "dropping connection";
+            context.m_state = CryptoNoteConnectionContext::state_shutdown;
+            return 1;
+        }
+
+        BlockTemplate blockTemplate;
+
+        /* Checked when the compact block arrived */
+        fromBinaryArray(blockTemplate, pending.request.blockTemplate);
+
+        auto provided = arg.txs.begin();
+
+        for (const auto &transactionHash : pending.transactionHashes)
+        {
+            blockTemplate.transactionHashes.push_back(
+                transactionHash ? *transactionHash : getBinaryArrayHash(*provided++));
+        }
+
+        return doPushCompactBlock(pending.request, std::move(blockTemplate), context, std::move(arg.txs));
+    }
+
+    void CryptoNoteProtocolHandler::relayLiteBlock(
+        NOTIFY_NEW_LITE_BLOCK::request &arg,
+        const boost::uuids::uuid *excludeConnection)
+    {
+        std::list<boost::uuids::uuid> compactBlockConnections, liteBlockConnections;
+
+        m_p2p->for_each_connection([&](const CryptoNoteConnectionContext &ctx, uint64_t peerId) {
+            if (excludeConnection != nullptr && ctx.m_connection_id == *excludeConnection)
+            {
+                return;
+            }
+
+            if (ctx.version >= P2P_COMPACT_BLOCKS_PROPOGATION_VERSION)
+            {
+                compactBlockConnections.push_back(ctx.m_connection_id);
+            }
+            else if (ctx.version >= P2P_LITE_BLOCKS_PROPOGATION_VERSION)
+            {
+                liteBlockConnections.push_back(ctx.m_connection_id);
+            }
+        });
+
+        const auto compact = makeCompactBlock(arg);
+
+        /* Shouldn't happen, the template has been parsed already */
+        if (!compact)
+        {
+            liteBlockConnections.splice(liteBlockConnections.end(), compactBlockConnections);
+        }
+
+        if (!compactBlockConnections.empty())
+        {
+            const auto compact_buf = LevinProtocol::encode(*compact);
+            logger(Logging::DEBUGGING) << "NOTIFY_NEW_COMPACT_BLOCK - MSG_SIZE = " << compact_buf.size();
+            m_p2p->externalRelayNotifyToList(NOTIFY_NEW_COMPACT_BLOCK::ID, compact_buf, compactBlockConnections);
+        }
+
+        if (!liteBlockConnections.empty())
+        {
+            const auto lite_buf = LevinProtocol::encode(arg);
+            logger(Logging::DEBUGGING) << "NOTIFY_NEW_LITE_BLOCK - MSG_SIZE = " << lite_buf.size();
+            m_p2p->externalRelayNotifyToList(NOTIFY_NEW_LITE_BLOCK::ID, lite_buf, liteBlockConnections);
+        }
+    }
+
     void CryptoNoteProtocolHandler::relayBlock(NOTIFY_NEW_BLOCK::request &arg)
     {
         // generate a lite block request from the received normal block.
@@ -1143,25 +1717,13 @@ namespace CryptoNote
         lite_arg.blockTemplate = arg.block.blockTemplate;
         lite_arg.hop = arg.hop;
 
-        // encoding the request for sending the blocks to peers.
-        auto buf = LevinProtocol::encode(arg);
-        auto lite_buf = LevinProtocol::encode(lite_arg);
+        std::list<boost::uuids::uuid> normalBlockConnections;
 
-        // logging the msg size to see the difference in payload size.
-        logger(Logging::DEBUGGING) << "NOTIFY_NEW_BLOCK - MSG_SIZE = " << buf.size();
-        logger(Logging::DEBUGGING) << "NOTIFY_NEW_LITE_BLOCK - MSG_SIZE = " << lite_buf.size();
-
-        std::list<boost::uuids::uuid> liteBlockConnections, normalBlockConnections;
-
-        // sort the peers into their support categories.
-        m_p2p->for_each_connection([this, &liteBlockConnections, &normalBlockConnections](
+        // compact and lite blocks go out through relayLiteBlock, so only
+        // the peers supporting neither need the full block.
+        m_p2p->for_each_connection([this, &normalBlockConnections](
                                        const CryptoNoteConnectionContext &ctx, uint64_t peerId) {
-            if (ctx.version >= P2P_LITE_BLOCKS_PROPOGATION_VERSION)
-            {
-                logger(Logging::DEBUGGING) << ctx << "Peer supports lite-blocks... adding peer to lite block list";
-                liteBlockConnections.push_back(ctx.m_connection_id);
-            }
-            else
+            if (ctx.version < P2P_LITE_BLOCKS_PROPOGATION_VERSION)
             {
                 logger(Logging::DEBUGGING)
                     << ctx << "Peer doesn't support lite-blocks... adding peer to normal block list";
@@ -1169,14 +1731,16 @@ namespace CryptoNote
             }
         });
 
-        // first send lite one's.. coz they are faster
-        if (!liteBlockConnections.empty())
-        {
-            m_p2p->externalRelayNotifyToList(NOTIFY_NEW_LITE_BLOCK::ID, lite_buf, liteBlockConnections);
-        }
+        // first send compact and lite one's.. coz they are faster
+        relayLiteBlock(lite_arg, nullptr);
 
         if (!normalBlockConnections.empty())
         {
+            auto buf = LevinProtocol::encode(arg);
+
+            // logging the msg size to see the difference in payload size.
+            logger(Logging::DEBUGGING) << "NOTIFY_NEW_BLOCK - MSG_SIZE = " << buf.size();
+
             m_p2p->externalRelayNotifyToList(NOTIFY_NEW_BLOCK::ID, buf, normalBlockConnections);
         }
     }
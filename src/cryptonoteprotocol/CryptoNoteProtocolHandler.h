@@ -7,6 +7,8 @@
 #pragma once
 
 #include "cryptonotecore/ICore.h"
+#include "cryptonoteprotocol/BlockBlobCache.h"
+#include "cryptonoteprotocol/BlockDownloadScheduler.h"
 #include "cryptonoteprotocol/CryptoNoteProtocolDefinitions.h"
 #include "cryptonoteprotocol/CryptoNoteProtocolHandlerCommon.h"
 #include "cryptonoteprotocol/ICryptoNoteProtocolObserver.h"
@@ -84,8 +86,13 @@ namespace CryptoNote
 
         virtual uint32_t getBlockchainHeight() const override;
 
+        virtual std::vector<PeerDownloadStatistics> getPeerDownloadStatistics() const override;
+
         void requestMissingPoolTransactions(const CryptoNoteConnectionContext &context);
 
+        /* Called every second by the node server */
+        void onIdle();
+
       private:
         //----------------- commands handlers ----------------------------------------------
         int handle_notify_new_block(int command, NOTIFY_NEW_BLOCK::request &arg, CryptoNoteConnectionContext &context);
@@ -127,6 +134,26 @@ namespace CryptoNote
             NOTIFY_MISSING_TXS::request &arg,
             CryptoNoteConnectionContext &context);
 
+        int handle_notify_new_compact_block(
+            int command,
+            NOTIFY_NEW_COMPACT_BLOCK::request &arg,
+            CryptoNoteConnectionContext &context);
+
+        int handle_request_lite_block(
+            int command,
+            NOTIFY_REQUEST_LITE_BLOCK::request &arg,
+            CryptoNoteConnectionContext &context);
+
+        int handle_request_compact_block_txs(
+            int command,
+            NOTIFY_REQUEST_COMPACT_BLOCK_TXS::request &arg,
+            CryptoNoteConnectionContext &context);
+
+        int handle_compact_block_txs(
+            int command,
+            NOTIFY_COMPACT_BLOCK_TXS::request &arg,
+            CryptoNoteConnectionContext &context);
+
         //----------------- i_cryptonote_protocol ----------------------------------
         virtual void relayBlock(NOTIFY_NEW_BLOCK::request &arg) override;
 
@@ -135,7 +162,27 @@ namespace CryptoNote
         //----------------------------------------------------------------------------------
         uint32_t get_current_blockchain_height();
 
-        bool request_missing_objects(CryptoNoteConnectionContext &context, bool check_having_blocks);
+        bool request_missing_objects(CryptoNoteConnectionContext &context);
+
+        /* The blocks, serialized as they are sent in NOTIFY_RESPONSE_GET_OBJECTS,
+           from the cache where possible. Blocks we don't have are added to
+           missedHashes. */
+        std::vector<std::shared_ptr<const BinaryArray>> getBlockBlobs(
+            const std::vector<Crypto::Hash> &blockHashes,
+            std::vector<Crypto::Hash> &missedHashes);
+
+        /* Asks every synchronizing peer without a request in flight for the
+           next window of blocks it can send us */
+        void requestBlocks();
+
+        /* Adds the downloaded windows to the chain, in order, for as long as
+           the next one has arrived */
+        void processDownloadedBlocks();
+
+        void shutdownConnection(
+            const boost::uuids::uuid &connectionId,
+            Logging::Level level,
+            const std::string &reason);
 
         bool on_connection_synchronized();
 
@@ -143,8 +190,10 @@ namespace CryptoNote
 
         void recalculateMaxObservedHeight(const CryptoNoteConnectionContext &context);
 
-        int processObjects(
-            CryptoNoteConnectionContext &context,
+        /* Returns false if a block couldn't be added, after dropping the
+           peer which sent it */
+        bool processObjects(
+            const boost::uuids::uuid &connectionId,
             std::vector<RawBlock> &&rawBlocks,
             const std::vector<CachedBlock> &cachedBlocks);
 
@@ -156,6 +205,19 @@ namespace CryptoNote
             CryptoNoteConnectionContext &context,
             std::vector<BinaryArray> missingTxs);
 
+        /* Adds the compact block once all of its transaction hashes are known,
+           asking the sender for the lite block if the hash doesn't match. The
+           transactions it sent us are passed in missingTxs. */
+        int doPushCompactBlock(
+            const NOTIFY_NEW_COMPACT_BLOCK::request &arg,
+            BlockTemplate blockTemplate,
+            CryptoNoteConnectionContext &context,
+            std::vector<BinaryArray> missingTxs);
+
+        /* Sends the block as a compact block to the peers which support them,
+           and as a lite block to the other peers which support those */
+        void relayLiteBlock(NOTIFY_NEW_LITE_BLOCK::request &arg, const boost::uuids::uuid *excludeConnection);
+
       private:
         System::Dispatcher &m_dispatcher;
 
@@ -182,5 +244,17 @@ namespace CryptoNote
         std::atomic<size_t> m_peersCount;
 
         Tools::ObserverManager<ICryptoNoteProtocolObserver> m_observerManager;
+
+        BlockDownloadScheduler m_downloads;
+
+        /* Adding blocks yields to the dispatcher, during which other peers'
+           blocks can arrive, and mustn't be added out of order */
+        bool m_processingDownloads = false;
+
+        BlockBlobCache m_blockBlobs;
+
+        /* The chain switch count of the core when the cache was last used.
+           Blocks switched away from are no longer worth keeping. */
+        uint64_t m_blockBlobsChainSwitchCount = 0;
     };
 } // namespace CryptoNote
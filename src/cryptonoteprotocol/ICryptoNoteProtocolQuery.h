@@ -7,11 +7,41 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <string>
+#include <vector>
 
 namespace CryptoNote
 {
     class ICryptoNoteProtocolObserver;
 
+    /* How a synchronizing peer has performed at sending us blocks */
+    struct PeerDownloadStatistics
+    {
+        std::string address;
+
+        uint64_t blocksReceived;
+
+        uint64_t bytesReceived;
+
+        /* Received, over the time spent waiting for it */
+        uint64_t bytesPerSecond;
+
+        /* Milliseconds between requesting a window of blocks and receiving it */
+        uint64_t averageResponseTime;
+
+        uint64_t windowsRequested;
+
+        /* Windows the peer didn't send in time, which were requested from
+           another peer instead */
+        uint64_t windowsStalled;
+
+        /* Waiting on the peer to send a window */
+        bool downloading;
+
+        /* The peer hasn't sent the last window in time */
+        bool stalled;
+    };
+
     class ICryptoNoteProtocolQuery
     {
       public:
@@ -26,6 +56,8 @@ namespace CryptoNote
         virtual size_t getPeerCount() const = 0;
 
         virtual bool isSynchronized() const = 0;
+
+        virtual std::vector<PeerDownloadStatistics> getPeerDownloadStatistics() const = 0;
     };
 
 } // namespace CryptoNote
@@ -7,12 +7,18 @@
 #include "common/StringTools.h"
 #include "crypto/crypto.h"
 #include "crypto/multisig.h"
+#include "cryptonotecore/TransactionPool.h"
+#include "cryptonotecore/TransactionValidatiorState.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <chrono>
 #include <config/CliHeader.h>
+#include <cstring>
 #include <cxxopts.hpp>
 #include <iostream>
+#include <logging/ConsoleLogger.h>
+#include <unordered_set>
 
 #define PERFORMANCE_ITERATIONS 1000
 #define PERFORMANCE_ITERATIONS_LONG_MULTIPLIER 10
@@ -246,6 +252,174 @@ void benchmarkUnderivePublicKey()
     std::cout << "Time to perform underivePublicKey: " << timePerDerivation / 1000.0 << " ms" << std::endl;
 }
 
+/* Scans outputs the way the wallet synchronizer does - one at a time, and
+   then a block's worth at a time - looking the derived keys up in a set of
+   subwallet spend keys */
+void benchmarkScanOutputs()
+{
+    Crypto::KeyDerivation derivation;
+
+    Crypto::PublicKey txPublicKey;
+    Common::podFromHex("f235acd76ee38ec4f7d95123436200f9ed74f9eb291b1454fbc30742481be1ab", txPublicKey);
+
+    Crypto::SecretKey privateViewKey;
+    Common::podFromHex("89df8c4d34af41a51cfae0267e8254cadd2298f9256439fa1cfa7e25ee606606", privateViewKey);
+
+    Crypto::generate_key_derivation(txPublicKey, privateViewKey, derivation);
+
+    Crypto::PublicKey outputKey;
+    Common::podFromHex("4a078e76cd41a3d3b534b83dc6f2ea2de500b653ca82273b7bfad8045d85a400", outputKey);
+
+    std::unordered_set<Crypto::PublicKey> spendKeys;
+
+    for (size_t i = 0; i < 1000; i++)
+    {
+        Crypto::PublicKey publicKey;
+        Crypto::SecretKey secretKey;
+
+        Crypto::generate_keys(publicKey, secretKey);
+
+        spendKeys.insert(publicKey);
+    }
+
+    const uint64_t outputCount = 200000;
+
+    const uint64_t batchSize = 100;
+
+    uint64_t found = 0;
+
+    auto startTimer = std::chrono::high_resolution_clock::now();
+
+    for (uint64_t i = 0; i < outputCount; i++)
+    {
+        Crypto::PublicKey spendKey;
+
+        Crypto::underive_public_key(derivation, i, outputKey, spendKey);
+
+        found += spendKeys.count(spendKey);
+    }
+
+    const auto singleTime = std::chrono::high_resolution_clock::now() - startTimer;
+
+    std::vector<Crypto::UnderiveRequest> requests(batchSize);
+    std::vector<Crypto::PublicKey> spendKeysFound;
+    std::vector<bool> valid;
+
+    startTimer = std::chrono::high_resolution_clock::now();
+
+    for (uint64_t i = 0; i < outputCount; i += batchSize)
+    {
+        for (uint64_t j = 0; j < batchSize; j++)
+        {
+            requests[j] = {derivation, i + j, outputKey};
+        }
+
+        Crypto::underive_public_keys(requests, spendKeysFound, valid);
+
+        for (uint64_t j = 0; j < batchSize; j++)
+        {
+            found += valid[j] && spendKeys.count(spendKeysFound[j]);
+        }
+    }
+
+    const auto batchTime = std::chrono::high_resolution_clock::now() - startTimer;
+
+    const auto outputsPerSecond = [&](const auto elapsed) {
+        return outputCount * 1000000 / std::max<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), 1);
+    };
+
+    std::cout << "Outputs scanned per second, one at a time: " << outputsPerSecond(singleTime) << std::endl;
+
+    std::cout << "Outputs scanned per second, " << batchSize << " at a time: " << outputsPerSecond(batchTime)
+              << std::endl;
+
+    /* Use the result to prevent optimization */
+    if (found != 0)
+    {
+        std::cout << "Unexpectedly found " << found << " outputs" << std::endl;
+    }
+}
+
+/* Times picking the transactions for a block template from pools of
+   increasing size, against copying every pool transaction out as we used
+   to, before doing any work on them */
+void benchmarkBlockTemplate()
+{
+    const size_t maxTotalSize = 100000;
+
+    for (const size_t poolSize : {1000, 10000, 50000})
+    {
+        TransactionPool pool(std::make_shared<Logging::ConsoleLogger>(Logging::WARNING));
+
+        for (size_t i = 0; i < poolSize; i++)
+        {
+            /* Distinct key images and keys, the contents don't matter */
+            const Crypto::Hash seed = Crypto::cn_fast_hash(&i, sizeof(i));
+
+            Transaction transaction;
+            transaction.version = 1;
+            transaction.unlockTime = 0;
+
+            KeyInput input;
+            input.amount = 1000000 + i;
+            input.outputIndexes = {0, 1, 2};
+            std::memcpy(input.keyImage.data, seed.data, sizeof(seed.data));
+
+            transaction.inputs.push_back(input);
+            transaction.signatures.push_back(std::vector<Crypto::Signature>(input.outputIndexes.size()));
+
+            KeyOutput target;
+            std::memcpy(target.key.data, seed.data, sizeof(seed.data));
+
+            transaction.outputs.push_back({1000000, target});
+
+            TransactionValidatorState state;
+            state.spentKeyImages.insert(input.keyImage);
+
+            pool.pushTransaction(CachedTransaction(std::move(transaction)), std::move(state));
+        }
+
+        const uint64_t iterations = 100;
+
+        uint64_t total = 0;
+
+        auto startTimer = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            total += pool.getPoolTransactions().size();
+        }
+
+        const auto copyTime = std::chrono::high_resolution_clock::now() - startTimer;
+
+        startTimer = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            total += pool.selectTransactionsForBlockTemplate(maxTotalSize, [](const CachedTransaction &) {
+                return true;
+            }).transactionHashes.size();
+        }
+
+        const auto selectTime = std::chrono::high_resolution_clock::now() - startTimer;
+
+        const auto microsecondsPerTemplate = [&](const auto elapsed) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / iterations;
+        };
+
+        std::cout << "Block template with " << poolSize << " pool transactions, copying the pool: "
+                  << microsecondsPerTemplate(copyTime) << " us, selecting: " << microsecondsPerTemplate(selectTime)
+                  << " us" << std::endl;
+
+        /* Use the result to prevent optimization */
+        if (total == 0)
+        {
+            std::cout << "Unexpectedly empty pool" << std::endl;
+        }
+    }
+}
+
 void benchmarkGenerateKeyDerivation()
 {
     Crypto::KeyDerivation derivation;
@@ -273,6 +447,84 @@ void benchmarkGenerateKeyDerivation()
     std::cout << "Time to perform generateKeyDerivation: " << timePerDerivation / 1000.0 << " ms" << std::endl;
 }
 
+/* Reports the throughput of each of the key primitives wallet scanning and
+   transaction construction are built on, so a regression in any one of
+   them stands out */
+void benchmarkKeyPrimitives()
+{
+    Crypto::PublicKey txPublicKey;
+    Common::podFromHex("f235acd76ee38ec4f7d95123436200f9ed74f9eb291b1454fbc30742481be1ab", txPublicKey);
+
+    Crypto::SecretKey privateViewKey;
+    Common::podFromHex("89df8c4d34af41a51cfae0267e8254cadd2298f9256439fa1cfa7e25ee606606", privateViewKey);
+
+    Crypto::PublicKey outputKey;
+    Common::podFromHex("4a078e76cd41a3d3b534b83dc6f2ea2de500b653ca82273b7bfad8045d85a400", outputKey);
+
+    Crypto::KeyDerivation derivation;
+    Crypto::generate_key_derivation(txPublicKey, privateViewKey, derivation);
+
+    const uint64_t iterations = 20000;
+
+    /* Accumulates the results to prevent optimization */
+    uint64_t sink = 0;
+
+    const auto measure = [&](const std::string &name, const auto &primitive) {
+        const auto startTimer = std::chrono::high_resolution_clock::now();
+
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            sink += primitive(i);
+        }
+
+        const auto elapsedTime = std::chrono::high_resolution_clock::now() - startTimer;
+
+        const uint64_t opsPerSecond = iterations * 1000000
+                                      / std::max<uint64_t>(
+                                          std::chrono::duration_cast<std::chrono::microseconds>(elapsedTime).count(), 1);
+
+        std::cout << name << ": " << opsPerSecond << " ops/s" << std::endl;
+    };
+
+    measure("generate_key_derivation", [&](const uint64_t) {
+        return Crypto::generate_key_derivation(txPublicKey, privateViewKey, derivation);
+    });
+
+    measure("derivation_to_scalar", [&](const uint64_t i) {
+        Crypto::EllipticCurveScalar scalar;
+        Crypto::derivation_to_scalar(derivation, i, scalar);
+        return scalar.data[0];
+    });
+
+    measure("derive_public_key", [&](const uint64_t i) {
+        Crypto::PublicKey derivedKey;
+        return Crypto::derive_public_key(derivation, i, outputKey, derivedKey);
+    });
+
+    measure("underive_public_key", [&](const uint64_t i) {
+        Crypto::PublicKey spendKey;
+        return Crypto::underive_public_key(derivation, i, outputKey, spendKey);
+    });
+
+    measure("secret_key_to_public_key", [&](const uint64_t) {
+        Crypto::PublicKey publicKey;
+        return Crypto::secret_key_to_public_key(privateViewKey, publicKey);
+    });
+
+    measure("check_key", [&](const uint64_t) { return Crypto::check_key(outputKey); });
+
+    measure("generate_key_image", [&](const uint64_t) {
+        Crypto::KeyImage keyImage;
+        Crypto::generate_key_image(outputKey, privateViewKey, keyImage);
+        return keyImage.data[0];
+    });
+
+    if (sink == 0)
+    {
+        std::cout << "Unexpectedly failed every operation" << std::endl;
+    }
+}
+
 void TestDeterministicSubwalletCreation(
     const std::string baseSpendKey,
     const uint64_t subWalletIndex,
@@ -723,7 +975,10 @@ int main(int argc, char **argv)
             std::cout << "\nPerformance Tests: Please wait, this may take a while depending on your system...\n\n";
 
             benchmarkUnderivePublicKey();
+            benchmarkScanOutputs();
+            benchmarkBlockTemplate();
             benchmarkGenerateKeyDerivation();
+            benchmarkKeyPrimitives();
 
             BENCHMARK(cn_slow_hash_v0, o_iterations);
             BENCHMARK(cn_slow_hash_v1, o_iterations);
@@ -183,9 +183,25 @@ int main(int argc, char *argv[])
         std::vector<std::string> removablePaths = {
             config.dataDirectory + "/" + CryptoNote::parameters::CRYPTONOTE_BLOCKS_FILENAME,
             config.dataDirectory + "/" + CryptoNote::parameters::CRYPTONOTE_BLOCKINDEXES_FILENAME,
+            config.dataDirectory + "/" + CryptoNote::parameters::CRYPTONOTE_BLOCKOFFSETS_FILENAME,
             config.dataDirectory + "/" + CryptoNote::parameters::P2P_NET_DATA_FILENAME,
             config.dataDirectory + "/DB"};
 
+        /* The block storage segments after the first, which is the blocks file */
+        for (uint32_t segment = 1;; segment++)
+        {
+            const std::string segmentPath = config.dataDirectory + "/"
+                                            + CryptoNote::parameters::CRYPTONOTE_BLOCKS_FILENAME + "."
+                                            + std::to_string(segment);
+
+            if (!fs::exists(segmentPath))
+            {
+                break;
+            }
+
+            removablePaths.push_back(segmentPath);
+        }
+
         for (const auto &path : removablePaths)
         {
             fs::remove_all(fs::path(path), ec);
@@ -315,7 +331,7 @@ int main(int argc, char *argv[])
         {
             logger(INFO) << "Rewinding blockchain to: " << config.rewindToHeight << std::endl;
 
-            std::unique_ptr<IMainChainStorage> mainChainStorage = createSwappedMainChainStorage(config.dataDirectory, currency);
+            std::unique_ptr<IMainChainStorage> mainChainStorage = createMainChainStorage(config.dataDirectory, currency);
 
             mainChainStorage->rewindTo(config.rewindToHeight);
 
@@ -393,7 +409,7 @@ int main(int argc, char *argv[])
         System::Dispatcher dispatcher;
         logger(INFO) << "Initializing core...";
 
-        std::unique_ptr<IMainChainStorage> tmainChainStorage = createSwappedMainChainStorage(config.dataDirectory, currency);
+        std::unique_ptr<IMainChainStorage> tmainChainStorage = createMainChainStorage(config.dataDirectory, currency);
 
         const auto ccore = std::make_shared<CryptoNote::Core>(
             currency,
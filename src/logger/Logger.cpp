@@ -118,12 +118,14 @@ namespace Logger
         throw std::invalid_argument("Invalid log category given");
     }
 
-    void Logger::log(const std::string message, const LogLevel level, const std::vector<LogCategory> categories) const
+    void Logger::log(const std::string &message, const LogLevel level, const std::vector<LogCategory> &categories) const
     {
-        if (level == DISABLED)
+        /* Nothing is formatted unless it is going to be logged */
+        if (!isEnabled(level))
         {
             return;
         }
+
         const std::time_t now = std::time(nullptr);
         std::stringstream output;
         output << "[" << std::put_time(std::localtime(&now), "%H:%M:%S") << "] "
@@ -133,18 +135,21 @@ namespace Logger
             output << " [" << logCategoryToString(category) << "]";
         }
         output << ": " << message;
-        if (level <= m_logLevel)
+
+        /* If the user provides a callback, log to that instead */
+        if (m_callback)
         {
-            /* If the user provides a callback, log to that instead */
-            if (m_callback)
-            {
-                m_callback(output.str(), message, level, categories);
-            }
-            else
-            {
-                std::cout << output.str() << std::endl;
-            }
+            m_callback(output.str(), message, level, categories);
         }
+        else
+        {
+            std::cout << output.str() << std::endl;
+        }
+    }
+
+    bool Logger::isEnabled(const LogLevel level) const
+    {
+        return level != DISABLED && level <= m_logLevel.load(std::memory_order_relaxed);
     }
 
     void Logger::setLogLevel(const LogLevel level)
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
 #include <string>
 #include <vector>
@@ -42,7 +43,11 @@ namespace Logger
       public:
         Logger() {};
 
-        void log(const std::string message, const LogLevel level, const std::vector<LogCategory> categories) const;
+        void log(const std::string &message, const LogLevel level, const std::vector<LogCategory> &categories) const;
+
+        /* Whether a message at this level would be logged, for skipping
+           building messages that won't be */
+        bool isEnabled(const LogLevel level) const;
 
         void setLogLevel(const LogLevel level);
 
@@ -53,8 +58,8 @@ namespace Logger
                                 const std::vector<LogCategory> categories)> callback);
 
       private:
-        /* Logging disabled by default */
-        LogLevel m_logLevel = DISABLED;
+        /* Logging disabled by default. Read on every message, from any thread */
+        std::atomic<LogLevel> m_logLevel {DISABLED};
 
         std::function<void(
             const std::string prettyMessage,
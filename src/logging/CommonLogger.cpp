@@ -93,6 +93,11 @@ namespace Logging
         logLevel = level;
     }
 
+    bool CommonLogger::isEnabled(Level level) const
+    {
+        return level <= logLevel.load(std::memory_order_relaxed);
+    }
+
     CommonLogger::CommonLogger(Level level): logLevel(level), pattern("%D %T %L [%C] ") {}
 
     void CommonLogger::doLogString(const std::string &message) {}
@@ -7,6 +7,7 @@
 
 #include "ILogger.h"
 
+#include <atomic>
 #include <set>
 
 namespace Logging
@@ -24,12 +25,15 @@ namespace Logging
 
         virtual void setMaxLevel(Level level);
 
+        virtual bool isEnabled(Level level) const override;
+
         void setPattern(const std::string &pattern);
 
       protected:
         std::set<std::string> disabledCategories;
 
-        Level logLevel;
+        /* Read on every message, from any thread */
+        std::atomic<Level> logLevel;
 
         std::string pattern;
 
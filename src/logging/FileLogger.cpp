@@ -9,6 +9,12 @@ namespace Logging
 {
     FileLogger::FileLogger(Level level): StreamLogger(level) {}
 
+    FileLogger::~FileLogger()
+    {
+        /* The writer thread must be done with fileStream before it goes */
+        stopWriting();
+    }
+
     void FileLogger::init(const std::string &fileName)
     {
         fileStream.open(fileName, std::ios::app);
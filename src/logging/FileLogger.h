@@ -16,6 +16,8 @@ namespace Logging
       public:
         FileLogger(Level level = DEBUGGING);
 
+        ~FileLogger();
+
         void init(const std::string &filename);
 
       private:
@@ -67,6 +67,13 @@ namespace Logging
             Level level,
             boost::posix_time::ptime time,
             const std::string &body) = 0;
+
+        /* Whether a message at this level would be logged anywhere, so the
+           caller can skip building it */
+        virtual bool isEnabled(Level level) const
+        {
+            return true;
+        }
     };
 
 #ifndef ENDL
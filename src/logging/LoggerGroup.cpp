@@ -28,4 +28,12 @@ namespace Logging
         }
     }
 
+    bool LoggerGroup::isEnabled(Level level) const
+    {
+        return CommonLogger::isEnabled(level)
+               && std::any_of(loggers.begin(), loggers.end(), [level](const ILogger *logger) {
+                      return logger->isEnabled(level);
+                  });
+    }
+
 } // namespace Logging
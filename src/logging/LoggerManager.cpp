@@ -23,6 +23,18 @@ namespace Logging
         LoggerGroup::operator()(category, level, time, body);
     }
 
+    bool LoggerManager::isEnabled(Level level) const
+    {
+        /* Most messages are above the global level, so skip the lock for those */
+        if (!CommonLogger::isEnabled(level))
+        {
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(reconfigureLock);
+        return LoggerGroup::isEnabled(level);
+    }
+
     void LoggerManager::configure(const JsonValue &val)
     {
         std::unique_lock<std::mutex> lock(reconfigureLock);
@@ -25,10 +25,12 @@ namespace Logging
             operator()(const std::string &category, Level level, boost::posix_time::ptime time, const std::string &body)
                 override;
 
+        virtual bool isEnabled(Level level) const override;
+
       private:
         std::vector<std::unique_ptr<CommonLogger>> loggers;
 
-        std::mutex reconfigureLock;
+        mutable std::mutex reconfigureLock;
     };
 
 } // namespace Logging
@@ -11,16 +11,22 @@ namespace Logging
         std::shared_ptr<ILogger> logger,
         const std::string &category,
         Level level,
-        const std::string &color):
+        const std::string &color,
+        bool enabled):
         std::ostream(this),
         std::streambuf(),
         logger(logger),
-        category(category),
+        category(enabled ? category : std::string()),
         logLevel(level),
-        message(color),
-        timestamp(boost::posix_time::microsec_clock::local_time()),
-        gotText(false)
+        message(enabled ? color : std::string()),
+        timestamp(enabled ? boost::posix_time::microsec_clock::local_time() : boost::posix_time::ptime()),
+        gotText(false),
+        enabled(enabled)
     {
+        if (!enabled)
+        {
+            setstate(std::ios::badbit);
+        }
     }
 
     LoggerMessage::~LoggerMessage()
@@ -41,7 +47,8 @@ namespace Logging
         logger(other.logger),
         message(other.message),
         timestamp(boost::posix_time::microsec_clock::local_time()),
-        gotText(false)
+        gotText(false),
+        enabled(other.enabled)
     {
         this->set_rdbuf(this);
     }
@@ -55,7 +62,8 @@ namespace Logging
         logger(other.logger),
         message(other.message),
         timestamp(boost::posix_time::microsec_clock::local_time()),
-        gotText(false)
+        gotText(false),
+        enabled(other.enabled)
     {
         if (this != &other)
         {
@@ -102,6 +110,11 @@ namespace Logging
 
     int LoggerMessage::sync()
     {
+        if (!enabled)
+        {
+            return 0;
+        }
+
         (*logger)(category, logLevel, timestamp, message);
         gotText = false;
         message = DEFAULT;
@@ -18,7 +18,8 @@ namespace Logging
             std::shared_ptr<ILogger> logger,
             const std::string &category,
             Level level,
-            const std::string &color);
+            const std::string &color,
+            bool enabled = true);
 
         ~LoggerMessage();
 
@@ -46,6 +47,10 @@ namespace Logging
         boost::posix_time::ptime timestamp;
 
         bool gotText;
+
+        /* When false the stream is left in a failed state, so anything
+           written to it is dropped without being formatted */
+        bool enabled;
     };
 
 } // namespace Logging
@@ -15,7 +15,12 @@ namespace Logging
 
     LoggerMessage LoggerRef::operator()(Level level, const std::string &color) const
     {
-        return LoggerMessage(logger, category, level, color);
+        return LoggerMessage(logger, category, level, color, logger->isEnabled(level));
+    }
+
+    bool LoggerRef::isEnabled(Level level) const
+    {
+        return logger->isEnabled(level);
     }
 
     std::shared_ptr<ILogger> LoggerRef::getLogger() const
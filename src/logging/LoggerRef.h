@@ -15,8 +15,13 @@ namespace Logging
       public:
         LoggerRef(std::shared_ptr<ILogger> logger, const std::string &category);
 
+        /* Messages at a level nothing will log are thrown away as they are
+           written, without being formatted */
         LoggerMessage operator()(Level level = INFO, const std::string &color = DEFAULT) const;
 
+        /* For skipping work done only to build a log message */
+        bool isEnabled(Level level) const;
+
         std::shared_ptr<ILogger> getLogger() const;
 
       private:
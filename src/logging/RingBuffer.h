@@ -0,0 +1,126 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace Logging
+{
+    /* A bounded queue which any number of threads can push to and pop from
+       without taking a lock. Each slot carries a sequence number saying
+       whether it is waiting to be written or read in the current lap
+       around the buffer.
+
+       Capacity must be a power of two. Push fails rather than waiting when
+       the buffer is full. */
+    template<typename T> class RingBuffer
+    {
+      public:
+        explicit RingBuffer(const size_t capacity): m_slots(capacity), m_mask(capacity - 1)
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                m_slots[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        RingBuffer(const RingBuffer &) = delete;
+
+        RingBuffer &operator=(const RingBuffer &) = delete;
+
+        bool push(T &&item)
+        {
+            size_t position = m_pushPosition.load(std::memory_order_relaxed);
+            Slot *slot;
+
+            for (;;)
+            {
+                slot = &m_slots[position & m_mask];
+
+                const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+
+                if (difference == 0)
+                {
+                    if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                /* Still holding the item from the last lap, so we're full */
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = m_pushPosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            slot->item = std::move(item);
+            slot->sequence.store(position + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        bool pop(T &item)
+        {
+            size_t position = m_popPosition.load(std::memory_order_relaxed);
+            Slot *slot;
+
+            for (;;)
+            {
+                slot = &m_slots[position & m_mask];
+
+                const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+                const auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+
+                if (difference == 0)
+                {
+                    if (m_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                /* Not written yet, so we're empty */
+                else if (difference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    position = m_popPosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            item = std::move(slot->item);
+            slot->sequence.store(position + m_mask + 1, std::memory_order_release);
+
+            return true;
+        }
+
+      private:
+        struct Slot
+        {
+            std::atomic<size_t> sequence;
+
+            T item;
+        };
+
+        std::vector<Slot> m_slots;
+
+        const size_t m_mask;
+
+        /* On their own cache lines, so pushing threads don't slow down the
+           popping one */
+        alignas(64) std::atomic<size_t> m_pushPosition {0};
+
+        alignas(64) std::atomic<size_t> m_popPosition {0};
+    };
+
+} // namespace Logging
@@ -5,40 +5,159 @@
 
 #include "StreamLogger.h"
 
+#include <algorithm>
 #include <iostream>
-#include <sstream>
 
 namespace Logging
 {
-    StreamLogger::StreamLogger(Level level): CommonLogger(level), stream(nullptr) {}
+    namespace
+    {
+        /* Messages waiting to be written, must be a power of two */
+        const size_t QUEUE_SIZE = 8192;
+
+        /* How long the writer sleeps for if it misses being woken up */
+        const std::chrono::milliseconds WRITER_WAKE_INTERVAL(100);
+    } // namespace
+
+    StreamLogger::StreamLogger(Level level):
+        CommonLogger(level),
+        stream(nullptr),
+        queue(QUEUE_SIZE),
+        droppedMessages(0),
+        stopping(false)
+    {
+        writerThread = std::thread(&StreamLogger::writeMessages, this);
+    }
+
+    StreamLogger::StreamLogger(std::ostream &stream, Level level):
+        CommonLogger(level),
+        stream(&stream),
+        queue(QUEUE_SIZE),
+        droppedMessages(0),
+        stopping(false)
+    {
+        writerThread = std::thread(&StreamLogger::writeMessages, this);
+    }
 
-    StreamLogger::StreamLogger(std::ostream &stream, Level level): CommonLogger(level), stream(&stream) {}
+    StreamLogger::~StreamLogger()
+    {
+        stopWriting();
+    }
 
     void StreamLogger::attachToStream(std::ostream &stream)
     {
+        std::lock_guard<std::mutex> lock(mutex);
         this->stream = &stream;
     }
 
-    void StreamLogger::doLogString(const std::string &message)
+    void StreamLogger::
+        operator()(const std::string &category, Level level, boost::posix_time::ptime time, const std::string &body)
     {
-        if (stream != nullptr && stream->good())
+        CommonLogger::operator()(category, level, time, body);
+
+        if (level <= ERROR)
         {
             std::lock_guard<std::mutex> lock(mutex);
-            bool readingText = true;
-            for (size_t charPos = 0; charPos < message.size(); ++charPos)
+            writeQueuedMessages();
+        }
+    }
+
+    void StreamLogger::doLogString(const std::string &message)
+    {
+        if (!queue.push(std::string(message)))
+        {
+            droppedMessages++;
+        }
+
+        wakeWriter.notify_one();
+    }
+
+    void StreamLogger::stopWriting()
+    {
+        if (writerThread.joinable())
+        {
+            stopping = true;
+            wakeWriter.notify_one();
+            writerThread.join();
+        }
+    }
+
+    void StreamLogger::writeMessages()
+    {
+        for (;;)
+        {
+            /* Checked before emptying the queue, so everything queued before
+               we were stopped is written */
+            const bool stop = stopping;
+
             {
-                if (message[charPos] == ILogger::COLOR_DELIMETER)
-                {
-                    readingText = !readingText;
-                }
-                else if (readingText)
-                {
-                    *stream << message[charPos];
-                }
+                std::lock_guard<std::mutex> lock(mutex);
+                writeQueuedMessages();
             }
 
+            if (stop)
+            {
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeWriter.wait_for(lock, WRITER_WAKE_INTERVAL);
+        }
+    }
+
+    void StreamLogger::writeQueuedMessages()
+    {
+        std::string message;
+        bool wroteMessages = false;
+
+        while (queue.pop(message))
+        {
+            writeMessage(message);
+            wroteMessages = true;
+        }
+
+        if (const uint64_t dropped = droppedMessages.exchange(0))
+        {
+            writeMessage(std::to_string(dropped) + " log messages dropped\n");
+            wroteMessages = true;
+        }
+
+        if (wroteMessages && stream != nullptr && stream->good())
+        {
             *stream << std::flush;
         }
     }
 
+    void StreamLogger::writeMessage(const std::string &message)
+    {
+        if (stream == nullptr || !stream->good())
+        {
+            return;
+        }
+
+        /* Colours are between pairs of delimiters, write what is outside them */
+        size_t textStart = 0;
+
+        while (textStart < message.size())
+        {
+            const size_t colorStart = std::min(message.find(ILogger::COLOR_DELIMETER, textStart), message.size());
+
+            stream->write(message.data() + textStart, colorStart - textStart);
+
+            if (colorStart == message.size())
+            {
+                break;
+            }
+
+            const size_t colorEnd = message.find(ILogger::COLOR_DELIMETER, colorStart + 1);
+
+            if (colorEnd == std::string::npos)
+            {
+                break;
+            }
+
+            textStart = colorEnd + 1;
+        }
+    }
+
 } // namespace Logging
@@ -6,11 +6,18 @@
 #pragma once
 
 #include "CommonLogger.h"
+#include "RingBuffer.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 
 namespace Logging
 {
+    /* Messages are queued and written to the stream by a thread of our own,
+       so logging never waits on the stream. If the queue fills up, messages
+       are dropped and a count of them is written in their place. */
     class StreamLogger : public CommonLogger
     {
       public:
@@ -18,16 +25,48 @@ namespace Logging
 
         StreamLogger(std::ostream &stream, Level level = DEBUGGING);
 
+        ~StreamLogger();
+
         void attachToStream(std::ostream &stream);
 
+        /* Errors are written out before returning, in case we are about
+           to exit */
+        virtual void
+            operator()(const std::string &category, Level level, boost::posix_time::ptime time, const std::string &body)
+                override;
+
       protected:
         virtual void doLogString(const std::string &message) override;
 
+        /* Writes out what is queued and stops the writer thread. Classes
+           owning the stream must call this before it is destroyed. */
+        void stopWriting();
+
       protected:
         std::ostream *stream;
 
       private:
+        void writeMessages();
+
+        /* Empties the queue into the stream, with mutex held */
+        void writeQueuedMessages();
+
+        void writeMessage(const std::string &message);
+
+        /* Held while writing to or changing the stream */
         std::mutex mutex;
+
+        RingBuffer<std::string> queue;
+
+        std::atomic<uint64_t> droppedMessages;
+
+        std::atomic<bool> stopping;
+
+        std::mutex wakeMutex;
+
+        std::condition_variable wakeWriter;
+
+        std::thread writerThread;
     };
 
 } // namespace Logging
@@ -8,6 +8,7 @@
 
 #include <common/CryptoNoteTools.h>
 #include <common/Varint.h>
+#include <cstring>
 #include <serialization/CryptoNoteSerialization.h>
 #include <serialization/SerializationTools.h>
 
@@ -83,9 +84,9 @@ Crypto::Hash getMerkleRoot(const CryptoNote::BlockTemplate &block)
 
 Crypto::Hash getBlockLongHash(const CryptoNote::BlockTemplate &block)
 {
-    const std::vector<uint8_t> rawHashingBlock = block.majorVersion == CryptoNote::BLOCK_MAJOR_VERSION_1
-                                                     ? getBlockHashingBinaryArray(block)
-                                                     : getParentBlockHashingBinaryArray(block, true);
+    size_t nonceOffset;
+
+    const std::vector<uint8_t> rawHashingBlock = getBlockLongHashingBinaryArray(block, nonceOffset);
 
     Crypto::Hash hash;
 
@@ -102,3 +103,28 @@ Crypto::Hash getBlockLongHash(const CryptoNote::BlockTemplate &block)
         throw std::runtime_error("Unknown block major version.");
     }
 }
+
+std::vector<uint8_t> getBlockLongHashingBinaryArray(const CryptoNote::BlockTemplate &block, size_t &nonceOffset)
+{
+    /* Both the block header and the parent block start with the major and
+       minor version, the timestamp and the previous block hash, followed by
+       the nonce as four raw bytes */
+    const bool isVersion1 = block.majorVersion == CryptoNote::BLOCK_MAJOR_VERSION_1;
+
+    const uint8_t majorVersion = isVersion1 ? block.majorVersion : block.parentBlock.majorVersion;
+    const uint8_t minorVersion = isVersion1 ? block.minorVersion : block.parentBlock.minorVersion;
+
+    nonceOffset = Tools::get_varint_data(majorVersion).size() + Tools::get_varint_data(minorVersion).size()
+                  + Tools::get_varint_data(block.timestamp).size() + sizeof(Crypto::Hash);
+
+    std::vector<uint8_t> binaryArray =
+        isVersion1 ? getBlockHashingBinaryArray(block) : getParentBlockHashingBinaryArray(block, true);
+
+    if (binaryArray.size() < nonceOffset + sizeof(block.nonce)
+        || std::memcmp(binaryArray.data() + nonceOffset, &block.nonce, sizeof(block.nonce)) != 0)
+    {
+        throw std::runtime_error("Can't find the nonce in the hashing blob");
+    }
+
+    return binaryArray;
+}
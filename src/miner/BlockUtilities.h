@@ -24,3 +24,8 @@ Crypto::Hash getBlockHash(const CryptoNote::BlockTemplate &block);
 Crypto::Hash getMerkleRoot(const CryptoNote::BlockTemplate &block);
 
 Crypto::Hash getBlockLongHash(const CryptoNote::BlockTemplate &block);
+
+/* The data getBlockLongHash() hashes, along with where the nonce is in it,
+   so a miner can try each nonce by overwriting those bytes, rather than
+   serializing the whole block again */
+std::vector<uint8_t> getBlockLongHashingBinaryArray(const CryptoNote::BlockTemplate &block, size_t &nonceOffset);
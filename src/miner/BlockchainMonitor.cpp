@@ -9,9 +9,12 @@
 #include "rpc/CoreRpcServerCommandsDefinitions.h"
 #include "rpc/JsonRpc.h"
 
+#include <atomic>
+#include <memory>
 #include <system/EventLock.h>
 #include <system/InterruptedException.h>
 #include <system/Timer.h>
+#include <thread>
 #include <utilities/ColouredMsg.h>
 
 using json = nlohmann::json;
@@ -19,20 +22,57 @@ using json = nlohmann::json;
 BlockchainMonitor::BlockchainMonitor(
     System::Dispatcher &dispatcher,
     const size_t pollingInterval,
+    const std::string miningAddress,
+    const std::string &daemonHost,
+    const uint16_t daemonPort,
     const std::shared_ptr<httplib::Client> httpClient):
 
     m_dispatcher(dispatcher),
     m_pollingInterval(pollingInterval),
+    m_miningAddress(miningAddress),
     m_stopped(false),
     m_sleepingContext(dispatcher),
-    m_httpClient(httpClient)
+    m_httpClient(httpClient),
+    m_longPollClient(std::make_shared<httplib::Client>(daemonHost.c_str(), daemonPort, 10 /* 10 second timeout */))
 {
 }
 
-void BlockchainMonitor::waitBlockchainUpdate()
+namespace
+{
+    /* How often we check if a long poll request has come back */
+    const auto LONG_POLL_CHECK_INTERVAL = std::chrono::milliseconds(100);
+
+    struct LongPollResult
+    {
+        std::atomic<bool> done = false;
+
+        /* The long poll id of the template the daemon returned, if the
+           request succeeded */
+        std::optional<std::string> longPollId;
+    };
+} // namespace
+
+void BlockchainMonitor::waitBlockchainUpdate(const std::optional<std::string> &longPollId)
 {
     m_stopped = false;
 
+    if (longPollId)
+    {
+        longPoll(*longPollId);
+    }
+    else
+    {
+        pollLastBlockHash();
+    }
+
+    if (m_stopped)
+    {
+        throw System::InterruptedException();
+    }
+}
+
+void BlockchainMonitor::pollLastBlockHash()
+{
     auto lastBlockHash = requestLastBlockHash();
 
     while (!lastBlockHash && !m_stopped)
@@ -63,13 +103,86 @@ void BlockchainMonitor::waitBlockchainUpdate()
             break;
         }
     }
+}
 
-    if (m_stopped)
+void BlockchainMonitor::longPoll(const std::string &longPollId)
+{
+    const json j = {{"jsonrpc", "2.0"},
+                    {"method", "getblocktemplate"},
+                    {"params", {{"wallet_address", m_miningAddress}, {"reserve_size", 0}, {"longpollid", longPollId}}}};
+
+    const std::string body = j.dump();
+
+    while (!m_stopped)
     {
-        throw System::InterruptedException();
+        auto result = std::make_shared<LongPollResult>();
+
+        /* The daemon holds the request open for a while, and blocking the
+           dispatcher for that long would hold up submitting a block we've
+           found, so the request is made on its own thread. If we're stopped
+           in the meantime, it finishes on its own and the result is dropped. */
+        std::thread([result, httpClient = m_longPollClient, body]() {
+            auto res = httpClient->Post("/json_rpc", body, "application/json");
+
+            if (res && res->status == 200)
+            {
+                try
+                {
+                    const json response = json::parse(res->body);
+
+                    const auto &blockTemplate = response.at("result");
+
+                    if (blockTemplate.at("status").get<std::string>() == "OK")
+                    {
+                        result->longPollId = blockTemplate.at("longpollid").get<std::string>();
+                    }
+                }
+                catch (const json::exception &)
+                {
+                }
+            }
+
+            result->done = true;
+        }).detach();
+
+        while (!result->done && !m_stopped)
+        {
+            sleep(LONG_POLL_CHECK_INTERVAL);
+        }
+
+        if (m_stopped)
+        {
+            break;
+        }
+
+        if (!result->longPollId)
+        {
+            std::cout << WarningMsg("Failed to wait for a new block template - Is your daemon open?\n");
+
+            sleep(std::chrono::seconds(m_pollingInterval));
+
+            continue;
+        }
+
+        /* The daemon returns the same template if nothing changed before its
+           timeout, in which case we just ask again */
+        if (*result->longPollId != longPollId)
+        {
+            break;
+        }
     }
 }
 
+void BlockchainMonitor::sleep(const std::chrono::milliseconds duration)
+{
+    m_sleepingContext.spawn([this, duration]() {
+        System::Timer timer(m_dispatcher);
+        timer.sleep(duration);
+    });
+
+    m_sleepingContext.wait();
+}
+
 void BlockchainMonitor::stop()
 {
     m_stopped = true;
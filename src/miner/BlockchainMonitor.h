@@ -8,7 +8,9 @@
 #include "CryptoTypes.h"
 #include "httplib.h"
 
+#include <chrono>
 #include <optional>
+#include <string>
 #include <system/ContextGroup.h>
 #include <system/Dispatcher.h>
 #include <system/Event.h>
@@ -19,9 +21,15 @@ class BlockchainMonitor
     BlockchainMonitor(
         System::Dispatcher &dispatcher,
         const size_t pollingInterval,
+        const std::string miningAddress,
+        const std::string &daemonHost,
+        const uint16_t daemonPort,
         const std::shared_ptr<httplib::Client> httpClient);
 
-    void waitBlockchainUpdate();
+    /* Returns once the block template should be refreshed. With a long poll
+       id, the daemon holds our request open until the template changes,
+       otherwise we poll for a new top block every pollingInterval seconds. */
+    void waitBlockchainUpdate(const std::optional<std::string> &longPollId);
 
     void stop();
 
@@ -30,11 +38,23 @@ class BlockchainMonitor
 
     size_t m_pollingInterval;
 
+    std::string m_miningAddress;
+
     bool m_stopped;
 
     System::ContextGroup m_sleepingContext;
 
     std::optional<Crypto::Hash> requestLastBlockHash();
 
+    void pollLastBlockHash();
+
+    void longPoll(const std::string &longPollId);
+
+    void sleep(const std::chrono::milliseconds duration);
+
     std::shared_ptr<httplib::Client> m_httpClient = nullptr;
+
+    /* A client only allows one request at a time, so long polls get their
+       own, rather than holding up submitting a block until they return */
+    std::shared_ptr<httplib::Client> m_longPollClient = nullptr;
 };
@@ -10,8 +10,10 @@
 
 #include <common/CheckDifficulty.h>
 #include <common/StringTools.h>
+#include <config/CryptoNoteConfig.h>
 #include <crypto/crypto.h>
 #include <crypto/random.h>
+#include <cstring>
 #include <iostream>
 #include <miner/BlockUtilities.h>
 #include <system/InterruptedException.h>
@@ -103,9 +105,26 @@ namespace CryptoNote
         {
             BlockTemplate block = blockTemplate;
 
+            /* Only the nonce changes between attempts, so serialize the block
+               once, and write each nonce over the old one */
+            size_t nonceOffset;
+
+            std::vector<uint8_t> hashingBlob = getBlockLongHashingBinaryArray(block, nonceOffset);
+
+            const auto hashingAlgorithm = HASHING_ALGORITHMS_BY_BLOCK_VERSION.find(block.majorVersion);
+
+            if (hashingAlgorithm == HASHING_ALGORITHMS_BY_BLOCK_VERSION.end())
+            {
+                throw std::runtime_error("Unknown block major version.");
+            }
+
             while (m_state == MiningState::MINING_IN_PROGRESS)
             {
-                Crypto::Hash hash = getBlockLongHash(block);
+                std::memcpy(hashingBlob.data() + nonceOffset, &block.nonce, sizeof(block.nonce));
+
+                Crypto::Hash hash;
+
+                hashingAlgorithm->second(hashingBlob.data(), hashingBlob.size(), hash);
 
                 if (check_hash(hash, difficulty))
                 {
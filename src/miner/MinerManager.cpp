@@ -62,7 +62,13 @@ namespace Miner
         m_contextGroup(dispatcher),
         m_config(config),
         m_miner(dispatcher),
-        m_blockchainMonitor(dispatcher, m_config.scanPeriod, httpClient),
+        m_blockchainMonitor(
+            dispatcher,
+            m_config.scanPeriod,
+            m_config.miningAddress,
+            m_config.daemonHost,
+            m_config.daemonPort,
+            httpClient),
         m_eventOccurred(dispatcher),
         m_lastBlockTimestamp(0),
         m_httpClient(httpClient)
@@ -190,10 +196,10 @@ namespace Miner
 
     void MinerManager::startBlockchainMonitoring()
     {
-        m_contextGroup.spawn([this]() {
+        m_contextGroup.spawn([this, longPollId = m_longPollId]() {
             try
             {
-                m_blockchainMonitor.waitBlockchainUpdate();
+                m_blockchainMonitor.waitBlockchainUpdate(longPollId);
                 pushEvent(BlockchainUpdatedEvent());
             }
             catch (const std::exception &)
@@ -289,6 +295,19 @@ namespace Miner
                     continue;
                 }
 
+                /* Older daemons don't support long polling, in which case we
+                   fall back to polling for a new top block */
+                const auto &result = j.at("result");
+
+                if (result.find("longpollid") != result.end())
+                {
+                    m_longPollId = result.at("longpollid").get<std::string>();
+                }
+                else
+                {
+                    m_longPollId = std::nullopt;
+                }
+
                 return params;
             }
             catch (const json::exception &e)
@@ -12,6 +12,7 @@
 #include "MiningConfig.h"
 #include "logging/LoggerRef.h"
 
+#include <optional>
 #include <queue>
 #include <system/ContextGroup.h>
 #include <system/Event.h>
@@ -54,6 +55,10 @@ namespace Miner
 
         std::shared_ptr<httplib::Client> m_httpClient = nullptr;
 
+        /* Identifies the block template we're mining on, when the daemon
+           supports long polling for a new one */
+        std::optional<std::string> m_longPollId;
+
         void eventLoop();
 
         MinerEvent waitEvent();
@@ -8,10 +8,12 @@
 
 #include <common/CryptoNoteTools.h>
 #include <config/CryptoNoteConfig.h>
+#include <cryptonotecore/BlockchainUtils.h>
 #include <cryptonotecore/CachedBlock.h>
 #include <cryptonotecore/Core.h>
 #include <CryptoNote.h>
 #include <errors/ValidateParameters.h>
+#include <rpc/WalletSyncStream.h>
 #include <utilities/Utilities.h>
 #include <version.h>
 
@@ -88,6 +90,7 @@ void Nigel::swapNode(const std::string daemonHost, const uint16_t daemonPort, co
     m_isBlockchainCache = false;
     m_nodeFeeAddress = "";
     m_nodeFeeAmount = 0;
+    m_useBinarySync = true;
     m_useRawBlocks = true;
 
     m_daemonHost = daemonHost;
@@ -127,13 +130,78 @@ std::tuple<bool, std::vector<WalletTypes::WalletBlockInfo>, std::optional<Wallet
               {"blockCount", m_blockCount.load()},
               {"skipCoinbaseTransactions", skipCoinbaseTransactions}};
 
+    if (m_useBinarySync)
+    {
+        j["compression"] = CryptoNote::WALLET_SYNC_STREAM_ZSTD;
+
+        if (Logger::logger.isEnabled(Logger::TRACE))
+        {
+            Logger::logger.log(
+                "Sending /getwalletsyncdata/binary request to daemon: " + j.dump(),
+                Logger::TRACE,
+                { Logger::SYNC, Logger::DAEMON }
+            );
+        }
+
+        const auto res = m_nodeClient->Post("/getwalletsyncdata/binary", m_requestHeaders, j.dump(), "application/json");
+
+        /* Daemon doesn't support the binary endpoint, fall back to /getrawblocks */
+        if (res && res->status == 404)
+        {
+            m_useBinarySync = false;
+
+            return getWalletSyncData(
+                blockHashCheckpoints,
+                startHeight,
+                startTimestamp,
+                skipCoinbaseTransactions
+            );
+        }
+
+        if (!res || res->status != 200)
+        {
+            std::stringstream stream;
+
+            stream << "Failed to fetch blocks from daemon";
+
+            if (res)
+            {
+                stream << " - got status code " << res->status;
+            }
+
+            Logger::logger.log(stream.str(), Logger::INFO, { Logger::SYNC, Logger::DAEMON });
+
+            return { false, {}, std::nullopt };
+        }
+
+        const bool compressed = res->get_header_value("Content-Encoding") == CryptoNote::WALLET_SYNC_STREAM_ZSTD;
+
+        const auto contents = CryptoNote::readWalletSyncStream(res->body, compressed);
+
+        if (!contents)
+        {
+            Logger::logger.log(
+                "Failed to fetch blocks from daemon - malformed binary wallet sync data",
+                Logger::INFO,
+                { Logger::SYNC, Logger::DAEMON }
+            );
+
+            return { false, {}, std::nullopt };
+        }
+
+        return { true, contents->blocks, contents->topBlock };
+    }
+
     const std::string endpoint = m_useRawBlocks ? "/getrawblocks" : "/getwalletsyncdata";
 
-    Logger::logger.log(
-        "Sending " + endpoint + " request to daemon: " + j.dump(),
-        Logger::TRACE,
-        { Logger::SYNC, Logger::DAEMON }
-    );
+    if (Logger::logger.isEnabled(Logger::TRACE))
+    {
+        Logger::logger.log(
+            "Sending " + endpoint + " request to daemon: " + j.dump(),
+            Logger::TRACE,
+            { Logger::SYNC, Logger::DAEMON }
+        );
+    }
 
     const auto res = m_nodeClient->Post(endpoint, m_requestHeaders, j.dump(), "application/json");
 
@@ -177,12 +245,14 @@ std::tuple<bool, std::vector<WalletTypes::WalletBlockInfo>, std::optional<Wallet
 
                 if (!skipCoinbaseTransactions)
                 {
-                    walletBlock.coinbaseTransaction = CryptoNote::Core::getRawCoinbaseTransaction(block.baseTransaction);
+                    walletBlock.coinbaseTransaction =
+                        CryptoNote::Utils::getRawCoinbaseTransaction(CryptoNote::CachedTransaction(block.baseTransaction));
                 }
 
                 for (const auto &transaction : rawBlock.transactions)
                 {
-                    walletBlock.transactions.push_back(CryptoNote::Core::getRawTransaction(transaction));
+                    walletBlock.transactions.push_back(
+                        CryptoNote::Utils::getRawTransaction(CryptoNote::CachedTransaction(transaction)));
                 }
 
                 items.push_back(walletBlock);
@@ -231,6 +231,10 @@ class Nigel
     /* If the daemon is SSL */
     bool m_daemonSSL = false;
 
+    /* Whether we should use /getwalletsyncdata/binary, before falling back
+       to /getrawblocks */
+    bool m_useBinarySync = true;
+
     /* Whether we should use /getrawblocks instead of /getwalletsyncdata */
     bool m_useRawBlocks = true;
 };
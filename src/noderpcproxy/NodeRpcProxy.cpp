@@ -119,6 +119,7 @@ namespace CryptoNote
         lastLocalBlockHeaderInfo.difficulty = 0;
         lastLocalBlockHeaderInfo.reward = 0;
         m_knownTxs.clear();
+        m_poolSequence = 0;
     }
 
     void NodeRpcProxy::init(const INode::Callback &callback)
@@ -234,8 +235,10 @@ namespace CryptoNote
         std::vector<std::unique_ptr<ITransactionReader>> addedTxs;
         std::vector<Crypto::Hash> deletedTxsIds;
 
-        std::error_code ec =
-            doGetPoolSymmetricDifference(std::move(knownTxs), tailBlock, isBcActual, addedTxs, deletedTxsIds);
+        uint64_t poolSequence = m_poolSequence;
+
+        std::error_code ec = doGetPoolSymmetricDifference(
+            std::move(knownTxs), tailBlock, isBcActual, addedTxs, deletedTxsIds, poolSequence);
         if (ec)
         {
             return true;
@@ -246,6 +249,8 @@ namespace CryptoNote
             return false;
         }
 
+        m_poolSequence = poolSequence;
+
         if (!addedTxs.empty() || !deletedTxsIds.empty())
         {
             updatePoolState(addedTxs, deletedTxsIds);
@@ -597,8 +602,12 @@ namespace CryptoNote
 
         scheduleRequest(
             [this, knownPoolTxIds, knownBlockId, &isBcActual, &newTxs, &deletedTxIds]() mutable -> std::error_code {
+                /* The caller's known transactions aren't ours, so always
+                   diff against them */
+                uint64_t poolSequence = 0;
+
                 return this->doGetPoolSymmetricDifference(
-                    std::move(knownPoolTxIds), knownBlockId, isBcActual, newTxs, deletedTxIds);
+                    std::move(knownPoolTxIds), knownBlockId, isBcActual, newTxs, deletedTxIds, poolSequence);
             },
             callback);
     }
@@ -826,13 +835,15 @@ namespace CryptoNote
         Crypto::Hash knownBlockId,
         bool &isBcActual,
         std::vector<std::unique_ptr<ITransactionReader>> &newTxs,
-        std::vector<Crypto::Hash> &deletedTxIds)
+        std::vector<Crypto::Hash> &deletedTxIds,
+        uint64_t &poolSequence)
     {
         CryptoNote::COMMAND_RPC_GET_POOL_CHANGES_LITE::request req = AUTO_VAL_INIT(req);
         CryptoNote::COMMAND_RPC_GET_POOL_CHANGES_LITE::response rsp = AUTO_VAL_INIT(rsp);
 
         req.tailBlockId = knownBlockId;
         req.knownTxsIds = knownPoolTxIds;
+        req.poolSequence = poolSequence;
 
         m_logger(TRACE) << "Send get_pool_changes_lite request, tailBlockId " << req.tailBlockId;
         std::error_code ec = jsonCommand("/get_pool_changes_lite", "POST", req, rsp);
@@ -845,6 +856,7 @@ namespace CryptoNote
 
         m_logger(TRACE) << "get_pool_changes_lite complete, isTailBlockActual " << rsp.isTailBlockActual;
         isBcActual = rsp.isTailBlockActual;
+        poolSequence = rsp.poolSequence;
 
         deletedTxIds = std::move(rsp.deletedTxsIds);
 
@@ -208,7 +208,8 @@ namespace CryptoNote
             Crypto::Hash knownBlockId,
             bool &isBcActual,
             std::vector<std::unique_ptr<ITransactionReader>> &newTxs,
-            std::vector<Crypto::Hash> &deletedTxIds);
+            std::vector<Crypto::Hash> &deletedTxIds,
+            uint64_t &poolSequence);
 
         void scheduleRequest(std::function<std::error_code()> &&procedure, const Callback &callback);
 
@@ -275,6 +276,10 @@ namespace CryptoNote
         // protect it with mutex if decided to add worker threads
         std::unordered_set<Crypto::Hash> m_knownTxs;
 
+        /* The daemon's pool sequence number m_knownTxs is up to date with, so
+           it only has to send us what changed since */
+        uint64_t m_poolSequence = 0;
+
         bool m_connected;
 
         std::string m_fee_address;
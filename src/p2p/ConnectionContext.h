@@ -39,8 +39,9 @@ namespace CryptoNote
 
         state m_state = state_befor_handshake;
         std::optional<PendingLiteBlock> m_pending_lite_block;
-        std::list<Crypto::Hash> m_needed_objects;
+        std::optional<PendingCompactBlock> m_pending_compact_block;
         std::unordered_set<Crypto::Hash> m_requested_objects;
+        bool m_chain_requested = false;
         uint32_t m_remote_blockchain_height = 0;
         uint32_t m_last_response_height = 0;
     };
@@ -74,6 +75,11 @@ namespace std
 {
     inline std::ostream &operator<<(std::ostream &s, const CryptoNote::CryptoNoteConnectionContext &context)
     {
+        if (!s)
+        {
+            return s;
+        }
+
         return s << "[" << Common::ipAddressToString(context.m_remote_ip) << ":" << context.m_remote_port
                  << (context.m_is_income ? " INC" : " OUT") << "] ";
     }
@@ -5,6 +5,7 @@
 
 #include "LevinProtocol.h"
 
+#include <algorithm>
 #include <system/TcpConnection.h>
 
 using namespace CryptoNote;
@@ -33,6 +34,54 @@ namespace
     };
 #pragma pack(pop)
 
+    bucket_head2 makeHead(
+        const uint32_t command,
+        const uint64_t size,
+        const bool needResponse,
+        const uint32_t flags,
+        const int32_t returnCode)
+    {
+        bucket_head2 head = {0};
+        head.m_signature = LEVIN_SIGNATURE;
+        head.m_cb = size;
+        head.m_have_to_return_data = needResponse;
+        head.m_command = command;
+        head.m_return_code = returnCode;
+        head.m_flags = flags;
+        head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
+        return head;
+    }
+
+    void writeStrict(System::TcpConnection &connection, std::vector<System::TcpConnection::Buffer> buffers)
+    {
+        /* The platforms without a vectored write would return 0 for them */
+        buffers.erase(
+            std::remove_if(buffers.begin(), buffers.end(), [](const auto &buffer) { return buffer.size == 0; }),
+            buffers.end());
+
+        size_t next = 0;
+
+        while (next < buffers.size())
+        {
+            size_t written = connection.write(&buffers[next], buffers.size() - next);
+
+            while (written != 0)
+            {
+                auto &buffer = buffers[next];
+
+                if (written < buffer.size)
+                {
+                    buffer.data += written;
+                    buffer.size -= written;
+                    break;
+                }
+
+                written -= buffer.size;
+                ++next;
+            }
+        }
+    }
+
 } // namespace
 
 bool LevinProtocol::Command::needReply() const
@@ -44,23 +93,35 @@ LevinProtocol::LevinProtocol(System::TcpConnection &connection): m_conn(connecti
 
 void LevinProtocol::sendMessage(uint32_t command, const BinaryArray &out, bool needResponse)
 {
-    bucket_head2 head = {0};
-    head.m_signature = LEVIN_SIGNATURE;
-    head.m_cb = out.size();
-    head.m_have_to_return_data = needResponse;
-    head.m_command = command;
-    head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
-    head.m_flags = LEVIN_PACKET_REQUEST;
+    const bucket_head2 head = makeHead(command, out.size(), needResponse, LEVIN_PACKET_REQUEST, 0);
 
     // write header and body in one operation
-    BinaryArray writeBuffer;
-    writeBuffer.reserve(sizeof(head) + out.size());
+    writeStrict(m_conn, {{reinterpret_cast<const uint8_t *>(&head), sizeof(head)}, {out.data(), out.size()}});
+}
 
-    Common::VectorOutputStream stream(writeBuffer);
-    stream.writeSome(&head, sizeof(head));
-    stream.writeSome(out.data(), out.size());
+void LevinProtocol::sendMessages(const std::vector<Message> &messages)
+{
+    /* Sized up front, the buffers point into it */
+    std::vector<bucket_head2> heads;
+    heads.reserve(messages.size());
+
+    std::vector<System::TcpConnection::Buffer> buffers;
+    buffers.reserve(messages.size() * 2);
+
+    for (const auto &message : messages)
+    {
+        heads.push_back(makeHead(
+            message.command,
+            message.body->size(),
+            message.needResponse,
+            message.isReply ? LEVIN_PACKET_RESPONSE : LEVIN_PACKET_REQUEST,
+            message.returnCode));
+
+        buffers.push_back({reinterpret_cast<const uint8_t *>(&heads.back()), sizeof(bucket_head2)});
+        buffers.push_back({message.body->data(), message.body->size()});
+    }
 
-    writeStrict(writeBuffer.data(), writeBuffer.size());
+    writeStrict(m_conn, std::move(buffers));
 }
 
 bool LevinProtocol::readCommand(Command &cmd)
@@ -103,32 +164,9 @@ bool LevinProtocol::readCommand(Command &cmd)
 
 void LevinProtocol::sendReply(uint32_t command, const BinaryArray &out, int32_t returnCode)
 {
-    bucket_head2 head = {0};
-    head.m_signature = LEVIN_SIGNATURE;
-    head.m_cb = out.size();
-    head.m_have_to_return_data = false;
-    head.m_command = command;
-    head.m_protocol_version = LEVIN_PROTOCOL_VER_1;
-    head.m_flags = LEVIN_PACKET_RESPONSE;
-    head.m_return_code = returnCode;
-
-    BinaryArray writeBuffer;
-    writeBuffer.reserve(sizeof(head) + out.size());
-
-    Common::VectorOutputStream stream(writeBuffer);
-    stream.writeSome(&head, sizeof(head));
-    stream.writeSome(out.data(), out.size());
-
-    writeStrict(writeBuffer.data(), writeBuffer.size());
-}
+    const bucket_head2 head = makeHead(command, out.size(), false, LEVIN_PACKET_RESPONSE, returnCode);
 
-void LevinProtocol::writeStrict(const uint8_t *ptr, size_t size)
-{
-    size_t offset = 0;
-    while (offset < size)
-    {
-        offset += m_conn.write(ptr + offset, size - offset);
-    }
+    writeStrict(m_conn, {{reinterpret_cast<const uint8_t *>(&head), sizeof(head)}, {out.data(), out.size()}});
 }
 
 bool LevinProtocol::readStrict(uint8_t *ptr, size_t size)
@@ -11,6 +11,8 @@
 
 #include <common/MemoryInputStream.h>
 #include <common/VectorOutputStream.h>
+#include <memory>
+#include <vector>
 
 namespace System
 {
@@ -78,6 +80,23 @@ namespace CryptoNote
 
         void sendReply(uint32_t command, const BinaryArray &out, int32_t returnCode);
 
+        struct Message
+        {
+            uint32_t command;
+
+            std::shared_ptr<const BinaryArray> body;
+
+            bool isReply;
+
+            bool needResponse;
+
+            int32_t returnCode;
+        };
+
+        /* Sends the messages with as few writes as possible, without copying
+           their bodies */
+        void sendMessages(const std::vector<Message> &messages);
+
         template<typename T> static bool decode(const BinaryArray &buf, T &value)
         {
             try
@@ -107,8 +126,6 @@ namespace CryptoNote
       private:
         bool readStrict(uint8_t *ptr, size_t size);
 
-        void writeStrict(const uint8_t *ptr, size_t size);
-
         System::TcpConnection &m_conn;
     };
 
@@ -381,9 +381,10 @@ namespace CryptoNote
         const BinaryArray &data_buff,
         const boost::uuids::uuid *excludeConnection)
     {
-        m_dispatcher.remoteSpawn([this, command, data_buff, excludeConnection] {
-            relay_notify_to_all(command, data_buff, excludeConnection);
-        });
+        m_dispatcher.remoteSpawn(
+            [this, command, buffer = std::make_shared<const BinaryArray>(data_buff), excludeConnection] {
+                relayNotifyToAll(command, buffer, excludeConnection);
+            });
     }
 
     //-----------------------------------------------------------------------------------
@@ -392,7 +393,7 @@ namespace CryptoNote
         const BinaryArray &data_buff,
         const std::list<boost::uuids::uuid> relayList)
     {
-        m_dispatcher.remoteSpawn([this, command, data_buff, relayList] {
+        m_dispatcher.remoteSpawn([this, command, buffer = std::make_shared<const BinaryArray>(data_buff), relayList] {
             forEachConnection([&](P2pConnectionContext &conn) {
                 if (std::find(relayList.begin(), relayList.end(), conn.m_connection_id) != relayList.end())
                 {
@@ -400,7 +401,7 @@ namespace CryptoNote
                         && (conn.m_state == CryptoNoteConnectionContext::state_normal
                             || conn.m_state == CryptoNoteConnectionContext::state_synchronizing))
                     {
-                        conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, data_buff));
+                        conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, buffer));
                     }
                 }
             });
@@ -700,7 +701,8 @@ namespace CryptoNote
     {
         COMMAND_TIMED_SYNC::request arg = boost::value_initialized<COMMAND_TIMED_SYNC::request>();
         m_payload_handler.get_payload_sync_data(arg.payload_data);
-        auto cmdBuf = LevinProtocol::encode<COMMAND_TIMED_SYNC::request>(arg);
+        const auto cmdBuf =
+            std::make_shared<const BinaryArray>(LevinProtocol::encode<COMMAND_TIMED_SYNC::request>(arg));
 
         forEachConnection([&](P2pConnectionContext &conn) {
             if (conn.peerId
@@ -1090,6 +1092,7 @@ namespace CryptoNote
         {
             m_connections_maker_interval.call(std::bind(&NodeServer::connections_maker, this));
             m_peerlist_store_interval.call(std::bind(&NodeServer::store_config, this));
+            m_payload_handler.onIdle();
         }
         catch (std::exception &e)
         {
@@ -1265,6 +1268,15 @@ namespace CryptoNote
         int command,
         const BinaryArray &data_buff,
         const boost::uuids::uuid *excludeConnection)
+    {
+        relayNotifyToAll(command, std::make_shared<const BinaryArray>(data_buff), excludeConnection);
+    }
+
+    //-----------------------------------------------------------------------------------
+    void NodeServer::relayNotifyToAll(
+        int command,
+        const std::shared_ptr<const BinaryArray> &buffer,
+        const boost::uuids::uuid *excludeConnection)
     {
         boost::uuids::uuid excludeId =
             excludeConnection ? *excludeConnection : boost::value_initialized<boost::uuids::uuid>();
@@ -1274,7 +1286,7 @@ namespace CryptoNote
                 && (conn.m_state == CryptoNoteConnectionContext::state_normal
                     || conn.m_state == CryptoNoteConnectionContext::state_synchronizing))
             {
-                conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, data_buff));
+                conn.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, buffer));
             }
         });
     }
@@ -1291,7 +1303,7 @@ namespace CryptoNote
             return false;
         }
 
-        it->second.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, buffer));
+        it->second.pushMessage(P2pMessage(P2pMessage::NOTIFY, command, BinaryArray(buffer)));
 
         return true;
     }
@@ -1753,24 +1765,37 @@ namespace CryptoNote
                     break;
                 }
 
+                /* Everything queued goes out together, in as few writes as the
+                   socket allows */
+                std::vector<LevinProtocol::Message> messages;
+                messages.reserve(msgs.size());
+
+                const bool logMessages = logger.isEnabled(DEBUGGING);
+
                 for (const auto &msg : msgs)
                 {
-                    logger(DEBUGGING) << ctx << "msg " << msg.type << ':' << msg.command;
+                    if (logMessages)
+                    {
+                        logger(DEBUGGING) << ctx << "msg " << msg.type << ':' << msg.command;
+                    }
+
                     switch (msg.type)
                     {
                         case P2pMessage::COMMAND:
-                            proto.sendMessage(msg.command, msg.buffer, true);
+                            messages.push_back({msg.command, msg.buffer, false, true, 0});
                             break;
                         case P2pMessage::NOTIFY:
-                            proto.sendMessage(msg.command, msg.buffer, false);
+                            messages.push_back({msg.command, msg.buffer, false, false, 0});
                             break;
                         case P2pMessage::REPLY:
-                            proto.sendReply(msg.command, msg.buffer, msg.returnCode);
+                            messages.push_back({msg.command, msg.buffer, true, false, msg.returnCode});
                             break;
                         default:
                             assert(false);
                     }
                 }
+
+                proto.sendMessages(messages);
             }
         }
         catch (System::InterruptedException &)
@@ -19,6 +19,7 @@
 #include <boost/functional/hash.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <functional>
+#include <memory>
 #include <system/Context.h>
 #include <system/ContextGroup.h>
 #include <system/Dispatcher.h>
@@ -48,10 +49,24 @@ namespace CryptoNote
             NOTIFY
         };
 
-        P2pMessage(Type type, uint32_t command, const BinaryArray &buffer, int32_t returnCode = 0):
+        /* The buffer is shared, so a message relayed to every peer is only
+           held in memory once */
+        P2pMessage(
+            Type type,
+            uint32_t command,
+            std::shared_ptr<const BinaryArray> buffer,
+            int32_t returnCode = 0):
             type(type),
             command(command),
-            buffer(buffer),
+            buffer(std::move(buffer)),
+            returnCode(returnCode)
+        {
+        }
+
+        P2pMessage(Type type, uint32_t command, BinaryArray &&buffer, int32_t returnCode = 0):
+            type(type),
+            command(command),
+            buffer(std::make_shared<const BinaryArray>(std::move(buffer))),
             returnCode(returnCode)
         {
         }
@@ -66,14 +81,14 @@ namespace CryptoNote
 
         size_t size()
         {
-            return buffer.size();
+            return buffer->size();
         }
 
         Type type;
 
         uint32_t command;
 
-        const BinaryArray buffer;
+        const std::shared_ptr<const BinaryArray> buffer;
 
         int32_t returnCode;
     };
@@ -239,6 +254,13 @@ namespace CryptoNote
 
         void forEachConnection(std::function<void(P2pConnectionContext &)> action);
 
+        /* Queues the message for every peer we are in sync with, or syncing
+           from, all sharing the one buffer */
+        void relayNotifyToAll(
+            int command,
+            const std::shared_ptr<const BinaryArray> &buffer,
+            const boost::uuids::uuid *excludeConnection);
+
         void on_connection_new(P2pConnectionContext &context);
 
         void on_connection_close(P2pConnectionContext &context);
@@ -6,7 +6,9 @@
 
 #include "cryptonoteprotocol/CryptoNoteProtocolDefinitions.h"
 
+#include <optional>
 #include <unordered_set>
+#include <vector>
 
 namespace CryptoNote
 {
@@ -15,4 +17,12 @@ namespace CryptoNote
         NOTIFY_NEW_LITE_BLOCK_request request;
         std::unordered_set<Crypto::Hash> missed_transactions;
     };
+
+    /* A compact block waiting on the transactions we asked its sender for */
+    struct PendingCompactBlock
+    {
+        NOTIFY_NEW_COMPACT_BLOCK_request request;
+        /* std::nullopt for each transaction we asked for */
+        std::vector<std::optional<Crypto::Hash>> transactionHashes;
+    };
 } // namespace CryptoNote
@@ -5,15 +5,20 @@
 
 #include "TcpConnection.h"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <cassert>
+#include <climits>
 #include <cstdint>
 #include <stdexcept>
 #include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <system/ErrorMessage.h>
 #include <system/InterruptedException.h>
 #include <system/Ipv4Address.h>
 #include <unistd.h>
+#include <vector>
 
 namespace System
 {
@@ -194,15 +199,14 @@ namespace System
     std::size_t TcpConnection::write(const uint8_t *data, size_t size)
     {
         assert(dispatcher != nullptr);
-        assert(contextPair.writeContext == nullptr);
-        if (dispatcher->interrupted())
-        {
-            throw InterruptedException();
-        }
 
-        std::string message;
         if (size == 0)
         {
+            if (dispatcher->interrupted())
+            {
+                throw InterruptedException();
+            }
+
             if (shutdown(connection, SHUT_WR) == -1)
             {
                 throw std::runtime_error("TcpConnection::write, shutdown failed, " + lastErrorMessage());
@@ -211,7 +215,39 @@ namespace System
             return 0;
         }
 
-        ssize_t transferred = ::send(connection, (void *)data, size, MSG_NOSIGNAL);
+        const Buffer buffer {data, size};
+
+        return write(&buffer, 1);
+    }
+
+    std::size_t TcpConnection::write(const Buffer *buffers, size_t count)
+    {
+        assert(dispatcher != nullptr);
+        assert(contextPair.writeContext == nullptr);
+        if (dispatcher->interrupted())
+        {
+            throw InterruptedException();
+        }
+
+        assert(count != 0);
+
+        std::vector<iovec> iovecs(std::min<size_t>(count, IOV_MAX));
+
+        size_t size = 0;
+
+        for (size_t i = 0; i < iovecs.size(); i++)
+        {
+            iovecs[i].iov_base = const_cast<uint8_t *>(buffers[i].data);
+            iovecs[i].iov_len = buffers[i].size;
+            size += buffers[i].size;
+        }
+
+        msghdr header = {};
+        header.msg_iov = iovecs.data();
+        header.msg_iovlen = iovecs.size();
+
+        std::string message;
+        ssize_t transferred = ::sendmsg(connection, &header, MSG_NOSIGNAL);
         if (transferred == -1)
         {
             bool knownError = false;
@@ -302,7 +338,7 @@ namespace System
                         throw std::runtime_error("TcpConnection::write, events & (EPOLLERR | EPOLLHUP) != 0");
                     }
 
-                    ssize_t transferred = ::send(connection, (void *)data, size, 0);
+                    ssize_t transferred = ::sendmsg(connection, &header, MSG_NOSIGNAL);
                     if (transferred == -1)
                     {
                         message = "send failed, " + lastErrorMessage();
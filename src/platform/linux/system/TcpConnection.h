@@ -34,6 +34,18 @@ namespace System
 
         std::size_t write(const uint8_t *data, std::size_t size);
 
+        struct Buffer
+        {
+            const uint8_t *data;
+
+            std::size_t size;
+        };
+
+        /* Writes the buffers one after the other with a single sendmsg, as
+           far as they fit in the socket's send buffer and up to IOV_MAX of
+           them. Returns the bytes written. */
+        std::size_t write(const Buffer *buffers, std::size_t count);
+
         std::pair<Ipv4Address, uint16_t> getPeerAddressAndPort() const;
 
       private:
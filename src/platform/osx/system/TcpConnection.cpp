@@ -249,6 +249,19 @@ namespace System
         return transferred;
     }
 
+    size_t TcpConnection::write(const Buffer *buffers, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (buffers[i].size != 0)
+            {
+                return write(buffers[i].data, buffers[i].size);
+            }
+        }
+
+        return 0;
+    }
+
     std::pair<Ipv4Address, uint16_t> TcpConnection::getPeerAddressAndPort() const
     {
         sockaddr_in addr;
@@ -33,6 +33,18 @@ namespace System
 
         size_t write(const uint8_t *data, size_t size);
 
+        struct Buffer
+        {
+            const uint8_t *data;
+
+            size_t size;
+        };
+
+        /* Writes the buffers one after the other. There is no vectored send
+           here, so only the first non empty one is written per call. Returns
+           the bytes written. */
+        size_t write(const Buffer *buffers, size_t count);
+
         std::pair<Ipv4Address, uint16_t> getPeerAddressAndPort() const;
 
       private:
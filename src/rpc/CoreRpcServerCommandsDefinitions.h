@@ -154,10 +154,14 @@ namespace CryptoNote
 
             std::vector<Crypto::Hash> knownTxsIds;
 
+            /* The poolSequence from the last response, or zero */
+            uint64_t poolSequence;
+
             void serialize(ISerializer &s)
             {
                 KV_MEMBER(tailBlockId)
                 KV_MEMBER(knownTxsIds);
+                KV_MEMBER(poolSequence)
             }
         };
 
@@ -167,6 +171,7 @@ namespace CryptoNote
 
             std::vector<TransactionPrefixInfo> addedTxs; // Added transactions blobs
             std::vector<Crypto::Hash> deletedTxsIds; // IDs of not found transactions
+            uint64_t poolSequence;
             std::string status;
 
             void serialize(ISerializer &s)
@@ -174,6 +179,7 @@ namespace CryptoNote
                 KV_MEMBER(isTailBlockActual)
                 KV_MEMBER(addedTxs)
                 KV_MEMBER(deletedTxsIds);
+                KV_MEMBER(poolSequence)
                 KV_MEMBER(status)
             }
         };
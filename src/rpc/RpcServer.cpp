@@ -14,12 +14,57 @@
 #include <common/CryptoNoteTools.h>
 #include <errors/ValidateParameters.h>
 #include <logger/Logger.h>
+#include <rpc/WalletSyncStream.h>
 #include <serialization/SerializationTools.h>
 #include <utilities/Addresses.h>
 #include <utilities/ColouredMsg.h>
 #include <utilities/FormatTools.h>
 #include <utilities/ParseExtra.h>
 
+namespace
+{
+    /* How long a getblocktemplate long poll is held when nothing changes.
+       Must stay below the 30 second read timeout of our HTTP clients. */
+    const auto LONG_POLL_TIMEOUT = std::chrono::seconds(20);
+
+    /* New transactions alone only make a better template, not an invalid
+       one, so don't wake the caller for them until this long has passed */
+    const auto LONG_POLL_POOL_DELAY = std::chrono::seconds(5);
+
+    /* How often a long poll checks whether the server is stopping */
+    const auto LONG_POLL_STOP_CHECK_INTERVAL = std::chrono::seconds(1);
+
+    /* The top block hash, followed by the pool version */
+    std::string makeLongPollId(const Crypto::Hash &topBlockHash, const uint64_t poolVersion)
+    {
+        return Common::podToHex(topBlockHash) + std::to_string(poolVersion);
+    }
+
+    bool parseLongPollId(const std::string &longPollId, Crypto::Hash &topBlockHash, uint64_t &poolVersion)
+    {
+        const size_t hashLength = sizeof(topBlockHash) * 2;
+
+        if (longPollId.size() <= hashLength
+            || !Common::podFromHex(longPollId.substr(0, hashLength), topBlockHash))
+        {
+            return false;
+        }
+
+        try
+        {
+            size_t parsed = 0;
+
+            poolVersion = std::stoull(longPollId.substr(hashLength), &parsed);
+
+            return parsed == longPollId.size() - hashLength;
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+    }
+}
+
 RpcServer::RpcServer(
     const uint16_t bindPort,
     const std::string rpcBindIp,
@@ -147,6 +192,7 @@ RpcServer::RpcServer(
             .Post("/sendrawtransaction", router(&RpcServer::sendTransaction, RpcMode::Default, bodyRequired, syncRequired))
             .Post("/getrandom_outs", router(&RpcServer::getRandomOuts, RpcMode::Default, bodyRequired, syncNotRequired))
             .Post("/getwalletsyncdata", router(&RpcServer::getWalletSyncData, RpcMode::Default, bodyRequired, syncNotRequired))
+            .Post("/getwalletsyncdata/binary", router(&RpcServer::getWalletSyncDataBinary, RpcMode::Default, bodyRequired, syncNotRequired))
             .Post("/get_global_indexes_for_range", router(&RpcServer::getGlobalIndexes, RpcMode::Default, bodyRequired, syncNotRequired))
             .Post("/queryblockslite", router(&RpcServer::queryBlocksLite, RpcMode::Default, bodyRequired, syncNotRequired))
             .Post("/get_transactions_status", router(&RpcServer::getTransactionsStatus, RpcMode::Default, bodyRequired, syncNotRequired))
@@ -184,6 +230,8 @@ void RpcServer::listen()
 
 void RpcServer::stop()
 {
+    m_stopping = true;
+
     m_server.stop();
 
     if (m_serverThread.joinable())
@@ -250,11 +298,14 @@ void RpcServer::middleware(
         httplib::Response &res,
         const rapidjson::Document &body)> handler)
 {
-    Logger::logger.log(
-        "[" + req.get_header_value("REMOTE_ADDR") + "] Incoming " + req.method + " request: " + req.path + ", User-Agent: " + req.get_header_value("User-Agent"),
-        Logger::DEBUG,
-        { Logger::DAEMON_RPC }
-    );
+    if (Logger::logger.isEnabled(Logger::DEBUG))
+    {
+        Logger::logger.log(
+            "[" + req.get_header_value("REMOTE_ADDR") + "] Incoming " + req.method + " request: " + req.path + ", User-Agent: " + req.get_header_value("User-Agent"),
+            Logger::DEBUG,
+            { Logger::DAEMON_RPC }
+        );
+    }
 
     if (m_corsHeader != "")
     {
@@ -635,6 +686,46 @@ std::tuple<Error, uint16_t> RpcServer::peers(
     }
     writer.EndArray();
 
+    /* How fast each peer we have been syncing from sends us blocks */
+    writer.Key("downloads");
+    writer.StartArray();
+    {
+        for (const auto &peer : m_syncManager->getPeerDownloadStatistics())
+        {
+            writer.StartObject();
+
+            writer.Key("address");
+            writer.String(peer.address);
+
+            writer.Key("blocks_received");
+            writer.Uint64(peer.blocksReceived);
+
+            writer.Key("bytes_received");
+            writer.Uint64(peer.bytesReceived);
+
+            writer.Key("bytes_per_second");
+            writer.Uint64(peer.bytesPerSecond);
+
+            writer.Key("average_response_time");
+            writer.Uint64(peer.averageResponseTime);
+
+            writer.Key("windows_requested");
+            writer.Uint64(peer.windowsRequested);
+
+            writer.Key("windows_stalled");
+            writer.Uint64(peer.windowsStalled);
+
+            writer.Key("downloading");
+            writer.Bool(peer.downloading);
+
+            writer.Key("stalled");
+            writer.Bool(peer.stalled);
+
+            writer.EndObject();
+        }
+    }
+    writer.EndArray();
+
     writer.Key("status");
     writer.String("OK");
 
@@ -810,16 +901,11 @@ std::tuple<Error, uint16_t> RpcServer::getRandomOuts(
     return {SUCCESS, 200};
 }
 
-std::tuple<Error, uint16_t> RpcServer::getWalletSyncData(
-    const httplib::Request &req,
-    httplib::Response &res,
-    const rapidjson::Document &body)
+bool RpcServer::getWalletSyncBlocks(
+    const rapidjson::Document &body,
+    std::vector<WalletTypes::WalletBlockInfo> &walletBlocks,
+    std::optional<WalletTypes::TopBlock> &topBlockInfo)
 {
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-
-    writer.StartObject();
-
     std::vector<Crypto::Hash> blockHashCheckpoints;
 
     if (hasMember(body, "blockHashCheckpoints"))
@@ -851,10 +937,7 @@ std::tuple<Error, uint16_t> RpcServer::getWalletSyncData(
         ? getBoolFromJSON(body, "skipCoinbaseTransactions")
         : false;
 
-    std::vector<WalletTypes::WalletBlockInfo> walletBlocks;
-    std::optional<WalletTypes::TopBlock> topBlockInfo;
-
-    const bool success = m_core->getWalletSyncData(
+    return m_core->getWalletSyncData(
         blockHashCheckpoints,
         startHeight,
         startTimestamp,
@@ -863,8 +946,22 @@ std::tuple<Error, uint16_t> RpcServer::getWalletSyncData(
         walletBlocks,
         topBlockInfo
     );
+}
 
-    if (!success)
+std::tuple<Error, uint16_t> RpcServer::getWalletSyncData(
+    const httplib::Request &req,
+    httplib::Response &res,
+    const rapidjson::Document &body)
+{
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+
+    writer.StartObject();
+
+    std::vector<WalletTypes::WalletBlockInfo> walletBlocks;
+    std::optional<WalletTypes::TopBlock> topBlockInfo;
+
+    if (!getWalletSyncBlocks(body, walletBlocks, topBlockInfo))
     {
         return {SUCCESS, 500};
     }
@@ -893,6 +990,12 @@ std::tuple<Error, uint16_t> RpcServer::getWalletSyncData(
 
                                 writer.Key("amount");
                                 writer.Uint64(output.amount);
+
+                                if (output.globalOutputIndex)
+                                {
+                                    writer.Key("globalIndex");
+                                    writer.Uint64(*output.globalOutputIndex);
+                                }
                             }
                             writer.EndObject();
                         }
@@ -930,6 +1033,12 @@ std::tuple<Error, uint16_t> RpcServer::getWalletSyncData(
 
                                     writer.Key("amount");
                                     writer.Uint64(output.amount);
+
+                                    if (output.globalOutputIndex)
+                                    {
+                                        writer.Key("globalIndex");
+                                        writer.Uint64(*output.globalOutputIndex);
+                                    }
                                 }
                                 writer.EndObject();
                             }
@@ -1022,6 +1131,73 @@ std::tuple<Error, uint16_t> RpcServer::getWalletSyncData(
     return {SUCCESS, 200};
 }
 
+std::tuple<Error, uint16_t> RpcServer::getWalletSyncDataBinary(
+    const httplib::Request &req,
+    httplib::Response &res,
+    const rapidjson::Document &body)
+{
+    auto walletBlocks = std::make_shared<std::vector<WalletTypes::WalletBlockInfo>>();
+    std::optional<WalletTypes::TopBlock> topBlockInfo;
+
+    if (!getWalletSyncBlocks(body, *walletBlocks, topBlockInfo))
+    {
+        return {SUCCESS, 500};
+    }
+
+    const bool compress = hasMember(body, "compression")
+        && getStringFromJSON(body, "compression") == CryptoNote::WALLET_SYNC_STREAM_ZSTD;
+
+    res.headers.erase("Content-Type");
+    res.set_header("Content-Type", "application/octet-stream");
+
+    if (compress)
+    {
+        res.set_header("Content-Encoding", CryptoNote::WALLET_SYNC_STREAM_ZSTD);
+    }
+
+    /* Same as the JSON endpoint - the top block is only of interest once
+       the wallet has caught up */
+    if (!walletBlocks->empty())
+    {
+        topBlockInfo = std::nullopt;
+    }
+
+    auto stream = std::make_shared<CryptoNote::WalletSyncStreamWriter>(compress);
+    auto nextBlock = std::make_shared<size_t>(0);
+
+    /* Sent with chunked transfer encoding, a handful of blocks per chunk, so
+       neither side has to hold the whole encoded response at once */
+    res.streamcb = [walletBlocks, topBlockInfo, stream, nextBlock](const uint64_t offset) -> std::string {
+        const size_t WALLET_SYNC_BLOCKS_PER_CHUNK = 10;
+
+        if (stream->isFinished())
+        {
+            return "";
+        }
+
+        const size_t end = std::min(*nextBlock + WALLET_SYNC_BLOCKS_PER_CHUNK, walletBlocks->size());
+
+        for (; *nextBlock < end; (*nextBlock)++)
+        {
+            stream->addBlock((*walletBlocks)[*nextBlock]);
+        }
+
+        if (*nextBlock == walletBlocks->size())
+        {
+            if (topBlockInfo)
+            {
+                stream->addTopBlock(*topBlockInfo);
+            }
+
+            stream->finish();
+        }
+
+        return stream->take();
+    };
+
+    return {SUCCESS, 200};
+}
+
 std::tuple<Error, uint16_t> RpcServer::getGlobalIndexes(
     const httplib::Request &req,
     httplib::Response &res,
@@ -1085,6 +1261,40 @@ std::tuple<Error, uint16_t> RpcServer::getGlobalIndexes(
     return {SUCCESS, 200};
 }
 
+void RpcServer::waitForBlockTemplateChange(const Crypto::Hash &knownTopBlockHash, const uint64_t knownPoolVersion)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = start + LONG_POLL_TIMEOUT;
+    const auto poolDeadline = start + LONG_POLL_POOL_DELAY;
+
+    /* The pool version we last saw, so we can wait for it to change again */
+    uint64_t poolVersion = m_core->getPoolVersion();
+
+    while (!m_stopping && m_core->getTopBlockHash() == knownTopBlockHash)
+    {
+        const auto now = std::chrono::steady_clock::now();
+
+        const bool poolChanged = poolVersion != knownPoolVersion;
+
+        if (now >= deadline || (poolChanged && now >= poolDeadline))
+        {
+            break;
+        }
+
+        /* Once the pool has changed, there's no need to be woken for further
+           pool changes, only a new block, or the pool delay passing */
+        const auto until = std::min({
+            deadline,
+            poolChanged ? poolDeadline : deadline,
+            now + LONG_POLL_STOP_CHECK_INTERVAL
+        });
+
+        m_core->waitForBlockTemplateChange(knownTopBlockHash, poolVersion, until);
+
+        poolVersion = m_core->getPoolVersion();
+    }
+}
+
 std::tuple<Error, uint16_t> RpcServer::getBlockTemplate(
     const httplib::Request &req,
     httplib::Response &res,
@@ -1127,6 +1337,33 @@ std::tuple<Error, uint16_t> RpcServer::getBlockTemplate(
 
     const auto [publicSpendKey, publicViewKey] = Utilities::addressToKeys(address);
 
+    /* The longpollid from a previous response. If given, we hold on to the
+       request until there's a new top block, or (after a short delay) new
+       pool transactions, rather than have miners poll us repeatedly. */
+    if (hasMember(params, "longpollid"))
+    {
+        Crypto::Hash knownTopBlockHash;
+        uint64_t knownPoolVersion;
+
+        if (!parseLongPollId(getStringFromJSON(params, "longpollid"), knownTopBlockHash, knownPoolVersion))
+        {
+            failJsonRpcRequest(
+                -1,
+                "Invalid longpollid, should be as returned from a previous getblocktemplate",
+                res
+            );
+
+            return {SUCCESS, 200};
+        }
+
+        waitForBlockTemplateChange(knownTopBlockHash, knownPoolVersion);
+    }
+
+    /* Taken before making the template, so if anything changes in between,
+       the next long poll returns straight away */
+    const Crypto::Hash topBlockHash = m_core->getTopBlockHash();
+    const uint64_t poolVersion = m_core->getPoolVersion();
+
     CryptoNote::BlockTemplate blockTemplate;
 
     std::vector<uint8_t> blobReserve;
@@ -1202,6 +1439,9 @@ std::tuple<Error, uint16_t> RpcServer::getBlockTemplate(
         writer.Key("blocktemplate_blob");
         writer.String(Common::toHex(blockBlob));
 
+        writer.Key("longpollid");
+        writer.String(makeLongPollId(topBlockHash, poolVersion));
+
         writer.Key("status");
         writer.String("OK");
     }
@@ -2568,11 +2808,18 @@ std::tuple<Error, uint16_t> RpcServer::getPoolChanges(
         knownHashes.push_back(hash);
     }
 
+    /* Returned by the previous call. If still recent enough, we only have to
+       look at what changed since then, rather than diffing the whole pool. */
+    const uint64_t knownSequence = hasMember(body, "poolSequence")
+        ? getUint64FromJSON(body, "poolSequence")
+        : 0;
+
     std::vector<CryptoNote::TransactionPrefixInfo> addedTransactions;
     std::vector<Crypto::Hash> deletedTransactions;
+    uint64_t currentSequence;
 
     const bool atTopOfChain = m_core->getPoolChangesLite(
-        lastBlockHash, knownHashes, addedTransactions, deletedTransactions
+        lastBlockHash, knownHashes, knownSequence, addedTransactions, deletedTransactions, currentSequence
     );
 
     writer.StartObject();
@@ -2700,6 +2947,9 @@ std::tuple<Error, uint16_t> RpcServer::getPoolChanges(
     writer.Key("isTailBlockActual");
     writer.Bool(atTopOfChain);
 
+    writer.Key("poolSequence");
+    writer.Uint64(currentSequence);
+
     writer.Key("status");
     writer.String("OK");
 
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <future>
 #include <memory>
 #include <optional>
@@ -86,6 +87,12 @@ class RpcServer
 
     void failRequest(uint16_t statusCode, std::string body, httplib::Response &res);
 
+    /* Fetches the blocks asked for by a /getwalletsyncdata style request body */
+    bool getWalletSyncBlocks(
+        const rapidjson::Document &body,
+        std::vector<WalletTypes::WalletBlockInfo> &walletBlocks,
+        std::optional<WalletTypes::TopBlock> &topBlockInfo);
+
     void failJsonRpcRequest(
         const int64_t errorCode,
         const std::string errorMessage,
@@ -126,6 +133,11 @@ class RpcServer
     std::tuple<Error, uint16_t>
         getWalletSyncData(const httplib::Request &req, httplib::Response &res, const rapidjson::Document &body);
 
+    /* As getWalletSyncData, but streamed in the binary format described in
+       rpc/WalletSyncStream.h */
+    std::tuple<Error, uint16_t>
+        getWalletSyncDataBinary(const httplib::Request &req, httplib::Response &res, const rapidjson::Document &body);
+
     std::tuple<Error, uint16_t>
         getGlobalIndexes(const httplib::Request &req, httplib::Response &res, const rapidjson::Document &body);
 
@@ -155,6 +167,10 @@ class RpcServer
     std::tuple<Error, uint16_t>
         getBlockTemplate(const httplib::Request &req, httplib::Response &res, const rapidjson::Document &body);
 
+    /* Holds a getblocktemplate long poll until the template it was given is
+       out of date, or the long poll times out */
+    void waitForBlockTemplateChange(const Crypto::Hash &knownTopBlockHash, const uint64_t knownPoolVersion);
+
     std::tuple<Error, uint16_t>
         submitBlock(const httplib::Request &req, httplib::Response &res, const rapidjson::Document &body);
 
@@ -221,4 +237,7 @@ class RpcServer
     const std::shared_ptr<CryptoNote::NodeServer> m_p2p;
 
     const std::shared_ptr<CryptoNote::ICryptoNoteProtocolHandler> m_syncManager;
+
+    /* Set when stopping, so held long polls return */
+    std::atomic<bool> m_stopping = false;
 };
@@ -0,0 +1,280 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include <common/CryptoNoteTools.h>
+#include <cryptonotecore/DatabaseCacheData.h>
+#include <cstring>
+#include <lib/zstd.h>
+#include <rpc/WalletSyncStream.h>
+#include <stdexcept>
+
+namespace CryptoNote
+{
+    namespace
+    {
+        const size_t FRAME_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint32_t);
+
+        /* Refuse to inflate a response past this, so a hostile daemon can't
+           exhaust our memory with a small, highly compressible body */
+        const size_t MAX_DECOMPRESSED_SIZE = 512 * 1024 * 1024;
+
+        const int COMPRESSION_LEVEL = 3;
+
+        void writeUint32(std::string &out, const uint32_t value)
+        {
+            for (size_t i = 0; i < sizeof(value); i++)
+            {
+                out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+            }
+        }
+
+        uint32_t readUint32(const char *data)
+        {
+            uint32_t value = 0;
+
+            for (size_t i = 0; i < sizeof(value); i++)
+            {
+                value |= static_cast<uint32_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+            }
+
+            return value;
+        }
+
+        std::optional<std::string> decompress(const std::string &body)
+        {
+            ZSTD_DCtx *context = ZSTD_createDCtx();
+
+            if (context == nullptr)
+            {
+                return std::nullopt;
+            }
+
+            std::string result;
+            std::vector<char> buffer(ZSTD_DStreamOutSize());
+
+            ZSTD_inBuffer input {body.data(), body.size(), 0};
+
+            bool success = true;
+
+            while (input.pos < input.size)
+            {
+                ZSTD_outBuffer output {buffer.data(), buffer.size(), 0};
+
+                const size_t status = ZSTD_decompressStream(context, &output, &input);
+
+                if (ZSTD_isError(status) || result.size() + output.pos > MAX_DECOMPRESSED_SIZE)
+                {
+                    success = false;
+                    break;
+                }
+
+                result.append(buffer.data(), output.pos);
+            }
+
+            ZSTD_freeDCtx(context);
+
+            if (!success)
+            {
+                return std::nullopt;
+            }
+
+            return result;
+        }
+    } // namespace
+
+    WalletSyncStreamWriter::WalletSyncStreamWriter(const bool compress)
+    {
+        if (compress)
+        {
+            m_compressor = ZSTD_createCCtx();
+
+            if (m_compressor == nullptr)
+            {
+                throw std::runtime_error("Failed to create zstd compression context");
+            }
+
+            ZSTD_CCtx_setParameter(m_compressor, ZSTD_c_compressionLevel, COMPRESSION_LEVEL);
+        }
+    }
+
+    WalletSyncStreamWriter::~WalletSyncStreamWriter()
+    {
+        if (m_compressor != nullptr)
+        {
+            ZSTD_freeCCtx(m_compressor);
+        }
+    }
+
+    void WalletSyncStreamWriter::addBlock(const WalletTypes::WalletBlockInfo &block)
+    {
+        const auto payload = toBinaryArray(WalletBlockInfoRecord {block});
+
+        addFrame(WalletSyncFrameType::BLOCK, std::string(payload.begin(), payload.end()));
+    }
+
+    void WalletSyncStreamWriter::addTopBlock(const WalletTypes::TopBlock &topBlock)
+    {
+        std::string payload(reinterpret_cast<const char *>(&topBlock.hash), sizeof(topBlock.hash));
+
+        writeUint32(payload, static_cast<uint32_t>(topBlock.height));
+        writeUint32(payload, static_cast<uint32_t>(topBlock.height >> 32));
+
+        addFrame(WalletSyncFrameType::TOP_BLOCK, payload);
+    }
+
+    void WalletSyncStreamWriter::finish()
+    {
+        addFrame(WalletSyncFrameType::END, "");
+
+        m_finished = true;
+    }
+
+    bool WalletSyncStreamWriter::isFinished() const
+    {
+        return m_finished;
+    }
+
+    void WalletSyncStreamWriter::addFrame(const WalletSyncFrameType type, const std::string &payload)
+    {
+        if (m_finished)
+        {
+            throw std::logic_error("Can't add frames to a finished wallet sync stream");
+        }
+
+        m_pending.push_back(static_cast<char>(type));
+        writeUint32(m_pending, static_cast<uint32_t>(payload.size()));
+        m_pending.append(payload);
+    }
+
+    std::string WalletSyncStreamWriter::take()
+    {
+        std::string frames = std::move(m_pending);
+        m_pending.clear();
+
+        if (m_compressor == nullptr)
+        {
+            return frames;
+        }
+
+        std::string result;
+        std::vector<char> buffer(ZSTD_CStreamOutSize());
+
+        ZSTD_inBuffer input {frames.data(), frames.size(), 0};
+
+        /* Flush, rather than just continue, so the client gets everything
+           written so far. At the end, close the zstd frame properly. */
+        const ZSTD_EndDirective mode = m_finished ? ZSTD_e_end : ZSTD_e_flush;
+
+        size_t remaining;
+
+        do
+        {
+            ZSTD_outBuffer output {buffer.data(), buffer.size(), 0};
+
+            remaining = ZSTD_compressStream2(m_compressor, &output, &input, mode);
+
+            if (ZSTD_isError(remaining))
+            {
+                throw std::runtime_error(
+                    "Failed to compress wallet sync stream: " + std::string(ZSTD_getErrorName(remaining)));
+            }
+
+            result.append(buffer.data(), output.pos);
+        } while (remaining != 0);
+
+        return result;
+    }
+
+    std::optional<WalletSyncStreamContents> readWalletSyncStream(const std::string &body, const bool compressed)
+    {
+        std::string decompressed;
+
+        if (compressed)
+        {
+            auto result = decompress(body);
+
+            if (!result)
+            {
+                return std::nullopt;
+            }
+
+            decompressed = std::move(*result);
+        }
+
+        const std::string &frames = compressed ? decompressed : body;
+
+        WalletSyncStreamContents contents;
+
+        size_t offset = 0;
+
+        while (frames.size() - offset >= FRAME_HEADER_SIZE)
+        {
+            const auto type = static_cast<WalletSyncFrameType>(frames[offset]);
+            const uint32_t length = readUint32(frames.data() + offset + 1);
+
+            offset += FRAME_HEADER_SIZE;
+
+            if (length > frames.size() - offset)
+            {
+                return std::nullopt;
+            }
+
+            const char *payload = frames.data() + offset;
+
+            offset += length;
+
+            switch (type)
+            {
+                case WalletSyncFrameType::BLOCK:
+                {
+                    WalletBlockInfoRecord record;
+
+                    if (!fromBinaryArray(record, BinaryArray(payload, payload + length)))
+                    {
+                        return std::nullopt;
+                    }
+
+                    contents.blocks.push_back(std::move(record.block));
+
+                    break;
+                }
+                case WalletSyncFrameType::TOP_BLOCK:
+                {
+                    WalletTypes::TopBlock topBlock;
+
+                    if (length != sizeof(topBlock.hash) + sizeof(uint64_t))
+                    {
+                        return std::nullopt;
+                    }
+
+                    std::memcpy(&topBlock.hash, payload, sizeof(topBlock.hash));
+
+                    topBlock.height = readUint32(payload + sizeof(topBlock.hash))
+                                      | static_cast<uint64_t>(readUint32(payload + sizeof(topBlock.hash) + 4)) << 32;
+
+                    contents.topBlock = topBlock;
+
+                    break;
+                }
+                case WalletSyncFrameType::END:
+                {
+                    /* Anything after the end is garbage */
+                    if (length != 0 || offset != frames.size())
+                    {
+                        return std::nullopt;
+                    }
+
+                    return contents;
+                }
+                default:
+                {
+                    return std::nullopt;
+                }
+            }
+        }
+
+        /* Ran out of data before the END frame */
+        return std::nullopt;
+    }
+} // namespace CryptoNote
@@ -0,0 +1,84 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <WalletTypes.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+struct ZSTD_CCtx_s;
+
+namespace CryptoNote
+{
+    /* The value of the "compression" request parameter, and the response
+       Content-Encoding, when the stream is zstd compressed */
+    const std::string WALLET_SYNC_STREAM_ZSTD = "zstd";
+
+    /* The /getwalletsyncdata/binary response body is a series of frames, each
+       a one byte type, a four byte little endian payload length, and the
+       payload. The END frame marks a complete response, so a truncated one
+       can be told apart from a daemon with no more blocks to give us.
+
+       When compressed, the whole series of frames is a single zstd stream,
+       flushed whenever the frames written so far are taken, so each HTTP
+       chunk can be decompressed on its own. */
+    enum class WalletSyncFrameType : uint8_t
+    {
+        /* A binary serialized WalletBlockInfoRecord */
+        BLOCK = 1,
+
+        /* The top block hash, followed by its height as a 64 bit integer.
+           Only sent when the wallet is synced. */
+        TOP_BLOCK = 2,
+
+        /* Empty, always the last frame */
+        END = 3
+    };
+
+    class WalletSyncStreamWriter
+    {
+      public:
+        explicit WalletSyncStreamWriter(const bool compress);
+
+        ~WalletSyncStreamWriter();
+
+        WalletSyncStreamWriter(const WalletSyncStreamWriter &) = delete;
+
+        WalletSyncStreamWriter &operator=(const WalletSyncStreamWriter &) = delete;
+
+        void addBlock(const WalletTypes::WalletBlockInfo &block);
+
+        void addTopBlock(const WalletTypes::TopBlock &topBlock);
+
+        /* Adds the END frame. Nothing may be added afterwards. */
+        void finish();
+
+        bool isFinished() const;
+
+        /* Takes the bytes written since the last call, ready to send */
+        std::string take();
+
+      private:
+        void addFrame(const WalletSyncFrameType type, const std::string &payload);
+
+        /* Frames not yet taken, before compression */
+        std::string m_pending;
+
+        ZSTD_CCtx_s *m_compressor = nullptr;
+
+        bool m_finished = false;
+    };
+
+    struct WalletSyncStreamContents
+    {
+        std::vector<WalletTypes::WalletBlockInfo> blocks;
+
+        std::optional<WalletTypes::TopBlock> topBlock;
+    };
+
+    /* Returns std::nullopt if the stream is malformed or truncated */
+    std::optional<WalletSyncStreamContents> readWalletSyncStream(const std::string &body, const bool compressed);
+} // namespace CryptoNote
@@ -9,6 +9,7 @@
 
 #include <cassert>
 #include <common/StreamTools.h>
+#include <limits>
 #include <stdexcept>
 
 using namespace Common;
@@ -89,6 +90,21 @@ namespace CryptoNote
         write(target, stream().data(), stream().size());
     }
 
+    void KVBinaryOutputStreamSerializer::dumpObject(IOutputStream &target)
+    {
+        assert(m_objectsStack.size() == 1);
+        assert(m_stack.size() == 1);
+
+        writeArraySize(target, m_stack.front().count);
+        write(target, stream().data(), stream().size());
+    }
+
+    void KVBinaryOutputStreamSerializer::serializedObject(const std::vector<uint8_t> &object, Common::StringView name)
+    {
+        writeElementPrefix(BIN_KV_SERIALIZE_TYPE_OBJECT, name);
+        write(stream(), object.data(), object.size());
+    }
+
     ISerializer::SerializerType KVBinaryOutputStreamSerializer::type() const
     {
         return ISerializer::OUTPUT;
@@ -22,6 +22,14 @@ namespace CryptoNote
 
         void dump(Common::IOutputStream &target);
 
+        /* Writes the root object without the storage header, as it is written
+           when nested in another object, so it can be spliced into one with
+           serializedObject */
+        void dumpObject(Common::IOutputStream &target);
+
+        /* Writes an object previously written out with dumpObject */
+        void serializedObject(const std::vector<uint8_t> &object, Common::StringView name);
+
         virtual ISerializer::SerializerType type() const override;
 
         virtual bool beginObject(Common::StringView name) override;
@@ -7,6 +7,8 @@
 /////////////////////////////////
 
 #include <config/Constants.h>
+#include <config/CryptoNoteConfig.h>
+#include <iterator>
 #include <logger/Logger.h>
 #include <utilities/Utilities.h>
 #include <walletbackend/Constants.h>
@@ -104,16 +106,8 @@ void SubWallet::storeTransactionInput(const WalletTypes::TransactionInput input,
         }
     }
 
-    auto it = std::find_if(m_unspentInputs.begin(), m_unspentInputs.end(), [&input](const auto x) {
-        return x.key == input.key;
-    });
-
     /* Ensure we don't add the input twice */
-    if (it == m_unspentInputs.end())
-    {
-        m_unspentInputs.push_back(input);
-    }
-    else
+    if (!addUnspentInput(input))
     {
         std::stringstream stream;
 
@@ -128,23 +122,24 @@ void SubWallet::storeTransactionInput(const WalletTypes::TransactionInput input,
     }
 }
 
-std::tuple<uint64_t, uint64_t> SubWallet::getBalance(const uint64_t currentHeight) const
+bool SubWallet::addUnspentInput(const WalletTypes::TransactionInput &input)
 {
-    uint64_t unlockedBalance = 0;
-    uint64_t lockedBalance = 0;
-    for (const auto &input : m_unspentInputs)
+    if (m_unspentInputs.get<InputKeyIndex>().count(input.key) != 0)
     {
-        /* If an unlock height is present, check if the input is unlocked */
-        if (Utilities::isInputUnlocked(input.unlockTime, currentHeight))
-        {
-            unlockedBalance += input.amount;
-        }
-        else
-        {
-            lockedBalance += input.amount;
-        }
+        return false;
     }
 
+    m_unspentInputs.push_back(input);
+    m_unspentBalance += input.amount;
+
+    return true;
+}
+
+std::tuple<uint64_t, uint64_t> SubWallet::getBalance(const uint64_t currentHeight) const
+{
+    uint64_t lockedBalance = getLockedUnspentBalance(currentHeight);
+    uint64_t unlockedBalance = m_unspentBalance - lockedBalance;
+
     /* Add the locked balance from incoming transactions */
     for (const auto &unconfirmedInput : m_unconfirmedIncomingAmounts)
     {
@@ -153,6 +148,38 @@ std::tuple<uint64_t, uint64_t> SubWallet::getBalance(const uint64_t currentHeigh
     return {unlockedBalance, lockedBalance};
 }
 
+uint64_t SubWallet::getLockedUnspentBalance(const uint64_t currentHeight) const
+{
+    /* Nearly every input unlocks straight away, so rather than checking them
+       all, we only look at those with the latest unlock times, until we get
+       to ones which have unlocked. Unlock times above the max block number
+       are timestamps, and the rest are heights, so each range is checked
+       on its own. */
+    const auto &index = m_unspentInputs.get<InputUnlockTimeIndex>();
+
+    const auto timestampsBegin = index.lower_bound(CryptoNote::parameters::CRYPTONOTE_MAX_BLOCK_NUMBER);
+
+    uint64_t lockedBalance = 0;
+
+    const auto sumLocked = [&](auto begin, auto end)
+    {
+        for (auto it = std::make_reverse_iterator(end); it != std::make_reverse_iterator(begin); ++it)
+        {
+            if (Utilities::isInputUnlocked(it->unlockTime, currentHeight))
+            {
+                break;
+            }
+
+            lockedBalance += it->amount;
+        }
+    };
+
+    sumLocked(index.begin(), timestampsBegin);
+    sumLocked(timestampsBegin, index.end());
+
+    return lockedBalance;
+}
+
 void SubWallet::reset(const uint64_t scanHeight)
 {
     m_syncStartTimestamp = 0;
@@ -160,6 +187,7 @@ void SubWallet::reset(const uint64_t scanHeight)
     m_lockedInputs.clear();
     m_unconfirmedIncomingAmounts.clear();
     m_unspentInputs.clear();
+    m_unspentBalance = 0;
     m_spentInputs.clear();
 }
 
@@ -190,14 +218,7 @@ Crypto::SecretKey SubWallet::privateSpendKey() const
 
 void SubWallet::markInputAsSpent(const Crypto::KeyImage keyImage, const uint64_t spendHeight)
 {
-    /* Find the input */
-    auto it = std::find_if(m_unspentInputs.begin(), m_unspentInputs.end(), [&keyImage](const auto x) {
-        return x.keyImage == keyImage;
-    });
-
-    bool inSpent = std::find_if(m_spentInputs.begin(), m_spentInputs.end(), [&keyImage](const auto x) {
-        return x.keyImage == keyImage;
-    }) != m_spentInputs.end();
+    bool inSpent = m_spentInputs.get<InputKeyImageIndex>().count(keyImage) != 0;
 
     if (inSpent)
     {
@@ -213,41 +234,53 @@ void SubWallet::markInputAsSpent(const Crypto::KeyImage keyImage, const uint64_t
         );
     }
 
-    if (it != m_unspentInputs.end())
-    {
-        /* Set the spend height */
-        it->spendHeight = spendHeight;
+    /* Find the input */
+    auto &unspent = m_unspentInputs.get<InputKeyImageIndex>();
 
+    auto it = unspent.find(keyImage);
 
+    if (it != unspent.end())
+    {
         /* Ensure we don't add the input twice */
         if (!inSpent)
         {
+            WalletTypes::TransactionInput input = *it;
+
+            /* Set the spend height */
+            input.spendHeight = spendHeight;
+
             /* Add to the spent inputs vector */
-            m_spentInputs.push_back(*it);
+            m_spentInputs.push_back(input);
         }
 
+        m_unspentBalance -= it->amount;
+
         /* Remove from the unspent vector */
-        m_unspentInputs.erase(it);
+        unspent.erase(it);
 
         return;
     }
 
     /* Didn't find it, lets try in the locked inputs */
-    it = std::find_if(
-        m_lockedInputs.begin(), m_lockedInputs.end(), [&keyImage](const auto x) { return x.keyImage == keyImage; });
-    if (it != m_lockedInputs.end())
-    {
-        /* Set the spend height */
-        it->spendHeight = spendHeight;
+    auto &locked = m_lockedInputs.get<InputKeyImageIndex>();
+
+    it = locked.find(keyImage);
 
+    if (it != locked.end())
+    {
         if (!inSpent)
         {
+            WalletTypes::TransactionInput input = *it;
+
+            /* Set the spend height */
+            input.spendHeight = spendHeight;
+
             /* Add to the spent inputs vector */
-            m_spentInputs.push_back(*it);
+            m_spentInputs.push_back(input);
         }
 
         /* Remove from the locked vector */
-        m_lockedInputs.erase(it);
+        locked.erase(it);
 
         return;
     }
@@ -266,11 +299,12 @@ void SubWallet::markInputAsSpent(const Crypto::KeyImage keyImage, const uint64_t
 void SubWallet::markInputAsLocked(const Crypto::KeyImage keyImage)
 {
     /* Find the input */
-    auto it = std::find_if(
-        m_unspentInputs.begin(), m_unspentInputs.end(), [&keyImage](const auto x) { return x.keyImage == keyImage; });
+    auto &unspent = m_unspentInputs.get<InputKeyImageIndex>();
+
+    const auto it = unspent.find(keyImage);
 
     /* Shouldn't happen */
-    if (it == m_unspentInputs.end())
+    if (it == unspent.end())
     {
         std::stringstream stream;
 
@@ -285,9 +319,7 @@ void SubWallet::markInputAsLocked(const Crypto::KeyImage keyImage)
         return;
     }
 
-    bool inLocked = std::find_if(m_lockedInputs.begin(), m_lockedInputs.end(), [&keyImage](const auto x) {
-        return x.keyImage == keyImage;
-    }) != m_lockedInputs.end();
+    bool inLocked = m_lockedInputs.get<InputKeyImageIndex>().count(keyImage) != 0;
 
     if (!inLocked)
     {
@@ -308,8 +340,10 @@ void SubWallet::markInputAsLocked(const Crypto::KeyImage keyImage)
         );
     }
 
+    m_unspentBalance -= it->amount;
+
     /* Remove from the unspent vector */
-    m_unspentInputs.erase(it);
+    unspent.erase(it);
 }
 
 std::vector<Crypto::KeyImage> SubWallet::removeForkedInputs(const uint64_t forkHeight, const bool isViewWallet)
@@ -319,74 +353,63 @@ std::vector<Crypto::KeyImage> SubWallet::removeForkedInputs(const uint64_t forkH
 
     std::vector<Crypto::KeyImage> keyImagesToRemove;
 
-    auto isForked = [forkHeight, &keyImagesToRemove](const auto &input)
+    /* Returns the sum of the inputs removed */
+    auto removeForked = [forkHeight, &keyImagesToRemove](auto &inputs)
     {
-        if (input.blockHeight >= forkHeight)
-        {
-            keyImagesToRemove.push_back(input.keyImage);
-        }
+        auto &index = inputs.template get<InputBlockHeightIndex>();
 
-        return input.blockHeight >= forkHeight;
-    };
+        const auto begin = index.lower_bound(forkHeight);
 
-    auto removeForked = [isForked](auto &inputVector)
-    {
-        const auto it = std::remove_if(inputVector.begin(), inputVector.end(), isForked);
+        uint64_t removedAmount = 0;
 
-        if (it != inputVector.end())
+        for (auto it = begin; it != index.end(); ++it)
         {
-            inputVector.erase(it, inputVector.end());
+            keyImagesToRemove.push_back(it->keyImage);
+            removedAmount += it->amount;
         }
+
+        index.erase(begin, index.end());
+
+        return removedAmount;
     };
 
     /* Remove both spent and unspent and locked inputs that were recieved after
      * the fork height */
     removeForked(m_lockedInputs);
-    removeForked(m_unspentInputs);
+    m_unspentBalance -= removeForked(m_unspentInputs);
     removeForked(m_spentInputs);
 
     /* If the input was spent after the fork height, but received before the
        fork height, then we keep it, but move it into the unspent vector */
-    const auto it = std::remove_if(m_spentInputs.begin(), m_spentInputs.end(), [&forkHeight, this](auto &input) {
-        if (input.spendHeight >= forkHeight)
-        {
-            /* Reset spend height */
-            input.spendHeight = 0;
+    auto &spent = m_spentInputs.get<InputSpendHeightIndex>();
 
-            bool inUnspent = std::find_if(m_unspentInputs.begin(), m_unspentInputs.end(), [&input](const auto x) {
-                return x.key == input.key;
-            }) != m_unspentInputs.end();
+    const auto spentAfterFork = spent.lower_bound(forkHeight);
 
-            if (!inUnspent)
-            {
-                /* Readd to the unspent vector */
-                m_unspentInputs.push_back(input);
-            }
-            else
-            {
-                std::stringstream stream;
-
-                stream << "Input with key " << input.key
-                       << " being marked as unspent is already present in unspent inputs vector.";
+    for (auto it = spentAfterFork; it != spent.end(); ++it)
+    {
+        WalletTypes::TransactionInput input = *it;
 
-                Logger::logger.log(
-                    stream.str(),
-                    Logger::WARNING,
-                    { Logger::SYNC }
-                );
-            }
+        /* Reset spend height */
+        input.spendHeight = 0;
 
-            return true;
-        }
+        /* Readd to the unspent vector */
+        if (!addUnspentInput(input))
+        {
+            std::stringstream stream;
 
-        return false;
-    });
+            stream << "Input with key " << input.key
+                   << " being marked as unspent is already present in unspent inputs vector.";
 
-    if (it != m_spentInputs.end())
-    {
-        m_spentInputs.erase(it, m_spentInputs.end());
+            Logger::logger.log(
+                stream.str(),
+                Logger::WARNING,
+                { Logger::SYNC }
+            );
+        }
     }
 
+    spent.erase(spentAfterFork, spent.end());
+
     if (isViewWallet)
     {
         return {};
@@ -400,23 +423,25 @@ std::vector<Crypto::KeyImage> SubWallet::removeForkedInputs(const uint64_t forkH
 void SubWallet::removeCancelledTransactions(const std::unordered_set<Crypto::Hash> cancelledTransactions)
 {
     /* Find the inputs used in the cancelled transactions */
-    auto it = std::remove_if(m_lockedInputs.begin(), m_lockedInputs.end(), [&cancelledTransactions, this](auto &input) {
-        if (cancelledTransactions.find(input.parentTransactionHash) != cancelledTransactions.end())
+    for (auto it = m_lockedInputs.begin(); it != m_lockedInputs.end();)
+    {
+        if (cancelledTransactions.find(it->parentTransactionHash) != cancelledTransactions.end())
         {
+            WalletTypes::TransactionInput input = *it;
+
             input.spendHeight = 0;
 
             /* Re-add the input to the unspent vector now it has been returned
                to our wallet */
-            m_unspentInputs.push_back(input);
-            return true;
-        }
-        return false;
-    });
+            addUnspentInput(input);
 
-    /* Remove the inputs used in the cancelled tranactions */
-    if (it != m_lockedInputs.end())
-    {
-        m_lockedInputs.erase(it, m_lockedInputs.end());
+            /* Remove the inputs used in the cancelled tranactions */
+            it = m_lockedInputs.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
     }
 
     /* Find inputs that we 'received' in outgoing transfers (scanning our
@@ -437,15 +462,24 @@ bool SubWallet::haveSpendableInput(
     const WalletTypes::TransactionInput& input,
     const uint64_t height) const
 {
-    for (const auto &i : m_unspentInputs)
+    const auto &byKeyImage = m_unspentInputs.get<InputKeyImageIndex>();
+
+    auto it = byKeyImage.find(input.keyImage);
+
+    if (it != byKeyImage.end())
     {
-        /* Checking for .key to support view wallets */
-        if (input.keyImage == i.keyImage || input.key == i.key)
-        {
-            /* Only gonna be one input that matches so can early return false
-             * if the input is locked */
-            return Utilities::isInputUnlocked(i.unlockTime, height);
-        }
+        return Utilities::isInputUnlocked(it->unlockTime, height);
+    }
+
+    /* Checking for .key to support view wallets */
+    const auto &byKey = m_unspentInputs.get<InputKeyIndex>();
+
+    const auto it2 = byKey.find(input.key);
+
+    if (it2 != byKey.end())
+    {
+        /* Only gonna be one input that matches */
+        return Utilities::isInputUnlocked(it2->unlockTime, height);
     }
 
     return false;
@@ -490,16 +524,14 @@ void SubWallet::convertSyncTimestampToHeight(const uint64_t timestamp, const uin
 
 void SubWallet::pruneSpentInputs(const uint64_t pruneHeight)
 {
-    const uint64_t lenBeforePrune = m_spentInputs.size();
-    const auto it = std::remove_if(m_spentInputs.begin(), m_spentInputs.end(), [&pruneHeight](const auto input) {
-        return input.spendHeight <= pruneHeight;
-    });
-    if (it != m_spentInputs.end())
-    {
-        m_spentInputs.erase(it, m_spentInputs.end());
-    }
-    const uint64_t lenAfterPrune = m_spentInputs.size();
-    const uint64_t difference = lenBeforePrune - lenAfterPrune;
+    auto &index = m_spentInputs.get<InputSpendHeightIndex>();
+
+    const auto end = index.upper_bound(pruneHeight);
+
+    const uint64_t difference = std::distance(index.begin(), end);
+
+    index.erase(index.begin(), end);
+
     if (difference != 0)
     {
         Logger::logger.log(
@@ -547,7 +579,7 @@ void SubWallet::fromJSON(const JSONValue &j)
     {
         WalletTypes::TransactionInput input;
         input.fromJSON(x);
-        m_unspentInputs.push_back(input);
+        addUnspentInput(input);
     }
     for (const auto &x : getArrayFromJSON(j, "lockedInputs"))
     {
@@ -571,7 +603,7 @@ void SubWallet::fromJSON(const JSONValue &j)
     }
 }
 
-void SubWallet::toJSON(rapidjson::Writer<rapidjson::StringBuffer> &writer) const
+void SubWallet::toJSON(rapidjson::Writer<rapidjson::StringBuffer> &writer, const bool includeInputs) const
 {
     writer.StartObject();
     writer.Key("walletIndex");
@@ -586,23 +618,32 @@ void SubWallet::toJSON(rapidjson::Writer<rapidjson::StringBuffer> &writer) const
     writer.Uint64(m_syncStartTimestamp);
     writer.Key("unspentInputs");
     writer.StartArray();
-    for (const auto &input : m_unspentInputs)
+    if (includeInputs)
     {
-        input.toJSON(writer);
+        for (const auto &input : m_unspentInputs)
+        {
+            input.toJSON(writer);
+        }
     }
     writer.EndArray();
     writer.Key("lockedInputs");
     writer.StartArray();
-    for (const auto &input : m_lockedInputs)
+    if (includeInputs)
     {
-        input.toJSON(writer);
+        for (const auto &input : m_lockedInputs)
+        {
+            input.toJSON(writer);
+        }
     }
     writer.EndArray();
     writer.Key("spentInputs");
     writer.StartArray();
-    for (const auto &input : m_spentInputs)
+    if (includeInputs)
     {
-        input.toJSON(writer);
+        for (const auto &input : m_spentInputs)
+        {
+            input.toJSON(writer);
+        }
     }
     writer.EndArray();
     writer.Key("syncStartHeight");
@@ -618,3 +659,22 @@ void SubWallet::toJSON(rapidjson::Writer<rapidjson::StringBuffer> &writer) const
     writer.EndArray();
     writer.EndObject();
 }
+
+void SubWallet::forEachInput(
+    const std::function<void(const std::string &list, const WalletTypes::TransactionInput &input)> &func) const
+{
+    for (const auto &input : m_unspentInputs)
+    {
+        func("unspentInputs", input);
+    }
+
+    for (const auto &input : m_lockedInputs)
+    {
+        func("lockedInputs", input);
+    }
+
+    for (const auto &input : m_spentInputs)
+    {
+        func("spentInputs", input);
+    }
+}
@@ -8,11 +8,64 @@
 #include "WalletTypes.h"
 #include "rapidjson/document.h"
 
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index_container.hpp>
 #include <crypto/crypto.h>
 #include <errors/Errors.h>
+#include <functional>
 #include <string>
 #include <unordered_set>
 
+struct InputKeyImageIndex
+{
+};
+
+struct InputKeyIndex
+{
+};
+
+struct InputBlockHeightIndex
+{
+};
+
+struct InputSpendHeightIndex
+{
+};
+
+struct InputUnlockTimeIndex
+{
+};
+
+/* Inputs are kept in the order they were added, which is the order they're
+   saved in, and indexed for the lookups done while syncing and sending, so
+   none of them have to walk every input we've ever received */
+typedef boost::multi_index_container<
+    WalletTypes::TransactionInput,
+    boost::multi_index::indexed_by<
+        boost::multi_index::sequenced<>,
+        /* View wallets can't generate key images, so these aren't unique */
+        boost::multi_index::hashed_non_unique<
+            boost::multi_index::tag<InputKeyImageIndex>,
+            BOOST_MULTI_INDEX_MEMBER(WalletTypes::TransactionInput, Crypto::KeyImage, keyImage),
+            std::hash<Crypto::KeyImage>>,
+        boost::multi_index::hashed_non_unique<
+            boost::multi_index::tag<InputKeyIndex>,
+            BOOST_MULTI_INDEX_MEMBER(WalletTypes::TransactionInput, Crypto::PublicKey, key),
+            std::hash<Crypto::PublicKey>>,
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<InputBlockHeightIndex>,
+            BOOST_MULTI_INDEX_MEMBER(WalletTypes::TransactionInput, uint64_t, blockHeight)>,
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<InputSpendHeightIndex>,
+            BOOST_MULTI_INDEX_MEMBER(WalletTypes::TransactionInput, uint64_t, spendHeight)>,
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<InputUnlockTimeIndex>,
+            BOOST_MULTI_INDEX_MEMBER(WalletTypes::TransactionInput, uint64_t, unlockTime)>>>
+    TransactionInputs;
+
 class SubWallet
 {
   public:
@@ -42,12 +95,18 @@ class SubWallet
     /* Public member functions */
     /////////////////////////////
 
-    /* Converts the class to a json object */
-    void toJSON(rapidjson::Writer<rapidjson::StringBuffer> &writer) const;
+    /* Converts the class to a json object. The input lists are left empty
+       if includeInputs is false, for when they're saved separately. */
+    void toJSON(rapidjson::Writer<rapidjson::StringBuffer> &writer, const bool includeInputs = true) const;
 
     /* Initializes the class from a json string */
     void fromJSON(const JSONValue &j);
 
+    /* Calls func with each input, and the name of the list it's in, as
+       it appears in the json */
+    void forEachInput(
+        const std::function<void(const std::string &list, const WalletTypes::TransactionInput &input)> &func) const;
+
     /* Generates a key image from the derivation, and stores the
        transaction input along with the key image filled in */
     std::tuple<Crypto::KeyImage, Crypto::SecretKey> getTxInputKeyImage(
@@ -104,16 +163,27 @@ class SubWallet
     /////////////////////////////
 
   private:
-    /* A vector of the stored transaction input data, to be used for
-       sending transactions later */
-    std::vector<WalletTypes::TransactionInput> m_unspentInputs;
+    /* Adds to the unspent inputs, keeping the unspent balance up to date.
+       Returns false if an input with the same key is already unspent. */
+    bool addUnspentInput(const WalletTypes::TransactionInput &input);
+
+    /* The sum of the unspent inputs which can't be spent yet */
+    uint64_t getLockedUnspentBalance(const uint64_t currentHeight) const;
+
+    /* The stored transaction input data, to be used for sending transactions
+       later */
+    TransactionInputs m_unspentInputs;
+
+    /* The sum of the unspent inputs, so we don't have to add them all up
+       whenever we're asked for our balance */
+    uint64_t m_unspentBalance = 0;
 
     /* Inputs which have been used in a transaction, and are waiting to
        either be put into a block, or return to our wallet */
-    std::vector<WalletTypes::TransactionInput> m_lockedInputs;
+    TransactionInputs m_lockedInputs;
 
     /* Inputs which have been spent in a transaction */
-    std::vector<WalletTypes::TransactionInput> m_spentInputs;
+    TransactionInputs m_spentInputs;
 
     /* Inputs which have come in from a transaction we sent - either from
        change or from sending to ourself - we use this to display unlocked
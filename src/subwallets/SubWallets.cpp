@@ -6,6 +6,7 @@
 #include <subwallets/SubWallets.h>
 //////////////////////////////////
 
+#include <common/StringTools.h>
 #include <config/CryptoNoteConfig.h>
 #include <ctime>
 #include <mutex>
@@ -241,33 +242,30 @@ Error SubWallets::deleteSubWallet(const std::string address)
     return SUCCESS;
 }
 
-void SubWallets::deleteAddressTransactions(std::vector<WalletTypes::Transaction> &txs, const Crypto::PublicKey spendKey)
+void SubWallets::deleteAddressTransactions(Transactions &txs, const Crypto::PublicKey spendKey)
 {
-    const auto it = std::remove_if(txs.begin(), txs.end(), [spendKey](auto &tx) {
+    for (auto it = txs.begin(); it != txs.end();)
+    {
         /* See if this transaction contains the subwallet we're deleting */
-        const auto key = tx.transfers.find(spendKey);
+        const auto key = it->transfers.find(spendKey);
 
         /* OK, it does */
-        if (key != tx.transfers.end())
+        if (key != it->transfers.end())
         {
             /* It's the only element, delete the transaction */
-            if (tx.transfers.size() == 1)
+            if (it->transfers.size() == 1)
             {
-                return true;
+                it = txs.erase(it);
+                continue;
             }
             /* Otherwise just delete the transfer in the transaction */
             else
             {
-                tx.transfers.erase(key);
+                txs.modify(it, [&spendKey](auto &tx) { tx.transfers.erase(spendKey); });
             }
         }
 
-        return false;
-    });
-
-    if (it != txs.end())
-    {
-        txs.erase(it, txs.end());
+        ++it;
     }
 }
 
@@ -325,12 +323,7 @@ void SubWallets::addUnconfirmedTransaction(const WalletTypes::Transaction tx)
 {
     std::scoped_lock lock(m_mutex);
 
-    const auto it2 =
-        std::find_if(m_lockedTransactions.begin(), m_lockedTransactions.end(), [tx](const auto transaction) {
-            return tx.hash == transaction.hash;
-        });
-
-    if (it2 != m_lockedTransactions.end())
+    if (!m_lockedTransactions.push_back(tx).second)
     {
         std::stringstream stream;
 
@@ -341,11 +334,7 @@ void SubWallets::addUnconfirmedTransaction(const WalletTypes::Transaction tx)
             Logger::WARNING,
             { Logger::SYNC }
         );
-
-        return;
     }
-
-    m_lockedTransactions.push_back(tx);
 }
 
 void SubWallets::addTransaction(const WalletTypes::Transaction tx)
@@ -356,22 +345,9 @@ void SubWallets::addTransaction(const WalletTypes::Transaction tx)
        vector instantly. This lets us display the data to the user, and then
        when the transaction actually comes in, we will update the transaction
        with the block infomation. */
-    const auto it =
-        std::remove_if(m_lockedTransactions.begin(), m_lockedTransactions.end(), [tx](const auto transaction) {
-            return tx.hash == transaction.hash;
-        });
-
-    if (it != m_lockedTransactions.end())
-    {
-        /* Remove from the locked container */
-        m_lockedTransactions.erase(it, m_lockedTransactions.end());
-    }
+    m_lockedTransactions.get<TransactionHashIndex>().erase(tx.hash);
 
-    const auto it2 = std::find_if(m_transactions.begin(), m_transactions.end(), [tx](const auto transaction) {
-        return tx.hash == transaction.hash;
-    });
-
-    if (it2 != m_transactions.end())
+    if (!m_transactions.push_back(tx).second)
     {
         std::stringstream stream;
 
@@ -382,11 +358,7 @@ void SubWallets::addTransaction(const WalletTypes::Transaction tx)
             Logger::WARNING,
             { Logger::SYNC }
         );
-
-        return;
     }
-
-    m_transactions.push_back(tx);
 }
 
 std::tuple<Crypto::KeyImage, Crypto::SecretKey> SubWallets::getTxInputKeyImage(
@@ -483,20 +455,20 @@ std::vector<WalletTypes::TxInputAndOwner> SubWallets::getSpendableTransactionInp
         subWalletsToTakeFrom = m_publicSpendKeys;
     }
 
-    std::vector<SubWallet> wallets;
+    std::vector<const SubWallet *> wallets;
 
     /* Loop through each public key and grab the associated wallet */
     for (const auto &publicKey : subWalletsToTakeFrom)
     {
-        wallets.push_back(m_subWallets.at(publicKey));
+        wallets.push_back(&m_subWallets.at(publicKey));
     }
 
     std::vector<WalletTypes::TxInputAndOwner> availableInputs;
 
     /* Copy the transaction inputs from this sub wallet to inputs */
-    for (const auto &subWallet : wallets)
+    for (const auto subWallet : wallets)
     {
-        const auto moreInputs = subWallet.getSpendableInputs(height);
+        const auto moreInputs = subWallet->getSpendableInputs(height);
 
         availableInputs.insert(availableInputs.end(), moreInputs.begin(), moreInputs.end());
     }
@@ -570,20 +542,20 @@ std::tuple<std::vector<WalletTypes::TxInputAndOwner>, uint64_t, uint64_t> SubWal
         subWalletsToTakeFrom = m_publicSpendKeys;
     }
 
-    std::vector<SubWallet> wallets;
+    std::vector<const SubWallet *> wallets;
 
     /* Loop through each public key and grab the associated wallet */
     for (const auto &publicKey : subWalletsToTakeFrom)
     {
-        wallets.push_back(m_subWallets.at(publicKey));
+        wallets.push_back(&m_subWallets.at(publicKey));
     }
 
     std::vector<WalletTypes::TxInputAndOwner> availableInputs;
 
     /* Copy the transaction inputs from this sub wallet to inputs */
-    for (const auto &subWallet : wallets)
+    for (const auto subWallet : wallets)
     {
-        const auto moreInputs = subWallet.getSpendableInputs(height);
+        const auto moreInputs = subWallet->getSpendableInputs(height);
 
         availableInputs.insert(availableInputs.end(), moreInputs.begin(), moreInputs.end());
     }
@@ -776,15 +748,10 @@ void SubWallets::removeForkedTransactions(const uint64_t forkHeight)
 {
     std::scoped_lock lock(m_mutex);
 
-    const auto it = std::remove_if(m_transactions.begin(), m_transactions.end(), [forkHeight](auto tx) {
-        /* Remove the transaction if it's height is >= than the fork height */
-        return tx.blockHeight >= forkHeight;
-    });
+    /* Remove the transactions with a height >= than the fork height */
+    auto &byHeight = m_transactions.get<TransactionBlockHeightIndex>();
 
-    if (it != m_transactions.end())
-    {
-        m_transactions.erase(it, m_transactions.end());
-    }
+    byHeight.erase(byHeight.lower_bound(forkHeight), byHeight.end());
 
     std::vector<Crypto::KeyImage> keyImagesToRemove;
 
@@ -808,16 +775,10 @@ void SubWallets::removeCancelledTransactions(const std::unordered_set<Crypto::Ha
 
     std::scoped_lock lock(m_mutex);
 
-    /* Find any cancelled transactions */
-    const auto it = std::remove_if(
-        m_lockedTransactions.begin(), m_lockedTransactions.end(), [&cancelledTransactions](const auto &tx) {
-            return cancelledTransactions.find(tx.hash) != cancelledTransactions.end();
-        });
-
-    if (it != m_lockedTransactions.end())
+    /* Remove the cancelled transactions */
+    for (const auto &hash : cancelledTransactions)
     {
-        /* Remove the cancelled transactions */
-        m_lockedTransactions.erase(it, m_lockedTransactions.end());
+        m_lockedTransactions.get<TransactionHashIndex>().erase(hash);
     }
 
     for (auto &[pubKey, subWallet] : m_subWallets)
@@ -919,7 +880,40 @@ Crypto::SecretKey SubWallets::getPrimaryPrivateSpendKey() const
 
 std::vector<WalletTypes::Transaction> SubWallets::getTransactions() const
 {
-    return m_transactions;
+    std::scoped_lock lock(m_mutex);
+
+    return {m_transactions.begin(), m_transactions.end()};
+}
+
+std::vector<WalletTypes::Transaction>
+    SubWallets::getTransactionsRange(const uint64_t startHeight, const uint64_t endHeight) const
+{
+    std::scoped_lock lock(m_mutex);
+
+    if (startHeight >= endHeight)
+    {
+        return {};
+    }
+
+    const auto &byHeight = m_transactions.get<TransactionBlockHeightIndex>();
+
+    return {byHeight.lower_bound(startHeight), byHeight.lower_bound(endHeight)};
+}
+
+std::optional<WalletTypes::Transaction> SubWallets::getTransaction(const Crypto::Hash transactionHash) const
+{
+    std::scoped_lock lock(m_mutex);
+
+    const auto &byHash = m_transactions.get<TransactionHashIndex>();
+
+    const auto it = byHash.find(transactionHash);
+
+    if (it == byHash.end())
+    {
+        return std::nullopt;
+    }
+
+    return *it;
 }
 
 /* Note that this DOES NOT return incoming transactions in the pool. It only
@@ -927,7 +921,9 @@ std::vector<WalletTypes::Transaction> SubWallets::getTransactions() const
    block yet. */
 std::vector<WalletTypes::Transaction> SubWallets::getUnconfirmedTransactions() const
 {
-    return m_lockedTransactions;
+    std::scoped_lock lock(m_mutex);
+
+    return {m_lockedTransactions.begin(), m_lockedTransactions.end()};
 }
 
 std::tuple<Error, std::string> SubWallets::getAddress(const Crypto::PublicKey spendKey) const
@@ -1068,7 +1064,7 @@ void SubWallets::fromJSON(const JSONObject &j)
     }
 }
 
-void SubWallets::toJSON(rapidjson::Writer<rapidjson::StringBuffer> &writer) const
+void SubWallets::toJSON(rapidjson::Writer<rapidjson::StringBuffer> &writer, const bool includeRecords) const
 {
     writer.StartObject();
 
@@ -1085,17 +1081,23 @@ void SubWallets::toJSON(rapidjson::Writer<rapidjson::StringBuffer> &writer) cons
 
     writer.Key("subWallet");
     writer.StartArray();
-    for (const auto &[publicKey, subWallet] : m_subWallets)
+    if (includeRecords)
     {
-        subWallet.toJSON(writer);
+        for (const auto &[publicKey, subWallet] : m_subWallets)
+        {
+            subWallet.toJSON(writer);
+        }
     }
     writer.EndArray();
 
     writer.Key("transactions");
     writer.StartArray();
-    for (const auto &tx : m_transactions)
+    if (includeRecords)
     {
-        tx.toJSON(writer);
+        for (const auto &tx : m_transactions)
+        {
+            tx.toJSON(writer);
+        }
     }
     writer.EndArray();
 
@@ -1131,3 +1133,154 @@ void SubWallets::toJSON(rapidjson::Writer<rapidjson::StringBuffer> &writer) cons
 
     writer.EndObject();
 }
+
+void SubWallets::toJournalRecords(
+    const std::function<void(const std::string &key, const std::string &value)> &put) const
+{
+    /* Each record is serialized on its own, so we never hold the json for
+       the whole wallet at once */
+    const auto toJSONString = [](const auto &serialize) {
+        rapidjson::StringBuffer sb;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+
+        serialize(writer);
+
+        return std::string(sb.GetString(), sb.GetSize());
+    };
+
+    put("subWallets", toJSONString([this](auto &writer) { toJSON(writer, false); }));
+
+    for (const auto &[publicKey, subWallet] : m_subWallets)
+    {
+        const std::string subWalletKey = "subWallets/subWallet/" + Common::podToHex(publicKey);
+
+        put(subWalletKey, toJSONString([&subWallet](auto &writer) { subWallet.toJSON(writer, false); }));
+
+        subWallet.forEachInput([&](const std::string &list, const WalletTypes::TransactionInput &input) {
+            /* Output keys are only unique within a transaction */
+            const std::string inputKey = subWalletKey + "/" + list + "/"
+                                         + Common::podToHex(input.parentTransactionHash) + "/"
+                                         + Common::podToHex(input.key);
+
+            put(inputKey, toJSONString([&input](auto &writer) { input.toJSON(writer); }));
+        });
+    }
+
+    for (const auto &tx : m_transactions)
+    {
+        put("subWallets/transaction/" + Common::podToHex(tx.hash),
+            toJSONString([&tx](auto &writer) { tx.toJSON(writer); }));
+    }
+}
+
+void SubWallets::fromJournalRecords(const std::vector<std::pair<std::string, std::string>> &records)
+{
+    const std::string subWalletPrefix = "subWallets/subWallet/";
+    const std::string transactionPrefix = "subWallets/transaction/";
+
+    /* Put the json back together as toJSON() would have written it */
+    rapidjson::Document j;
+
+    auto &allocator = j.GetAllocator();
+
+    const auto parse = [&allocator](const std::string &json) {
+        rapidjson::Document document(&allocator);
+
+        if (document.Parse(json.c_str(), json.size()).HasParseError())
+        {
+            throw std::invalid_argument("Failed to parse wallet journal record");
+        }
+
+        rapidjson::Value value;
+        value = document.Move();
+
+        return value;
+    };
+
+    std::vector<rapidjson::Value> subWallets;
+    std::unordered_map<std::string, size_t> subWalletIndexes;
+    rapidjson::Value transactions(rapidjson::kArrayType);
+
+    bool haveContainer = false;
+
+    for (const auto &[key, value] : records)
+    {
+        if (key == "subWallets")
+        {
+            j.Parse(value.c_str(), value.size());
+
+            if (j.HasParseError() || !j.IsObject())
+            {
+                throw std::invalid_argument("Failed to parse wallet journal record");
+            }
+
+            haveContainer = true;
+        }
+        /* Inputs are added once we've found all the subwallets */
+        else if (key.compare(0, subWalletPrefix.size(), subWalletPrefix) == 0
+                 && key.find('/', subWalletPrefix.size()) == std::string::npos)
+        {
+            subWalletIndexes[key] = subWallets.size();
+            subWallets.push_back(parse(value));
+        }
+        else if (key.compare(0, transactionPrefix.size(), transactionPrefix) == 0)
+        {
+            transactions.PushBack(parse(value), allocator);
+        }
+    }
+
+    if (!haveContainer)
+    {
+        throw std::invalid_argument("Missing subWallets record in wallet journal");
+    }
+
+    for (const auto &[key, value] : records)
+    {
+        if (key.compare(0, subWalletPrefix.size(), subWalletPrefix) != 0)
+        {
+            continue;
+        }
+
+        /* subWallets/subWallet/<spend key>/<list>/<transaction hash>/<key> */
+        const size_t listStart = key.find('/', subWalletPrefix.size());
+
+        if (listStart == std::string::npos)
+        {
+            continue;
+        }
+
+        const size_t listEnd = key.find('/', listStart + 1);
+
+        const auto subWallet = subWalletIndexes.find(key.substr(0, listStart));
+
+        if (listEnd == std::string::npos || subWallet == subWalletIndexes.end())
+        {
+            throw std::invalid_argument("Wallet journal input record " + key + " has no subwallet");
+        }
+
+        const std::string list = key.substr(listStart + 1, listEnd - listStart - 1);
+
+        auto &subWalletJSON = subWallets[subWallet->second];
+
+        const auto inputs = subWalletJSON.FindMember(list.c_str());
+
+        if (inputs == subWalletJSON.MemberEnd() || !inputs->value.IsArray())
+        {
+            throw std::invalid_argument("Wallet journal input record " + key + " has an unknown list");
+        }
+
+        inputs->value.PushBack(parse(value), allocator);
+    }
+
+    rapidjson::Value subWalletsJSON(rapidjson::kArrayType);
+
+    for (auto &subWallet : subWallets)
+    {
+        subWalletsJSON.PushBack(subWallet, allocator);
+    }
+
+    j["subWallet"] = subWalletsJSON;
+    j["transactions"] = transactions;
+
+    fromJSON(static_cast<const rapidjson::Value &>(j).Get_Object());
+}
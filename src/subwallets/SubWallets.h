@@ -5,8 +5,33 @@
 #pragma once
 
 #include <crypto/crypto.h>
+#include <optional>
 #include <subwallets/SubWallet.h>
 
+struct TransactionHashIndex
+{
+};
+
+struct TransactionBlockHeightIndex
+{
+};
+
+/* Transactions are kept in the order they were added, and indexed by hash
+   and block height, so they can be looked up, and a range of them fetched
+   or removed, without going through the whole history */
+typedef boost::multi_index_container<
+    WalletTypes::Transaction,
+    boost::multi_index::indexed_by<
+        boost::multi_index::sequenced<>,
+        boost::multi_index::hashed_unique<
+            boost::multi_index::tag<TransactionHashIndex>,
+            BOOST_MULTI_INDEX_MEMBER(WalletTypes::Transaction, Crypto::Hash, hash),
+            std::hash<Crypto::Hash>>,
+        boost::multi_index::ordered_non_unique<
+            boost::multi_index::tag<TransactionBlockHeightIndex>,
+            BOOST_MULTI_INDEX_MEMBER(WalletTypes::Transaction, uint64_t, blockHeight)>>>
+    Transactions;
+
 class SubWallets
 {
   public:
@@ -57,12 +82,24 @@ class SubWallets
        of the values will be non zero */
     std::tuple<uint64_t, uint64_t> getMinInitialSyncStart() const;
 
-    /* Converts the class to a json object */
-    void toJSON(rapidjson::Writer<rapidjson::StringBuffer> &writer) const;
+    /* Converts the class to a json object. The subwallets and transactions
+       are left empty if includeRecords is false, for when they're saved
+       separately. */
+    void toJSON(rapidjson::Writer<rapidjson::StringBuffer> &writer, const bool includeRecords = true) const;
 
     /* Initializes the class from a json string */
     void fromJSON(const JSONObject &j);
 
+    /* Splits the class into records for the wallet journal - the container
+       itself, then each subwallet, each of their inputs, and each
+       transaction - so saving only has to write the ones which changed.
+       Each record is the json it would have in toJSON(). */
+    void toJournalRecords(const std::function<void(const std::string &key, const std::string &value)> &put) const;
+
+    /* Initializes the class from the records given by toJournalRecords().
+       Records which aren't ours are ignored. */
+    void fromJournalRecords(const std::vector<std::pair<std::string, std::string>> &records);
+
     /* Store a transaction */
     void addTransaction(const WalletTypes::Transaction tx);
 
@@ -149,6 +186,13 @@ class SubWallets
 
     std::vector<WalletTypes::Transaction> getTransactions() const;
 
+    /* Returns transactions in the range [startHeight, endHeight - 1] */
+    std::vector<WalletTypes::Transaction>
+        getTransactionsRange(const uint64_t startHeight, const uint64_t endHeight) const;
+
+    /* Returns the confirmed transaction with the given hash, if we have it */
+    std::optional<WalletTypes::Transaction> getTransaction(const Crypto::Hash transactionHash) const;
+
     /* Note that this DOES NOT return incoming transactions in the pool. It only
        returns outgoing transactions which we sent but have not encountered in a
        block yet. */
@@ -190,7 +234,7 @@ class SubWallets
     /* Deletes any transactions containing the given spend key, or just
        removes from the transfers array if there are multiple transfers
        in the tx */
-    void deleteAddressTransactions(std::vector<WalletTypes::Transaction> &txs, const Crypto::PublicKey spendKey);
+    void deleteAddressTransactions(Transactions &txs, const Crypto::PublicKey spendKey);
 
     //////////////////////////////
     /* Private member variables */
@@ -202,11 +246,11 @@ class SubWallets
     /* The subwallets, indexed by public spend key */
     std::unordered_map<Crypto::PublicKey, SubWallet> m_subWallets;
 
-    /* A vector of transactions */
-    std::vector<WalletTypes::Transaction> m_transactions;
+    /* The transactions in blocks */
+    Transactions m_transactions;
 
     /* Transactions which we sent, but haven't been added to a block yet */
-    std::vector<WalletTypes::Transaction> m_lockedTransactions;
+    Transactions m_lockedTransactions;
 
     Crypto::SecretKey m_privateViewKey;
 
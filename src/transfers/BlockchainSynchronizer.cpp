@@ -12,6 +12,7 @@
 #include "cryptonotecore/TransactionApi.h"
 
 #include <functional>
+#include <future>
 #include <iostream>
 #include <sstream>
 #include <unordered_set>
@@ -66,9 +67,11 @@ namespace CryptoNote
     BlockchainSynchronizer::BlockchainSynchronizer(
         INode &node,
         std::shared_ptr<Logging::ILogger> logger,
-        const Hash &genesisBlockHash):
+        const Hash &genesisBlockHash,
+        PreprocessingExecutor &executor):
         m_logger(logger, "BlockchainSynchronizer"),
         m_node(node),
+        m_executor(executor),
         m_genesisBlockHash(genesisBlockHash),
         m_currentState(State::stopped),
         m_futureState(State::stopped)
@@ -604,6 +607,14 @@ namespace CryptoNote
                         completeBlock.transactions.push_back(createTransactionPrefix(
                             txShortInfo.txPrefix, reinterpret_cast<const Hash &>(txShortInfo.txId)));
                     }
+
+                    /* Indexed once here, and shared by all the consumers */
+                    completeBlock.scanInfo.reserve(completeBlock.transactions.size());
+
+                    for (const auto &transaction : completeBlock.transactions)
+                    {
+                        completeBlock.scanInfo.push_back(getTransactionScanInfo(*transaction));
+                    }
                 }
                 catch (const std::exception &e)
                 {
@@ -676,7 +687,18 @@ namespace CryptoNote
         bool smthChanged = false;
         bool hasErrors = false;
 
-        uint32_t lastBlockIndex = std::numeric_limits<uint32_t>::max();
+        struct ConsumerUpdate
+        {
+            IBlockchainConsumer *consumer;
+            SynchronizationState *state;
+            uint32_t newBlockHeight;
+            uint32_t startOffset;
+            uint32_t blockCount;
+            uint32_t addedCount;
+        };
+
+        std::vector<ConsumerUpdate> updates;
+
         for (auto &kv : m_consumers)
         {
             auto result = kv.second->checkInterval(interval);
@@ -701,34 +723,70 @@ namespace CryptoNote
                     startOffset = 0;
                 }
                 uint32_t blockCount = static_cast<uint32_t>(blocks.size()) - startOffset;
-                // update consumer
-                m_logger(DEBUGGING) << "Adding blocks to consumer, consumer " << kv.first << ", start index "
-                                    << result.newBlockHeight << ", count " << blockCount;
-                uint32_t addedCount =
-                    kv.first->onNewBlocks(blocks.data() + startOffset, result.newBlockHeight, blockCount);
-                if (addedCount > 0)
-                {
-                    if (addedCount < blockCount)
-                    {
-                        m_logger(ERROR, BRIGHT_RED) << "Failed to add " << (blockCount - addedCount) << " blocks of "
-                                                    << blockCount << " to consumer, consumer " << kv.first;
-                        hasErrors = true;
-                    }
 
-                    // update state if consumer succeeded
-                    kv.second->addBlocks(interval.blocks.data() + startOffset, result.newBlockHeight, addedCount);
-                    smthChanged = true;
-                }
-                else
+                updates.push_back({kv.first, kv.second.get(), result.newBlockHeight, startOffset, blockCount, 0});
+            }
+        }
+
+        std::vector<std::exception_ptr> errors(updates.size());
+
+        auto updateConsumer = [&](const size_t i) {
+            ConsumerUpdate &update = updates[i];
+
+            m_logger(DEBUGGING) << "Adding blocks to consumer, consumer " << update.consumer << ", start index "
+                                << update.newBlockHeight << ", count " << update.blockCount;
+
+            try
+            {
+                update.addedCount = update.consumer->onNewBlocks(
+                    blocks.data() + update.startOffset, update.newBlockHeight, update.blockCount);
+            }
+            catch (...)
+            {
+                errors[i] = std::current_exception();
+            }
+
+            return true;
+        };
+
+        /* The consumers scan the same blocks for different view keys, and
+           don't share any state, so they can all go at once. Each keeps its
+           own place in the chain, so one failing doesn't hold the others
+           back. */
+        m_executor.run(updates.size(), updateConsumer, [](size_t) { return true; });
+
+        for (const auto &error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+
+        uint32_t lastBlockIndex = std::numeric_limits<uint32_t>::max();
+        for (const auto &update : updates)
+        {
+            if (update.addedCount > 0)
+            {
+                if (update.addedCount < update.blockCount)
                 {
-                    m_logger(ERROR, BRIGHT_RED) << "Failed to add blocks to consumer, consumer " << kv.first;
+                    m_logger(ERROR, BRIGHT_RED) << "Failed to add " << (update.blockCount - update.addedCount)
+                                                << " blocks of " << update.blockCount << " to consumer, consumer "
+                                                << update.consumer;
                     hasErrors = true;
                 }
 
-                if (addedCount > 0)
-                {
-                    lastBlockIndex = std::min(lastBlockIndex, startOffset + addedCount - 1);
-                }
+                // update state if consumer succeeded
+                update.state->addBlocks(
+                    interval.blocks.data() + update.startOffset, update.newBlockHeight, update.addedCount);
+                smthChanged = true;
+
+                lastBlockIndex = std::min(lastBlockIndex, update.startOffset + update.addedCount - 1);
+            }
+            else
+            {
+                m_logger(ERROR, BRIGHT_RED) << "Failed to add blocks to consumer, consumer " << update.consumer;
+                hasErrors = true;
             }
         }
 
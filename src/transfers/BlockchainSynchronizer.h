@@ -9,6 +9,7 @@
 #include "INode.h"
 #include "IObservableImpl.h"
 #include "IStreamSerializable.h"
+#include "PreprocessingExecutor.h"
 #include "SynchronizationState.h"
 #include "logging/LoggerRef.h"
 
@@ -27,7 +28,8 @@ namespace CryptoNote
         BlockchainSynchronizer(
             INode &node,
             std::shared_ptr<Logging::ILogger> logger,
-            const Crypto::Hash &genesisBlockHash);
+            const Crypto::Hash &genesisBlockHash,
+            PreprocessingExecutor &executor);
 
         ~BlockchainSynchronizer();
 
@@ -161,6 +163,9 @@ namespace CryptoNote
 
         INode &m_node;
 
+        /* Runs the consumer updates for a batch of blocks side by side */
+        PreprocessingExecutor &m_executor;
+
         const Crypto::Hash m_genesisBlockHash;
 
         Crypto::Hash lastBlockId;
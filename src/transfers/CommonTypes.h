@@ -12,6 +12,7 @@
 #include <boost/optional.hpp>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace CryptoNote
 {
@@ -21,12 +22,49 @@ namespace CryptoNote
         std::vector<Crypto::Hash> blocks;
     };
 
+    struct ScannedKeyOutput
+    {
+        uint32_t outputIndex;
+        Crypto::PublicKey key;
+    };
+
+    /* What every consumer needs to scan a transaction for its view key,
+       pulled out of the transaction once, however many consumers scan it */
+    struct TransactionScanInfo
+    {
+        Crypto::PublicKey publicKey;
+        std::vector<ScannedKeyOutput> keyOutputs;
+    };
+
+    inline TransactionScanInfo getTransactionScanInfo(const ITransactionReader &tx)
+    {
+        TransactionScanInfo info;
+        info.publicKey = tx.getTransactionPublicKey();
+
+        const size_t outputCount = tx.getOutputCount();
+
+        for (size_t i = 0; i < outputCount; ++i)
+        {
+            if (tx.getOutputType(i) == TransactionTypes::OutputType::Key)
+            {
+                uint64_t amount;
+                KeyOutput out;
+                tx.getOutput(i, out, amount);
+                info.keyOutputs.push_back({static_cast<uint32_t>(i), out.key});
+            }
+        }
+
+        return info;
+    }
+
     struct CompleteBlock
     {
         Crypto::Hash blockHash;
         boost::optional<CryptoNote::BlockTemplate> block;
         // first transaction is always coinbase
         std::list<std::shared_ptr<ITransactionReader>> transactions;
+        // one for each transaction, in the same order
+        std::vector<TransactionScanInfo> scanInfo;
     };
 
 } // namespace CryptoNote
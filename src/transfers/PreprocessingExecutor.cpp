@@ -0,0 +1,213 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "PreprocessingExecutor.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace CryptoNote
+{
+    PreprocessingExecutor::Batch::Batch(const size_t count, const std::function<bool(size_t)> &job):
+        count(count),
+        job(job),
+        completed(new std::atomic<bool>[count])
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            completed[i] = false;
+        }
+    }
+
+    PreprocessingExecutor::PreprocessingExecutor(size_t threadCount)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::thread::hardware_concurrency();
+        }
+
+        if (threadCount == 0)
+        {
+            threadCount = 2;
+        }
+
+        for (size_t i = 0; i < threadCount; i++)
+        {
+            m_threads.emplace_back(&PreprocessingExecutor::workerProcedure, this);
+        }
+    }
+
+    PreprocessingExecutor::~PreprocessingExecutor()
+    {
+        {
+            std::scoped_lock lock(m_mutex);
+            m_stopping = true;
+        }
+
+        m_batchAvailable.notify_all();
+
+        for (auto &thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    size_t PreprocessingExecutor::run(
+        const size_t count,
+        const std::function<bool(size_t)> &job,
+        const std::function<bool(size_t)> &consume)
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        Batch batch(count, job);
+
+        {
+            std::scoped_lock lock(m_mutex);
+            m_batches.push_back(&batch);
+        }
+
+        m_batchAvailable.notify_all();
+
+        size_t consumed = 0;
+
+        std::exception_ptr error;
+
+        try
+        {
+            for (; consumed < count; consumed++)
+            {
+                while (!batch.completed[consumed] && !batch.stopped)
+                {
+                    if (batch.next < batch.count)
+                    {
+                        process(batch);
+                        continue;
+                    }
+
+                    /* Everything is handed out, wait for the workers */
+                    std::unique_lock<std::mutex> lock(batch.mutex);
+
+                    batch.itemCompleted.wait(lock, [&] { return batch.completed[consumed] || batch.stopped; });
+                }
+
+                /* A job failed, or was skipped because another one did */
+                if (!batch.completed[consumed] || !consume(consumed))
+                {
+                    break;
+                }
+            }
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        /* Stop handing out the rest, and wait for the workers to let go of
+           the batch, as it's about to go out of scope */
+        batch.stopped = true;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_batches.erase(std::find(m_batches.begin(), m_batches.end(), &batch));
+
+            m_workersFinished.wait(lock, [&] { return batch.activeWorkers == 0; });
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+
+        return consumed;
+    }
+
+    void PreprocessingExecutor::workerProcedure()
+    {
+        while (true)
+        {
+            Batch *batch;
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+
+                m_batchAvailable.wait(lock, [&] { return m_stopping || (batch = findWork()) != nullptr; });
+
+                if (m_stopping)
+                {
+                    return;
+                }
+
+                batch->activeWorkers++;
+            }
+
+            process(*batch);
+
+            {
+                std::scoped_lock lock(m_mutex);
+                batch->activeWorkers--;
+            }
+
+            m_workersFinished.notify_all();
+        }
+    }
+
+    PreprocessingExecutor::Batch *PreprocessingExecutor::findWork()
+    {
+        /* Take turns between the batches, so one caller doesn't have to wait
+           for another's batch to be finished before its own gets going */
+        for (size_t i = 0; i < m_batches.size(); i++)
+        {
+            Batch *batch = m_batches[(m_nextBatch + i) % m_batches.size()];
+
+            if (!batch->stopped && batch->next < batch->count)
+            {
+                m_nextBatch = (m_nextBatch + i + 1) % m_batches.size();
+                return batch;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void PreprocessingExecutor::process(Batch &batch)
+    {
+        const size_t i = batch.next++;
+
+        if (batch.stopped || i >= batch.count)
+        {
+            return;
+        }
+
+        bool success = false;
+
+        try
+        {
+            success = batch.job(i);
+        }
+        catch (...)
+        {
+        }
+
+        if (success)
+        {
+            batch.completed[i] = true;
+        }
+        else
+        {
+            batch.stopped = true;
+        }
+
+        /* Taking the lock makes sure the caller is either asleep, and gets
+           woken, or hasn't checked the flags yet */
+        {
+            std::scoped_lock lock(batch.mutex);
+        }
+
+        batch.itemCompleted.notify_one();
+    }
+} // namespace CryptoNote
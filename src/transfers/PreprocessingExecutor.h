@@ -0,0 +1,101 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CryptoNote
+{
+    /* A fixed set of threads which preprocess the transactions of a batch of
+       blocks in parallel, while the caller works through the results in
+       order. The threads live as long as the executor, so syncing in lots of
+       small batches doesn't pay for starting and stopping them each time. */
+    class PreprocessingExecutor
+    {
+      public:
+        /* Zero picks the amount of hardware threads */
+        explicit PreprocessingExecutor(size_t threadCount = 0);
+
+        ~PreprocessingExecutor();
+
+        PreprocessingExecutor(const PreprocessingExecutor &) = delete;
+
+        PreprocessingExecutor &operator=(const PreprocessingExecutor &) = delete;
+
+        /* Calls job(i) on the worker threads for every i in [0, count), and
+           consume(i) on this thread, in order, as soon as job(i) and all
+           those before it have completed. Each job should only write to its
+           own output, so the workers don't need to lock anything to hand
+           their results back.
+
+           Stops early if a job or consume returns false. Returns the amount
+           of items consumed. Several callers can run batches at once, in
+           which case the workers share themselves out between them.
+
+           While the next item isn't done, the caller works on the batch
+           too, so a job can run a batch of its own without the workers all
+           ending up waiting on each other. */
+        size_t run(
+            const size_t count,
+            const std::function<bool(size_t)> &job,
+            const std::function<bool(size_t)> &consume);
+
+      private:
+        struct Batch
+        {
+            Batch(const size_t count, const std::function<bool(size_t)> &job);
+
+            const size_t count;
+
+            const std::function<bool(size_t)> &job;
+
+            /* The next item a worker should pick up */
+            std::atomic<size_t> next {0};
+
+            /* Set when a job fails, or the caller gives up on the batch */
+            std::atomic<bool> stopped {false};
+
+            std::unique_ptr<std::atomic<bool>[]> completed;
+
+            /* Only used to sleep on while the next item in order isn't done */
+            std::mutex mutex;
+
+            std::condition_variable itemCompleted;
+
+            /* Workers which may still touch the batch, guarded by m_mutex */
+            size_t activeWorkers = 0;
+        };
+
+        void workerProcedure();
+
+        /* Works on the next item of the batch */
+        void process(Batch &batch);
+
+        /* A batch with items left to hand out, if any. m_mutex must be held. */
+        Batch *findWork();
+
+        std::vector<std::thread> m_threads;
+
+        std::mutex m_mutex;
+
+        std::condition_variable m_batchAvailable;
+
+        std::condition_variable m_workersFinished;
+
+        /* The batches being worked on, guarded by m_mutex */
+        std::vector<Batch *> m_batches;
+
+        /* Where findWork() starts looking next time */
+        size_t m_nextBatch = 0;
+
+        bool m_stopping = false;
+    };
+} // namespace CryptoNote
@@ -10,7 +10,6 @@
 #include "CommonTypes.h"
 #include "INode.h"
 #include "WalletGreenTypes.h"
-#include "common/BlockingQueue.h"
 #include "cryptonotecore/CryptoNoteBasicImpl.h"
 #include "cryptonotecore/CryptoNoteFormatUtils.h"
 #include "cryptonotecore/TransactionApi.h"
@@ -65,34 +64,22 @@ namespace
     }
 
     void findMyOutputs(
-        const ITransactionReader &tx,
+        const TransactionScanInfo &scanInfo,
         const SecretKey &viewSecretKey,
         const std::unordered_set<PublicKey> &spendKeys,
         std::unordered_map<PublicKey, std::vector<uint32_t>> &outputs)
     {
-        auto txPublicKey = tx.getTransactionPublicKey();
         KeyDerivation derivation;
 
-        if (!generate_key_derivation(txPublicKey, viewSecretKey, derivation))
+        if (!generate_key_derivation(scanInfo.publicKey, viewSecretKey, derivation))
         {
             return;
         }
 
-        size_t keyIndex = 0;
-        size_t outputCount = tx.getOutputCount();
-
-        for (size_t idx = 0; idx < outputCount; ++idx)
+        for (size_t keyIndex = 0; keyIndex < scanInfo.keyOutputs.size(); ++keyIndex)
         {
-            auto outType = tx.getOutputType(size_t(idx));
-
-            if (outType == TransactionTypes::OutputType::Key)
-            {
-                uint64_t amount;
-                KeyOutput out;
-                tx.getOutput(idx, out, amount);
-                checkOutputKey(derivation, out.key, keyIndex, idx, spendKeys, outputs);
-                ++keyIndex;
-            }
+            const auto &out = scanInfo.keyOutputs[keyIndex];
+            checkOutputKey(derivation, out.key, keyIndex, out.outputIndex, spendKeys, outputs);
         }
     }
 
@@ -117,11 +104,13 @@ namespace CryptoNote
         const CryptoNote::Currency &currency,
         INode &node,
         std::shared_ptr<Logging::ILogger> logger,
-        const SecretKey &viewSecret):
+        const SecretKey &viewSecret,
+        PreprocessingExecutor &preprocessingExecutor):
         m_node(node),
         m_viewSecret(viewSecret),
         m_currency(currency),
-        m_logger(logger, "TransfersConsumer")
+        m_logger(logger, "TransfersConsumer"),
+        m_preprocessingExecutor(preprocessingExecutor)
     {
         updateSyncStart();
     }
@@ -233,161 +222,134 @@ namespace CryptoNote
         assert(blocks);
         assert(count > 0);
 
-        struct Tx
+        struct PreprocessedTx : PreprocessInfo
         {
             TransactionBlockInfo blockInfo;
             const ITransactionReader *tx;
+            const TransactionScanInfo *scanInfo;
             bool isLastTransactionInBlock;
+            std::error_code error;
         };
 
-        struct PreprocessedTx : Tx, PreprocessInfo
-        {
-        };
-
+        /* Laid out in block order up front, so each worker writes straight
+           into its own slot and nothing needs sorting afterwards */
         std::vector<PreprocessedTx> preprocessedTransactions;
-        std::mutex preprocessedTransactionsMutex;
 
-        size_t workers = std::thread::hardware_concurrency();
-        if (workers == 0)
-        {
-            workers = 2;
-        }
+        uint32_t emptyBlockCount = 0;
 
-        BlockingQueue<Tx> inputQueue(workers * 2);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const auto &block = blocks[i].block;
 
-        std::atomic<bool> stopProcessing(false);
-        std::atomic<size_t> emptyBlockCount(0);
+            if (!block.is_initialized())
+            {
+                ++emptyBlockCount;
+                continue;
+            }
 
-        auto pushingThread = std::async(std::launch::async, [&] {
-            for (uint32_t i = 0; i < count && !stopProcessing; ++i)
+            // filter by syncStartTimestamp
+            if (m_syncStart.timestamp && block->timestamp < m_syncStart.timestamp)
             {
-                const auto &block = blocks[i].block;
+                ++emptyBlockCount;
+                continue;
+            }
 
-                if (!block.is_initialized())
-                {
-                    ++emptyBlockCount;
-                    continue;
-                }
+            TransactionBlockInfo blockInfo;
+            blockInfo.height = startHeight + i;
+            blockInfo.timestamp = block->timestamp;
+            blockInfo.transactionIndex = 0; // position in block
 
-                // filter by syncStartTimestamp
-                if (m_syncStart.timestamp && block->timestamp < m_syncStart.timestamp)
+            for (const auto &tx : blocks[i].transactions)
+            {
+                const auto &scanInfo = blocks[i].scanInfo[blockInfo.transactionIndex];
+                const auto &pubKey = scanInfo.publicKey;
+                bool isLastTransactionInBlock = blockInfo.transactionIndex + 1 == blocks[i].transactions.size();
+
+                /* Need to ensure we add the last tx in the block even if it
+                 * has a null pub key, as we use this to indicate when we
+                 * have finished processing a block. */
+                if (pubKey == Constants::NULL_PUBLIC_KEY && !isLastTransactionInBlock)
                 {
-                    ++emptyBlockCount;
+                    ++blockInfo.transactionIndex;
                     continue;
                 }
 
-                TransactionBlockInfo blockInfo;
-                blockInfo.height = startHeight + i;
-                blockInfo.timestamp = block->timestamp;
-                blockInfo.transactionIndex = 0; // position in block
+                PreprocessedTx item;
+                item.blockInfo = blockInfo;
+                item.tx = tx.get();
+                item.scanInfo = &scanInfo;
+                item.isLastTransactionInBlock = isLastTransactionInBlock;
 
-                for (const auto &tx : blocks[i].transactions)
-                {
-                    auto pubKey = tx->getTransactionPublicKey();
-                    bool isLastTransactionInBlock = blockInfo.transactionIndex + 1 == blocks[i].transactions.size();
-
-                    /* Need to ensure we add the last tx in the block even if it
-                     * has a null pub key, as we use this to indicate when we
-                     * have finished processing a block. */
-                    if (pubKey == Constants::NULL_PUBLIC_KEY && !isLastTransactionInBlock)
-                    {
-                        ++blockInfo.transactionIndex;
-                        continue;
-                    }
-
-                    Tx item = {blockInfo, tx.get(), isLastTransactionInBlock};
-                    inputQueue.push(item);
-                    ++blockInfo.transactionIndex;
-                }
+                preprocessedTransactions.push_back(std::move(item));
+                ++blockInfo.transactionIndex;
             }
+        }
 
-            inputQueue.close();
-        });
-
-        auto processingFunction = [&] {
-            Tx item;
-            std::error_code ec;
-            while (!stopProcessing && inputQueue.pop(item))
-            {
-                PreprocessedTx output;
-                static_cast<Tx &>(output) = item;
-
-                ec = preprocessOutputs(item.blockInfo, *item.tx, output);
-                if (ec)
-                {
-                    stopProcessing = true;
-                    break;
-                }
-
-                std::lock_guard<std::mutex> lk(preprocessedTransactionsMutex);
-                preprocessedTransactions.push_back(std::move(output));
-            }
-            return ec;
-        };
+        std::vector<Crypto::Hash> blockHashes = getBlockHashes(blocks, count);
+        m_observerManager.notify(&IBlockchainConsumerObserver::onBlocksAdded, this, blockHashes);
 
-        std::vector<std::future<std::error_code>> processingThreads;
-        for (size_t i = 0; i < workers; ++i)
-        {
-            processingThreads.push_back(std::async(std::launch::async, processingFunction));
-        }
+        auto preprocess = [&](const size_t i) {
+            auto &item = preprocessedTransactions[i];
 
-        std::error_code processingError;
-        for (auto &f : processingThreads)
-        {
             try
             {
-                std::error_code ec = f.get();
-                if (!processingError && ec)
-                {
-                    processingError = ec;
-                }
+                item.error = preprocessOutputs(item.blockInfo, *item.tx, *item.scanInfo, item);
             }
             catch (const std::system_error &e)
             {
-                processingError = e.code();
+                item.error = e.code();
             }
             catch (const std::exception &)
             {
-                processingError = std::make_error_code(std::errc::operation_canceled);
+                item.error = std::make_error_code(std::errc::operation_canceled);
             }
-        }
 
-        if (processingError)
-        {
-            forEachSubscription([&](TransfersSubscription &sub) { sub.onError(processingError, startHeight); });
+            return !item.error;
+        };
 
-            return 0;
-        }
+        uint32_t processedBlockCount = emptyBlockCount;
 
-        std::vector<Crypto::Hash> blockHashes = getBlockHashes(blocks, count);
-        m_observerManager.notify(&IBlockchainConsumerObserver::onBlocksAdded, this, blockHashes);
+        /* Transactions are applied as soon as they and everything before them
+           are preprocessed, rather than once the whole batch is */
+        auto apply = [&](const size_t i) {
+            const auto &tx = preprocessedTransactions[i];
 
-        // sort by block height and transaction index in block
-        std::sort(
-            preprocessedTransactions.begin(),
-            preprocessedTransactions.end(),
-            [](const PreprocessedTx &a, const PreprocessedTx &b) {
-                return std::tie(a.blockInfo.height, a.blockInfo.transactionIndex)
-                       < std::tie(b.blockInfo.height, b.blockInfo.transactionIndex);
-            });
+            processTransaction(tx.blockInfo, *tx.tx, tx);
+
+            if (tx.isLastTransactionInBlock)
+            {
+                ++processedBlockCount;
+                m_logger(TRACE) << "Processed block " << processedBlockCount << " of " << count
+                                << ", last processed block index " << tx.blockInfo.height << ", hash "
+                                << blocks[processedBlockCount - 1].blockHash;
+
+                auto newHeight = startHeight + processedBlockCount - 1;
+                forEachSubscription([newHeight](TransfersSubscription &sub) { sub.advanceHeight(newHeight); });
+            }
+
+            return true;
+        };
 
-        uint32_t processedBlockCount = static_cast<uint32_t>(emptyBlockCount);
         try
         {
-            for (const auto &tx : preprocessedTransactions)
+            const size_t appliedCount = m_preprocessingExecutor.run(preprocessedTransactions.size(), preprocess, apply);
+
+            if (appliedCount < preprocessedTransactions.size())
             {
-                processTransaction(tx.blockInfo, *tx.tx, tx);
+                std::error_code processingError;
 
-                if (tx.isLastTransactionInBlock)
+                for (const auto &tx : preprocessedTransactions)
                 {
-                    ++processedBlockCount;
-                    m_logger(TRACE) << "Processed block " << processedBlockCount << " of " << count
-                                    << ", last processed block index " << tx.blockInfo.height << ", hash "
-                                    << blocks[processedBlockCount - 1].blockHash;
-
-                    auto newHeight = startHeight + processedBlockCount - 1;
-                    forEachSubscription([newHeight](TransfersSubscription &sub) { sub.advanceHeight(newHeight); });
+                    if (tx.error)
+                    {
+                        processingError = tx.error;
+                        break;
+                    }
                 }
+
+                const uint32_t errorHeight = startHeight + processedBlockCount;
+
+                forEachSubscription([&](TransfersSubscription &sub) { sub.onError(processingError, errorHeight); });
             }
         }
         catch (const MarkTransactionConfirmedException &e)
@@ -576,12 +538,13 @@ namespace CryptoNote
     std::error_code TransfersConsumer::preprocessOutputs(
         const TransactionBlockInfo &blockInfo,
         const ITransactionReader &tx,
+        const TransactionScanInfo &scanInfo,
         PreprocessInfo &info)
     {
         std::unordered_map<PublicKey, std::vector<uint32_t>> outputs;
         try
         {
-            findMyOutputs(tx, m_viewSecret, m_spendKeys, outputs);
+            findMyOutputs(scanInfo, m_viewSecret, m_spendKeys, outputs);
         }
         catch (const std::exception &e)
         {
@@ -628,7 +591,7 @@ namespace CryptoNote
         TransfersConsumer::processTransaction(const TransactionBlockInfo &blockInfo, const ITransactionReader &tx)
     {
         PreprocessInfo info;
-        auto ec = preprocessOutputs(blockInfo, tx, info);
+        auto ec = preprocessOutputs(blockInfo, tx, getTransactionScanInfo(tx), info);
         if (ec)
         {
             return ec;
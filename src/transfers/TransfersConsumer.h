@@ -10,6 +10,7 @@
 #include "IBlockchainSynchronizer.h"
 #include "IObservableImpl.h"
 #include "ITransfersSynchronizer.h"
+#include "PreprocessingExecutor.h"
 #include "TransfersSubscription.h"
 #include "TypeHelpers.h"
 #include "crypto/crypto.h"
@@ -21,6 +22,8 @@ namespace CryptoNote
 {
     class INode;
 
+    struct TransactionScanInfo;
+
     class TransfersConsumer : public IObservableImpl<IBlockchainConsumerObserver, IBlockchainConsumer>
     {
       public:
@@ -28,7 +31,8 @@ namespace CryptoNote
             const CryptoNote::Currency &currency,
             INode &node,
             std::shared_ptr<Logging::ILogger> logger,
-            const Crypto::SecretKey &viewSecret);
+            const Crypto::SecretKey &viewSecret,
+            PreprocessingExecutor &preprocessingExecutor);
 
         ITransfersSubscription &addSubscription(const AccountSubscription &subscription);
 
@@ -78,6 +82,7 @@ namespace CryptoNote
         std::error_code preprocessOutputs(
             const TransactionBlockInfo &blockInfo,
             const ITransactionReader &tx,
+            const TransactionScanInfo &scanInfo,
             PreprocessInfo &info);
 
         std::error_code processTransaction(const TransactionBlockInfo &blockInfo, const ITransactionReader &tx);
@@ -116,6 +121,9 @@ namespace CryptoNote
         const CryptoNote::Currency &m_currency;
 
         Logging::LoggerRef m_logger;
+
+        /* Shared with the other consumers of the synchronizer */
+        PreprocessingExecutor &m_preprocessingExecutor;
     };
 
 } // namespace CryptoNote
@@ -25,9 +25,11 @@ namespace CryptoNote
         const CryptoNote::Currency &currency,
         std::shared_ptr<Logging::ILogger> logger,
         IBlockchainSynchronizer &sync,
-        INode &node):
+        INode &node,
+        PreprocessingExecutor &preprocessingExecutor):
         m_currency(currency),
         m_logger(logger, "TransfersSyncronizer"),
+        m_preprocessingExecutor(preprocessingExecutor),
         m_sync(sync),
         m_node(node)
     {
@@ -56,8 +58,8 @@ namespace CryptoNote
 
         if (it == m_consumers.end())
         {
-            std::unique_ptr<TransfersConsumer> consumer(
-                new TransfersConsumer(m_currency, m_node, m_logger.getLogger(), acc.keys.viewSecretKey));
+            std::unique_ptr<TransfersConsumer> consumer(new TransfersConsumer(
+                m_currency, m_node, m_logger.getLogger(), acc.keys.viewSecretKey, m_preprocessingExecutor));
 
             m_sync.addConsumer(consumer.get());
             consumer->addObserver(this);
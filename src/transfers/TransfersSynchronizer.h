@@ -9,6 +9,7 @@
 
 #include "IBlockchainSynchronizer.h"
 #include "ITransfersSynchronizer.h"
+#include "PreprocessingExecutor.h"
 #include "TypeHelpers.h"
 #include "common/ObserverManager.h"
 #include "logging/LoggerRef.h"
@@ -35,7 +36,8 @@ namespace CryptoNote
             const CryptoNote::Currency &currency,
             std::shared_ptr<Logging::ILogger> logger,
             IBlockchainSynchronizer &sync,
-            INode &node);
+            INode &node,
+            PreprocessingExecutor &preprocessingExecutor);
 
         virtual ~TransfersSyncronizer();
 
@@ -73,6 +75,9 @@ namespace CryptoNote
       private:
         Logging::LoggerRef m_logger;
 
+        /* Preprocesses new blocks for all of the consumers */
+        PreprocessingExecutor &m_preprocessingExecutor;
+
         // map { view public key -> consumer }
         typedef std::unordered_map<Crypto::PublicKey, std::unique_ptr<TransfersConsumer>> ConsumersContainer;
 
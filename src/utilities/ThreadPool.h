@@ -4,16 +4,148 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <vector>
 
 namespace Utilities
 {
-    template<typename ReturnValue>
+    struct ThreadPoolStatistics
+    {
+        /* Jobs which have been queued but not yet picked up by a worker */
+        uint64_t queueDepth = 0;
+
+        /* Jobs a worker took from another worker's queue */
+        uint64_t steals = 0;
+
+        /* Jobs run to completion */
+        uint64_t jobsCompleted = 0;
+    };
+
+    /* A set of work items, submitted with ThreadPool::addBatch(). Items are
+       claimed in chunks by whichever threads are free, including the thread
+       waiting on the batch, so one batch costs a handful of queued jobs no
+       matter how many items it contains. */
+    class BatchJob
+    {
+        public:
+            /////////////////
+            /* CONSTRUCTOR */
+            /////////////////
+
+            BatchJob(const size_t count, const size_t chunkSize, std::function<void(size_t)> job) :
+                m_count(count),
+                m_chunkSize(std::max<size_t>(chunkSize, 1)),
+                m_job(std::move(job))
+            {
+            }
+
+            /////////////////////////////
+            /* PUBLIC MEMBER FUNCTIONS */
+            /////////////////////////////
+
+            /* Blocks until every item in the batch has been processed, helping
+               to process them in the meantime. Rethrows the first exception
+               thrown by the job, if any. */
+            void wait()
+            {
+                while (runChunk())
+                {
+                }
+
+                std::unique_lock<std::mutex> lock(m_mutex);
+
+                m_finished.wait(lock, [&] {
+                    return m_completed == m_count;
+                });
+
+                if (m_exception)
+                {
+                    std::rethrow_exception(m_exception);
+                }
+            }
+
+            bool isFinished() const
+            {
+                return m_completed == m_count;
+            }
+
+            /* Processes the next unclaimed chunk of the batch. Returns false
+               if there is nothing left to claim. */
+            bool runChunk()
+            {
+                const size_t start = m_next.fetch_add(m_chunkSize);
+
+                if (start >= m_count)
+                {
+                    return false;
+                }
+
+                const size_t end = std::min(start + m_chunkSize, m_count);
+
+                for (size_t i = start; i < end; i++)
+                {
+                    try
+                    {
+                        m_job(i);
+                    }
+                    catch (...)
+                    {
+                        std::scoped_lock lock(m_mutex);
+
+                        if (!m_exception)
+                        {
+                            m_exception = std::current_exception();
+                        }
+                    }
+                }
+
+                if (m_completed.fetch_add(end - start) + (end - start) == m_count)
+                {
+                    std::scoped_lock lock(m_mutex);
+                    m_finished.notify_all();
+                }
+
+                return true;
+            }
+
+        private:
+            //////////////////////////////
+            /* PRIVATE MEMBER VARIABLES */
+            //////////////////////////////
+
+            const size_t m_count;
+
+            const size_t m_chunkSize;
+
+            const std::function<void(size_t)> m_job;
+
+            /* The next item to be claimed */
+            std::atomic<size_t> m_next = 0;
+
+            /* The amount of items processed */
+            std::atomic<size_t> m_completed = 0;
+
+            std::exception_ptr m_exception;
+
+            std::mutex m_mutex;
+
+            std::condition_variable m_finished;
+    };
+
+    /* A work stealing thread pool. Every worker owns a queue; jobs submitted
+       from a worker go to the back of its own queue, and jobs submitted from
+       elsewhere are spread over the queues round robin. An idle worker takes
+       from the back of its own queue first, and otherwise steals from the
+       front of another worker's queue, so workers rarely contend on a lock. */
     class ThreadPool
     {
         public:
@@ -35,13 +167,23 @@ namespace Utilities
 
                 m_threadCount = threadCount;
 
+                for (uint64_t i = 0; i < threadCount; i++)
+                {
+                    m_queues.push_back(std::make_unique<WorkerQueue>());
+                }
+
                 /* Launch our worker threads */
                 for (uint64_t i = 0; i < threadCount; i++)
                 {
-                    m_threads.push_back(std::thread(&ThreadPool::waitForJob, this));
+                    m_threads.push_back(std::thread(&ThreadPool::waitForJob, this, i));
                 }
             }
 
+            /* Owns threads which point back at us */
+            ThreadPool(const ThreadPool &) = delete;
+
+            ThreadPool &operator=(const ThreadPool &) = delete;
+
             ////////////////
             /* DESTRUCTOR */
             ////////////////
@@ -49,7 +191,10 @@ namespace Utilities
             ~ThreadPool()
             {
                 /* Signal threads to stop */
-                m_shouldStop = true;
+                {
+                    std::scoped_lock lock(m_sleepMutex);
+                    m_shouldStop = true;
+                }
 
                 /* Wake them all up */
                 m_haveJob.notify_all();
@@ -65,66 +210,183 @@ namespace Utilities
             /* PUBLIC MEMBER FUNCTIONS */
             /////////////////////////////
 
-            std::future<ReturnValue> addJob(const std::function<ReturnValue()> job)
+            template<typename Job>
+            std::future<std::invoke_result_t<Job>> addJob(Job job)
             {
-                std::promise<ReturnValue> promise;
+                /* std::function must be copyable, std::packaged_task is not */
+                auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Job>()>>(std::move(job));
 
-                std::future<ReturnValue> result = promise.get_future();
+                auto result = task->get_future();
 
-                /* Aquire lock */
-                std::unique_lock<std::mutex> lock(m_mutex);
+                pushJob([task] { (*task)(); });
 
-                /* Add job to queue */
-                m_queue.push({ job, std::move(promise) });
+                return result;
+            }
+
+            /* Runs job(0) .. job(count - 1) on the pool, claiming chunkSize
+               items at a time, and returns a single handle for the whole
+               batch. A chunkSize of zero splits the batch evenly over the
+               threads. */
+            std::shared_ptr<BatchJob> addBatch(const size_t count, std::function<void(size_t)> job, size_t chunkSize = 0)
+            {
+                if (chunkSize == 0)
+                {
+                    chunkSize = (count + m_threadCount - 1) / m_threadCount;
+                }
 
-                /* Manually unlocking here so we don't wake up and instantly
-                 * sleep upon notify_one */
-                lock.unlock();
+                chunkSize = std::max<size_t>(chunkSize, 1);
 
-                /* Wake up a thread to process the job */
-                m_haveJob.notify_one();
+                auto batch = std::make_shared<BatchJob>(count, chunkSize, std::move(job));
 
-                return result;
+                const size_t chunks = (count + chunkSize - 1) / chunkSize;
+
+                /* No point waking more workers than there are chunks */
+                const size_t workers = std::min<size_t>(chunks, m_threadCount);
+
+                for (size_t i = 0; i < workers; i++)
+                {
+                    pushJob([batch] {
+                        while (batch->runChunk())
+                        {
+                        }
+                    });
+                }
+
+                return batch;
+            }
+
+            /* Like addBatch(), but waits for the batch to complete, with the
+               calling thread helping out */
+            void parallelFor(const size_t count, std::function<void(size_t)> job, size_t chunkSize = 0)
+            {
+                if (count == 0)
+                {
+                    return;
+                }
+
+                addBatch(count, std::move(job), chunkSize)->wait();
+            }
+
+            uint64_t getThreadCount() const
+            {
+                return m_threadCount;
+            }
+
+            ThreadPoolStatistics getStatistics() const
+            {
+                ThreadPoolStatistics statistics;
+
+                statistics.queueDepth = m_queuedJobs;
+                statistics.steals = m_steals;
+                statistics.jobsCompleted = m_jobsCompleted;
+
+                return statistics;
             }
 
         private:
+            struct WorkerQueue
+            {
+                std::mutex mutex;
+
+                std::deque<std::function<void()>> jobs;
+            };
 
             //////////////////////////////
             /* PRIVATE MEMBER FUNCTIONS */
             //////////////////////////////
 
-            void waitForJob()
+            void pushJob(std::function<void()> job)
             {
-                while (!m_shouldStop)
+                /* Jobs submitted from one of our own workers stay local to
+                   that worker, to be stolen if it's busy */
+                const size_t queueIndex = t_currentPool == this
+                    ? t_workerIndex
+                    : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_threadCount;
+
+                m_queuedJobs++;
+
                 {
-                    std::unique_lock<std::mutex> lock(m_mutex);
+                    auto &queue = *m_queues[queueIndex];
+                    std::scoped_lock lock(queue.mutex);
+                    queue.jobs.push_back(std::move(job));
+                }
 
-                    /* Wait for data to become available or to be stopped */
-                    m_haveJob.wait(lock, [&] {
-                        if (m_shouldStop)
-                        {
-                            return true;
-                        }
+                /* Only touch the sleep mutex if somebody is sleeping on it.
+                   Taking the lock ensures the sleeper is inside wait() before
+                   we notify it, so the wake up can't be lost. */
+                if (m_sleepingThreads > 0)
+                {
+                    {
+                        std::scoped_lock lock(m_sleepMutex);
+                    }
 
-                        return !m_queue.empty();
-                    });
+                    m_haveJob.notify_one();
+                }
+            }
+
+            bool tryPopJob(const size_t workerIndex, std::function<void()> &job)
+            {
+                /* Newest job from our own queue first - it's the most likely
+                   to be hot in the cache */
+                {
+                    auto &queue = *m_queues[workerIndex];
+                    std::scoped_lock lock(queue.mutex);
+
+                    if (!queue.jobs.empty())
+                    {
+                        job = std::move(queue.jobs.back());
+                        queue.jobs.pop_back();
+                        m_queuedJobs--;
+                        return true;
+                    }
+                }
+
+                /* Then the oldest job of any other worker */
+                for (size_t i = 1; i < m_threadCount; i++)
+                {
+                    auto &queue = *m_queues[(workerIndex + i) % m_threadCount];
+                    std::scoped_lock lock(queue.mutex);
+
+                    if (!queue.jobs.empty())
+                    {
+                        job = std::move(queue.jobs.front());
+                        queue.jobs.pop_front();
+                        m_queuedJobs--;
+                        m_steals++;
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            void waitForJob(const size_t workerIndex)
+            {
+                t_currentPool = this;
+                t_workerIndex = workerIndex;
 
-                    if (m_shouldStop)
+                std::function<void()> job;
+
+                while (!m_shouldStop)
+                {
+                    if (tryPopJob(workerIndex, job))
                     {
-                        return;
+                        job();
+                        job = nullptr;
+                        m_jobsCompleted++;
+                        continue;
                     }
 
-                    /* Take next job from queue */
-                    auto [job, result] = std::move(m_queue.front());
+                    std::unique_lock<std::mutex> lock(m_sleepMutex);
 
-                    /* Remove item from queue */
-                    m_queue.pop();
+                    m_sleepingThreads++;
 
-                    /* Undo the lock so other threads can process jobs */
-                    lock.unlock();
+                    /* Wait for data to become available or to be stopped */
+                    m_haveJob.wait(lock, [&] {
+                        return m_shouldStop || m_queuedJobs > 0;
+                    });
 
-                    /* Process job and set return value */
-                    result.set_value(job());
+                    m_sleepingThreads--;
                 }
             }
 
@@ -135,6 +397,9 @@ namespace Utilities
             /* The work threads */
             std::vector<std::thread> m_threads;
 
+            /* One job queue per worker thread */
+            std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
             /* The amount of threads to launch */
             uint64_t m_threadCount;
 
@@ -144,12 +409,24 @@ namespace Utilities
             /* Whether we have a new job to process */
             std::condition_variable m_haveJob;
 
-            /* Mutex to serialize access to job queue */
-            std::mutex m_mutex;
+            /* Only used for sleeping / waking workers */
+            std::mutex m_sleepMutex;
+
+            std::atomic<uint64_t> m_sleepingThreads = 0;
+
+            /* Round robin counter for jobs submitted from outside the pool */
+            std::atomic<uint64_t> m_nextQueue = 0;
+
+            std::atomic<uint64_t> m_queuedJobs = 0;
+
+            std::atomic<uint64_t> m_steals = 0;
+
+            std::atomic<uint64_t> m_jobsCompleted = 0;
+
+            /* The pool and worker index of the current thread, if it is one
+               of our workers */
+            inline static thread_local ThreadPool *t_currentPool = nullptr;
 
-            /* The queue of job functions and job results */
-            std::queue<
-                std::tuple<std::function<ReturnValue()>, std::promise<ReturnValue>>
-            > m_queue;
+            inline static thread_local size_t t_workerIndex = 0;
     };
 }
@@ -151,8 +151,8 @@ namespace CryptoNote
         m_logger(logger, "WalletGreen/empty"),
         m_stopped(false),
         m_blockchainSynchronizerStarted(false),
-        m_blockchainSynchronizer(node, logger, currency.genesisBlockHash()),
-        m_synchronizer(currency, logger, m_blockchainSynchronizer, node),
+        m_blockchainSynchronizer(node, logger, currency.genesisBlockHash(), m_preprocessingExecutor),
+        m_synchronizer(currency, logger, m_blockchainSynchronizer, node, m_preprocessingExecutor),
         m_eventOccurred(m_dispatcher),
         m_readyEvent(m_dispatcher),
         m_state(WalletState::NOT_INITIALIZED),
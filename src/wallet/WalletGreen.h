@@ -660,6 +660,10 @@ namespace CryptoNote
 
         bool m_blockchainSynchronizerStarted;
 
+        /* Shared by the synchronizers, declared before them so it outlives
+           them */
+        PreprocessingExecutor m_preprocessingExecutor;
+
         BlockchainSynchronizer m_blockchainSynchronizer;
 
         TransfersSyncronizer m_synchronizer;
@@ -137,6 +137,11 @@ ApiDispatcher::ApiDispatcher(
             "/export/json",
             router(&ApiDispatcher::exportToJSON, WalletMustBeOpen, viewWalletsAllowed))
 
+        /* Export the wallet in the older, single blob file format */
+        .Post(
+            "/export/legacy",
+            router(&ApiDispatcher::exportToLegacyWallet, WalletMustBeOpen, viewWalletsAllowed))
+
         /* DELETE */
 
         /* Close the current wallet */
@@ -980,6 +985,31 @@ std::tuple<Error, uint16_t>
     return {SUCCESS, 200};
 }
 
+std::tuple<Error, uint16_t>
+    ApiDispatcher::exportToLegacyWallet(const httplib::Request &req, httplib::Response &res, const nlohmann::json &body)
+{
+    std::scoped_lock lock(m_mutex);
+
+    const std::string filename = getJsonValue<std::string>(body, "filename");
+
+    /* Defaults to the password of the open wallet */
+    std::string password = m_walletBackend->getWalletPassword();
+
+    if (body.find("password") != body.end())
+    {
+        password = getJsonValue<std::string>(body, "password");
+    }
+
+    const Error error = m_walletBackend->exportJSONWallet(filename, password);
+
+    if (error)
+    {
+        return {error, 400};
+    }
+
+    return {SUCCESS, 200};
+}
+
 /////////////////////
 /* DELETE REQUESTS */
 /////////////////////
@@ -1530,32 +1560,29 @@ std::tuple<Error, uint16_t> ApiDispatcher::getTransactionDetails(
 
     Common::podFromHex(hashStr, hash.data);
 
-    for (const auto &tx : m_walletBackend->getTransactions())
+    if (const auto tx = m_walletBackend->getTransaction(hash))
     {
-        if (tx.hash == hash)
-        {
-            nlohmann::json j {{"transaction", tx}};
+        nlohmann::json j {{"transaction", *tx}};
 
-            /* Replace publicKey with address for ease of use */
-            for (auto &tx : j.at("transaction").at("transfers"))
-            {
-                /* Get the spend key */
-                Crypto::PublicKey spendKey = tx.at("publicKey").get<Crypto::PublicKey>();
+        /* Replace publicKey with address for ease of use */
+        for (auto &tx : j.at("transaction").at("transfers"))
+        {
+            /* Get the spend key */
+            Crypto::PublicKey spendKey = tx.at("publicKey").get<Crypto::PublicKey>();
 
-                /* Get the address it belongs to */
-                const auto [error, address] = m_walletBackend->getAddress(spendKey);
+            /* Get the address it belongs to */
+            const auto [error, address] = m_walletBackend->getAddress(spendKey);
 
-                /* Add the address to the json */
-                tx["address"] = address;
+            /* Add the address to the json */
+            tx["address"] = address;
 
-                /* Remove the spend key */
-                tx.erase("publicKey");
-            }
+            /* Remove the spend key */
+            tx.erase("publicKey");
+        }
 
-            res.set_content(j.dump(4) + "\n", "application/json");
+        res.set_content(j.dump(4) + "\n", "application/json");
 
-            return {SUCCESS, 200};
-        }
+        return {SUCCESS, 200};
     }
 
     /* Not found */
@@ -172,6 +172,10 @@ class ApiDispatcher
     std::tuple<Error, uint16_t>
         exportToJSON(const httplib::Request &req, httplib::Response &res, const nlohmann::json &body);
 
+    /* Export wallet to a file older versions can open */
+    std::tuple<Error, uint16_t>
+        exportToLegacyWallet(const httplib::Request &req, httplib::Response &res, const nlohmann::json &body);
+
     /////////////////////
     /* DELETE REQUESTS */
     /////////////////////
@@ -25,6 +25,13 @@ namespace Constants
                                                                   0x62, 0x69, 0x67, 0x20, 0x67, 0x75, 0x79, 0x2e, 0x0a,
                                                                   0x46, 0x6f, 0x72, 0x20, 0x79, 0x6f, 0x75, 0x2e}};
 
+    /* Marks the file as a journaled wallet file, as opposed to the older
+       format which is a single encrypted JSON blob, starting with
+       IS_A_WALLET_IDENTIFIER. Not encrypted either. */
+    const std::array<char, 32> IS_A_WALLET_JOURNAL_IDENTIFIER = {
+        {0x54, 0x68, 0x65, 0x72, 0x65, 0x27, 0x73, 0x20, 0x6e, 0x6f, 0x20, 0x70, 0x6c, 0x61, 0x63, 0x65,
+         0x20, 0x6c, 0x69, 0x6b, 0x65, 0x20, 0x31, 0x32, 0x37, 0x2e, 0x30, 0x2e, 0x30, 0x2e, 0x31, 0x0a}};
+
     /* The number of iterations of PBKDF2 to perform on the wallet
        password. */
     const uint64_t PBKDF2_ITERATIONS = 500000;
@@ -33,6 +40,14 @@ namespace Constants
        upgrade the wallet format in the future) */
     const uint16_t WALLET_FILE_FORMAT_VERSION = 0;
 
+    /* What version of the journal format are we on. This is the layout of
+       the records, their contents are WALLET_FILE_FORMAT_VERSION JSON */
+    const uint16_t WALLET_JOURNAL_FORMAT_VERSION = 0;
+
+    /* Compact the wallet journal once it's at least this large, and over
+       half of it is records which have since been overwritten or deleted */
+    const uint64_t WALLET_JOURNAL_COMPACTION_THRESHOLD = 1024 * 1024;
+
     /* How large should the m_lastKnownBlockHashes container be */
     const size_t LAST_KNOWN_BLOCK_HASHES_SIZE = 50;
 
@@ -712,7 +712,7 @@ namespace SendTransaction
         return SUCCESS;
     }
 
-    /* Possibly we could abstract some of this from processTransactionOutputs...
+    /* Possibly we could abstract some of this from processBlockOutputs...
        but I think it would make the code harder to follow */
     void storeUnconfirmedIncomingInputs(
         const std::shared_ptr<SubWallets> subWallets,
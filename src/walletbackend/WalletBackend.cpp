@@ -448,6 +448,47 @@ std::tuple<Error, std::shared_ptr<WalletBackend>> WalletBackend::openWallet(
     const bool daemonSSL,
     const unsigned int syncThreadCount)
 {
+    if (WalletJournal::isJournal(filename))
+    {
+        const auto [journalError, journal] = WalletJournal::open(filename, password);
+
+        if (journalError)
+        {
+            return {journalError, nullptr};
+        }
+
+        const auto [recordsError, records] = journal->getRecords();
+
+        if (recordsError)
+        {
+            return {recordsError, nullptr};
+        }
+
+        try
+        {
+            const auto wallet = std::make_shared<WalletBackend>();
+
+            wallet->m_journal = journal;
+
+            Error error = wallet->fromJournalRecords(
+                records, filename, password, daemonHost, daemonPort, daemonSSL, syncThreadCount);
+
+            return {error, wallet};
+        }
+        catch (const std::invalid_argument &e)
+        {
+            Logger::logger.log(
+                std::string("Failed to open wallet file: ") + e.what(),
+                Logger::FATAL,
+                {Logger::FILESYSTEM, Logger::SAVE});
+
+            return {WALLET_FILE_CORRUPTED, nullptr};
+        }
+    }
+
+    /* Otherwise, it's the older format, which is converted to a journal the
+       first time we save */
+
     /* Open in binary mode, since we have encrypted data */
     std::ifstream file(filename, std::ios_base::binary);
 
@@ -713,7 +754,66 @@ Error WalletBackend::save() const
    blockchain synchronizer first (Call save()) */
 Error WalletBackend::unsafeSave() const
 {
-    return WalletBackend::saveWalletJSONToDisk(unsafeToJSON(), m_filename, m_password);
+    const auto writeRecords = [this](const WalletJournal::RecordWriter &put) {
+        StringBuffer sb;
+        Writer<StringBuffer> writer(sb);
+
+        writer.StartObject();
+
+        writer.Key("walletFileFormatVersion");
+        writer.Uint(Constants::WALLET_FILE_FORMAT_VERSION);
+
+        writer.Key("walletSynchronizer");
+        m_walletSynchronizer->toJSON(writer);
+
+        writer.EndObject();
+
+        put("walletBackend", std::string(sb.GetString(), sb.GetSize()));
+
+        m_subWallets->toJournalRecords(put);
+    };
+
+    if (m_journal != nullptr)
+    {
+        Error error = m_journal->save(writeRecords);
+
+        /* We can't be sure what made it to disk, so the next save writes the
+           whole wallet out again */
+        if (error)
+        {
+            m_journal = nullptr;
+        }
+
+        return error;
+    }
+
+    std::error_code ec;
+
+    if (fs::exists(m_filename, ec) && !WalletJournal::isJournal(m_filename))
+    {
+        Logger::logger.log(
+            "Converting wallet file " + m_filename + " to the journal format. Older versions of the software "
+            "can't open it, a copy they can open can be exported with /export/legacy in wallet-api.",
+            Logger::INFO,
+            {Logger::FILESYSTEM, Logger::SAVE});
+    }
+
+    const auto [error, journal] = WalletJournal::create(m_filename, m_password, writeRecords);
+
+    m_journal = journal;
+
+    return error;
+}
+
+Error WalletBackend::exportJSONWallet(const std::string filename, const std::string password) const
+{
+    if (Error error = checkNewWalletFilename(filename); error != SUCCESS)
+    {
+        return error;
+    }
+
+    return m_syncRAIIWrapper->pauseSynchronizerToRunFunction(
+        [this, filename, password]() { return saveWalletJSONToDisk(unsafeToJSON(), filename, password); });
 }
 
 /* Get the balance for one subwallet (error, unlocked, locked) */
@@ -1093,9 +1193,15 @@ Error WalletBackend::changePassword(const std::string newPassword)
         return SUCCESS;
     }
 
-    m_password = newPassword;
+    return m_syncRAIIWrapper->pauseSynchronizerToRunFunction([this, newPassword]() {
+        m_password = newPassword;
+
+        /* The journal is encrypted with keys derived from the old password,
+           so write out a new one */
+        m_journal = nullptr;
 
-    return save();
+        return unsafeSave();
+    });
 }
 
 std::tuple<Error, Crypto::PublicKey, Crypto::SecretKey, uint64_t> WalletBackend::getSpendKeys(const std::string &address) const
@@ -1192,19 +1298,12 @@ WalletTypes::WalletStatus WalletBackend::getStatus() const
 std::vector<WalletTypes::Transaction>
     WalletBackend::getTransactionsRange(const uint64_t startHeight, const uint64_t endHeight) const
 {
-    std::vector<WalletTypes::Transaction> result;
-
-    const auto transactions = getTransactions();
-
-    std::copy_if(
-        transactions.begin(),
-        transactions.end(),
-        std::back_inserter(result),
-        [&startHeight, &endHeight](const auto tx) {
-            return tx.blockHeight >= startHeight && tx.blockHeight < endHeight;
-        });
+    return m_subWallets->getTransactionsRange(startHeight, endHeight);
+}
 
-    return result;
+std::optional<WalletTypes::Transaction> WalletBackend::getTransaction(const Crypto::Hash &transactionHash) const
+{
+    return m_subWallets->getTransaction(transactionHash);
 }
 
 std::tuple<uint64_t, std::string> WalletBackend::getNodeFee() const
@@ -1306,6 +1405,64 @@ Error WalletBackend::fromJSON(const rapidjson::Document &j)
     return SUCCESS;
 }
 
+Error WalletBackend::fromJournalRecords(const std::vector<std::pair<std::string, std::string>> &records)
+{
+    const auto it = std::find_if(
+        records.begin(), records.end(), [](const auto &record) { return record.first == "walletBackend"; });
+
+    if (it == records.end())
+    {
+        return WALLET_FILE_CORRUPTED;
+    }
+
+    rapidjson::Document j;
+
+    if (j.Parse(it->second.c_str(), it->second.size()).HasParseError() || !j.IsObject())
+    {
+        return WALLET_FILE_CORRUPTED;
+    }
+
+    uint64_t version = getUint64FromJSON(j, "walletFileFormatVersion");
+
+    if (version != Constants::WALLET_FILE_FORMAT_VERSION)
+    {
+        return UNSUPPORTED_WALLET_FILE_FORMAT_VERSION;
+    }
+
+    m_subWallets = std::make_shared<SubWallets>();
+    m_subWallets->fromJournalRecords(records);
+
+    m_walletSynchronizer = std::make_shared<WalletSynchronizer>();
+    m_walletSynchronizer->fromJSON(getObjectFromJSON(j, "walletSynchronizer"));
+
+    return SUCCESS;
+}
+
+Error WalletBackend::fromJournalRecords(
+    const std::vector<std::pair<std::string, std::string>> &records,
+    const std::string filename,
+    const std::string password,
+    const std::string daemonHost,
+    const uint16_t daemonPort,
+    const bool daemonSSL,
+    const unsigned int syncThreadCount)
+{
+    if (Error error = fromJournalRecords(records); error != SUCCESS)
+    {
+        return error;
+    }
+
+    m_filename = filename;
+    m_password = password;
+    m_syncThreadCount = syncThreadCount;
+
+    m_daemon = std::make_shared<Nigel>(daemonHost, daemonPort, daemonSSL);
+
+    init();
+
+    return SUCCESS;
+}
+
 Error WalletBackend::fromJSON(
     const rapidjson::Document &j,
     const std::string filename,
@@ -13,6 +13,7 @@
 #include <subwallets/SubWallets.h>
 #include <tuple>
 #include <vector>
+#include <walletbackend/WalletJournal.h>
 #include <walletbackend/WalletSynchronizer.h>
 #include <walletbackend/WalletSynchronizerRAIIWrapper.h>
 
@@ -112,12 +113,20 @@ class WalletBackend
     /* Save the wallet to disk */
     Error save() const;
 
+    /* Saves a copy of the wallet in the older file format, a single
+       encrypted json blob, which older versions of the software can open.
+       The file must not already exist. */
+    Error exportJSONWallet(const std::string filename, const std::string password) const;
+
     /* Converts the class to a json string */
     std::string toJSON() const;
 
     /* Initializes the class from a json string */
     Error fromJSON(const rapidjson::Document &j);
 
+    /* Initializes the class from the records of a wallet journal */
+    Error fromJournalRecords(const std::vector<std::pair<std::string, std::string>> &records);
+
     /* Initializes the class from a json string, and inits the stuff we
        can't init from the json */
     Error fromJSON(
@@ -129,6 +138,17 @@ class WalletBackend
         const bool daemonSSL,
         const unsigned int syncThreadCount);
 
+    /* Initializes the class from the records of a wallet journal, and inits
+       the stuff we can't init from the records */
+    Error fromJournalRecords(
+        const std::vector<std::pair<std::string, std::string>> &records,
+        const std::string filename,
+        const std::string password,
+        const std::string daemonHost,
+        const uint16_t daemonPort,
+        const bool daemonSSL,
+        const unsigned int syncThreadCount);
+
     /* Remove a previously prepared transaction. */
     bool removePreparedTransaction(const Crypto::Hash &transactionHash);
 
@@ -248,6 +268,9 @@ class WalletBackend
     std::vector<WalletTypes::Transaction>
         getTransactionsRange(const uint64_t startHeight, const uint64_t endHeight) const;
 
+    /* Get the (confirmed) transaction with the given hash, if we have it */
+    std::optional<WalletTypes::Transaction> getTransaction(const Crypto::Hash &transactionHash) const;
+
     /* Get the node fee and address ({0, ""} if empty) */
     std::tuple<uint64_t, std::string> getNodeFee() const;
 
@@ -328,6 +351,10 @@ class WalletBackend
     /* The password the wallet is encrypted with */
     std::string m_password;
 
+    /* The wallet file, once it's been opened or written. Created on the
+       first save if we loaded an older format file. */
+    mutable std::shared_ptr<WalletJournal> m_journal;
+
     /* The sub wallets container (Using a shared_ptr here so
        the WalletSynchronizer has access to it) */
     std::shared_ptr<SubWallets> m_subWallets;
@@ -0,0 +1,808 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+////////////////////////////////////////
+#include <walletbackend/WalletJournal.h>
+////////////////////////////////////////
+
+#include <algorithm>
+#include <common/FileSystemShim.h>
+#include <common/Util.h>
+#include <crypto/hash.h>
+#include <crypto/random.h>
+#include <cryptopp/aes.h>
+#include <cryptopp/filters.h>
+#include <cryptopp/hmac.h>
+#include <cryptopp/misc.h>
+#include <cryptopp/modes.h>
+#include <cryptopp/pwdbased.h>
+#include <cryptopp/sha.h>
+#include <cstring>
+#include <logger/Logger.h>
+#include <walletbackend/Constants.h>
+
+namespace
+{
+    const size_t SALT_SIZE = 16;
+
+    const size_t KEY_SIZE = 16;
+
+    const size_t IV_SIZE = 16;
+
+    const size_t MAC_SIZE = CryptoPP::HMAC<CryptoPP::SHA256>::DIGESTSIZE;
+
+    /* Identifier, format version, salt, then the MAC of the correct password
+       identifier, to check the password with */
+    const uint64_t HEADER_SIZE =
+        Constants::IS_A_WALLET_JOURNAL_IDENTIFIER.size() + sizeof(uint16_t) + SALT_SIZE + MAC_SIZE;
+
+    /* Each entry is the size of the ciphertext, the IV, the ciphertext, then
+       the MAC of all of those */
+    const uint64_t ENTRY_OVERHEAD = sizeof(uint32_t) + IV_SIZE + MAC_SIZE;
+
+    std::vector<uint8_t> calculateMac(const std::vector<uint8_t> &key, const std::string &data)
+    {
+        CryptoPP::HMAC<CryptoPP::SHA256> hmac(key.data(), key.size());
+
+        std::vector<uint8_t> mac(MAC_SIZE);
+
+        hmac.CalculateDigest(mac.data(), reinterpret_cast<const CryptoPP::byte *>(data.data()), data.size());
+
+        return mac;
+    }
+
+    std::vector<uint8_t> passwordCheck(const std::vector<uint8_t> &macKey)
+    {
+        return calculateMac(
+            macKey,
+            std::string(
+                Constants::IS_CORRECT_PASSWORD_IDENTIFIER.begin(), Constants::IS_CORRECT_PASSWORD_IDENTIFIER.end()));
+    }
+
+    template<typename T> void appendBytes(std::string &data, const T &value)
+    {
+        data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+} // namespace
+
+///////////////////////////////////
+/* CONSTRUCTORS / DECONSTRUCTORS */
+///////////////////////////////////
+
+WalletJournal::WalletJournal(
+    const std::string &filename,
+    const std::vector<uint8_t> &salt,
+    const std::string &password):
+    m_filename(filename),
+    m_salt(salt)
+{
+    /* This is the slow bit, so we only want to do it once per session */
+    std::vector<uint8_t> keys(KEY_SIZE * 2);
+
+    CryptoPP::PKCS5_PBKDF2_HMAC<CryptoPP::SHA256> pbkdf2;
+
+    pbkdf2.DeriveKey(
+        keys.data(),
+        keys.size(),
+        0,
+        reinterpret_cast<const CryptoPP::byte *>(password.c_str()),
+        password.size(),
+        m_salt.data(),
+        m_salt.size(),
+        Constants::PBKDF2_ITERATIONS);
+
+    m_encryptionKey.assign(keys.begin(), keys.begin() + KEY_SIZE);
+    m_macKey.assign(keys.begin() + KEY_SIZE, keys.end());
+}
+
+WalletJournal::~WalletJournal()
+{
+    if (m_compactionThread.joinable())
+    {
+        m_compactionThread.join();
+    }
+}
+
+//////////////////////
+/* STATIC FUNCTIONS */
+//////////////////////
+
+std::tuple<Error, std::shared_ptr<WalletJournal>> WalletJournal::create(
+    const std::string &filename,
+    const std::string &password,
+    const std::function<void(const RecordWriter &)> &writeRecords)
+{
+    std::vector<uint8_t> salt(SALT_SIZE);
+
+    Random::randomBytes(salt.size(), salt.data());
+
+    const std::string temporaryFilename = filename + ".tmp";
+
+    std::shared_ptr<WalletJournal> journal(new WalletJournal(temporaryFilename, salt, password));
+
+    {
+        std::ofstream file(temporaryFilename, std::ios_base::binary | std::ios_base::trunc);
+
+        if (Error error = journal->writeHeader(file); error != SUCCESS)
+        {
+            return {error, nullptr};
+        }
+    }
+
+    journal->m_size = HEADER_SIZE;
+
+    journal->m_file.open(temporaryFilename, std::ios_base::binary | std::ios_base::app);
+
+    Error error = journal->save(writeRecords);
+
+    journal->m_file.close();
+
+    if (error)
+    {
+        std::error_code ignore;
+        fs::remove(temporaryFilename, ignore);
+
+        return {error, nullptr};
+    }
+
+    std::error_code renameError;
+
+    fs::rename(temporaryFilename, filename, renameError);
+
+    if (renameError)
+    {
+        std::error_code ignore;
+        fs::remove(temporaryFilename, ignore);
+
+        return {INVALID_WALLET_FILENAME, nullptr};
+    }
+
+    journal->m_filename = filename;
+
+    journal->syncDirectory();
+
+    journal->m_file.open(filename, std::ios_base::binary | std::ios_base::app);
+
+    if (!journal->m_file)
+    {
+        return {INVALID_WALLET_FILENAME, nullptr};
+    }
+
+    return {SUCCESS, journal};
+}
+
+std::tuple<Error, std::shared_ptr<WalletJournal>>
+    WalletJournal::open(const std::string &filename, const std::string &password)
+{
+    std::ifstream file(filename, std::ios_base::binary);
+
+    if (!file)
+    {
+        return {FILENAME_NON_EXISTENT, nullptr};
+    }
+
+    std::array<char, Constants::IS_A_WALLET_JOURNAL_IDENTIFIER.size()> identifier;
+    uint16_t version = 0;
+    std::vector<uint8_t> salt(SALT_SIZE);
+    std::vector<uint8_t> check(MAC_SIZE);
+
+    file.read(identifier.data(), identifier.size());
+    file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    file.read(reinterpret_cast<char *>(salt.data()), salt.size());
+    file.read(reinterpret_cast<char *>(check.data()), check.size());
+
+    if (!file)
+    {
+        return {WALLET_FILE_CORRUPTED, nullptr};
+    }
+
+    if (identifier != Constants::IS_A_WALLET_JOURNAL_IDENTIFIER)
+    {
+        return {NOT_A_WALLET_FILE, nullptr};
+    }
+
+    if (version != Constants::WALLET_JOURNAL_FORMAT_VERSION)
+    {
+        return {UNSUPPORTED_WALLET_FILE_FORMAT_VERSION, nullptr};
+    }
+
+    file.close();
+
+    std::shared_ptr<WalletJournal> journal(new WalletJournal(filename, salt, password));
+
+    const std::vector<uint8_t> expectedCheck = passwordCheck(journal->m_macKey);
+
+    if (!CryptoPP::VerifyBufsEqual(check.data(), expectedCheck.data(), check.size()))
+    {
+        return {WRONG_PASSWORD, nullptr};
+    }
+
+    if (Error error = journal->load(); error != SUCCESS)
+    {
+        return {error, nullptr};
+    }
+
+    return {SUCCESS, journal};
+}
+
+bool WalletJournal::isJournal(const std::string &filename)
+{
+    std::ifstream file(filename, std::ios_base::binary);
+
+    std::array<char, Constants::IS_A_WALLET_JOURNAL_IDENTIFIER.size()> identifier;
+
+    file.read(identifier.data(), identifier.size());
+
+    return file && identifier == Constants::IS_A_WALLET_JOURNAL_IDENTIFIER;
+}
+
+/////////////////////
+/* CLASS FUNCTIONS */
+/////////////////////
+
+Error WalletJournal::save(const std::function<void(const RecordWriter &)> &writeRecords)
+{
+    std::scoped_lock lock(m_mutex);
+
+    if (m_failed || !m_file)
+    {
+        return INVALID_WALLET_FILENAME;
+    }
+
+    m_saveCount++;
+
+    writeRecords([this](const std::string &key, const std::string &value) { putRecord(key, value); });
+
+    /* Anything we haven't heard about this time has been removed from the
+       wallet */
+    for (auto it = m_records.begin(); it != m_records.end();)
+    {
+        if (it->second.saveCount == m_saveCount)
+        {
+            ++it;
+            continue;
+        }
+
+        m_size += append(DELETE_RECORD, it->first, "");
+        m_liveSize -= it->second.size;
+
+        it = m_records.erase(it);
+    }
+
+    m_size += append(COMMIT, "", "");
+
+    m_file.flush();
+
+    /* The save isn't done until the commit is on disk */
+    if (!m_file || !Tools::syncFile(m_filename))
+    {
+        m_failed = true;
+
+        Logger::logger.log(
+            "Failed to write to wallet file " + m_filename, Logger::FATAL, {Logger::FILESYSTEM, Logger::SAVE});
+
+        return INVALID_WALLET_FILENAME;
+    }
+
+    maybeCompact();
+
+    return SUCCESS;
+}
+
+void WalletJournal::syncDirectory() const
+{
+    if (!Tools::syncDirectory(fs::path(m_filename).parent_path().string()))
+    {
+        Logger::logger.log(
+            "Failed to sync the directory of wallet file " + m_filename,
+            Logger::WARNING,
+            {Logger::FILESYSTEM, Logger::SAVE});
+    }
+}
+
+std::tuple<Error, std::vector<std::pair<std::string, std::string>>> WalletJournal::getRecords() const
+{
+    std::scoped_lock lock(m_mutex);
+
+    std::vector<std::pair<std::string, const Record *>> ordered;
+
+    for (const auto &[key, record] : m_records)
+    {
+        ordered.emplace_back(key, &record);
+    }
+
+    std::sort(ordered.begin(), ordered.end(), [](const auto &a, const auto &b) {
+        return a.second->sequence < b.second->sequence;
+    });
+
+    std::ifstream file(m_filename, std::ios_base::binary);
+
+    std::vector<std::pair<std::string, std::string>> records;
+
+    for (const auto &[key, record] : ordered)
+    {
+        file.seekg(record->offset);
+
+        Entry entry;
+        uint64_t size;
+
+        if (!readEntry(file, record->size, entry, size) || entry.type != PUT_RECORD || entry.key != key)
+        {
+            return {WALLET_FILE_CORRUPTED, {}};
+        }
+
+        records.emplace_back(key, std::move(entry.value));
+    }
+
+    return {SUCCESS, records};
+}
+
+Error WalletJournal::load()
+{
+    std::error_code ec;
+
+    const uint64_t fileSize = fs::file_size(m_filename, ec);
+
+    std::ifstream file(m_filename, std::ios_base::binary);
+
+    if (ec || !file)
+    {
+        return FILENAME_NON_EXISTENT;
+    }
+
+    file.seekg(HEADER_SIZE);
+
+    struct PendingEntry
+    {
+        EntryType type;
+
+        std::string key;
+
+        Crypto::Hash digest;
+
+        uint64_t offset;
+
+        uint64_t size;
+    };
+
+    /* Entries aren't applied until we reach the commit at the end of the save
+       they were written in */
+    std::vector<PendingEntry> pending;
+
+    uint64_t offset = HEADER_SIZE;
+    uint64_t committedSize = HEADER_SIZE;
+
+    Entry entry;
+    uint64_t size;
+
+    while (offset < fileSize && readEntry(file, fileSize - offset, entry, size))
+    {
+        if (entry.type == COMMIT)
+        {
+            for (const auto &p : pending)
+            {
+                const auto it = m_records.find(p.key);
+
+                if (it != m_records.end())
+                {
+                    m_liveSize -= it->second.size;
+                }
+
+                if (p.type == DELETE_RECORD)
+                {
+                    if (it != m_records.end())
+                    {
+                        m_records.erase(it);
+                    }
+
+                    continue;
+                }
+
+                if (it == m_records.end())
+                {
+                    m_records[p.key] = {m_nextSequence++, p.offset, p.size, p.digest, 0};
+                }
+                else
+                {
+                    it->second.offset = p.offset;
+                    it->second.size = p.size;
+                    it->second.digest = p.digest;
+                }
+
+                m_liveSize += p.size;
+            }
+
+            pending.clear();
+
+            committedSize = offset + size;
+        }
+        else
+        {
+            const Crypto::Hash digest = Crypto::cn_fast_hash(entry.value.data(), entry.value.size());
+
+            pending.push_back({entry.type, entry.key, digest, offset, size});
+        }
+
+        offset += size;
+    }
+
+    file.close();
+
+    /* Drop whatever was left over from a save which didn't finish, so the
+       next one doesn't get committed along with it */
+    if (committedSize < fileSize)
+    {
+        Logger::logger.log(
+            "Discarding unfinished save at the end of wallet file " + m_filename,
+            Logger::WARNING,
+            {Logger::FILESYSTEM, Logger::SAVE});
+
+        fs::resize_file(m_filename, committedSize, ec);
+
+        if (ec)
+        {
+            return INVALID_WALLET_FILENAME;
+        }
+    }
+
+    m_size = committedSize;
+
+    m_file.open(m_filename, std::ios_base::binary | std::ios_base::app);
+
+    if (!m_file)
+    {
+        return INVALID_WALLET_FILENAME;
+    }
+
+    return SUCCESS;
+}
+
+Error WalletJournal::writeHeader(std::ostream &file) const
+{
+    const std::vector<uint8_t> check = passwordCheck(m_macKey);
+
+    file.write(Constants::IS_A_WALLET_JOURNAL_IDENTIFIER.data(), Constants::IS_A_WALLET_JOURNAL_IDENTIFIER.size());
+    file.write(
+        reinterpret_cast<const char *>(&Constants::WALLET_JOURNAL_FORMAT_VERSION),
+        sizeof(Constants::WALLET_JOURNAL_FORMAT_VERSION));
+    file.write(reinterpret_cast<const char *>(m_salt.data()), m_salt.size());
+    file.write(reinterpret_cast<const char *>(check.data()), check.size());
+
+    if (!file)
+    {
+        Logger::logger.log(
+            std::string("Wallet filename: ") + m_filename + " is invalid",
+            Logger::FATAL,
+            {Logger::FILESYSTEM, Logger::SAVE});
+
+        return INVALID_WALLET_FILENAME;
+    }
+
+    return SUCCESS;
+}
+
+uint64_t WalletJournal::append(const EntryType type, const std::string &key, const std::string &value)
+{
+    const std::string entry = encryptEntry(type, key, value);
+
+    m_file.write(entry.data(), entry.size());
+
+    return entry.size();
+}
+
+std::string WalletJournal::encryptEntry(const EntryType type, const std::string &key, const std::string &value) const
+{
+    using namespace CryptoPP;
+
+    std::string plaintext;
+
+    plaintext.reserve(1 + sizeof(uint32_t) + key.size() + value.size());
+
+    plaintext.push_back(static_cast<char>(type));
+    appendBytes(plaintext, static_cast<uint32_t>(key.size()));
+    plaintext.append(key);
+    plaintext.append(value);
+
+    /* Every entry is encrypted with the same key, so needs its own IV */
+    byte iv[IV_SIZE];
+
+    Random::randomBytes(sizeof(iv), iv);
+
+    CBC_Mode<AES>::Encryption cbcEncryption;
+
+    cbcEncryption.SetKeyWithIV(m_encryptionKey.data(), m_encryptionKey.size(), iv);
+
+    std::string ciphertext;
+
+    StringSource(plaintext, true, new StreamTransformationFilter(cbcEncryption, new StringSink(ciphertext)));
+
+    std::string entry;
+
+    entry.reserve(ENTRY_OVERHEAD + ciphertext.size());
+
+    appendBytes(entry, static_cast<uint32_t>(ciphertext.size()));
+    entry.append(reinterpret_cast<const char *>(iv), sizeof(iv));
+    entry.append(ciphertext);
+
+    const std::vector<uint8_t> mac = calculateMac(m_macKey, entry);
+
+    entry.append(reinterpret_cast<const char *>(mac.data()), mac.size());
+
+    return entry;
+}
+
+bool WalletJournal::readEntry(std::istream &file, const uint64_t maxSize, Entry &entry, uint64_t &size) const
+{
+    using namespace CryptoPP;
+
+    uint32_t ciphertextSize = 0;
+
+    file.read(reinterpret_cast<char *>(&ciphertextSize), sizeof(ciphertextSize));
+
+    if (!file || ciphertextSize + ENTRY_OVERHEAD > maxSize)
+    {
+        return false;
+    }
+
+    size = ciphertextSize + ENTRY_OVERHEAD;
+
+    std::string data(size, '\0');
+
+    std::memcpy(data.data(), &ciphertextSize, sizeof(ciphertextSize));
+
+    file.read(data.data() + sizeof(ciphertextSize), size - sizeof(ciphertextSize));
+
+    if (!file)
+    {
+        return false;
+    }
+
+    const std::string authenticated = data.substr(0, size - MAC_SIZE);
+
+    const std::vector<uint8_t> mac = calculateMac(m_macKey, authenticated);
+
+    if (!VerifyBufsEqual(mac.data(), reinterpret_cast<const byte *>(data.data() + authenticated.size()), MAC_SIZE))
+    {
+        return false;
+    }
+
+    const byte *iv = reinterpret_cast<const byte *>(data.data() + sizeof(ciphertextSize));
+
+    CBC_Mode<AES>::Decryption cbcDecryption;
+
+    cbcDecryption.SetKeyWithIV(m_encryptionKey.data(), m_encryptionKey.size(), iv);
+
+    std::string plaintext;
+
+    try
+    {
+        StringSource(
+            reinterpret_cast<const byte *>(authenticated.data() + sizeof(ciphertextSize) + IV_SIZE),
+            ciphertextSize,
+            true,
+            new StreamTransformationFilter(cbcDecryption, new StringSink(plaintext)));
+    }
+    catch (const CryptoPP::Exception &)
+    {
+        return false;
+    }
+
+    uint32_t keySize = 0;
+
+    if (plaintext.size() < 1 + sizeof(keySize))
+    {
+        return false;
+    }
+
+    std::memcpy(&keySize, plaintext.data() + 1, sizeof(keySize));
+
+    if (plaintext.size() < 1 + sizeof(keySize) + keySize || plaintext[0] > COMMIT)
+    {
+        return false;
+    }
+
+    entry.type = static_cast<EntryType>(plaintext[0]);
+    entry.key = plaintext.substr(1 + sizeof(keySize), keySize);
+    entry.value = plaintext.substr(1 + sizeof(keySize) + keySize);
+
+    return true;
+}
+
+void WalletJournal::putRecord(const std::string &key, const std::string &value)
+{
+    const Crypto::Hash digest = Crypto::cn_fast_hash(value.data(), value.size());
+
+    const auto it = m_records.find(key);
+
+    if (it != m_records.end() && it->second.digest == digest)
+    {
+        it->second.saveCount = m_saveCount;
+        return;
+    }
+
+    const uint64_t offset = m_size;
+    const uint64_t size = append(PUT_RECORD, key, value);
+
+    m_size += size;
+    m_liveSize += size;
+
+    if (it == m_records.end())
+    {
+        m_records[key] = {m_nextSequence++, offset, size, digest, m_saveCount};
+    }
+    else
+    {
+        m_liveSize -= it->second.size;
+
+        it->second.offset = offset;
+        it->second.size = size;
+        it->second.digest = digest;
+        it->second.saveCount = m_saveCount;
+    }
+}
+
+void WalletJournal::maybeCompact()
+{
+    if (m_size < Constants::WALLET_JOURNAL_COMPACTION_THRESHOLD || m_size - m_liveSize < m_liveSize)
+    {
+        return;
+    }
+
+    if (m_compacting)
+    {
+        return;
+    }
+
+    if (m_compactionThread.joinable())
+    {
+        m_compactionThread.join();
+    }
+
+    m_compacting = true;
+
+    m_compactionThread = std::thread(&WalletJournal::compact, this);
+}
+
+void WalletJournal::compact()
+{
+    const std::string temporaryFilename = m_filename + ".compact";
+
+    std::vector<std::pair<std::string, Record>> snapshot;
+
+    uint64_t snapshotSize;
+
+    {
+        std::scoped_lock lock(m_mutex);
+
+        snapshot.assign(m_records.begin(), m_records.end());
+
+        snapshotSize = m_size;
+    }
+
+    /* Keep the records in the order they were first written, so they're
+       loaded back in the same order */
+    std::sort(snapshot.begin(), snapshot.end(), [](const auto &a, const auto &b) {
+        return a.second.sequence < b.second.sequence;
+    });
+
+    std::ifstream input(m_filename, std::ios_base::binary);
+    std::ofstream output(temporaryFilename, std::ios_base::binary | std::ios_base::trunc);
+
+    bool success = input && writeHeader(output) == SUCCESS;
+
+    /* Where each entry we keep moved to */
+    std::unordered_map<uint64_t, uint64_t> newOffsets;
+
+    uint64_t outputSize = HEADER_SIZE;
+
+    std::string buffer;
+
+    /* The entries are self contained, so we can copy them across as they
+       are, without decrypting them */
+    for (const auto &[key, record] : snapshot)
+    {
+        if (!success)
+        {
+            break;
+        }
+
+        buffer.resize(record.size);
+
+        input.seekg(record.offset);
+        input.read(buffer.data(), buffer.size());
+        output.write(buffer.data(), buffer.size());
+
+        newOffsets[record.offset] = outputSize;
+
+        outputSize += record.size;
+
+        success = input && output;
+    }
+
+    if (success)
+    {
+        const std::string commit = encryptEntry(COMMIT, "", "");
+
+        output.write(commit.data(), commit.size());
+
+        outputSize += commit.size();
+    }
+
+    {
+        std::scoped_lock lock(m_mutex);
+
+        /* Bring across anything saved while we were busy. It's only ever
+           whole saves, as saving holds the lock. */
+        if (success && m_size > snapshotSize)
+        {
+            buffer.resize(m_size - snapshotSize);
+
+            input.seekg(snapshotSize);
+            input.read(buffer.data(), buffer.size());
+            output.write(buffer.data(), buffer.size());
+        }
+
+        output.flush();
+
+        success = success && input && output && !m_failed;
+
+        input.close();
+        output.close();
+
+        /* Make sure the new file is on disk before it replaces the old one */
+        success = success && Tools::syncFile(temporaryFilename);
+
+        if (success)
+        {
+            m_file.close();
+
+            std::error_code ec;
+
+            fs::rename(temporaryFilename, m_filename, ec);
+
+            if (!ec)
+            {
+                syncDirectory();
+            }
+
+            m_file.open(m_filename, std::ios_base::binary | std::ios_base::app);
+
+            if (ec || !m_file)
+            {
+                /* Either way we're no longer sure the index matches the file,
+                   the next save will start a fresh one */
+                m_failed = true;
+            }
+            else
+            {
+                for (auto &[key, record] : m_records)
+                {
+                    /* Anything that was live when we took the snapshot, and
+                       hasn't been written since, was copied across */
+                    if (record.offset < snapshotSize)
+                    {
+                        record.offset = newOffsets.at(record.offset);
+                    }
+                    else
+                    {
+                        record.offset = record.offset - snapshotSize + outputSize;
+                    }
+                }
+
+                m_size = m_size - snapshotSize + outputSize;
+            }
+        }
+
+        if (!success)
+        {
+            std::error_code ignore;
+            fs::remove(temporaryFilename, ignore);
+
+            Logger::logger.log(
+                "Failed to compact wallet file " + m_filename, Logger::WARNING, {Logger::FILESYSTEM, Logger::SAVE});
+        }
+    }
+
+    m_compacting = false;
+}
@@ -0,0 +1,168 @@
+// Copyright (c) 2018-2019, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include "CryptoTypes.h"
+
+#include <array>
+#include <atomic>
+#include <errors/Errors.h>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/* The wallet file, stored as an encrypted, append only log of records, each
+   of which is a piece of the wallet JSON.
+
+   The AES and MAC keys are derived from the password once, when the file is
+   created or opened, rather than on every save. A save only appends the
+   records which changed since the last one, followed by a commit marker, so
+   an interrupted save is discarded on open. Once enough of the file is
+   records which have since been overwritten, it's compacted in the
+   background. */
+class WalletJournal
+{
+  public:
+    /* Used to hand the journal each record of a save, as a key, and the JSON
+       to store */
+    typedef std::function<void(const std::string &key, const std::string &value)> RecordWriter;
+
+    /* Writes a new journal, holding the records written by writeRecords, to
+       a temporary file, then moves it over filename. Anything already there
+       is untouched if we fail. */
+    static std::tuple<Error, std::shared_ptr<WalletJournal>> create(
+        const std::string &filename,
+        const std::string &password,
+        const std::function<void(const RecordWriter &)> &writeRecords);
+
+    /* Opens an existing journal, dropping any unfinished save at the end of
+       it */
+    static std::tuple<Error, std::shared_ptr<WalletJournal>>
+        open(const std::string &filename, const std::string &password);
+
+    /* Does the file start with the journal identifier */
+    static bool isJournal(const std::string &filename);
+
+    ~WalletJournal();
+
+    WalletJournal(const WalletJournal &) = delete;
+
+    WalletJournal &operator=(const WalletJournal &) = delete;
+
+    /* Writes a save. Records which are the same as last time aren't written
+       again, and records from the last save which aren't written this time
+       are deleted. */
+    Error save(const std::function<void(const RecordWriter &)> &writeRecords);
+
+    /* The records from the last save, in the order they were first
+       written */
+    std::tuple<Error, std::vector<std::pair<std::string, std::string>>> getRecords() const;
+
+  private:
+    enum EntryType : uint8_t
+    {
+        PUT_RECORD = 0,
+        DELETE_RECORD = 1,
+        COMMIT = 2,
+    };
+
+    struct Record
+    {
+        /* When the key was first written, records are given back in this
+           order */
+        uint64_t sequence;
+
+        /* Where the entry holding the current value starts, and its size */
+        uint64_t offset;
+
+        uint64_t size;
+
+        /* Lets us skip writing a record when it hasn't changed */
+        Crypto::Hash digest;
+
+        /* The last save the record was written in */
+        uint64_t saveCount;
+    };
+
+    struct Entry
+    {
+        EntryType type;
+
+        std::string key;
+
+        std::string value;
+    };
+
+    WalletJournal(const std::string &filename, const std::vector<uint8_t> &salt, const std::string &password);
+
+    /* Reads the file, and builds the index of records from it */
+    Error load();
+
+    Error writeHeader(std::ostream &file) const;
+
+    /* Encrypts and writes an entry to the end of the file, returning its
+       size */
+    uint64_t append(const EntryType type, const std::string &key, const std::string &value);
+
+    std::string encryptEntry(const EntryType type, const std::string &key, const std::string &value) const;
+
+    /* Reads the entry at the current position, which can be at most maxSize
+       bytes. Returns false if it's truncated, or fails to authenticate. */
+    bool readEntry(std::istream &file, const uint64_t maxSize, Entry &entry, uint64_t &size) const;
+
+    void putRecord(const std::string &key, const std::string &value);
+
+    /* Makes sure renaming a file over ours has reached the disk */
+    void syncDirectory() const;
+
+    /* Starts compacting in the background, if it's worth doing */
+    void maybeCompact();
+
+    /* Rewrites the file, with just the current value of each record */
+    void compact();
+
+    std::string m_filename;
+
+    /* The PBKDF2 salt, stored in the clear in the file header */
+    std::vector<uint8_t> m_salt;
+
+    /* Derived from the password and salt */
+    std::vector<uint8_t> m_encryptionKey;
+
+    std::vector<uint8_t> m_macKey;
+
+    /* Opened for appending. Reads are done with their own stream, so the
+       compaction thread can read while we write. */
+    std::ofstream m_file;
+
+    /* The size of the file, up to the end of the last commit */
+    uint64_t m_size = 0;
+
+    /* The size of the entries which hold the current value of a record */
+    uint64_t m_liveSize = 0;
+
+    std::unordered_map<std::string, Record> m_records;
+
+    uint64_t m_nextSequence = 0;
+
+    uint64_t m_saveCount = 0;
+
+    /* Set if a write failed, in which case the file may not match the
+       index */
+    bool m_failed = false;
+
+    /* Guards everything above */
+    mutable std::mutex m_mutex;
+
+    std::thread m_compactionThread;
+
+    std::atomic<bool> m_compacting {false};
+};
@@ -13,8 +13,6 @@
 #include <future>
 #include <iostream>
 #include <logger/Logger.h>
-#include <utilities/ThreadSafeDeque.h>
-#include <utilities/ThreadSafeQueue.h>
 #include <utilities/Utilities.h>
 #include <walletbackend/Constants.h>
 
@@ -90,10 +88,6 @@ WalletSynchronizer &WalletSynchronizer::operator=(WalletSynchronizer &&old)
 
     m_subWallets = std::move(old.m_subWallets);
 
-    m_blockProcessingQueue = std::move(old.m_blockProcessingQueue);
-
-    m_processedBlocks = std::move(old.m_processedBlocks);
-
     m_threadCount = std::move(old.m_threadCount);
 
     return *this;
@@ -119,45 +113,34 @@ void WalletSynchronizer::mainLoop()
 
         if (!blocks.empty())
         {
-            m_blockProcessingQueue.push_back_n(blocks.begin(), blocks.end());
-
-            /* Tell the child threads to wake up */
-            m_haveBlocksToProcess.notify_all();
-
-            const size_t chunkSize = blocks.size();
-
-            {
-                /* *possibly* should use another mutex here for the different
-                    condition variable? I think it's fine since we're only
-                    stopping the child threads from aquiring the mutex for
-                    a very short time (since the check will fail when not all
-                    blocks are available) */
-                std::unique_lock<std::mutex> lock(m_mutex);
-
-                m_haveProcessedBlocksToHandle.wait(lock, [&] {
-                    if (m_shouldStop)
+            /* Take the max chunk size, split by the threads, divided by 2. So in
+               theory, each thread processes 2 chunks. This is to decrease locking,
+               while also trying to stop slower threads from delaying the system. */
+            const size_t chunkSize = Constants::BLOCK_PROCESSING_CHUNK / m_threadCount / 2;
+
+            std::vector<BlockInputsAndOwners> ourInputs(blocks.size());
+
+            /* Shared between the threads, rather than every transaction taking
+               a copy of the spend keys and searching it linearly */
+            const std::unordered_set<Crypto::PublicKey> spendKeys(
+                m_subWallets->m_publicSpendKeys.begin(), m_subWallets->m_publicSpendKeys.end());
+
+            /* Scan the blocks for our outputs in parallel... */
+            m_threadPool->parallelFor(
+                blocks.size(),
+                [&](const size_t i) {
+                    if (!m_shouldStop)
                     {
-                        return true;
+                        ourInputs[i] = processBlock(std::get<0>(blocks[i]), spendKeys);
                     }
+                },
+                m_threadCount == 1 ? blocks.size() : chunkSize);
 
-                    /* Wait until all the blocks have been added to the queue */
-                    return m_processedBlocks.size() == chunkSize;
-                });
-
-                if (m_shouldStop)
-                {
-                    return;
-                }
-            }
-
-            /* Nothing else should be pushing to the queue here, since the
-               child threads are waiting for a new chunk, so don't need to
-               use mutex to access */
-            while (!m_processedBlocks.empty_unsafe() && !m_shouldStop)
+            /* ...then handle them in the order they arrived in. This is
+               needed to ensure correct handling of network forks. */
+            for (size_t i = 0; i < blocks.size() && !m_shouldStop; i++)
             {
-                const auto [block, ourInputs, arrivalIndex] = m_processedBlocks.top_unsafe();
-                completeBlockProcessing(block, ourInputs);
-                m_processedBlocks.pop_unsafe();
+                completeBlockProcessing(std::get<0>(blocks[i]), ourInputs[i]);
             }
         }
 
@@ -179,143 +162,143 @@ void WalletSynchronizer::mainLoop()
     }
 }
 
-void WalletSynchronizer::blockProcessingThread()
+BlockInputsAndOwners WalletSynchronizer::processBlock(
+    const WalletTypes::WalletBlockInfo &block,
+    const std::unordered_set<Crypto::PublicKey> &spendKeys) const
 {
-    /* Take the max chunk size, split by the threads, divided by 2. So in
-       theory, each thread processes 2 chunks. This is to decrease locking,
-       while also trying to stop slower threads from delaying the system. */
-    size_t chunkSize = Constants::BLOCK_PROCESSING_CHUNK / m_threadCount / 2;
-
-    if (chunkSize == 0)
+    if (Logger::logger.isEnabled(Logger::DEBUG))
     {
-        chunkSize = 1;
+        Logger::logger.log("Processing block " + std::to_string(block.blockHeight), Logger::DEBUG, {Logger::SYNC});
     }
 
-    /* No point splitting into chunks if we're only using 1 thread */
-    if (m_threadCount == 1)
-    {
-        chunkSize = Constants::BLOCK_PROCESSING_CHUNK;
-    }
+    auto ourInputs = processBlockOutputs(block, spendKeys);
 
-    std::vector<SemiProcessedBlock> processedBlocks;
+    std::unordered_map<Crypto::Hash, std::vector<uint64_t>> globalIndexes;
 
-    while (!m_shouldStop)
+    for (auto &[publicKey, input] : ourInputs)
     {
+        if (!m_subWallets->isViewWallet() && !input.globalOutputIndex)
         {
-            std::unique_lock<std::mutex> lock(m_mutex);
-
-            /* Wait for blocks to be available */
-            m_haveBlocksToProcess.wait(lock, [&] {
-                if (m_shouldStop)
-                {
-                    return true;
-                }
-
-                return m_blockProcessingQueue.size() > 0;
-            });
-
-            if (m_shouldStop)
+            if (globalIndexes.empty())
             {
-                return;
+                globalIndexes = getGlobalIndexes(block.blockHeight);
             }
-        }
 
-        auto chunk = m_blockProcessingQueue.front_n_and_remove(chunkSize);
+            auto it = globalIndexes.find(input.parentTransactionHash);
 
-        /* Process blocks while we've got more to process */
-        while (!chunk.empty() && !m_shouldStop)
-        {
-            for (const auto &[block, arrivalIndex] : chunk)
-            {
-                Logger::logger.log(
-                    "Processing block " + std::to_string(block.blockHeight), Logger::DEBUG, {Logger::SYNC});
-
-                auto ourInputs = processBlockOutputs(block);
-
-                std::unordered_map<Crypto::Hash, std::vector<uint64_t>> globalIndexes;
+            /* Daemon returns indexes for hashes in a range. If we don't
+               find our hash, either the chain has forked, or the daemon
+               is faulty. Print a warning message, then return so we
+               can fetch new blocks, in the likely case the daemon has
+               forked.
 
-                for (auto &[publicKey, input] : ourInputs)
+               Also need to check there are enough indexes for the one we want */
+            while (it == globalIndexes.end() || it->second.size() <= input.transactionIndex)
+            {
+                if (m_shouldStop)
                 {
-                    if (!m_subWallets->isViewWallet() && !input.globalOutputIndex)
-                    {
-                        if (globalIndexes.empty())
-                        {
-                            globalIndexes = getGlobalIndexes(block.blockHeight);
-                        }
+                    return ourInputs;
+                }
 
-                        auto it = globalIndexes.find(input.parentTransactionHash);
+                Logger::logger.log(
+                    "Warning: Failed to get correct global indexes from daemon."
+                    "\nThe daemon may have gone offline or the chain may have just forked.",
+                    Logger::FATAL,
+                    {Logger::SYNC, Logger::DAEMON});
 
-                        /* Daemon returns indexes for hashes in a range. If we don't
-                           find our hash, either the chain has forked, or the daemon
-                           is faulty. Print a warning message, then return so we
-                           can fetch new blocks, in the likely case the daemon has
-                           forked.
+                std::this_thread::sleep_for(std::chrono::seconds(5));
 
-                           Also need to check there are enough indexes for the one we want */
-                        while (it == globalIndexes.end() || it->second.size() <= input.transactionIndex)
-                        {
-                            if (m_shouldStop)
-                            {
-                                return;
-                            }
+                globalIndexes = getGlobalIndexes(block.blockHeight);
 
-                            Logger::logger.log(
-                                "Warning: Failed to get correct global indexes from daemon."
-                                "\nThe daemon may have gone offline or the chain may have just forked.",
-                                Logger::FATAL,
-                                {Logger::SYNC, Logger::DAEMON});
+                it = globalIndexes.find(input.parentTransactionHash);
+            }
 
-                            std::this_thread::sleep_for(std::chrono::seconds(5));
+            input.globalOutputIndex = it->second[input.transactionIndex];
+        }
+    }
 
-                            globalIndexes = getGlobalIndexes(block.blockHeight);
+    return ourInputs;
+}
 
-                            it = globalIndexes.find(input.parentTransactionHash);
-                        }
+std::vector<std::tuple<Crypto::PublicKey, WalletTypes::TransactionInput>> WalletSynchronizer::processBlockOutputs(
+    const WalletTypes::WalletBlockInfo &block,
+    const std::unordered_set<Crypto::PublicKey> &spendKeys) const
+{
+    std::vector<const WalletTypes::RawCoinbaseTransaction *> transactions;
 
-                        input.globalOutputIndex = it->second[input.transactionIndex];
-                    }
-                }
+    if (!Config::config.wallet.skipCoinbaseTransactions && block.coinbaseTransaction)
+    {
+        transactions.push_back(&*block.coinbaseTransaction);
+    }
 
-                processedBlocks.push_back({block, ourInputs, arrivalIndex});
-            }
+    for (const auto &tx : block.transactions)
+    {
+        transactions.push_back(&tx);
+    }
 
-            chunk = m_blockProcessingQueue.front_n_and_remove(chunkSize);
-        }
+    /* Underive every output in the block in one go, so the expensive part
+       of encoding the derived keys can be shared between them */
+    std::vector<Crypto::UnderiveRequest> requests;
 
-        /* Push our processed blocks */
-        if (!processedBlocks.empty())
-        {
-            /* Store this chunks worth of blocks */
-            m_processedBlocks.push_n(processedBlocks.begin(), processedBlocks.end());
+    for (const auto tx : transactions)
+    {
+        Crypto::KeyDerivation derivation;
 
-            /* Notify the parent thread we've pushed data to the queue */
-            m_haveProcessedBlocksToHandle.notify_all();
+        Crypto::generate_key_derivation(tx->transactionPublicKey, m_privateViewKey, derivation);
 
-            /* Empty the processed blocks */
-            processedBlocks.clear();
+        for (size_t outputIndex = 0; outputIndex < tx->keyOutputs.size(); outputIndex++)
+        {
+            requests.push_back({derivation, outputIndex, tx->keyOutputs[outputIndex].key});
         }
-
-        /* Then go back to waiting for more data */
     }
-}
 
-std::vector<std::tuple<Crypto::PublicKey, WalletTypes::TransactionInput>>
-    WalletSynchronizer::processBlockOutputs(const WalletTypes::WalletBlockInfo &block) const
-{
+    std::vector<Crypto::PublicKey> derivedSpendKeys;
+    std::vector<bool> valid;
+
+    Crypto::underive_public_keys(requests, derivedSpendKeys, valid);
+
     std::vector<std::tuple<Crypto::PublicKey, WalletTypes::TransactionInput>> inputs;
 
-    if (!Config::config.wallet.skipCoinbaseTransactions && block.coinbaseTransaction)
+    size_t i = 0;
+
+    for (const auto tx : transactions)
     {
-        const auto newInputs = processTransactionOutputs(*(block.coinbaseTransaction), block.blockHeight);
+        for (size_t outputIndex = 0; outputIndex < tx->keyOutputs.size(); outputIndex++, i++)
+        {
+            /* If the derived spend key matches any of our spend keys, the
+               output belongs to us */
+            if (!valid[i] || spendKeys.find(derivedSpendKeys[i]) == spendKeys.end())
+            {
+                continue;
+            }
 
-        inputs.insert(inputs.end(), newInputs.begin(), newInputs.end());
-    }
+            const auto &output = tx->keyOutputs[outputIndex];
 
-    for (const auto &tx : block.transactions)
-    {
-        const auto newInputs = processTransactionOutputs(tx, block.blockHeight);
+            /* We need to fill in the key image of the transaction input -
+               we'll let the subwallet do this since we need the private spend
+               key. We use the key images to detect outgoing transactions,
+               and we use the transaction inputs to make transactions ourself */
+            const auto [keyImage, privateEphemeral]
+                = m_subWallets->getTxInputKeyImage(derivedSpendKeys[i], requests[i].derivation, outputIndex);
 
-        inputs.insert(inputs.end(), newInputs.begin(), newInputs.end());
+            const uint64_t spendHeight = 0;
+
+            const WalletTypes::TransactionInput input({
+                keyImage,
+                output.amount,
+                block.blockHeight,
+                tx->transactionPublicKey,
+                outputIndex,
+                output.globalOutputIndex,
+                output.key,
+                spendHeight,
+                tx->unlockTime,
+                tx->hash,
+                privateEphemeral
+            });
+
+            inputs.emplace_back(derivedSpendKeys[i], input);
+        }
     }
 
     return inputs;
@@ -394,7 +377,10 @@ void WalletSynchronizer::completeBlockProcessing(
         m_eventHandler->onSynced.fire(block.blockHeight);
     }
 
-    Logger::logger.log("Finished processing block " + std::to_string(block.blockHeight), Logger::DEBUG, {Logger::SYNC});
+    if (Logger::logger.isEnabled(Logger::DEBUG))
+    {
+        Logger::logger.log("Finished processing block " + std::to_string(block.blockHeight), Logger::DEBUG, {Logger::SYNC});
+    }
 }
 
 BlockScanTmpInfo WalletSynchronizer::processBlockTransactions(
@@ -534,64 +520,6 @@ std::tuple<std::optional<WalletTypes::Transaction>, std::vector<std::tuple<Crypt
     return {std::nullopt, {}};
 }
 
-std::vector<std::tuple<Crypto::PublicKey, WalletTypes::TransactionInput>> WalletSynchronizer::processTransactionOutputs(
-    const WalletTypes::RawCoinbaseTransaction &rawTX,
-    const uint64_t blockHeight) const
-{
-    std::vector<std::tuple<Crypto::PublicKey, WalletTypes::TransactionInput>> inputs;
-
-    Crypto::KeyDerivation derivation;
-
-    Crypto::generate_key_derivation(rawTX.transactionPublicKey, m_privateViewKey, derivation);
-
-    const std::vector<Crypto::PublicKey> spendKeys = m_subWallets->m_publicSpendKeys;
-
-    uint64_t outputIndex = 0;
-
-    for (const auto &output : rawTX.keyOutputs)
-    {
-        Crypto::PublicKey derivedSpendKey;
-
-        Crypto::underive_public_key(derivation, outputIndex, output.key, derivedSpendKey);
-
-        /* See if the derived spend key matches any of our spend keys */
-        const auto ourSpendKey = std::find(spendKeys.begin(), spendKeys.end(), derivedSpendKey);
-
-        /* If it does, the transaction belongs to us */
-        if (ourSpendKey != spendKeys.end())
-        {
-            /* We need to fill in the key image of the transaction input -
-               we'll let the subwallet do this since we need the private spend
-               key. We use the key images to detect outgoing transactions,
-               and we use the transaction inputs to make transactions ourself */
-            const auto [keyImage, privateEphemeral]
-                = m_subWallets->getTxInputKeyImage(derivedSpendKey, derivation, outputIndex);
-
-            const uint64_t spendHeight = 0;
-
-            const WalletTypes::TransactionInput input({
-                keyImage,
-                output.amount,
-                blockHeight,
-                rawTX.transactionPublicKey,
-                outputIndex,
-                output.globalOutputIndex,
-                output.key,
-                spendHeight,
-                rawTX.unlockTime,
-                rawTX.hash,
-                privateEphemeral
-            });
-
-            inputs.emplace_back(derivedSpendKey, input);
-        }
-
-        outputIndex++;
-    }
-
-    return inputs;
-}
-
 /* When we get the global indexes, we pass in a range of blocks, to obscure
    which transactions we are interested in - the ones that belong to us.
    To do this, we get the global indexes for all transactions in a range.
@@ -676,17 +604,10 @@ void WalletSynchronizer::start()
     }
 
     m_blockDownloader.start();
-    m_blockProcessingQueue.start();
-    m_processedBlocks.start();
-
-    m_syncThread = std::thread(&WalletSynchronizer::mainLoop, this);
 
-    m_syncThreads.clear();
+    m_threadPool = std::make_unique<Utilities::ThreadPool>(m_threadCount);
 
-    for (unsigned int i = 0; i < m_threadCount; i++)
-    {
-        m_syncThreads.push_back(std::thread(&WalletSynchronizer::blockProcessingThread, this));
-    }
+    m_syncThread = std::thread(&WalletSynchronizer::mainLoop, this);
 }
 
 void WalletSynchronizer::stop()
@@ -698,14 +619,6 @@ void WalletSynchronizer::stop()
 
     /* Tell the block downloader to stop and wait for it */
     m_blockDownloader.stop();
-    m_blockProcessingQueue.stop();
-    m_processedBlocks.stop();
-
-    m_haveBlocksToProcess.notify_all();
-    m_haveProcessedBlocksToHandle.notify_all();
-
-    m_blockProcessingQueue.clear();
-    m_processedBlocks.clear();
 
     /* Wait for the block downloader thread to finish (if applicable) */
     if (m_syncThread.joinable())
@@ -713,14 +626,8 @@ void WalletSynchronizer::stop()
         m_syncThread.join();
     }
 
-    /* Wait for each child thread to finish */
-    for (auto &thread : m_syncThreads)
-    {
-        if (thread.joinable())
-        {
-            thread.join();
-        }
-    }
+    /* Then tear down the block processing threads */
+    m_threadPool.reset();
 }
 
 void WalletSynchronizer::reset(uint64_t startHeight)